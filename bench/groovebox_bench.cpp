@@ -0,0 +1,143 @@
+// Drives a device-less AudioEngine through the mix, every bus effect type, every synth kind and
+// a sample-voice count sweep. Prints one line per case: name, ns per output frame, real-time
+// factor (audio time / compute time) and heap allocations per period made on the mixing
+// thread. An optional argument keeps only the cases whose name contains it.
+//
+// Single-threaded on purpose: offline engines run without mix workers, so the numbers compare
+// kernels rather than scheduling.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "EffectKernels.h"
+#include "RtSafety.h"
+
+namespace {
+constexpr int kSampleRate = 48000;
+constexpr int kPeriodFrames = 256;
+constexpr int kWarmupPeriods = 50;
+constexpr int kPeriods = 2000;
+constexpr int kSourceFrames = kSampleRate * 2;
+
+const char *const kSynthNames[] = {"dx7",  "simple", "cluster", "digital", "dna",
+                                   "drwave", "dsynth", "fm",      "pulse",   "phase",
+                                   "ring",   "string", "saw",     "voltage"};
+
+std::shared_ptr<const SampleBuffer> makeSource() {
+    std::shared_ptr<SampleBuffer> buffer = SampleBuffer::create(kSourceFrames, 2, kSampleRate);
+    float *data = buffer->writableFloat();
+    uint32_t seed = 0x1234567u;
+    for (int i = 0; i < kSourceFrames; ++i) {
+        // A decaying tone with some noise, so dynamics and filters have something to chew on.
+        seed = 1664525u * seed + 1013904223u;
+        const float noise = static_cast<float>(static_cast<int>(seed >> 8) & 0xFFFF) / 32768.0f;
+        const float tone = std::sin(2.0f * 3.14159265f * 110.0f * i / kSampleRate);
+        const float env = std::exp(-3.0f * static_cast<float>(i % kSampleRate) / kSampleRate);
+        data[i * 2] = 0.6f * tone * env + 0.05f * (noise - 1.0f);
+        data[i * 2 + 1] = 0.6f * tone * env - 0.05f * (noise - 1.0f);
+    }
+    return buffer;
+}
+
+void runCase(const char *filter, const std::string &name,
+             const std::function<void(AudioEngine &)> &setup) {
+    if (filter && name.find(filter) == std::string::npos) {
+        return;
+    }
+    AudioEngine engine(kSampleRate, kPeriodFrames);
+    setup(engine);
+    std::vector<float> out(static_cast<size_t>(kPeriodFrames * engine.channels()), 0.0f);
+    for (int i = 0; i < kWarmupPeriods; ++i) {
+        engine.renderOffline(out.data(), kPeriodFrames);
+    }
+
+    const size_t allocsBefore = RtSafety::allocationCount();
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPeriods; ++i) {
+        RtSafety::AudioThreadScope rtScope;
+        engine.renderOffline(out.data(), kPeriodFrames);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    const size_t allocs = RtSafety::allocationCount() - allocsBefore;
+
+    const double ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    const double frames = static_cast<double>(kPeriods) * kPeriodFrames;
+    const double audioNs = frames * 1.0e9 / kSampleRate;
+    std::printf("%s %.2f %.1f %.3f\n", name.c_str(), ns / frames, ns > 0.0 ? audioNs / ns : 0.0,
+                static_cast<double>(allocs) / kPeriods);
+    std::fflush(stdout);
+}
+
+// Starts count looping voices spread over the pads at a few playback rates.
+void startVoices(AudioEngine &engine, const std::shared_ptr<const SampleBuffer> &source,
+                 int count, int bus) {
+    const float rates[] = {1.0f, 0.75f, 1.37f};
+    const int pads = 8;
+    const int perPad = (count + pads - 1) / pads;
+    for (int pad = 0; pad < pads; ++pad) {
+        engine.setPadVoicing(pad, perPad, 0);
+    }
+    for (int v = 0; v < count; ++v) {
+        engine.trigger(v % pads, source, (v * 977) % (kSourceFrames / 2), 0, true, 0.3f,
+                       (v % 5 - 2) * 0.3f, rates[v % 3], bus);
+    }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    // Count allocations on the mixing thread without a backtrace for each one.
+    setenv("GROOVEBOX_RT_CHECK_QUIET", "1", 0);
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    const std::shared_ptr<const SampleBuffer> source = makeSource();
+
+    std::printf("case ns_per_frame rt_factor allocs_per_period\n");
+    runCase(filter, "mix/idle", [](AudioEngine &) {});
+    runCase(filter, "mix/voice", [&](AudioEngine &engine) { startVoices(engine, source, 1, 0); });
+
+    // Every effect on bus 1, fed by one voice; compare against effect/none. conv has no impulse
+    // file here, so it passes through; effect_kernel_bench times the convolver itself.
+    for (int type = 0; type < EffectKernels::TypeCount; ++type) {
+        const std::string name = std::string("effect/") + EffectKernels::typeName(type);
+        runCase(filter, name, [&](AudioEngine &engine) {
+            if (type > 0) {
+                AudioEngine::EffectSettings fx;
+                fx.type = type;
+                fx.p1 = 0.6f;
+                fx.p2 = 0.5f;
+                fx.p3 = 0.4f;
+                fx.p4 = 0.5f;
+                fx.p5 = 0.3f;
+                engine.setBusEffects(1, {fx});
+            }
+            startVoices(engine, source, 1, 1);
+        });
+    }
+
+    // A held four-note chord on pad 0 for each synth engine.
+    for (int kind = 0; kind < static_cast<int>(std::size(kSynthNames)); ++kind) {
+        runCase(filter, std::string("synth/") + kSynthNames[kind], [&](AudioEngine &engine) {
+            engine.setSynthKind(0, static_cast<AudioEngine::SynthKind>(kind));
+            engine.setSynthVoices(0, 8);
+            engine.setSynthParams(0, 0.8f, 0.0f, 0);
+            engine.setSynthEnabled(0, true);
+            for (int note : {48, 55, 60, 64}) {
+                engine.synthNoteOn(0, note, 100);
+            }
+        });
+    }
+
+    for (int voices : {1, 8, 16, 32, AudioEngine::kMaxVoices}) {
+        runCase(filter, "voices/" + std::to_string(voices),
+                [&](AudioEngine &engine) { startVoices(engine, source, voices, 0); });
+    }
+    return 0;
+}
@@ -1,22 +1,60 @@
 #include "AudioEngine.h"
+#include "EffectKernels.h"
 #include "op1_engines.h"
+#include "RtSafety.h"
+#include "RtScheduling.h"
+#include "SampleDecoder.h"
+#include "SampleStream.h"
+#include "VoiceKernel.h"
+#include "WavStreamWriter.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <new>
 #include <QString>
 #include <QStringList>
 #include <QtGlobal>
 #include <QFile>
-#include <QDataStream>
 
 #ifdef GROOVEBOX_WITH_ALSA
 #include <alsa/asoundlib.h>
 #endif
+#ifdef GROOVEBOX_WITH_JACK
+#include <jack/jack.h>
+#endif
 
 namespace {
+// About five seconds of headroom at 48 kHz before a stalled disk starts dropping frames.
+constexpr int kRecordRingFrames = 1 << 18;
+constexpr int kRecordChunkFrames = 4096;
+// Per streaming voice: about 0.7 s ahead of the playhead at 48 kHz, topped up in chunks.
+constexpr int kStreamRingFrames = 1 << 15;
+constexpr int kStreamChunkFrames = 4096;
+constexpr int kStreamPollMs = 5;
+// Pool helpers besides the audio thread; one core stays free for the UI.
+constexpr int kMaxMixWorkers = 3;
+// JACK periods up to this long are mixed; the server's own limit.
+constexpr int kMaxJackFrames = 8192;
+// How long post() waits for room in a full command queue before dropping the command.
+constexpr int kPostTimeoutMs = 100;
+// Longest impulse response the convolution effect loads.
+constexpr int kMaxImpulseSeconds = 10;
+// Release of a voice cut by its choke group: short enough to read as a cut, long enough not
+// to click.
+constexpr float kChokeReleaseSec = 0.005f;
+// Sixteenth-note steps in a 4/4 bar; atBar patterns change over on these.
+constexpr int kSeqStepsPerBar = 16;
+
+long long elapsedNs(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                begin)
+        .count();
+}
+
 float clampSample(float v) {
     if (v > 1.0f) {
         return 1.0f;
@@ -246,23 +284,33 @@ AudioEngine::AudioEngine(QObject *parent) : QObject(parent) {
             m_periodFrames = qBound(64, envFrames, 2048);
         }
     }
-#ifndef GROOVEBOX_WITH_ALSA
-    for (auto &gain : m_busGains) {
-        gain.store(1.0f);
-    }
+    initState();
+
+#if defined(GROOVEBOX_WITH_ALSA) || defined(GROOVEBOX_WITH_JACK)
+    start();
 #endif
-#ifdef GROOVEBOX_WITH_ALSA
+}
+
+AudioEngine::AudioEngine(int sampleRate, int blockFrames, QObject *parent) : QObject(parent) {
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    m_periodFrames = qBound(64, blockFrames, 8192);
+    m_offline = true;
+    m_available = true;
+    initState();
+}
+
+void AudioEngine::initState() {
     for (auto &gain : m_busGains) {
         gain.store(1.0f);
     }
-    start();
-#endif
 
     for (size_t i = 0; i < m_padAttack.size(); ++i) {
         m_padAttack[i].store(0.0f);
         m_padDecay[i].store(0.0f);
         m_padSustain[i].store(1.0f);
         m_padRelease[i].store(0.0f);
+        m_padPolyphony[i].store(1);
+        m_padChoke[i].store(0);
     }
     for (auto &state : m_synthStates) {
         state.fmParams.macros.fill(0.0f);
@@ -278,17 +326,31 @@ AudioEngine::AudioEngine(QObject *parent) : QObject(parent) {
     for (auto &ph : m_padPlayheads) {
         ph.store(-1.0f);
     }
+    prepareBuffers(m_periodFrames);
 }
 
 AudioEngine::~AudioEngine() {
     stop();
+    stopRecordWriter();
+    stopStreamReader();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    collectRetired();
 }
 
 void AudioEngine::start() {
-#ifdef GROOVEBOX_WITH_ALSA
     if (m_running) {
         return;
     }
+#ifdef GROOVEBOX_WITH_JACK
+    // Default is JACK when a server is already up, ALSA otherwise.
+    const QString backend = qEnvironmentVariable("GROOVEBOX_AUDIO_BACKEND").trimmed().toLower();
+    if (backend != "alsa" && m_deviceOverride.trimmed().isEmpty()) {
+        if (startJack() || backend == "jack") {
+            return;
+        }
+    }
+#endif
+#ifdef GROOVEBOX_WITH_ALSA
 
     auto deviceList = [this]() {
         auto detectPreferred = []() -> QString {
@@ -383,8 +445,24 @@ void AudioEngine::start() {
     snd_pcm_hw_params_t *params = nullptr;
     snd_pcm_hw_params_malloc(&params);
     snd_pcm_hw_params_any(pcm, params);
-    snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S16_LE);
+    // Mix straight into the hardware ring when the device allows it; GROOVEBOX_ALSA_MMAP=0
+    // keeps the write path.
+    bool mmapSet = false;
+    const int mmapEnv = qEnvironmentVariableIntValue("GROOVEBOX_ALSA_MMAP", &mmapSet);
+    m_pcmMmap = (!mmapSet || mmapEnv != 0) &&
+                snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!m_pcmMmap) {
+        snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    // Widest first: float needs no conversion at all, S32 no truncation.
+    m_pcmFormat = SND_PCM_FORMAT_S16_LE;
+    for (const snd_pcm_format_t format : {SND_PCM_FORMAT_FLOAT_LE, SND_PCM_FORMAT_S32_LE}) {
+        if (snd_pcm_hw_params_test_format(pcm, params, format) == 0) {
+            m_pcmFormat = format;
+            break;
+        }
+    }
+    snd_pcm_hw_params_set_format(pcm, params, static_cast<snd_pcm_format_t>(m_pcmFormat));
     snd_pcm_hw_params_set_channels(pcm, params, static_cast<unsigned int>(m_channels));
 
     unsigned int rate = static_cast<unsigned int>(m_sampleRate);
@@ -412,18 +490,206 @@ void AudioEngine::start() {
     m_activeDevice = openedDevice;
     m_available = true;
     m_running = true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prepareBuffers(m_periodFrames);
+    startWorkers();
     m_thread = std::thread(&AudioEngine::run, this);
 #endif
 }
 
+int AudioEngine::mixWorkerCount() const {
+    int workers = std::min(kMaxMixWorkers,
+                           static_cast<int>(std::thread::hardware_concurrency()) - 2);
+    bool workersSet = false;
+    const int workersEnv = qEnvironmentVariableIntValue("GROOVEBOX_MIX_WORKERS", &workersSet);
+    if (workersSet) {
+        workers = qBound(0, workersEnv, 7);
+    }
+    return workers;
+}
+
+void AudioEngine::startWorkers() {
+    // The audio thread takes the first configured core, the workers the rest. Without a spare
+    // configured core the workers stay unpinned, which keeps them off the audio core.
+    const RtScheduling::Config &rt = RtScheduling::config();
+    const int priority =
+        rt.priority > 0 ? std::max(1, rt.priority - RtScheduling::kWorkerPriorityGap) : 0;
+    std::vector<int> cores;
+    if (rt.cpus.size() > 1) {
+        cores.assign(rt.cpus.begin() + 1, rt.cpus.end());
+    }
+    m_workers.start(mixWorkerCount(), priority, cores);
+}
+
+bool AudioEngine::audioThreadActive() const {
+    return m_thread.joinable() || m_jackClient != nullptr;
+}
+
+QString AudioEngine::backendName() const {
+    if (m_jackClient) {
+        return QStringLiteral("jack");
+    }
+    return m_pcmHandle ? QStringLiteral("alsa") : QString();
+}
+
+#ifdef GROOVEBOX_WITH_JACK
+bool AudioEngine::startJack() {
+    jack_status_t status{};
+    jack_client_t *client =
+        jack_client_open("GrooveBox", static_cast<jack_options_t>(JackNoStartServer), &status);
+    if (!client) {
+        m_available = false;
+        return false;
+    }
+
+    static const char *const kPortNames[] = {"master_L", "master_R", "bus1_L", "bus1_R",
+                                             "bus2_L",   "bus2_R",   "bus3_L", "bus3_R",
+                                             "bus4_L",   "bus4_R",   "bus5_L", "bus5_R"};
+    for (size_t i = 0; i < m_jackPorts.size(); ++i) {
+        m_jackPorts[i] = jack_port_register(client, kPortNames[i], JACK_DEFAULT_AUDIO_TYPE,
+                                            JackPortIsOutput | JackPortIsTerminal, 0);
+        if (!m_jackPorts[i]) {
+            jack_client_close(client);
+            m_jackPorts.fill(nullptr);
+            m_available = false;
+            return false;
+        }
+    }
+
+    // The server owns rate and period; the engine follows.
+    m_sampleRate = static_cast<int>(jack_get_sample_rate(client));
+    m_periodFrames = static_cast<int>(jack_get_buffer_size(client));
+    jack_set_process_callback(
+        client,
+        [](jack_nframes_t frames, void *arg) {
+            return static_cast<AudioEngine *>(arg)->processJack(static_cast<int>(frames));
+        },
+        this);
+    // No buffer size callback: it would run on the process thread without m_mutex. The JACK
+    // scratch is sized for the largest period up front and mix() splits periods longer than
+    // prepareBuffers() sized for, so a period change needs no reallocation and effect tails
+    // carry on through it.
+
+    jack_set_xrun_callback(
+        client,
+        [](void *arg) {
+            static_cast<AudioEngine *>(arg)->m_dspStats.countXrun();
+            return 0;
+        },
+        this);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prepareBuffers(m_periodFrames);
+    const size_t samples = static_cast<size_t>(kMaxJackFrames * m_channels);
+    m_jackMix.assign(samples, 0.0f);
+    for (size_t bus = 1; bus < m_jackBusMix.size(); ++bus) {
+        m_jackBusMix[bus].assign(samples, 0.0f);
+        m_busTaps[bus] = m_jackBusMix[bus].data();
+    }
+    startWorkers();
+    m_jackClient = client;
+    m_running = true;
+    if (jack_activate(client) != 0) {
+        m_running = false;
+        m_jackClient = nullptr;
+        m_workers.stop();
+        m_busTaps.fill(nullptr);
+        jack_client_close(client);
+        m_jackPorts.fill(nullptr);
+        m_available = false;
+        return false;
+    }
+
+    // Master goes to the first two hardware outputs unless GROOVEBOX_JACK_CONNECT=0; the bus
+    // ports are left for the user to patch.
+    bool connectSet = false;
+    const int connect = qEnvironmentVariableIntValue("GROOVEBOX_JACK_CONNECT", &connectSet);
+    if (!connectSet || connect != 0) {
+        const char **playback = jack_get_ports(client, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+                                               JackPortIsPhysical | JackPortIsInput);
+        if (playback) {
+            for (int i = 0; i < m_channels && playback[i]; ++i) {
+                jack_connect(client,
+                             jack_port_name(static_cast<jack_port_t *>(m_jackPorts[i])),
+                             playback[i]);
+            }
+            jack_free(playback);
+        }
+    }
+    m_activeDevice = QString::fromUtf8(jack_get_client_name(client));
+    m_available = true;
+    return true;
+}
+
+int AudioEngine::processJack(int frames) {
+    RtSafety::AudioThreadScope rtScope;
+    std::array<float *, 12> ports{};
+    for (size_t i = 0; i < ports.size(); ++i) {
+        ports[i] = static_cast<float *>(jack_port_get_buffer(
+            static_cast<jack_port_t *>(m_jackPorts[i]), static_cast<jack_nframes_t>(frames)));
+    }
+    if (frames * m_channels > static_cast<int>(m_jackMix.size())) {
+        // Longer than any period JACK allows; never expected.
+        for (float *port : ports) {
+            std::fill(port, port + frames, 0.0f);
+        }
+        return 0;
+    }
+
+    const auto mixBegin = std::chrono::steady_clock::now();
+    std::fill(m_jackMix.begin(), m_jackMix.begin() + frames * m_channels, 0.0f);
+    mix(m_jackMix.data(), frames);
+    for (int i = 0; i < frames; ++i) {
+        ports[0][i] = m_jackMix[static_cast<size_t>(i * m_channels)];
+        ports[1][i] = m_jackMix[static_cast<size_t>(i * m_channels + 1)];
+    }
+    for (size_t bus = 1; bus < m_jackBusMix.size(); ++bus) {
+        const float *src = m_jackBusMix[bus].data();
+        float *left = ports[bus * 2];
+        float *right = ports[bus * 2 + 1];
+        for (int i = 0; i < frames; ++i) {
+            left[i] = src[i * m_channels];
+            right[i] = src[i * m_channels + 1];
+        }
+    }
+    const long long mixNs = elapsedNs(mixBegin);
+    const double periodNs = 1.0e9 * frames / std::max(1, m_sampleRate);
+    m_workers.publishLoad(static_cast<double>(mixNs), periodNs);
+    m_dspStats.endPeriod(mixNs, periodNs);
+    return 0;
+}
+#endif
+
 void AudioEngine::stop() {
     if (!m_running) {
         return;
     }
 
-    m_running = false;
-    if (m_thread.joinable()) {
-        m_thread.join();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+#ifdef GROOVEBOX_WITH_JACK
+        if (m_jackClient) {
+            // Returns once the process callback has finished its last cycle.
+            jack_client_t *client = static_cast<jack_client_t *>(m_jackClient);
+            jack_deactivate(client);
+            jack_client_close(client);
+            m_jackClient = nullptr;
+            m_jackPorts.fill(nullptr);
+            m_busTaps.fill(nullptr);
+        }
+#endif
+        m_workers.stop();
+        // Nothing consumes the queues any more; apply what is left so the state stays coherent.
+        Command cmd;
+        while (m_commands.pop(cmd) || m_midiCommands.pop(cmd)) {
+            applyCommand(cmd);
+            cmd = Command();
+        }
+        collectRetired();
     }
 
 #ifdef GROOVEBOX_WITH_ALSA
@@ -462,21 +728,23 @@ bool AudioEngine::setAlsaDevice(const QString &device) {
 }
 #endif
 
-void AudioEngine::trigger(int padId, const std::shared_ptr<Buffer> &buffer, int startFrame,
-                          int endFrame, bool loop, float volume, float pan, float rate, int bus) {
-    if (!m_available || !buffer || !buffer->isValid()) {
-        return;
+bool AudioEngine::makeVoice(int padId, const std::shared_ptr<const Buffer> &buffer,
+                            const std::shared_ptr<const SampleStream> &stream, int startFrame,
+                            int endFrame, bool loop, float volume, float pan, float rate,
+                            int bus, Voice &voice) const {
+    if (!buffer || !buffer->isValid()) {
+        return false;
     }
 
     if (startFrame < 0) {
         startFrame = 0;
     }
-    const int totalFrames = buffer->frames();
+    const int totalFrames = stream ? stream->frames() : buffer->frames();
     if (endFrame <= 0 || endFrame > totalFrames) {
         endFrame = totalFrames;
     }
     if (startFrame >= endFrame) {
-        return;
+        return false;
     }
 
     rate = std::max(0.125f, std::min(4.0f, rate));
@@ -484,15 +752,12 @@ void AudioEngine::trigger(int padId, const std::shared_ptr<Buffer> &buffer, int
     float gainR = 1.0f;
     computePanGains(pan, volume, gainL, gainR);
 
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_voices.erase(std::remove_if(m_voices.begin(), m_voices.end(),
-                                  [padId](const Voice &voice) { return voice.padId == padId; }),
-                   m_voices.end());
-
-    Voice voice;
     voice.padId = padId;
     voice.bus = bus;
     voice.buffer = buffer;
+    voice.stream = stream;
+    voice.streamSlot = -1;
+    voice.streamPass = 0;
     voice.startFrame = startFrame;
     voice.endFrame = endFrame;
     voice.position = static_cast<double>(startFrame);
@@ -503,42 +768,95 @@ void AudioEngine::trigger(int padId, const std::shared_ptr<Buffer> &buffer, int
     voice.env = 0.0f;
     voice.envStage = EnvStage::Attack;
     voice.releaseRequested = false;
+    voice.choked = false;
     voice.useEnv = (padId >= 0);
-    m_voices.push_back(std::move(voice));
+    return true;
 }
 
-void AudioEngine::stopPad(int padId) {
+bool AudioEngine::trigger(int padId, const std::shared_ptr<const Buffer> &buffer,
+                          int startFrame, int endFrame, bool loop, float volume, float pan,
+                          float rate, int bus) {
     if (!m_available) {
-        return;
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::Trigger;
+    cmd.padId = padId;
+    if (!makeVoice(padId, buffer, nullptr, startFrame, endFrame, loop, volume, pan, rate, bus,
+                   cmd.voice)) {
+        return false;
     }
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    for (Voice &voice : m_voices) {
-        if (voice.padId == padId) {
-            voice.releaseRequested = true;
-            voice.loop = false;
-        }
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    if (padId >= 0 && padId < static_cast<int>(m_padActive.size())) {
+        m_padActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool AudioEngine::trigger(int padId, const std::shared_ptr<const SampleStream> &stream,
+                          int startFrame, int endFrame, bool loop, float volume, float pan,
+                          float rate, int bus) {
+    if (!m_available || !stream) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::Trigger;
+    cmd.padId = padId;
+    if (!makeVoice(padId, stream->head(), stream, startFrame, endFrame, loop, volume, pan, rate,
+                   bus, cmd.voice)) {
+        return false;
     }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prepareStreaming();
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    if (padId >= 0 && padId < static_cast<int>(m_padActive.size())) {
+        m_padActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
+    }
+    return true;
 }
 
-void AudioEngine::stopAll() {
+bool AudioEngine::stopPad(int padId) {
     if (!m_available) {
-        return;
+        return false;
     }
+    Command cmd;
+    cmd.type = Command::Type::StopPad;
+    cmd.padId = padId;
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_voices.clear();
+    return post(std::move(cmd));
 }
 
-bool AudioEngine::isPadActive(int padId) const {
+bool AudioEngine::stopAll() {
     if (!m_available) {
         return false;
     }
+    Command cmd;
+    cmd.type = Command::Type::StopAll;
     std::lock_guard<std::mutex> lock(m_mutex);
-    for (const Voice &voice : m_voices) {
-        if (voice.padId == padId) {
-            return true;
-        }
+    if (!post(std::move(cmd))) {
+        return false;
     }
-    return false;
+    for (auto &active : m_padActive) {
+        active.store(false, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool AudioEngine::isPadActive(int padId) const {
+    if (!m_available) {
+        return false;
+    }
+    if (padId < 0 || padId >= static_cast<int>(m_padActive.size())) {
+        return false;
+    }
+    return m_padActive[static_cast<size_t>(padId)].load(std::memory_order_relaxed);
 }
 
 float AudioEngine::padPlayhead(int padId) const {
@@ -551,38 +869,209 @@ float AudioEngine::padPlayhead(int padId) const {
     return m_padPlayheads[static_cast<size_t>(padId)].load(std::memory_order_relaxed);
 }
 
+bool AudioEngine::setSequencerPattern(const SeqPattern &pattern) {
+    if (!m_available) {
+        return false;
+    }
+    auto program = std::make_unique<SeqProgram>();
+    const int steps = std::max(1, pattern.steps);
+    program->steps.resize(static_cast<size_t>(steps));
+    std::array<const SeqEvent *, 8> synthMix{};
+    bool streams = false;
+    for (const SeqEvent &event : pattern.events) {
+        if (event.step < 0 || event.step >= steps) {
+            continue;
+        }
+        SeqStep step;
+        step.padId = event.padId;
+        if (event.synth) {
+            if (event.padId < 0 || event.padId >= static_cast<int>(m_synthStates.size()) ||
+                event.midiNote < 0 || event.midiNote > 127) {
+                continue;
+            }
+            step.synth = true;
+            step.midiNote = event.midiNote;
+            step.lengthFrames = std::max(1, event.lengthFrames);
+            if (!synthMix[static_cast<size_t>(event.padId)]) {
+                synthMix[static_cast<size_t>(event.padId)] = &event;
+            }
+        } else if (!makeVoice(event.padId, event.stream ? event.stream->head() : event.buffer,
+                              event.stream, event.startFrame, event.endFrame, event.loop,
+                              event.volume, event.pan, event.rate, event.bus, step.voice)) {
+            continue;
+        }
+        streams = streams || event.stream != nullptr;
+        program->steps[static_cast<size_t>(event.step)].push_back(std::move(step));
+    }
+    program->metronome = pattern.metronome;
+    program->atBar = pattern.atBar;
+    if (pattern.metronome) {
+        makeVoice(-1, pattern.click, nullptr, 0, 0, false, 0.6f, 0.0f, 1.0f, 0, program->click);
+        makeVoice(-1, pattern.accent, nullptr, 0, 0, false, 0.6f, 0.0f, 1.0f, 0,
+                  program->accent);
+    }
+
+    // Synth pads have to be live, with their mix set, before the first step reaches them.
+    for (size_t pad = 0; pad < synthMix.size(); ++pad) {
+        if (const SeqEvent *event = synthMix[pad]) {
+            setSynthEnabled(static_cast<int>(pad), true);
+            setSynthParams(static_cast<int>(pad), event->volume, event->pan, event->bus);
+        }
+    }
+
+    Command cmd;
+    cmd.type = Command::Type::SeqSetPattern;
+    cmd.seq = std::move(program);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (streams) {
+        prepareStreaming();
+    }
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    m_seqPattern = pattern;
+    return true;
+}
+
+bool AudioEngine::startSequencer(int step) {
+    if (!m_available) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SeqTransport;
+    cmd.arg1 = 1;
+    cmd.arg2 = std::max(0, step);
+    const int startStep = cmd.arg2;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    m_seqPlayStep.store(startStep, std::memory_order_relaxed);
+    m_seqStepPhase.store(0.0f, std::memory_order_relaxed);
+    m_seqRunningFlag.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioEngine::stopSequencer() {
+    if (!m_available) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SeqTransport;
+    cmd.arg1 = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    m_seqRunningFlag.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+void AudioEngine::releaseRetired() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    collectRetired();
+}
+
+void AudioEngine::renderOffline(float *out, int frames) {
+    if (!m_offline || frames <= 0) {
+        return;
+    }
+    std::fill(out, out + frames * m_channels, 0.0f);
+    mix(out, frames);
+    releaseRetired();
+}
+
+void AudioEngine::copyStateTo(AudioEngine &target) const {
+    std::array<float, 6> busGains{};
+    std::array<std::vector<EffectSettings>, 6> busEffects;
+    std::array<SynthControl, 8> synths;
+    std::array<std::array<uint8_t, kDx7VoiceParamCount>, 8> voiceParams{};
+    SeqPattern pattern;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        busEffects = m_busEffectSettings;
+        synths = m_synthControls;
+        pattern = m_seqPattern;
+    }
+    for (size_t bus = 0; bus < busGains.size(); ++bus) {
+        busGains[bus] = m_busGains[bus].load();
+    }
+    for (size_t pad = 0; pad < voiceParams.size(); ++pad) {
+        for (size_t i = 0; i < voiceParams[pad].size(); ++i) {
+            voiceParams[pad][i] = m_synthVoiceParams[pad][i].load(std::memory_order_relaxed);
+        }
+    }
+
+    target.setBpm(static_cast<int>(std::lround(m_bpm.load())));
+    target.setVoiceSteal(m_voiceSteal.load());
+    for (size_t bus = 0; bus < busGains.size(); ++bus) {
+        target.setBusGain(static_cast<int>(bus), busGains[bus]);
+        target.setBusEffects(static_cast<int>(bus), busEffects[bus]);
+    }
+    for (size_t i = 0; i < synths.size(); ++i) {
+        const int pad = static_cast<int>(i);
+        target.setPadAdsr(pad, m_padAttack[i].load(), m_padDecay[i].load(),
+                          m_padSustain[i].load(), m_padRelease[i].load());
+        target.setPadVoicing(pad, m_padPolyphony[i].load(), m_padChoke[i].load());
+        const SynthControl &control = synths[i];
+        target.setSynthKind(pad, control.kind);
+        target.setSynthVoices(pad, control.voices);
+        target.setFmParams(pad, control.fmParams);
+        target.setSynthParams(pad, control.volume, control.pan, control.bus);
+        if (control.kind == SynthKind::Dx7 && !control.coreDirty) {
+            if (control.bankLoaded) {
+                target.loadSynthSysex(pad, control.bankPath);
+                target.setSynthProgram(pad, control.programIndex);
+            }
+            // Carries over any per-parameter edits made on top of the program.
+            for (int param = 0; param < kDx7VoiceParamCount; ++param) {
+                target.setSynthVoiceParam(pad, param, voiceParams[i][static_cast<size_t>(param)]);
+            }
+        }
+        target.setSynthEnabled(pad, control.enabled);
+    }
+    target.setSequencerPattern(pattern);
+}
+
 void AudioEngine::setBusEffects(int bus, const std::vector<EffectSettings> &effects) {
     if (bus < 0 || bus >= static_cast<int>(m_busChains.size())) {
         return;
     }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    BusChain &chain = m_busChains[static_cast<size_t>(bus)];
-    chain.effects.clear();
+    Command cmd;
+    cmd.type = Command::Type::BusEffects;
+    cmd.arg1 = bus;
+    cmd.chain = std::make_unique<BusChain>();
+    cmd.chain->effects.reserve(effects.size());
+    bool busSidechain = false;
     for (const EffectSettings &cfg : effects) {
         if (cfg.type <= 0) {
             continue;
         }
         EffectState state;
         state.type = cfg.type;
-        state.p1 = cfg.p1;
-        state.p2 = cfg.p2;
-        state.p3 = cfg.p3;
-        state.p4 = cfg.p4;
-        state.p5 = cfg.p5;
-        chain.effects.push_back(std::move(state));
-    }
-    bool hasSidechain = false;
-    for (const auto &busChain : m_busChains) {
-        for (const auto &fx : busChain.effects) {
-            if (fx.type == 8) {
-                hasSidechain = true;
-                break;
-            }
+        state.params.p1 = safeParam(cfg.p1);
+        state.params.p2 = safeParam(cfg.p2);
+        state.params.p3 = safeParam(cfg.p3);
+        state.params.p4 = safeParam(cfg.p4);
+        state.params.p5 = safeParam(cfg.p5);
+        if (cfg.type == EffectKernels::Convolution) {
+            state.impulse = loadImpulse(cfg.impulse);
         }
-        if (hasSidechain) {
-            break;
+        prepareEffect(state);
+        cmd.chain->effects.push_back(std::move(state));
+        if (cfg.type == 8) {
+            busSidechain = true;
         }
     }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!post(std::move(cmd))) {
+        return;
+    }
+    m_busEffectSettings[static_cast<size_t>(bus)] = effects;
+    m_busSidechain[static_cast<size_t>(bus)] = busSidechain;
+    const bool hasSidechain =
+        std::any_of(m_busSidechain.begin(), m_busSidechain.end(), [](bool v) { return v; });
     m_hasSidechain.store(hasSidechain);
 }
 
@@ -605,90 +1094,61 @@ void AudioEngine::setBpm(int bpm) {
     m_bpm.store(static_cast<float>(next));
 }
 
-static bool writeWavFile(const QString &path, const std::vector<float> &samples,
-                         int srcRate, int targetRate, int channels) {
-    if (samples.empty() || channels <= 0) {
+bool AudioEngine::startRecording(const QString &path, int totalFrames, int targetSampleRate) {
+    if (path.isEmpty()) {
         return false;
     }
-    int srcFrames = static_cast<int>(samples.size() / channels);
-    if (srcFrames <= 0) {
+    stopRecordWriter();
+    auto writer = std::make_unique<WavStreamWriter>();
+    if (!writer->open(path, m_sampleRate, targetSampleRate, m_channels)) {
         return false;
     }
-    if (targetRate <= 0) {
-        targetRate = srcRate;
-    }
-    std::vector<float> resampled;
-    const float rateRatio = static_cast<float>(targetRate) / static_cast<float>(srcRate);
-    int dstFrames = srcFrames;
-    if (targetRate != srcRate) {
-        dstFrames = qMax(1, static_cast<int>(std::floor(srcFrames * rateRatio)));
-        resampled.resize(static_cast<size_t>(dstFrames * channels));
-        for (int i = 0; i < dstFrames; ++i) {
-            const float srcPos = i / rateRatio;
-            const int i0 = qBound(0, static_cast<int>(std::floor(srcPos)), srcFrames - 1);
-            const int i1 = qMin(srcFrames - 1, i0 + 1);
-            const float frac = srcPos - i0;
-            for (int ch = 0; ch < channels; ++ch) {
-                const float s0 = samples[static_cast<size_t>(i0 * channels + ch)];
-                const float s1 = samples[static_cast<size_t>(i1 * channels + ch)];
-                resampled[static_cast<size_t>(i * channels + ch)] = s0 + (s1 - s0) * frac;
+    if (m_recordRing.capacity() == 0) {
+        m_recordRing.reset(static_cast<size_t>(kRecordRingFrames * m_channels));
+    }
+    m_recordFramesLeft = totalFrames > 0 ? totalFrames : -1;
+    m_recordDropped.store(0);
+    m_recordStop.store(false);
+    m_recording.store(true, std::memory_order_release);
+
+    m_recordWriter = std::thread([this, writer = std::move(writer)]() {
+        std::vector<float> chunk(static_cast<size_t>(kRecordChunkFrames * m_channels));
+        while (true) {
+            // Read the flag first: once it is false every frame the audio thread wrote is
+            // already visible in the ring.
+            const bool active = m_recording.load(std::memory_order_acquire);
+            const size_t got = m_recordRing.read(chunk.data(), chunk.size());
+            if (got > 0) {
+                writer->write(chunk.data(), static_cast<int>(got / static_cast<size_t>(m_channels)));
+                continue;
+            }
+            if (!active) {
+                break;
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
-    } else {
-        resampled = samples;
-    }
+        writer->close();
+    });
+    return true;
+}
 
-    const int totalFrames = static_cast<int>(resampled.size() / channels);
-    QByteArray pcm;
-    pcm.resize(totalFrames * channels * 2);
-    int16_t *out = reinterpret_cast<int16_t *>(pcm.data());
-    for (int i = 0; i < totalFrames * channels; ++i) {
-        float v = resampled[static_cast<size_t>(i)];
-        v = std::max(-1.0f, std::min(1.0f, v));
-        out[i] = static_cast<int16_t>(v * 32767.0f);
+void AudioEngine::stopRecording() {
+    if (!m_recording.load()) {
+        return;
     }
-
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) {
-        return false;
+    m_recordStop.store(true);
+    if (!audioThreadActive()) {
+        // Nobody is mixing, so nobody else will end the take.
+        m_recording.store(false, std::memory_order_release);
     }
-    const int byteRate = targetRate * channels * 2;
-    const int blockAlign = channels * 2;
-    const int dataSize = pcm.size();
-    const int riffSize = 36 + dataSize;
-
-    QDataStream ds(&file);
-    ds.setByteOrder(QDataStream::LittleEndian);
-    ds.writeRawData("RIFF", 4);
-    ds << riffSize;
-    ds.writeRawData("WAVE", 4);
-    ds.writeRawData("fmt ", 4);
-    ds << 16;
-    ds << static_cast<quint16>(1);
-    ds << static_cast<quint16>(channels);
-    ds << static_cast<quint32>(targetRate);
-    ds << static_cast<quint32>(byteRate);
-    ds << static_cast<quint16>(blockAlign);
-    ds << static_cast<quint16>(16);
-    ds.writeRawData("data", 4);
-    ds << static_cast<quint32>(dataSize);
-    file.write(pcm);
-    file.close();
-    return true;
 }
 
-bool AudioEngine::startRecording(const QString &path, int totalFrames, int targetSampleRate) {
-    if (totalFrames <= 0 || path.isEmpty()) {
-        return false;
+void AudioEngine::stopRecordWriter() {
+    if (!m_recordWriter.joinable()) {
+        return;
     }
-    std::lock_guard<std::mutex> lock(m_recordMutex);
-    m_recordFloat.clear();
-    m_recordFloat.reserve(static_cast<size_t>(totalFrames * m_channels));
-    m_recordFramesLeft = totalFrames;
-    m_recordTargetRate = targetSampleRate;
-    m_recordPath = path;
-    m_recording.store(true);
-    return true;
+    stopRecording();
+    m_recordWriter.join();
 }
 
 void AudioEngine::setPadAdsr(int padId, float attack, float decay, float sustain, float release) {
@@ -701,32 +1161,41 @@ void AudioEngine::setPadAdsr(int padId, float attack, float decay, float sustain
     m_padRelease[static_cast<size_t>(padId)].store(qBound(0.0f, release, 1.0f));
 }
 
-void AudioEngine::setSynthEnabled(int padId, bool enabled) {
-    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+void AudioEngine::setPadVoicing(int padId, int polyphony, int chokeGroup) {
+    if (padId < 0 || padId >= static_cast<int>(m_padPolyphony.size())) {
         return;
     }
+    m_padPolyphony[static_cast<size_t>(padId)].store(qBound(1, polyphony, kMaxPolyphony));
+    m_padChoke[static_cast<size_t>(padId)].store(qBound(0, chokeGroup, kChokeGroups));
+}
+
+void AudioEngine::setVoiceSteal(VoiceSteal mode) {
+    m_voiceSteal.store(mode);
+}
+
+bool AudioEngine::setSynthEnabled(int padId, bool enabled) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return false;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    state.enabled = enabled;
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    if (enabled) {
+        // A core that does not get through stays dirty, which keeps the pad from going live.
+        ensureSynthCore(padId);
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthEnable;
+    cmd.padId = padId;
+    cmd.arg1 = enabled ? 1 : 0;
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    control.enabled = enabled;
     if (!enabled) {
-        for (size_t n = 0; n < state.activeNotes.size(); ++n) {
-            if (state.activeNotes[n]) {
-                if (state.kind == SynthKind::Simple) {
-                    state.simple.noteOff(static_cast<int>(n));
-                } else if (state.kind == SynthKind::Dx7) {
-                    state.core.noteOff(static_cast<int>(n));
-                } else if (state.op1) {
-                    state.op1->noteOff(static_cast<int>(n));
-                }
-                state.activeNotes[n] = false;
-            }
-        }
-        state.env = 0.0f;
-        state.envStage = EnvStage::Attack;
-        state.releaseRequested = false;
-    } else {
-        ensureSynthInit(state);
+        m_synthActive[static_cast<size_t>(padId)].store(false, std::memory_order_relaxed);
     }
+    publishSynthLive(padId);
+    return true;
 }
 
 void AudioEngine::setSynthKind(int padId, SynthKind kind) {
@@ -734,110 +1203,77 @@ void AudioEngine::setSynthKind(int padId, SynthKind kind) {
         return;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (state.kind == kind) {
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    if (control.kind == kind) {
         return;
     }
-    state.kind = kind;
-    state.initialized = false;
-    state.bankLoaded = false;
-    state.op1.reset();
-    state.op1Kind = SynthKind::Dx7;
-    state.env = 0.0f;
-    state.envStage = EnvStage::Attack;
-    state.releaseRequested = false;
-    state.lfoPhase = 0.0f;
-    state.filterIc1L = 0.0f;
-    state.filterIc2L = 0.0f;
-    state.filterIc1R = 0.0f;
-    state.filterIc2R = 0.0f;
-    state.filterIc1LModules.fill(0.0f);
-    state.filterIc2LModules.fill(0.0f);
-    state.filterIc1RModules.fill(0.0f);
-    state.filterIc2RModules.fill(0.0f);
-    state.lfoPhaseModules.fill(0.0f);
-    state.lfoHoldModules.fill(0.0f);
-    state.envValues.fill(0.0f);
-    state.envReleaseRequested.fill(false);
-    for (bool &note : state.activeNotes) {
-        note = false;
-    }
-    if (state.enabled) {
-        ensureSynthInit(state);
-    }
-}
-
-void AudioEngine::setSynthParams(int padId, float volume, float pan, int bus) {
+    control.kind = kind;
+    control.coreDirty = true;
+    control.resetOnSwap = true;
+    control.bankLoaded = false;
+    if (control.enabled) {
+        ensureSynthCore(padId);
+    }
+    publishSynthLive(padId);
+}
+
+bool AudioEngine::setSynthParams(int padId, float volume, float pan, int bus) {
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
-        return;
+        return false;
     }
-    float gainL = 1.0f;
-    float gainR = 1.0f;
-    computePanGains(pan, volume, gainL, gainR);
+    Command cmd;
+    cmd.type = Command::Type::SynthMix;
+    cmd.padId = padId;
+    computePanGains(pan, volume, cmd.gainL, cmd.gainR);
+    cmd.arg1 = std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), bus));
+    const int clampedBus = cmd.arg1;
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    state.gainL = gainL;
-    state.gainR = gainR;
-    state.bus = std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), bus));
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    control.volume = volume;
+    control.pan = pan;
+    control.bus = clampedBus;
+    return true;
 }
 
-void AudioEngine::setFmParams(int padId, const FmParams &params) {
+bool AudioEngine::setFmParams(int padId, const FmParams &params) {
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
-        return;
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthFmParams;
+    cmd.padId = padId;
+    cmd.fmParams = std::make_unique<FmParams>(params);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    m_synthControls[static_cast<size_t>(padId)].fmParams = params;
+    return true;
+}
+
+bool AudioEngine::setSynthMacro(int padId, int macro, float value) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return false;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    state.fmParams = params;
-    state.filterCutoff = params.cutoff;
-    state.filterResonance = params.resonance;
-    state.filterType = params.filterType;
-    state.filterEnvAmount = params.filterEnv;
-    state.lfoRate = params.lfoRate;
-    state.lfoDepth = params.lfoDepth;
-    state.lfoShape = params.lfoShape;
-    state.lfoSync = params.lfoSync;
-    state.lfoSyncIndex = params.lfoSyncIndex;
-    state.lfoTarget = params.lfoTarget;
-    for (int i = 0; i < kLfoModuleCount; ++i) {
-        if (!params.lfoModules[static_cast<size_t>(i)].enabled) {
-            state.lfoPhaseModules[static_cast<size_t>(i)] = 0.0f;
-            state.lfoHoldModules[static_cast<size_t>(i)] = 0.0f;
-        }
-    }
-    for (int i = 0; i < kEnvModuleCount; ++i) {
-        if (!params.envModules[static_cast<size_t>(i)].enabled) {
-            state.envValues[static_cast<size_t>(i)] = 0.0f;
-            state.envStages[static_cast<size_t>(i)] = EnvStage::Attack;
-            state.envReleaseRequested[static_cast<size_t>(i)] = false;
-        }
-    }
-    for (int i = 0; i < kFilterModuleCount; ++i) {
-        if (!params.filterModules[static_cast<size_t>(i)].enabled) {
-            state.filterIc1LModules[static_cast<size_t>(i)] = 0.0f;
-            state.filterIc2LModules[static_cast<size_t>(i)] = 0.0f;
-            state.filterIc1RModules[static_cast<size_t>(i)] = 0.0f;
-            state.filterIc2RModules[static_cast<size_t>(i)] = 0.0f;
-        }
-    }
-    SimpleFmCore::Params simpleParams;
-    simpleParams.fmAmount = params.fmAmount;
-    simpleParams.ratio = params.ratio;
-    simpleParams.feedback = params.feedback;
-    simpleParams.octave = params.octave;
-    simpleParams.osc1Wave = params.osc1Wave;
-    simpleParams.osc2Wave = params.osc2Wave;
-    simpleParams.osc1Voices = params.osc1Voices;
-    simpleParams.osc2Voices = params.osc2Voices;
-    simpleParams.osc1Detune = params.osc1Detune;
-    simpleParams.osc2Detune = params.osc2Detune;
-    simpleParams.osc1Gain = params.osc1Gain;
-    simpleParams.osc2Gain = params.osc2Gain;
-    simpleParams.osc1Pan = params.osc1Pan;
-    simpleParams.osc2Pan = params.osc2Pan;
-    state.simple.setParams(simpleParams);
-    if (state.op1) {
-        state.op1->setParams(toOp1Params(params));
+    FmParams &params = m_synthControls[static_cast<size_t>(padId)].fmParams;
+    if (macro < 0 || macro >= static_cast<int>(params.macros.size())) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthFmParams;
+    cmd.padId = padId;
+    cmd.fmParams = std::make_unique<FmParams>(params);
+    const float clamped = qBound(0.0f, value, 1.0f);
+    cmd.fmParams->macros[static_cast<size_t>(macro)] = clamped;
+    if (!post(std::move(cmd))) {
+        return false;
     }
+    params.macros[static_cast<size_t>(macro)] = clamped;
+    return true;
 }
 
 void AudioEngine::setSynthVoices(int padId, int voices) {
@@ -846,57 +1282,46 @@ void AudioEngine::setSynthVoices(int padId, int voices) {
     }
     voices = std::max(1, std::min(16, voices));
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (state.voices == voices) {
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    if (control.voices == voices) {
         return;
     }
-    state.voices = voices;
-    state.initialized = false;
-    state.bankLoaded = false;
-    if (state.enabled) {
-        ensureSynthInit(state);
+    control.voices = voices;
+    control.coreDirty = true;
+    control.bankLoaded = false;
+    if (control.enabled) {
+        ensureSynthCore(padId);
     }
+    publishSynthLive(padId);
 }
 
-void AudioEngine::synthNoteOn(int padId, int midiNote, int velocity) {
+bool AudioEngine::synthNoteOn(int padId, int midiNote, int velocity, int lengthFrames) {
     if (!m_available) {
-        return;
+        return false;
     }
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
-        return;
+        return false;
     }
     if (midiNote < 0 || midiNote > 127) {
-        return;
+        return false;
     }
     velocity = std::max(1, std::min(127, velocity));
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (!state.enabled) {
-        return;
+    if (!m_synthControls[static_cast<size_t>(padId)].enabled) {
+        return false;
     }
-    const bool hadActive =
-        std::any_of(state.activeNotes.begin(), state.activeNotes.end(), [](bool v) { return v; });
-    ensureSynthInit(state);
-    if (state.kind == SynthKind::Simple) {
-        state.simple.noteOn(midiNote, velocity);
-    } else if (state.kind == SynthKind::Dx7) {
-        state.core.noteOn(midiNote, velocity);
-    } else if (state.op1) {
-        state.op1->noteOn(midiNote, velocity);
-    }
-    state.activeNotes[static_cast<size_t>(midiNote)] = true;
-    if (!hadActive || state.envStage == EnvStage::Release) {
-        state.envStage = EnvStage::Attack;
-        state.releaseRequested = false;
-        for (int i = 0; i < kEnvModuleCount; ++i) {
-            if (!state.fmParams.envModules[static_cast<size_t>(i)].enabled) {
-                continue;
-            }
-            state.envStages[static_cast<size_t>(i)] = EnvStage::Attack;
-            state.envReleaseRequested[static_cast<size_t>(i)] = false;
-            state.envValues[static_cast<size_t>(i)] = 0.0f;
-        }
+    ensureSynthCore(padId);
+    Command cmd;
+    cmd.type = Command::Type::SynthNoteOn;
+    cmd.padId = padId;
+    cmd.arg1 = midiNote;
+    cmd.arg2 = velocity;
+    cmd.arg3 = std::max(0, lengthFrames);
+    if (!post(std::move(cmd))) {
+        return false;
     }
+    m_synthActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
+    return true;
 }
 
 void AudioEngine::synthNoteOff(int padId, int midiNote) {
@@ -910,27 +1335,15 @@ void AudioEngine::synthNoteOff(int padId, int midiNote) {
         return;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (!state.enabled) {
+    if (!m_synthControls[static_cast<size_t>(padId)].enabled) {
         return;
     }
-    ensureSynthInit(state);
-    if (state.kind == SynthKind::Simple) {
-        state.simple.noteOff(midiNote);
-    } else if (state.kind == SynthKind::Dx7) {
-        state.core.noteOff(midiNote);
-    } else if (state.op1) {
-        state.op1->noteOff(midiNote);
-    }
-    state.activeNotes[static_cast<size_t>(midiNote)] = false;
-    const bool hasActive =
-        std::any_of(state.activeNotes.begin(), state.activeNotes.end(), [](bool v) { return v; });
-    if (!hasActive) {
-        state.releaseRequested = true;
-        for (int i = 0; i < kEnvModuleCount; ++i) {
-            state.envReleaseRequested[static_cast<size_t>(i)] = true;
-        }
-    }
+    ensureSynthCore(padId);
+    Command cmd;
+    cmd.type = Command::Type::SynthNoteOff;
+    cmd.padId = padId;
+    cmd.arg1 = midiNote;
+    post(std::move(cmd));
 }
 
 void AudioEngine::synthAllNotesOff(int padId) {
@@ -941,71 +1354,171 @@ void AudioEngine::synthAllNotesOff(int padId) {
         return;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (!state.enabled) {
+    if (!m_synthControls[static_cast<size_t>(padId)].enabled) {
         return;
     }
-    ensureSynthInit(state);
-    for (size_t n = 0; n < state.activeNotes.size(); ++n) {
-        if (state.activeNotes[n]) {
-            if (state.kind == SynthKind::Simple) {
-                state.simple.noteOff(static_cast<int>(n));
-            } else if (state.kind == SynthKind::Dx7) {
-                state.core.noteOff(static_cast<int>(n));
-            } else if (state.op1) {
-                state.op1->noteOff(static_cast<int>(n));
-            }
-            state.activeNotes[n] = false;
-        }
+    ensureSynthCore(padId);
+    Command cmd;
+    cmd.type = Command::Type::SynthAllNotesOff;
+    cmd.padId = padId;
+    post(std::move(cmd));
+}
+
+bool AudioEngine::midiTrigger(int padId, const std::shared_ptr<const Buffer> &buffer,
+                              int startFrame, int endFrame, bool loop, float volume, float pan,
+                              float rate, int bus) {
+    if (padId < 0 || padId >= static_cast<int>(m_padActive.size())) {
+        return true;
+    }
+    Command cmd;
+    cmd.type = Command::Type::Trigger;
+    cmd.padId = padId;
+    if (!makeVoice(padId, buffer, nullptr, startFrame, endFrame, loop, volume, pan, rate, bus,
+                   cmd.voice)) {
+        return true;
     }
-    state.releaseRequested = true;
-    for (int i = 0; i < kEnvModuleCount; ++i) {
-        state.envReleaseRequested[static_cast<size_t>(i)] = true;
+    if (!postMidi(std::move(cmd))) {
+        return false;
     }
+    m_padActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
+    return true;
 }
 
-bool AudioEngine::loadSynthSysex(int padId, const QString &path) {
-    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+bool AudioEngine::midiTrigger(int padId, const std::shared_ptr<const SampleStream> &stream,
+                              int startFrame, int endFrame, bool loop, float volume, float pan,
+                              float rate, int bus) {
+    if (padId < 0 || padId >= static_cast<int>(m_padActive.size()) || !stream) {
+        return true;
+    }
+    // The reader is started under m_mutex by the first locked stream trigger.
+    if (!m_streamRunning.load()) {
         return false;
     }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    const QString prevPath = state.bankPath;
-    state.bankPath = path;
-    if (path.isEmpty()) {
-        state.bankLoaded = false;
+    Command cmd;
+    cmd.type = Command::Type::Trigger;
+    cmd.padId = padId;
+    if (!makeVoice(padId, stream->head(), stream, startFrame, endFrame, loop, volume, pan, rate,
+                   bus, cmd.voice)) {
+        return true;
+    }
+    if (!postMidi(std::move(cmd))) {
         return false;
     }
-    const bool wasInitialized = state.initialized;
-    ensureSynthInit(state);
-    if (wasInitialized && (prevPath != path || !state.bankLoaded)) {
-        state.bankLoaded = state.core.loadSysexFile(path.toStdString());
+    m_padActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioEngine::midiStopPad(int padId) {
+    Command cmd;
+    cmd.type = Command::Type::StopPad;
+    cmd.padId = padId;
+    return postMidi(std::move(cmd));
+}
+
+bool AudioEngine::midiSynthNoteOn(int padId, int midiNote, int velocity, int lengthFrames,
+                                  float volume, float pan, int bus) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return true;
+    }
+    if (midiNote < 0 || midiNote > 127) {
+        return true;
     }
-    if (!state.bankLoaded) {
+    if (!m_synthLive[static_cast<size_t>(padId)].load(std::memory_order_acquire)) {
         return false;
     }
-    const int count = state.core.programCount();
-    if (count > 0) {
-        state.programIndex = qBound(0, state.programIndex, count - 1);
-        state.core.selectProgram(state.programIndex);
+    Command mix;
+    mix.type = Command::Type::SynthMix;
+    mix.padId = padId;
+    computePanGains(pan, volume, mix.gainL, mix.gainR);
+    mix.arg1 = std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), bus));
+    Command cmd;
+    cmd.type = Command::Type::SynthNoteOn;
+    cmd.padId = padId;
+    cmd.arg1 = midiNote;
+    cmd.arg2 = std::max(1, std::min(127, velocity));
+    cmd.arg3 = std::max(0, lengthFrames);
+    // A mix applied without its note is harmless; the replay sends both again.
+    if (!postMidi(std::move(mix)) || !postMidi(std::move(cmd))) {
+        return false;
     }
+    m_synthActive[static_cast<size_t>(padId)].store(true, std::memory_order_relaxed);
     return true;
 }
 
+bool AudioEngine::midiSynthNoteOff(int padId, int midiNote) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return true;
+    }
+    if (midiNote < 0 || midiNote > 127) {
+        return true;
+    }
+    if (!m_synthLive[static_cast<size_t>(padId)].load(std::memory_order_acquire)) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthNoteOff;
+    cmd.padId = padId;
+    cmd.arg1 = midiNote;
+    return postMidi(std::move(cmd));
+}
+
+bool AudioEngine::midiSynthMacro(int padId, int macro, float value) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return true;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthMacro;
+    cmd.padId = padId;
+    cmd.arg1 = macro;
+    cmd.gainL = qBound(0.0f, value, 1.0f);
+    return postMidi(std::move(cmd));
+}
+
+bool AudioEngine::loadSynthSysex(int padId, const QString &path) {
+    if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    const QString prevPath = control.bankPath;
+    control.bankPath = path;
+    if (path.isEmpty()) {
+        control.bankLoaded = false;
+        return false;
+    }
+    if (prevPath != path || !control.bankLoaded) {
+        control.coreDirty = true;
+    }
+    ensureSynthCore(padId);
+    publishSynthLive(padId);
+    return control.bankLoaded;
+}
+
 bool AudioEngine::setSynthProgram(int padId, int program) {
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
         return false;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    state.programIndex = std::max(0, program);
-    ensureSynthInit(state);
-    const int count = state.core.programCount();
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    const int prevProgram = control.programIndex;
+    // A rebuilt core selects control.programIndex itself.
+    control.programIndex = std::max(0, program);
+    ensureSynthCore(padId);
+    const int count = control.programNames.size();
     if (count <= 0) {
         return false;
     }
-    state.programIndex = qBound(0, state.programIndex, count - 1);
-    return state.core.selectProgram(state.programIndex);
+    Command cmd;
+    cmd.type = Command::Type::SynthProgram;
+    cmd.padId = padId;
+    cmd.arg1 = qBound(0, control.programIndex, count - 1);
+    const int nextProgram = cmd.arg1;
+    if (!post(std::move(cmd))) {
+        control.programIndex = prevProgram;
+        return false;
+    }
+    control.programIndex = nextProgram;
+    return true;
 }
 
 int AudioEngine::synthProgramCount(int padId) const {
@@ -1013,8 +1526,7 @@ int AudioEngine::synthProgramCount(int padId) const {
         return 0;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    const SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    return state.core.programCount();
+    return m_synthControls[static_cast<size_t>(padId)].programNames.size();
 }
 
 QString AudioEngine::synthProgramName(int padId, int index) const {
@@ -1022,17 +1534,18 @@ QString AudioEngine::synthProgramName(int padId, int index) const {
         return QString();
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    const SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    return QString::fromUtf8(state.core.programName(index));
+    return m_synthControls[static_cast<size_t>(padId)].programNames.value(index);
 }
 
 int AudioEngine::synthVoiceParam(int padId, int param) const {
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
         return 0;
     }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    const SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    return state.core.voiceParam(param);
+    if (param < 0 || param >= kDx7VoiceParamCount) {
+        return 0;
+    }
+    return m_synthVoiceParams[static_cast<size_t>(padId)][static_cast<size_t>(param)].load(
+        std::memory_order_relaxed);
 }
 
 bool AudioEngine::setSynthVoiceParam(int padId, int param, int value) {
@@ -1040,26 +1553,28 @@ bool AudioEngine::setSynthVoiceParam(int padId, int param, int value) {
         return false;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    ensureSynthInit(state);
-    return state.core.setVoiceParam(param, value);
+    ensureSynthCore(padId);
+    if (param < 0 || param >= kDx7VoiceParamCount) {
+        return false;
+    }
+    Command cmd;
+    cmd.type = Command::Type::SynthVoiceParam;
+    cmd.padId = padId;
+    cmd.arg1 = param;
+    cmd.arg2 = value;
+    if (!post(std::move(cmd))) {
+        return false;
+    }
+    m_synthVoiceParams[static_cast<size_t>(padId)][static_cast<size_t>(param)].store(
+        static_cast<uint8_t>(qBound(0, value, 255)), std::memory_order_relaxed);
+    return true;
 }
 
 bool AudioEngine::isSynthActive(int padId) const {
     if (padId < 0 || padId >= static_cast<int>(m_synthStates.size())) {
         return false;
     }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    const SynthState &state = m_synthStates[static_cast<size_t>(padId)];
-    if (!state.enabled) {
-        return false;
-    }
-    for (bool active : state.activeNotes) {
-        if (active) {
-            return true;
-        }
-    }
-    return state.env > 0.0005f;
+    return m_synthActive[static_cast<size_t>(padId)].load(std::memory_order_relaxed);
 }
 
 void AudioEngine::run() {
@@ -1068,26 +1583,106 @@ void AudioEngine::run() {
     if (!pcm) {
         return;
     }
+    const RtScheduling::Config &rt = RtScheduling::config();
+    RtScheduling::enterRealtime(rt.priority, rt.cpus.empty() ? -1 : rt.cpus.front());
+    RtScheduling::prefaultStack();
 
     const int framesPerPeriod = std::max(1, m_periodFrames);
+    const snd_pcm_format_t format = static_cast<snd_pcm_format_t>(m_pcmFormat);
+    // Float devices take the mix as is; integer ones get it through this block.
     std::vector<float> mixBuffer(framesPerPeriod * m_channels, 0.0f);
-    std::vector<int16_t> out(framesPerPeriod * m_channels, 0);
-
-    while (m_running) {
-        std::fill(mixBuffer.begin(), mixBuffer.end(), 0.0f);
-        mix(mixBuffer.data(), framesPerPeriod);
+    // Sized for the widest integer format; the write path converts into it.
+    std::vector<int32_t> out(m_pcmMmap ? 0 : framesPerPeriod * m_channels, 0);
+
+    // Mixes frames into dst in the device format, directly when it is float.
+    auto render = [&](void *dst, int frames) {
+        RtSafety::AudioThreadScope rtScope;
+        const auto mixBegin = std::chrono::steady_clock::now();
+        const int samples = frames * m_channels;
+        if (format == SND_PCM_FORMAT_FLOAT_LE) {
+            float *samplesOut = static_cast<float *>(dst);
+            mix(samplesOut, frames);
+            for (int i = 0; i < samples; ++i) {
+                samplesOut[i] = clampSample(samplesOut[i]);
+            }
+        } else {
+            mix(mixBuffer.data(), frames);
+            if (format == SND_PCM_FORMAT_S32_LE) {
+                int32_t *samplesOut = static_cast<int32_t *>(dst);
+                for (int i = 0; i < samples; ++i) {
+                    samplesOut[i] = static_cast<int32_t>(
+                        static_cast<double>(clampSample(mixBuffer[i])) * 2147483647.0);
+                }
+            } else {
+                int16_t *samplesOut = static_cast<int16_t *>(dst);
+                for (int i = 0; i < samples; ++i) {
+                    samplesOut[i] = static_cast<int16_t>(clampSample(mixBuffer[i]) * 32767.0f);
+                }
+            }
+        }
+        const long long mixNs = elapsedNs(mixBegin);
+        const double periodNs = 1.0e9 * frames / std::max(1, m_sampleRate);
+        m_workers.publishLoad(static_cast<double>(mixNs), periodNs);
+        m_dspStats.endPeriod(mixNs, periodNs);
+    };
 
-        for (int i = 0; i < framesPerPeriod * m_channels; ++i) {
-            const float v = clampSample(mixBuffer[i]);
-            out[i] = static_cast<int16_t>(v * 32767.0f);
+    if (m_pcmMmap) {
+        while (m_running) {
+            const snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+            if (avail < 0) {
+                m_dspStats.countXrun();
+                if (snd_pcm_recover(pcm, static_cast<int>(avail), 1) < 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                continue;
+            }
+            if (avail < framesPerPeriod) {
+                // A freshly prepared stream only starts once its ring has been filled.
+                if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED) {
+                    snd_pcm_start(pcm);
+                } else {
+                    const int waited = snd_pcm_wait(pcm, 100);
+                    if (waited < 0) {
+                        m_dspStats.countXrun();
+                        snd_pcm_recover(pcm, waited, 1);
+                    }
+                }
+                continue;
+            }
+            // The ring can wrap inside the period; each contiguous piece is mixed on its own.
+            const snd_pcm_channel_area_t *areas = nullptr;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t frames = static_cast<snd_pcm_uframes_t>(framesPerPeriod);
+            const int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+            if (err < 0) {
+                m_dspStats.countXrun();
+                snd_pcm_recover(pcm, err, 1);
+                continue;
+            }
+            char *base = static_cast<char *>(areas[0].addr) + areas[0].first / 8 +
+                         offset * (areas[0].step / 8);
+            render(base, static_cast<int>(frames));
+            const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+            if (committed < 0 || static_cast<snd_pcm_uframes_t>(committed) != frames) {
+                m_dspStats.countXrun();
+                snd_pcm_recover(pcm, committed < 0 ? static_cast<int>(committed) : -EPIPE, 1);
+            }
         }
+        return;
+    }
+
+    while (m_running) {
+        render(out.data(), framesPerPeriod);
 
+        const int frameBytes = snd_pcm_format_physical_width(format) / 8 * m_channels;
+        const char *bytes = reinterpret_cast<const char *>(out.data());
         int framesLeft = framesPerPeriod;
         int offset = 0;
         while (framesLeft > 0 && m_running) {
-            const snd_pcm_sframes_t written = snd_pcm_writei(
-                pcm, out.data() + offset * m_channels, framesLeft);
+            const snd_pcm_sframes_t written =
+                snd_pcm_writei(pcm, bytes + offset * frameBytes, framesLeft);
             if (written < 0) {
+                m_dspStats.countXrun();
                 const int err = snd_pcm_recover(pcm, static_cast<int>(written), 1);
                 if (err < 0) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
@@ -1101,1263 +1696,1757 @@ void AudioEngine::run() {
 #endif
 }
 
-void AudioEngine::ensureSynthInit(SynthState &state) {
-    if (state.initialized) {
-        return;
-    }
-    if (state.kind == SynthKind::Simple) {
-        state.simple.init(m_sampleRate, state.voices);
+std::unique_ptr<AudioEngine::SynthCore> AudioEngine::buildSynthCore(
+    const SynthControl &control) const {
+    auto engine = std::make_unique<SynthCore>();
+    engine->kind = control.kind;
+    if (control.kind == SynthKind::Simple) {
+        engine->simple.init(m_sampleRate, control.voices);
         SimpleFmCore::Params simpleParams;
         simpleParams.fmAmount = 0.0f;
         simpleParams.ratio = 1.0f;
         simpleParams.feedback = 0.0f;
-        simpleParams.octave = state.fmParams.octave;
-        simpleParams.osc1Wave = state.fmParams.osc1Wave;
-        simpleParams.osc2Wave = state.fmParams.osc2Wave;
-        simpleParams.osc1Voices = state.fmParams.osc1Voices;
-        simpleParams.osc2Voices = state.fmParams.osc2Voices;
-        simpleParams.osc1Detune = state.fmParams.osc1Detune;
-        simpleParams.osc2Detune = state.fmParams.osc2Detune;
-        simpleParams.osc1Gain = state.fmParams.osc1Gain;
-        simpleParams.osc2Gain = state.fmParams.osc2Gain;
+        simpleParams.octave = control.fmParams.octave;
+        simpleParams.osc1Wave = control.fmParams.osc1Wave;
+        simpleParams.osc2Wave = control.fmParams.osc2Wave;
+        simpleParams.osc1Voices = control.fmParams.osc1Voices;
+        simpleParams.osc2Voices = control.fmParams.osc2Voices;
+        simpleParams.osc1Detune = control.fmParams.osc1Detune;
+        simpleParams.osc2Detune = control.fmParams.osc2Detune;
+        simpleParams.osc1Gain = control.fmParams.osc1Gain;
+        simpleParams.osc2Gain = control.fmParams.osc2Gain;
         simpleParams.osc1Pan = 0.0f;
         simpleParams.osc2Pan = 0.0f;
-        state.simple.setParams(simpleParams);
-        state.initialized = true;
-        return;
+        engine->simple.setParams(simpleParams);
+        return engine;
     }
 
-    if (isCustomKind(state.kind)) {
-        if (!state.op1 || state.op1Kind != state.kind) {
-            state.op1 = createOp1Engine(op1TypeFromKind(state.kind));
-            state.op1Kind = state.kind;
-        }
-        if (state.op1) {
-            state.op1->init(m_sampleRate, state.voices);
-            state.op1->setParams(toOp1Params(state.fmParams));
-            state.initialized = true;
-            return;
+    if (isCustomKind(control.kind)) {
+        engine->op1 = createOp1Engine(op1TypeFromKind(control.kind));
+        if (engine->op1) {
+            engine->op1->init(m_sampleRate, control.voices);
+            engine->op1->setParams(toOp1Params(control.fmParams));
+            return engine;
         }
+        engine->kind = SynthKind::Dx7;
     }
 
-    state.core.init(m_sampleRate, state.voices);
-    state.initialized = true;
-    state.bankLoaded = false;
-    if (!state.bankPath.isEmpty()) {
-        state.bankLoaded = state.core.loadSysexFile(state.bankPath.toStdString());
-        if (state.bankLoaded) {
-            const int count = state.core.programCount();
-            if (count > 0) {
-                state.programIndex = qBound(0, state.programIndex, count - 1);
-                state.core.selectProgram(state.programIndex);
+    engine->core.init(m_sampleRate, control.voices);
+    return engine;
+}
+
+void AudioEngine::ensureSynthCore(int padId) {
+    SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    if (!control.coreDirty) {
+        return;
+    }
+    std::unique_ptr<SynthCore> engine = buildSynthCore(control);
+    control.bankLoaded = false;
+    control.programNames.clear();
+    if (engine->kind == SynthKind::Dx7) {
+        if (!control.bankPath.isEmpty()) {
+            control.bankLoaded = engine->core.loadSysexFile(control.bankPath.toStdString());
+        }
+        const int count = engine->core.programCount();
+        if (count > 0) {
+            if (control.bankLoaded) {
+                control.programIndex = qBound(0, control.programIndex, count - 1);
+                engine->core.selectProgram(control.programIndex);
+            }
+            for (int i = 0; i < count; ++i) {
+                control.programNames << QString::fromUtf8(engine->core.programName(i));
             }
         }
     }
+    publishVoiceParams(padId, *engine);
+
+    Command cmd;
+    cmd.type = Command::Type::SynthSwapCore;
+    cmd.padId = padId;
+    cmd.arg1 = control.resetOnSwap ? 1 : 0;
+    cmd.core = std::move(engine);
+    if (!post(std::move(cmd))) {
+        // Still dirty, so the next change builds and posts the core again.
+        return;
+    }
+    control.coreDirty = false;
+    control.resetOnSwap = false;
 }
 
-void AudioEngine::mix(float *out, int frames) {
-    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
-    if (!lock.owns_lock()) {
-        if (m_lastOutValid && static_cast<int>(m_lastOut.size()) == frames * m_channels) {
-            std::copy(m_lastOut.begin(), m_lastOut.end(), out);
-        } else {
-            std::fill(out, out + frames * m_channels, 0.0f);
+void AudioEngine::publishSynthLive(int padId) {
+    const SynthControl &control = m_synthControls[static_cast<size_t>(padId)];
+    // Callers publish once the core and the enable are both posted; release pairs with the
+    // MIDI thread's acquire, so its note is queued after them.
+    m_synthLive[static_cast<size_t>(padId)].store(control.enabled && !control.coreDirty,
+                                                  std::memory_order_release);
+}
+
+void AudioEngine::publishVoiceParams(int padId, const SynthCore &core) {
+    auto &params = m_synthVoiceParams[static_cast<size_t>(padId)];
+    for (int i = 0; i < kDx7VoiceParamCount; ++i) {
+        params[static_cast<size_t>(i)].store(static_cast<uint8_t>(core.core.voiceParam(i)),
+                                             std::memory_order_relaxed);
+    }
+}
+
+bool AudioEngine::post(Command &&cmd) {
+    collectRetired();
+    if (!audioThreadActive()) {
+        // No audio thread to hand off to; apply on the caller's thread.
+        applyCommand(cmd);
+        return true;
+    }
+    // A full queue means the audio thread is behind; give it a few periods to catch up before
+    // giving up. push() leaves cmd alone when it fails, so the payload is freed here.
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(kPostTimeoutMs);
+    while (!m_commands.push(std::move(cmd))) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            std::fprintf(stderr, "GrooveBox audio: command queue full, command dropped\n");
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        collectRetired();
+    }
+    return true;
+}
+
+bool AudioEngine::postMidi(Command &&cmd) {
+    // Never waits on a full queue; the caller replays the event instead.
+    return m_running.load() && m_midiCommands.push(std::move(cmd));
+}
+
+void AudioEngine::collectRetired() {
+    Command retired;
+    while (m_retired.pop(retired)) {
+        retired = Command();
+    }
+}
+
+void AudioEngine::drainCommands() {
+    Command cmd;
+    while (m_commands.pop(cmd)) {
+        runCommand(cmd);
+    }
+    Command earlier;
+    while (m_midiCommands.pop(cmd)) {
+        // A MIDI note may rely on a core the GUI posted just before it; apply that first.
+        while (m_commands.pop(earlier)) {
+            runCommand(earlier);
         }
+        runCommand(cmd);
+    }
+    flushRetireOverflow();
+}
+
+void AudioEngine::runCommand(Command &cmd) {
+    applyCommand(cmd);
+    const bool ownsPayload = cmd.voice.buffer || cmd.fmParams || cmd.core || cmd.chain || cmd.seq;
+    if (ownsPayload) {
+        // Hand anything that may free memory back to the control thread.
+        retire(std::move(cmd));
+    }
+    cmd.type = Command::Type::None;
+}
+
+void AudioEngine::retire(Command &&cmd) {
+    flushRetireOverflow();
+    if (m_retireOverflowCount == 0 && m_retired.push(std::move(cmd))) {
         return;
     }
-    for (auto &buffer : m_busBuffers) {
-        buffer.assign(frames * m_channels, 0.0f);
+    if (m_retireOverflowCount < kRetireOverflow) {
+        const int slot = (m_retireOverflowHead + m_retireOverflowCount) % kRetireOverflow;
+        m_retireOverflow[static_cast<size_t>(slot)] = std::move(cmd);
+        ++m_retireOverflowCount;
+        return;
+    }
+    // The control thread has not collected for thousands of retires. Overwriting the slot
+    // without destroying what it held leaks the previous payload; never free it here.
+    new (m_retireLeak) Command(std::move(cmd));
+}
+
+void AudioEngine::flushRetireOverflow() {
+    while (m_retireOverflowCount > 0) {
+        Command &oldest = m_retireOverflow[static_cast<size_t>(m_retireOverflowHead)];
+        if (!m_retired.push(std::move(oldest))) {
+            return;
+        }
+        m_retireOverflowHead = (m_retireOverflowHead + 1) % kRetireOverflow;
+        --m_retireOverflowCount;
     }
+}
 
-    std::array<float, 8> padPlayhead{};
-    padPlayhead.fill(-1.0f);
+void AudioEngine::retireVoice(Voice &voice) {
+    releaseStream(voice);
+    if (!voice.buffer) {
+        return;
+    }
+    // The last reference to a sample buffer must not be dropped on the audio thread.
+    Command retired;
+    retired.voice.buffer = std::move(voice.buffer);
+    retired.voice.stream = std::move(voice.stream);
+    retire(std::move(retired));
+}
 
-    for (auto it = m_voices.begin(); it != m_voices.end();) {
-        Voice &voice = *it;
-        if (!voice.buffer || !voice.buffer->isValid()) {
-            it = m_voices.erase(it);
+AudioEngine::Voice *AudioEngine::claimVoice(int padId) {
+    const int polyphony = padId >= 0 && padId < static_cast<int>(m_padPolyphony.size())
+                              ? m_padPolyphony[static_cast<size_t>(padId)].load()
+                              : 1;
+    int own = 0;
+    Voice *oldestOwn = nullptr;
+    for (int i = 0; i < m_voiceCount; ++i) {
+        Voice &voice = m_voices[static_cast<size_t>(i)];
+        if (voice.padId != padId) {
             continue;
         }
+        ++own;
+        if (!oldestOwn || voice.serial < oldestOwn->serial) {
+            oldestOwn = &voice;
+        }
+    }
+    if (oldestOwn && own >= polyphony) {
+        return oldestOwn;
+    }
+    if (m_voiceCount < kMaxVoices) {
+        return &m_voices[static_cast<size_t>(m_voiceCount++)];
+    }
 
-        const float *data = voice.buffer->samples.constData();
-        const int channels = voice.buffer->channels;
-        const int totalFrames = voice.buffer->frames();
-
-        double pos = voice.position;
-        bool done = false;
-        const int padIndex = qBound(0, voice.padId, static_cast<int>(m_padAttack.size()) - 1);
-        const float attack = m_padAttack[static_cast<size_t>(padIndex)].load();
-        const float decay = m_padDecay[static_cast<size_t>(padIndex)].load();
-        const float sustain = m_padSustain[static_cast<size_t>(padIndex)].load();
-        const float release = m_padRelease[static_cast<size_t>(padIndex)].load();
-
-        const float attackSec = attack * 1.2f;
-        const float decaySec = decay * 1.2f;
-        const float releaseSec = release * 1.6f;
-        const float attackStep = attackSec > 0.0f ? 1.0f / (attackSec * m_sampleRate) : 1.0f;
-        const float decayStep =
-            decaySec > 0.0f ? (1.0f - sustain) / (decaySec * m_sampleRate) : 1.0f;
-        const float releaseStep =
-            releaseSec > 0.0f ? 1.0f / (releaseSec * m_sampleRate) : 1.0f;
-
-        const int busIndex =
-            std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), voice.bus));
-        float *busOut = m_busBuffers[static_cast<size_t>(busIndex)].data();
-        for (int i = 0; i < frames; ++i) {
-            if (voice.releaseRequested && voice.envStage != EnvStage::Release) {
-                voice.envStage = EnvStage::Release;
-            }
-            if (pos >= voice.endFrame) {
-                if (voice.loop) {
-                    pos = static_cast<double>(voice.startFrame);
-                } else {
-                    done = true;
-                    break;
-                }
-            }
-            if (pos >= totalFrames) {
-                done = true;
-                break;
+    const bool quietest = m_voiceSteal.load() == VoiceSteal::Quietest;
+    Voice *victim = nullptr;
+    float victimLevel = 0.0f;
+    for (int i = 0; i < m_voiceCount; ++i) {
+        Voice &voice = m_voices[static_cast<size_t>(i)];
+        if (quietest) {
+            const float level =
+                std::max(voice.gainL, voice.gainR) * (voice.useEnv ? voice.env : 1.0f);
+            if (!victim || level < victimLevel) {
+                victim = &voice;
+                victimLevel = level;
             }
+        } else if (!victim || voice.serial < victim->serial) {
+            victim = &voice;
+        }
+    }
+    return victim;
+}
 
-            const int idx = static_cast<int>(pos);
-            const double frac = pos - static_cast<double>(idx);
-            const int next = std::min(idx + 1, voice.endFrame - 1);
-            const int idxA = idx * channels;
-            const int idxB = next * channels;
-            float leftA = data[idxA];
-            float rightA = (channels > 1 && idxA + 1 < voice.buffer->samples.size())
-                               ? data[idxA + 1]
-                               : leftA;
-            float leftB = data[idxB];
-            float rightB = (channels > 1 && idxB + 1 < voice.buffer->samples.size())
-                               ? data[idxB + 1]
-                               : leftB;
-            float left = leftA + static_cast<float>((leftB - leftA) * frac);
-            float right = rightA + static_cast<float>((rightB - rightA) * frac);
-            float env = voice.env;
-            if (voice.useEnv) {
-                switch (voice.envStage) {
-                    case EnvStage::Attack:
-                        env += attackStep;
-                        if (env >= 1.0f) {
-                            env = 1.0f;
-                            voice.envStage = EnvStage::Decay;
-                        }
-                        break;
-                    case EnvStage::Decay:
-                        env -= decayStep;
-                        if (env <= sustain || decaySec <= 0.0f) {
-                            env = sustain;
-                            voice.envStage = EnvStage::Sustain;
-                        }
-                        break;
-                    case EnvStage::Sustain:
-                        env = sustain;
-                        break;
-                    case EnvStage::Release:
-                        env -= releaseStep * std::max(0.1f, env);
-                        if (env <= 0.0005f || releaseSec <= 0.0f) {
-                            env = 0.0f;
-                            done = true;
-                        }
-                        break;
-                }
-                voice.env = env;
-            } else {
-                env = 1.0f;
+void AudioEngine::removeVoice(int index) {
+    retireVoice(m_voices[static_cast<size_t>(index)]);
+    const int last = --m_voiceCount;
+    if (index != last) {
+        m_voices[static_cast<size_t>(index)] = std::move(m_voices[static_cast<size_t>(last)]);
+    }
+    m_voices[static_cast<size_t>(last)] = Voice();
+}
+
+void AudioEngine::prepareStreaming() {
+    if (m_streamingReady) {
+        return;
+    }
+    for (StreamSlot &slot : m_streamSlots) {
+        slot.ring.assign(static_cast<size_t>(kStreamRingFrames) * 2, 0.0f);
+    }
+    m_streamingReady = true;
+    if (!m_offline) {
+        m_streamRunning.store(true);
+        m_streamReader = std::thread(&AudioEngine::runStreamReader, this);
+    }
+}
+
+void AudioEngine::stopStreamReader() {
+    if (m_streamReader.joinable()) {
+        m_streamRunning.store(false);
+        m_streamReader.join();
+    }
+    for (StreamSlot &slot : m_streamSlots) {
+        slot.stream.reset();
+        slot.state.store(StreamState::Free);
+    }
+}
+
+void AudioEngine::runStreamReader() {
+    while (m_streamRunning.load(std::memory_order_acquire)) {
+        bool busy = false;
+        for (StreamSlot &slot : m_streamSlots) {
+            const StreamState state = slot.state.load(std::memory_order_acquire);
+            if (state == StreamState::Releasing) {
+                slot.stream.reset();
+                slot.state.store(StreamState::Free, std::memory_order_release);
+            } else if (state == StreamState::Active) {
+                busy = fillStream(slot) || busy;
             }
-            busOut[i * m_channels] += left * voice.gainL * env;
-            busOut[i * m_channels + 1] += right * voice.gainR * env;
-            pos += voice.rate;
         }
+        if (!busy) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kStreamPollMs));
+        }
+    }
+}
+
+void AudioEngine::bindStream(Voice &voice) {
+    if (!voice.stream || voice.streamSlot >= 0 || !m_streamingReady) {
+        return;
+    }
+    // The ring takes over where the head can no longer supply both interpolation taps.
+    const int first = std::max(voice.startFrame, voice.buffer->frames() - 1);
+    if (first >= voice.endFrame) {
+        return;
+    }
+    for (size_t i = 0; i < m_streamSlots.size(); ++i) {
+        StreamSlot &slot = m_streamSlots[i];
+        if (slot.state.load(std::memory_order_acquire) != StreamState::Free) {
+            continue;
+        }
+        slot.first = first;
+        slot.end = voice.endFrame;
+        slot.loop = voice.loop;
+        slot.channels = voice.buffer->channels();
+        slot.failed = false;
+        slot.filled.store(0, std::memory_order_relaxed);
+        slot.consumed.store(0, std::memory_order_relaxed);
+        slot.stream = std::move(voice.stream);
+        slot.state.store(StreamState::Active, std::memory_order_release);
+        voice.streamSlot = static_cast<int>(i);
+        voice.streamPass = 0;
+        return;
+    }
+}
 
-        voice.position = pos;
-        if (voice.padId >= 0 && voice.padId < static_cast<int>(padPlayhead.size())) {
-            const int denom = std::max(1, voice.endFrame - voice.startFrame);
-            float ratio = static_cast<float>((pos - voice.startFrame) / static_cast<double>(denom));
-            ratio = std::max(0.0f, std::min(1.0f, ratio));
-            const size_t padIdx = static_cast<size_t>(voice.padId);
-            if (padPlayhead[padIdx] < 0.0f) {
-                padPlayhead[padIdx] = ratio;
-            } else if (ratio > padPlayhead[padIdx]) {
-                padPlayhead[padIdx] = ratio;
-            }
+void AudioEngine::releaseStream(Voice &voice) {
+    if (voice.streamSlot < 0) {
+        return;
+    }
+    StreamSlot &slot = m_streamSlots[static_cast<size_t>(voice.streamSlot)];
+    voice.streamSlot = -1;
+    if (m_offline) {
+        // No reader thread: this is the only thread touching the slot.
+        slot.stream.reset();
+        slot.state.store(StreamState::Free, std::memory_order_release);
+        return;
+    }
+    slot.state.store(StreamState::Releasing, std::memory_order_release);
+}
+
+bool AudioEngine::fillStream(StreamSlot &slot) {
+    if (slot.failed || !slot.stream) {
+        return false;
+    }
+    const qint64 length = slot.end - slot.first;
+    const qint64 consumed = slot.consumed.load(std::memory_order_acquire);
+    // After an underrun the voice has moved past frames that never arrived; skip them.
+    qint64 filled = std::max(slot.filled.load(std::memory_order_relaxed), consumed);
+    bool wrote = false;
+    while (true) {
+        qint64 space = consumed + kStreamRingFrames - filled;
+        const bool last = !slot.loop && length - filled <= space;
+        if (!slot.loop) {
+            space = std::min(space, length - filled);
         }
-        if (done) {
-            it = m_voices.erase(it);
-        } else {
-            ++it;
+        if (space <= 0 || (space < kStreamChunkFrames && !last)) {
+            break;
         }
+        const qint64 from = slot.first + filled % length;
+        const qint64 at = filled & (kStreamRingFrames - 1);
+        const int count = static_cast<int>(std::min<qint64>(
+            std::min<qint64>(space, kStreamChunkFrames),
+            std::min<qint64>(slot.end - from, kStreamRingFrames - at)));
+        if (!slot.stream->read(from, count,
+                               slot.ring.data() + static_cast<size_t>(at) * slot.channels)) {
+            slot.failed = true;
+            break;
+        }
+        filled += count;
+        slot.filled.store(filled, std::memory_order_release);
+        wrote = true;
     }
+    return wrote;
+}
 
-    for (size_t i = 0; i < m_padPlayheads.size(); ++i) {
-        m_padPlayheads[i].store(padPlayhead[i], std::memory_order_relaxed);
+int AudioEngine::mixStreamRun(Voice &voice, int lastFrame, double pos, int run, const float *env,
+                              float *left, float *right) {
+    StreamSlot &slot = m_streamSlots[static_cast<size_t>(voice.streamSlot)];
+    if (m_offline) {
+        // Offline renders may run far ahead of realtime; read on demand instead.
+        fillStream(slot);
+    }
+    const double rate = voice.rate;
+    const qint64 passBase = voice.streamPass * (slot.end - slot.first);
+    const int first = static_cast<int>(pos);
+    const qint64 base = passBase + (first - slot.first);
+    const int channels = slot.channels;
+    auto needed = [&](int frames) {
+        return std::min(lastFrame, static_cast<int>(pos + (frames - 1) * rate) + 1) - first + 1;
+    };
+
+    // Frames [first, first + limit) are in the ring and fit the scratch block.
+    const int limit = static_cast<int>(std::min<qint64>(
+        slot.filled.load(std::memory_order_acquire) - base,
+        static_cast<qint64>(m_streamScratch.size() / 2)));
+    // Like the head path, stop where the read position crosses the end of the region.
+    const double end = static_cast<double>(lastFrame + 1);
+    run = std::max(1, std::min(run, static_cast<int>(std::ceil((end - pos) / rate))));
+    while (run > 1 && pos + (run - 1) * rate >= end) {
+        --run;
+    }
+    int frames = static_cast<int>(std::ceil((first + limit - 1 - pos) / rate));
+    frames = std::max(1, std::min(frames, run));
+    while (frames > 1 && needed(frames) > limit) {
+        --frames;
+    }
+    const int count = needed(frames);
+    if (count > limit) {
+        // The reader is behind: play silence rather than stall the voice.
+        frames = run;
+    } else {
+        // Copy out of the ring in at most two pieces so the kernel sees plain frames.
+        const size_t at = static_cast<size_t>(base & (kStreamRingFrames - 1));
+        const size_t split = std::min<size_t>(static_cast<size_t>(count), kStreamRingFrames - at);
+        const float *ring = slot.ring.data();
+        float *scratch = m_streamScratch.data();
+        std::copy(ring + at * channels, ring + (at + split) * channels, scratch);
+        std::copy(ring, ring + (static_cast<size_t>(count) - split) * channels,
+                  scratch + split * channels);
+        VoiceKernel::mixLinear(scratch, channels, count - 1, pos - first, rate, env, voice.gainL,
+                               voice.gainR, left, right, frames);
+    }
+    const qint64 passed = std::min<qint64>(static_cast<qint64>(pos + frames * rate) - slot.first,
+                                           slot.end - slot.first);
+    slot.consumed.store(passBase + std::max<qint64>(0, passed), std::memory_order_release);
+    return frames;
+}
+
+void AudioEngine::prepareBuffers(int frames) {
+    frames = std::max(1, frames);
+    const size_t samples = static_cast<size_t>(frames * m_channels);
+    for (auto &buffer : m_busBuffers) {
+        buffer.assign(samples, 0.0f);
+    }
+    m_drySum.assign(samples, 0.0f);
+    m_master.assign(samples, 0.0f);
+    for (SynthBlock &block : m_synthBlocks) {
+        block.left.assign(static_cast<size_t>(frames), 0.0f);
+        block.right.assign(static_cast<size_t>(frames), 0.0f);
+        block.out.assign(samples, 0.0f);
+        block.active = false;
+    }
+    for (size_t bus = 0; bus < m_voiceLeft.size(); ++bus) {
+        m_voiceLeft[bus].assign(static_cast<size_t>(frames), 0.0f);
+        m_voiceRight[bus].assign(static_cast<size_t>(frames), 0.0f);
+    }
+    m_voiceEnv.assign(static_cast<size_t>(frames), 0.0f);
+    for (size_t bus = 0; bus < m_fxLeft.size(); ++bus) {
+        m_fxLeft[bus].assign(static_cast<size_t>(frames), 0.0f);
+        m_fxRight[bus].assign(static_cast<size_t>(frames), 0.0f);
+    }
+    // Enough stereo frames for one block of a streaming voice at the top playback rate.
+    m_streamScratch.assign(static_cast<size_t>(frames * 4 + 4) * 2, 0.0f);
+    for (BusChain &chain : m_busChains) {
+        for (EffectState &fx : chain.effects) {
+            prepareEffect(fx);
+        }
     }
+    m_mixCapacity = frames;
+}
 
-    if (frames > 0 && !m_synthStates.empty()) {
-        if (static_cast<int>(m_synthScratchL.size()) != frames) {
-            m_synthScratchL.assign(frames, 0.0f);
-            m_synthScratchR.assign(frames, 0.0f);
+void AudioEngine::applyCommand(Command &cmd) {
+    SynthState *synth = nullptr;
+    if (cmd.padId >= 0 && cmd.padId < static_cast<int>(m_synthStates.size())) {
+        synth = &m_synthStates[static_cast<size_t>(cmd.padId)];
+    }
+    auto releaseAllNotes = [](SynthState &state) {
+        if (!state.engine) {
+            return;
         }
-        for (size_t pad = 0; pad < m_synthStates.size(); ++pad) {
-            SynthState &synth = m_synthStates[pad];
-            if (!synth.enabled) {
-                continue;
+        SynthCore &engine = *state.engine;
+        for (size_t n = 0; n < state.activeNotes.size(); ++n) {
+            if (state.activeNotes[n]) {
+                if (engine.kind == SynthKind::Simple) {
+                    engine.simple.noteOff(static_cast<int>(n));
+                } else if (engine.kind == SynthKind::Dx7) {
+                    engine.core.noteOff(static_cast<int>(n));
+                } else if (engine.op1) {
+                    engine.op1->noteOff(static_cast<int>(n));
+                }
+                state.activeNotes[n] = false;
             }
-            ensureSynthInit(synth);
-            const int busIndex =
-                std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), synth.bus));
-            float *busOut = m_busBuffers[static_cast<size_t>(busIndex)].data();
+        }
+    };
 
-            const int padIndex = qBound(0, static_cast<int>(pad),
-                                        static_cast<int>(m_padAttack.size()) - 1);
-            const float attack = m_padAttack[static_cast<size_t>(padIndex)].load();
-            const float decay = m_padDecay[static_cast<size_t>(padIndex)].load();
-            const float sustain = m_padSustain[static_cast<size_t>(padIndex)].load();
-            const float release = m_padRelease[static_cast<size_t>(padIndex)].load();
-
-            const float attackSec = attack * 1.2f;
-            const float decaySec = decay * 1.2f;
-            const float releaseSec = release * 1.6f;
-            const float attackStep =
-                attackSec > 0.0f ? 1.0f / (attackSec * m_sampleRate) : 1.0f;
-            const float decayStep =
-                decaySec > 0.0f ? (1.0f - sustain) / (decaySec * m_sampleRate) : 1.0f;
-            const float releaseStep =
-                releaseSec > 0.0f ? 1.0f / (releaseSec * m_sampleRate) : 1.0f;
-
-            const bool isDx7 = (synth.kind == SynthKind::Dx7);
-            const bool isSimple = (synth.kind == SynthKind::Simple);
-            const bool neutralEnv =
-                (attack <= 0.001f && decay <= 0.001f && release <= 0.001f && sustain >= 0.999f);
-            const bool useExternalEnv = isDx7 ? !neutralEnv : true;
-
-            const bool hasNotes = std::any_of(synth.activeNotes.begin(),
-                                             synth.activeNotes.end(),
-                                             [](bool v) { return v; });
-            if (!hasNotes && !synth.releaseRequested) {
-                synth.env = 0.0f;
-                synth.envStage = EnvStage::Attack;
-                continue;
-            }
-            std::array<float, kModTargetCount> blockMods{};
-            const float bpmNow = std::max(30.0f, std::min(300.0f, m_bpm.load()));
-            for (int m = 0; m < kLfoModuleCount; ++m) {
-                const auto &module = synth.fmParams.lfoModules[static_cast<size_t>(m)];
-                if (!module.enabled || module.depth <= 0.0001f) {
-                    continue;
-                }
-                const float rateHz =
-                    module.sync ? lfoRateFromSyncIndex(module.syncIndex, bpmNow)
-                                : (0.05f + safeParam(module.rate) * 10.0f);
-                const float value = lfoModuleValue(module,
-                                                   synth.lfoPhaseModules[static_cast<size_t>(m)],
-                                                   synth.lfoHoldModules[static_cast<size_t>(m)]) *
-                                    safeParam(module.depth);
-                for (int t = 1; t < kModTargetCount; ++t) {
-                    blockMods[static_cast<size_t>(t)] +=
-                        value * module.assign[static_cast<size_t>(t)];
-                }
-                float nextPhase = synth.lfoPhaseModules[static_cast<size_t>(m)] +
-                                  (2.0f * static_cast<float>(M_PI) * rateHz / m_sampleRate) *
-                                      std::min(frames, 64);
-                if (module.kind == 1) {
-                    nextPhase = std::fmod(nextPhase, 2.0f * static_cast<float>(M_PI));
-                }
-                while (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
-                    nextPhase -= 2.0f * static_cast<float>(M_PI);
+    switch (cmd.type) {
+    case Command::Type::None:
+        break;
+    case Command::Type::Trigger: {
+        // Swap the new voice into the slot it takes over, so the old buffer reference leaves
+        // with the command instead of being dropped here.
+        Voice *started = claimVoice(cmd.padId);
+        if (!started) {
+            break;
+        }
+        std::swap(*started, cmd.voice);
+        releaseStream(cmd.voice);
+        started->serial = ++m_voiceSerial;
+        const int choke = cmd.padId >= 0 && cmd.padId < static_cast<int>(m_padChoke.size())
+                              ? m_padChoke[static_cast<size_t>(cmd.padId)].load()
+                              : 0;
+        if (choke > 0) {
+            for (int i = 0; i < m_voiceCount; ++i) {
+                Voice &voice = m_voices[static_cast<size_t>(i)];
+                if (voice.padId != cmd.padId && voice.padId >= 0 &&
+                    voice.padId < static_cast<int>(m_padChoke.size()) &&
+                    m_padChoke[static_cast<size_t>(voice.padId)].load() == choke) {
+                    voice.choked = true;
+                    voice.releaseRequested = true;
+                    voice.loop = false;
                 }
-                synth.lfoPhaseModules[static_cast<size_t>(m)] = nextPhase;
             }
-            for (int m = 0; m < kEnvModuleCount; ++m) {
-                const auto &module = synth.fmParams.envModules[static_cast<size_t>(m)];
-                if (!module.enabled) {
+        }
+        bindStream(*started);
+        break;
+    }
+    case Command::Type::StopPad:
+        for (int i = 0; i < m_voiceCount; ++i) {
+            Voice &voice = m_voices[static_cast<size_t>(i)];
+            if (voice.padId == cmd.padId) {
+                voice.releaseRequested = true;
+                voice.loop = false;
+            }
+        }
+        break;
+    case Command::Type::StopAll:
+        while (m_voiceCount > 0) {
+            removeVoice(m_voiceCount - 1);
+        }
+        break;
+    case Command::Type::BusEffects:
+        if (cmd.chain && cmd.arg1 >= 0 && cmd.arg1 < static_cast<int>(m_busChains.size())) {
+            std::swap(m_busChains[static_cast<size_t>(cmd.arg1)].effects, cmd.chain->effects);
+        }
+        break;
+    case Command::Type::SynthEnable:
+        if (!synth) {
+            break;
+        }
+        synth->enabled = cmd.arg1 != 0;
+        if (!synth->enabled) {
+            releaseAllNotes(*synth);
+            synth->env = 0.0f;
+            synth->envStage = EnvStage::Attack;
+            synth->releaseRequested = false;
+        }
+        break;
+    case Command::Type::SynthMix:
+        if (!synth) {
+            break;
+        }
+        synth->gainL = cmd.gainL;
+        synth->gainR = cmd.gainR;
+        synth->bus = cmd.arg1;
+        break;
+    case Command::Type::SynthSwapCore:
+        if (!synth || !cmd.core) {
+            break;
+        }
+        std::swap(synth->engine, cmd.core);
+        for (bool &note : synth->activeNotes) {
+            note = false;
+        }
+        if (cmd.arg1 != 0) {
+            synth->env = 0.0f;
+            synth->envStage = EnvStage::Attack;
+            synth->releaseRequested = false;
+            synth->lfoPhase = 0.0f;
+            synth->filterIc1L = 0.0f;
+            synth->filterIc2L = 0.0f;
+            synth->filterIc1R = 0.0f;
+            synth->filterIc2R = 0.0f;
+            synth->filterIc1LModules.fill(0.0f);
+            synth->filterIc2LModules.fill(0.0f);
+            synth->filterIc1RModules.fill(0.0f);
+            synth->filterIc2RModules.fill(0.0f);
+            synth->lfoPhaseModules.fill(0.0f);
+            synth->lfoHoldModules.fill(0.0f);
+            synth->envValues.fill(0.0f);
+            synth->envReleaseRequested.fill(false);
+        }
+        break;
+    case Command::Type::SynthMacro:
+        if (!synth || cmd.arg1 < 0 ||
+            cmd.arg1 >= static_cast<int>(synth->fmParams.macros.size())) {
+            break;
+        }
+        synth->fmParams.macros[static_cast<size_t>(cmd.arg1)] = cmd.gainL;
+        break;
+    case Command::Type::SynthFmParams: {
+        if (!synth || !cmd.fmParams) {
+            break;
+        }
+        const FmParams &params = *cmd.fmParams;
+        SynthState &state = *synth;
+        state.fmParams = params;
+        state.filterCutoff = params.cutoff;
+        state.filterResonance = params.resonance;
+        state.filterType = params.filterType;
+        state.filterEnvAmount = params.filterEnv;
+        state.lfoRate = params.lfoRate;
+        state.lfoDepth = params.lfoDepth;
+        state.lfoShape = params.lfoShape;
+        state.lfoSync = params.lfoSync;
+        state.lfoSyncIndex = params.lfoSyncIndex;
+        state.lfoTarget = params.lfoTarget;
+        for (int i = 0; i < kLfoModuleCount; ++i) {
+            if (!params.lfoModules[static_cast<size_t>(i)].enabled) {
+                state.lfoPhaseModules[static_cast<size_t>(i)] = 0.0f;
+                state.lfoHoldModules[static_cast<size_t>(i)] = 0.0f;
+            }
+        }
+        for (int i = 0; i < kEnvModuleCount; ++i) {
+            if (!params.envModules[static_cast<size_t>(i)].enabled) {
+                state.envValues[static_cast<size_t>(i)] = 0.0f;
+                state.envStages[static_cast<size_t>(i)] = EnvStage::Attack;
+                state.envReleaseRequested[static_cast<size_t>(i)] = false;
+            }
+        }
+        for (int i = 0; i < kFilterModuleCount; ++i) {
+            if (!params.filterModules[static_cast<size_t>(i)].enabled) {
+                state.filterIc1LModules[static_cast<size_t>(i)] = 0.0f;
+                state.filterIc2LModules[static_cast<size_t>(i)] = 0.0f;
+                state.filterIc1RModules[static_cast<size_t>(i)] = 0.0f;
+                state.filterIc2RModules[static_cast<size_t>(i)] = 0.0f;
+            }
+        }
+        if (!state.engine) {
+            break;
+        }
+        SimpleFmCore::Params simpleParams;
+        simpleParams.fmAmount = params.fmAmount;
+        simpleParams.ratio = params.ratio;
+        simpleParams.feedback = params.feedback;
+        simpleParams.octave = params.octave;
+        simpleParams.osc1Wave = params.osc1Wave;
+        simpleParams.osc2Wave = params.osc2Wave;
+        simpleParams.osc1Voices = params.osc1Voices;
+        simpleParams.osc2Voices = params.osc2Voices;
+        simpleParams.osc1Detune = params.osc1Detune;
+        simpleParams.osc2Detune = params.osc2Detune;
+        simpleParams.osc1Gain = params.osc1Gain;
+        simpleParams.osc2Gain = params.osc2Gain;
+        simpleParams.osc1Pan = params.osc1Pan;
+        simpleParams.osc2Pan = params.osc2Pan;
+        state.engine->simple.setParams(simpleParams);
+        if (state.engine->op1) {
+            state.engine->op1->setParams(toOp1Params(params));
+        }
+        break;
+    }
+    case Command::Type::SynthProgram:
+        if (!synth || !synth->engine) {
+            break;
+        }
+        synth->engine->core.selectProgram(cmd.arg1);
+        publishVoiceParams(cmd.padId, *synth->engine);
+        break;
+    case Command::Type::SynthVoiceParam:
+        if (!synth || !synth->engine) {
+            break;
+        }
+        synth->engine->core.setVoiceParam(cmd.arg1, cmd.arg2);
+        m_synthVoiceParams[static_cast<size_t>(cmd.padId)][static_cast<size_t>(cmd.arg1)].store(
+            static_cast<uint8_t>(synth->engine->core.voiceParam(cmd.arg1)),
+            std::memory_order_relaxed);
+        break;
+    case Command::Type::SynthNoteOn: {
+        if (!synth || !synth->enabled || !synth->engine) {
+            break;
+        }
+        SynthState &state = *synth;
+        SynthCore &engine = *state.engine;
+        const int midiNote = cmd.arg1;
+        const int velocity = cmd.arg2;
+        const bool hadActive = std::any_of(state.activeNotes.begin(), state.activeNotes.end(),
+                                           [](bool v) { return v; });
+        if (engine.kind == SynthKind::Simple) {
+            engine.simple.noteOn(midiNote, velocity);
+        } else if (engine.kind == SynthKind::Dx7) {
+            engine.core.noteOn(midiNote, velocity);
+        } else if (engine.op1) {
+            engine.op1->noteOn(midiNote, velocity);
+        }
+        state.activeNotes[static_cast<size_t>(midiNote)] = true;
+        if (cmd.arg3 > 0) {
+            scheduleNoteOff(cmd.padId, midiNote, m_frameClock + cmd.arg3);
+        }
+        if (!hadActive || state.envStage == EnvStage::Release) {
+            state.envStage = EnvStage::Attack;
+            state.releaseRequested = false;
+            for (int i = 0; i < kEnvModuleCount; ++i) {
+                if (!state.fmParams.envModules[static_cast<size_t>(i)].enabled) {
                     continue;
                 }
-                const float value = synth.envValues[static_cast<size_t>(m)];
-                for (int t = 1; t < kModTargetCount; ++t) {
-                    blockMods[static_cast<size_t>(t)] +=
-                        value * module.assign[static_cast<size_t>(t)];
-                }
+                state.envStages[static_cast<size_t>(i)] = EnvStage::Attack;
+                state.envReleaseRequested[static_cast<size_t>(i)] = false;
+                state.envValues[static_cast<size_t>(i)] = 0.0f;
             }
-            if (isCustomKind(synth.kind) && synth.op1) {
-                AudioEngine::FmParams modParams = synth.fmParams;
-                for (int m = 0; m < 4; ++m) {
-                    const int targetIndex = 13 + m;
-                    const float mod = blockMods[static_cast<size_t>(targetIndex)];
-                    if (std::fabs(mod) <= 0.0001f) {
-                        continue;
-                    }
-                    applyCustomMacroMod(synth.kind, m, mod, modParams);
-                }
+        }
+        break;
+    }
+    case Command::Type::SynthNoteOff: {
+        if (!synth || !synth->enabled || !synth->engine) {
+            break;
+        }
+        SynthState &state = *synth;
+        SynthCore &engine = *state.engine;
+        const int midiNote = cmd.arg1;
+        if (engine.kind == SynthKind::Simple) {
+            engine.simple.noteOff(midiNote);
+        } else if (engine.kind == SynthKind::Dx7) {
+            engine.core.noteOff(midiNote);
+        } else if (engine.op1) {
+            engine.op1->noteOff(midiNote);
+        }
+        state.activeNotes[static_cast<size_t>(midiNote)] = false;
+        const bool hasActive = std::any_of(state.activeNotes.begin(), state.activeNotes.end(),
+                                           [](bool v) { return v; });
+        if (!hasActive) {
+            state.releaseRequested = true;
+            for (int i = 0; i < kEnvModuleCount; ++i) {
+                state.envReleaseRequested[static_cast<size_t>(i)] = true;
+            }
+        }
+        break;
+    }
+    case Command::Type::SynthAllNotesOff:
+        if (!synth || !synth->enabled || !synth->engine) {
+            break;
+        }
+        releaseAllNotes(*synth);
+        synth->releaseRequested = true;
+        for (int i = 0; i < kEnvModuleCount; ++i) {
+            synth->envReleaseRequested[static_cast<size_t>(i)] = true;
+        }
+        break;
+    case Command::Type::SeqSetPattern:
+        if (!cmd.seq) {
+            break;
+        }
+        if (cmd.seq->atBar && m_seqRunning && m_seq) {
+            // Replaces any older pattern still waiting; cmd carries that one off.
+            std::swap(m_seqQueued, cmd.seq);
+            break;
+        }
+        std::swap(m_seq, cmd.seq);
+        if (m_seqQueued) {
+            // Older than the pattern just applied.
+            Command retired;
+            retired.seq = std::move(m_seqQueued);
+            retire(std::move(retired));
+        }
+        break;
+    case Command::Type::SeqTransport:
+        m_seqRunning = cmd.arg1 != 0;
+        if (m_seqQueued) {
+            promoteQueuedPattern();
+        }
+        if (m_seqRunning) {
+            m_seqStep = cmd.arg2;
+            m_seqCountdown = 0.0;
+        } else {
+            // Nothing would end these once the transport stops.
+            for (int i = 0; i < m_noteOffCount; ++i) {
+                Command off;
+                off.type = Command::Type::SynthNoteOff;
+                off.padId = m_noteOffs[static_cast<size_t>(i)].padId;
+                off.arg1 = m_noteOffs[static_cast<size_t>(i)].midiNote;
+                applyCommand(off);
+            }
+            m_noteOffCount = 0;
+        }
+        break;
+    }
+}
 
-                auto applyDirect = [&](int target, auto applyFn) {
-                    if (target <= 0 || target >= AudioEngine::kModTargetCount) {
-                        return;
-                    }
-                    const float mod = blockMods[static_cast<size_t>(target)];
-                    if (std::fabs(mod) <= 0.0001f) {
-                        return;
-                    }
-                    applyFn(mod);
-                };
+double AudioEngine::seqStepFrames() const {
+    return m_sampleRate * 60.0 / std::max(1.0f, m_bpm.load()) / 4.0;
+}
 
-                applyDirect(1, [&](float mod) { // Osc1Detune
-                    modParams.osc1Detune = modClamp(modParams.osc1Detune + mod * 0.5f, 0.0f, 1.0f);
-                });
-                applyDirect(2, [&](float mod) { // Osc1Gain
-                    modParams.osc1Gain = modClamp(modParams.osc1Gain + mod * 0.5f, 0.0f, 1.0f);
-                });
-                applyDirect(3, [&](float mod) { // Osc1Pan
-                    modParams.osc1Pan = modClamp(modParams.osc1Pan + mod * 0.5f, -1.0f, 1.0f);
-                });
-                applyDirect(4, [&](float mod) { // Osc2Detune
-                    modParams.osc2Detune = modClamp(modParams.osc2Detune + mod * 0.5f, 0.0f, 1.0f);
-                });
-                applyDirect(5, [&](float mod) { // Osc2Gain
-                    modParams.osc2Gain = modClamp(modParams.osc2Gain + mod * 0.5f, 0.0f, 1.0f);
-                });
-                applyDirect(6, [&](float mod) { // Osc2Pan
-                    modParams.osc2Pan = modClamp(modParams.osc2Pan + mod * 0.5f, -1.0f, 1.0f);
-                });
-                applyDirect(10, [&](float mod) { // FmAmount
-                    modParams.fmAmount = modClamp(modParams.fmAmount + mod * 0.6f, 0.0f, 1.0f);
-                });
-                applyDirect(11, [&](float mod) { // Ratio
-                    modParams.ratio = modClamp(modParams.ratio + mod * 2.0f, 0.1f, 8.0f);
-                });
-                applyDirect(12, [&](float mod) { // Feedback
-                    modParams.feedback = modClamp(modParams.feedback + mod * 0.6f, 0.0f, 1.0f);
-                });
-
-                synth.op1->setParams(toOp1Params(modParams));
-            }
-
-            if (synth.kind == SynthKind::Simple) {
-                synth.simple.render(m_synthScratchL.data(), m_synthScratchR.data(), frames);
-            } else if (synth.kind == SynthKind::Dx7) {
-                synth.core.render(m_synthScratchL.data(), m_synthScratchR.data(), frames);
-            } else if (synth.op1) {
-                synth.op1->render(m_synthScratchL.data(), m_synthScratchR.data(), frames);
-            } else {
-                std::fill(m_synthScratchL.begin(), m_synthScratchL.end(), 0.0f);
-                std::fill(m_synthScratchR.begin(), m_synthScratchR.end(), 0.0f);
-            }
-
-            const bool useFilter = (synth.filterType != 8);
-            float baseCutoff = synth.filterCutoff;
-            float baseRes = synth.filterResonance;
-            float baseEnv = synth.filterEnvAmount;
-            const float lfoDepth = synth.lfoDepth;
-            float lfoRateHz = 0.1f + synth.lfoRate * 8.0f;
-            if (synth.lfoSync) {
-                static const float syncBeats[] = {4.0f, 2.0f, 1.0f, 0.5f, 0.25f, 0.125f, 0.333f,
-                                                  0.166f};
-                const int idx = std::max(0, std::min(7, synth.lfoSyncIndex));
-                const float beats = syncBeats[idx];
-                const float bpm = std::max(30.0f, std::min(300.0f, m_bpm.load()));
-                const float bps = bpm / 60.0f;
-                if (beats > 0.0f) {
-                    lfoRateHz = bps / beats;
-                }
-            }
-            const float lfoInc = 2.0f * static_cast<float>(M_PI) * lfoRateHz / m_sampleRate;
-            bool lfoActive = lfoDepth > 0.0001f;
-            if (!lfoActive) {
-                for (float v : synth.fmParams.lfoAssign) {
-                    if (v > 0.0001f) {
-                        lfoActive = true;
-                        break;
-                    }
-                }
+void AudioEngine::promoteQueuedPattern() {
+    std::swap(m_seq, m_seqQueued);
+    Command retired;
+    retired.seq = std::move(m_seqQueued);
+    retire(std::move(retired));
+}
+
+void AudioEngine::startVoice(const Voice &voice) {
+    if (!voice.buffer) {
+        return;
+    }
+    Command cmd;
+    cmd.type = Command::Type::Trigger;
+    cmd.padId = voice.padId;
+    cmd.voice = voice;
+    applyCommand(cmd);
+    if (cmd.voice.buffer) {
+        // The voice this one replaced.
+        retire(std::move(cmd));
+    }
+    if (voice.padId >= 0 && voice.padId < static_cast<int>(m_padActive.size())) {
+        m_padActive[static_cast<size_t>(voice.padId)].store(true, std::memory_order_relaxed);
+    }
+}
+
+void AudioEngine::scheduleNoteOff(int padId, int midiNote, qint64 frame) {
+    for (int i = 0; i < m_noteOffCount; ++i) {
+        PendingNoteOff &pending = m_noteOffs[static_cast<size_t>(i)];
+        if (pending.padId == padId && pending.midiNote == midiNote) {
+            // Retriggered before it ended: the new gate wins.
+            pending.frame = frame;
+            return;
+        }
+    }
+    if (m_noteOffCount >= static_cast<int>(m_noteOffs.size())) {
+        // Out of slots: end the note that was due first now and reuse its slot.
+        int earliest = 0;
+        for (int i = 1; i < m_noteOffCount; ++i) {
+            if (m_noteOffs[static_cast<size_t>(i)].frame <
+                m_noteOffs[static_cast<size_t>(earliest)].frame) {
+                earliest = i;
             }
-            float staticG = 0.0f;
-            float staticR = 0.0f;
-            if (useFilter && lfoDepth <= 0.0001f) {
-                const float cutoff = std::max(0.02f, std::min(0.98f, baseCutoff));
-                const float hz = 40.0f * std::pow(2.0f, cutoff * 8.0f);
-                const float g = std::tan(static_cast<float>(M_PI) * hz / m_sampleRate);
-                const float q = 0.7f + baseRes * 7.0f;
-                staticG = g;
-                staticR = 1.0f / (2.0f * q);
+        }
+        Command off;
+        off.type = Command::Type::SynthNoteOff;
+        off.padId = m_noteOffs[static_cast<size_t>(earliest)].padId;
+        off.arg1 = m_noteOffs[static_cast<size_t>(earliest)].midiNote;
+        applyCommand(off);
+        m_noteOffs[static_cast<size_t>(earliest)] = m_noteOffs[static_cast<size_t>(--m_noteOffCount)];
+    }
+    m_noteOffs[static_cast<size_t>(m_noteOffCount++)] = {padId, midiNote, frame};
+}
+
+void AudioEngine::fireStep(int step) {
+    const SeqProgram &seq = *m_seq;
+    if (seq.metronome && step % 4 == 0) {
+        startVoice(step % 16 == 0 ? seq.accent : seq.click);
+    }
+    for (const SeqStep &event : seq.steps[static_cast<size_t>(step)]) {
+        if (!event.synth) {
+            startVoice(event.voice);
+            continue;
+        }
+        Command on;
+        on.type = Command::Type::SynthNoteOn;
+        on.padId = event.padId;
+        on.arg1 = event.midiNote;
+        on.arg2 = 127;
+        on.arg3 = event.lengthFrames;
+        applyCommand(on);
+        m_synthActive[static_cast<size_t>(event.padId)].store(true, std::memory_order_relaxed);
+    }
+}
+
+int AudioEngine::runSequencer(int maxFrames) {
+    for (int i = 0; i < m_noteOffCount;) {
+        const PendingNoteOff &pending = m_noteOffs[static_cast<size_t>(i)];
+        if (pending.frame > m_frameClock) {
+            ++i;
+            continue;
+        }
+        Command off;
+        off.type = Command::Type::SynthNoteOff;
+        off.padId = pending.padId;
+        off.arg1 = pending.midiNote;
+        applyCommand(off);
+        m_noteOffs[static_cast<size_t>(i)] = m_noteOffs[static_cast<size_t>(--m_noteOffCount)];
+    }
+
+    int frames = maxFrames;
+    if (m_seqRunning && m_seq && !m_seq->steps.empty()) {
+        const double stepFrames = seqStepFrames();
+        while (m_seqCountdown <= 0.0) {
+            if (m_seqQueued && m_seqStep % kSeqStepsPerBar == 0) {
+                promoteQueuedPattern();
             }
+            const int steps = static_cast<int>(m_seq->steps.size());
+            const int step = m_seqStep % steps;
+            fireStep(step);
+            m_seqPlayStep.store(step, std::memory_order_relaxed);
+            m_seqStep = (step + 1) % steps;
+            m_seqCountdown += stepFrames;
+        }
+        frames = std::min(frames, std::max(1, static_cast<int>(std::ceil(m_seqCountdown))));
+    }
+    for (int i = 0; i < m_noteOffCount; ++i) {
+        const qint64 until = m_noteOffs[static_cast<size_t>(i)].frame - m_frameClock;
+        frames = static_cast<int>(std::min<qint64>(frames, std::max<qint64>(1, until)));
+    }
+    return frames;
+}
 
-            float tailPeak = 0.0f;
-            for (int i = 0; i < frames; ++i) {
-                float env = 1.0f;
-                if (useExternalEnv) {
-                    if (synth.releaseRequested && !hasNotes &&
-                        synth.envStage != EnvStage::Release) {
-                        synth.envStage = EnvStage::Release;
-                    }
-                    env = synth.env;
-                    switch (synth.envStage) {
-                        case EnvStage::Attack:
-                            env += attackStep;
-                            if (env >= 1.0f) {
-                                env = 1.0f;
-                                synth.envStage = EnvStage::Decay;
-                            }
-                            break;
-                        case EnvStage::Decay:
-                            env -= decayStep;
-                            if (env <= sustain || decaySec <= 0.0f) {
-                                env = sustain;
-                                synth.envStage = EnvStage::Sustain;
-                            }
-                            break;
-                        case EnvStage::Sustain:
-                            env = sustain;
-                            break;
-                        case EnvStage::Release:
-                            env -= releaseStep * std::max(0.1f, env);
-                            if (env <= 0.0005f || releaseSec <= 0.0f) {
-                                env = 0.0f;
-                                synth.releaseRequested = false;
-                            }
-                            break;
-                    }
-                    synth.env = env;
-                } else {
-                    synth.envStage = EnvStage::Sustain;
-                    synth.env = 1.0f;
-                }
+void AudioEngine::mix(float *out, int frames) {
+    drainCommands();
+    // Blocks end wherever the sequencer or a scheduled note-off fires next, so events land on
+    // their exact frame. Larger blocks than prepareBuffers() sized for are split, not grown into.
+    int offset = 0;
+    while (m_mixCapacity > 0 && offset < frames) {
+        const int chunk = runSequencer(std::min(m_mixCapacity, frames - offset));
+        m_blockOffset = offset;
+        mixBlock(out + offset * m_channels, chunk);
+        m_frameClock += chunk;
+        if (m_seqRunning && m_seq) {
+            m_seqCountdown -= chunk;
+        }
+        offset += chunk;
+    }
+    if (m_seqRunning && m_seq) {
+        const float phase = static_cast<float>(1.0 - m_seqCountdown / seqStepFrames());
+        m_seqStepPhase.store(qBound(0.0f, phase, 1.0f), std::memory_order_relaxed);
+    }
+}
 
-                std::array<float, kModTargetCount> moduleMods{};
-                for (int m = 0; m < kEnvModuleCount; ++m) {
-                    const auto &module = synth.fmParams.envModules[static_cast<size_t>(m)];
-                    if (!module.enabled) {
-                        continue;
-                    }
-                    if (synth.envReleaseRequested[static_cast<size_t>(m)] && !hasNotes &&
-                        synth.envStages[static_cast<size_t>(m)] != EnvStage::Release) {
-                        synth.envStages[static_cast<size_t>(m)] = EnvStage::Release;
-                    }
-                    float value = synth.envValues[static_cast<size_t>(m)];
-                    const float aSec = safeParam(module.attack) * 1.2f;
-                    const float dSec = safeParam(module.decay) * 1.2f;
-                    const float rSec = safeParam(module.release) * 1.6f;
-                    const float sus = safeParam(module.sustain);
-                    const float aStep = aSec > 0.0f ? 1.0f / (aSec * m_sampleRate) : 1.0f;
-                    const float dStep =
-                        dSec > 0.0f ? (1.0f - sus) / (dSec * m_sampleRate) : 1.0f;
-                    const float rStep = rSec > 0.0f ? 1.0f / (rSec * m_sampleRate) : 1.0f;
-                    switch (synth.envStages[static_cast<size_t>(m)]) {
-                        case EnvStage::Attack:
-                            value += aStep;
-                            if (value >= 1.0f || aSec <= 0.0f) {
-                                value = 1.0f;
-                                synth.envStages[static_cast<size_t>(m)] = EnvStage::Decay;
-                            }
-                            break;
-                        case EnvStage::Decay:
-                            value -= dStep;
-                            if (value <= sus || dSec <= 0.0f) {
-                                value = sus;
-                                synth.envStages[static_cast<size_t>(m)] = EnvStage::Sustain;
-                            }
-                            break;
-                        case EnvStage::Sustain:
-                            value = sus;
-                            break;
-                        case EnvStage::Release:
-                            value -= rStep * std::max(0.1f, value);
-                            if (value <= 0.0005f || rSec <= 0.0f) {
-                                value = 0.0f;
-                                synth.envReleaseRequested[static_cast<size_t>(m)] = false;
-                            }
-                            break;
-                    }
-                    synth.envValues[static_cast<size_t>(m)] = value;
-                    for (int t = 1; t < kModTargetCount; ++t) {
-                        moduleMods[static_cast<size_t>(t)] +=
-                            value * module.assign[static_cast<size_t>(t)];
-                    }
-                }
+void AudioEngine::mixBlock(float *out, int frames) {
+    const int samples = frames * m_channels;
+    for (auto &buffer : m_busBuffers) {
+        std::fill(buffer.begin(), buffer.begin() + samples, 0.0f);
+    }
 
-                for (int m = 0; m < kLfoModuleCount; ++m) {
-                    const auto &module = synth.fmParams.lfoModules[static_cast<size_t>(m)];
-                    if (!module.enabled || module.depth <= 0.0001f) {
-                        continue;
-                    }
-                    const float rateHz =
-                        module.sync ? lfoRateFromSyncIndex(module.syncIndex, bpmNow)
-                                    : (0.05f + safeParam(module.rate) * 10.0f);
-                    const float phase = synth.lfoPhaseModules[static_cast<size_t>(m)];
-                    const float value =
-                        lfoModuleValue(module, phase, synth.lfoHoldModules[static_cast<size_t>(m)]) *
-                        safeParam(module.depth);
-                    for (int t = 1; t < kModTargetCount; ++t) {
-                        moduleMods[static_cast<size_t>(t)] +=
-                            value * module.assign[static_cast<size_t>(t)];
-                    }
-                    float nextPhase =
-                        phase + 2.0f * static_cast<float>(M_PI) * rateHz / m_sampleRate;
-                    if (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
-                        nextPhase -= 2.0f * static_cast<float>(M_PI);
-                        synth.lfoNoiseModules[static_cast<size_t>(m)] =
-                            1664525u * synth.lfoNoiseModules[static_cast<size_t>(m)] +
-                            1013904223u;
-                        const float r =
-                            (static_cast<int>(synth.lfoNoiseModules[static_cast<size_t>(m)] >> 8) &
-                             0xFFFF) /
-                                32768.0f -
-                            1.0f;
-                        synth.lfoHoldModules[static_cast<size_t>(m)] = r;
-                    }
-                    synth.lfoPhaseModules[static_cast<size_t>(m)] = nextPhase;
-                }
+    std::array<float, 8> padPlayhead{};
+    padPlayhead.fill(-1.0f);
 
-                float left = m_synthScratchL[static_cast<size_t>(i)];
-                float right = m_synthScratchR[static_cast<size_t>(i)];
-
-                float lfoValue = 0.0f;
-                if (lfoActive) {
-                    if (synth.lfoShape == 4) {
-                        const float nextPhase = synth.lfoPhase + lfoInc;
-                        if (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
-                            synth.lfoNoise = 1664525u * synth.lfoNoise + 1013904223u;
-                            const float r =
-                                (static_cast<int>(synth.lfoNoise >> 8) & 0xFFFF) / 32768.0f -
-                                1.0f;
-                            synth.lfoHold = r;
-                        }
-                    }
-                    lfoValue =
-                        lfoShapeValue(synth.lfoShape, synth.lfoPhase, synth.lfoHold);
-                    synth.lfoPhase += lfoInc;
-                    if (synth.lfoPhase > 2.0f * static_cast<float>(M_PI)) {
-                        synth.lfoPhase -= 2.0f * static_cast<float>(M_PI);
-                    }
-                }
-                if (lfoActive && synth.lfoTarget == 1 && lfoDepth > 0.0001f) {
-                    env = std::max(0.0f, std::min(1.5f, env + lfoValue * lfoDepth));
-                }
-                if (useFilter) {
-                    float g = staticG;
-                    float R = staticR;
-                    float cutoff = baseCutoff;
-                    float envAmount = baseEnv;
-                    if (synth.fmParams.envAssign[7] > 0.0001f ||
-                        synth.fmParams.lfoAssign[7] > 0.0001f) {
-                        cutoff += (synth.fmParams.lfoAssign[7] * lfoValue +
-                                   synth.fmParams.envAssign[7] * env) *
-                                  0.5f;
-                    }
-                    if (synth.fmParams.envAssign[8] > 0.0001f ||
-                        synth.fmParams.lfoAssign[8] > 0.0001f) {
-                        baseRes += (synth.fmParams.lfoAssign[8] * lfoValue +
-                                    synth.fmParams.envAssign[8] * env) *
-                                   0.5f;
-                    }
-                    if (synth.fmParams.envAssign[9] > 0.0001f ||
-                        synth.fmParams.lfoAssign[9] > 0.0001f) {
-                        baseEnv += (synth.fmParams.lfoAssign[9] * lfoValue +
-                                    synth.fmParams.envAssign[9] * env) *
-                                   0.5f;
-                    }
-                    cutoff += moduleMods[7] * 0.5f;
-                    baseRes += moduleMods[8] * 0.5f;
-                    baseEnv += moduleMods[9] * 0.5f;
-                    if (synth.fmParams.envAssign[7] > 0.0001f ||
-                        synth.fmParams.lfoAssign[7] > 0.0001f) {
-                        cutoff = std::max(0.02f, std::min(0.98f, cutoff));
-                    }
-                    baseRes = std::max(0.0f, std::min(1.0f, baseRes));
-                    baseEnv = std::max(0.0f, std::min(1.0f, baseEnv));
-                    if (envAmount > 0.0001f) {
-                        cutoff = std::max(0.02f, std::min(0.98f, cutoff + env * envAmount));
-                    }
-                    if (lfoActive && lfoDepth > 0.0001f) {
-                        cutoff = std::max(0.02f,
-                                          std::min(0.98f, cutoff + lfoValue * lfoDepth * 0.5f));
-                    }
-                    if (g == 0.0f || lfoDepth > 0.0001f || synth.filterEnvAmount > 0.0001f) {
-                        const float hz = 40.0f * std::pow(2.0f, cutoff * 8.0f);
-                        g = std::tan(static_cast<float>(M_PI) * hz / m_sampleRate);
-                        const float q = 0.7f + baseRes * 7.0f;
-                        R = 1.0f / (2.0f * q);
-                    }
-                    if (g > 0.0f) {
-                        auto svf = [&](float input, float &ic1, float &ic2, float &low,
-                                       float &band, float &high) {
-                            const float v3 = input - ic2;
-                            const float v1 = (g * v3 + ic1) / (1.0f + g * (g + R));
-                            const float v2 = ic2 + g * v1;
-                            ic1 = 2.0f * v1 - ic1;
-                            ic2 = 2.0f * v2 - ic2;
-                            low = v2;
-                            band = v1;
-                            high = v3 - R * v1 - v2;
-                        };
-
-                        float lowL = 0.0f, bandL = 0.0f, highL = 0.0f;
-                        float lowR = 0.0f, bandR = 0.0f, highR = 0.0f;
-                        svf(left, synth.filterIc1L, synth.filterIc2L, lowL, bandL, highL);
-                        svf(right, synth.filterIc1R, synth.filterIc2R, lowR, bandR, highR);
-
-                        auto applyFilterMode = [&](float input, float low, float band, float high) {
-                            switch (synth.filterType) {
-                                case 0: // lowpass
-                                    return low;
-                                case 1: // highpass
-                                    return high;
-                                case 2: // bandpass
-                                    return band;
-                                case 3: // notch
-                                    return low + high;
-                                case 4: // peak
-                                    return band;
-                                case 5: // low shelf
-                                    return input + low * 0.6f;
-                                case 6: // high shelf
-                                    return input + high * 0.6f;
-                                case 7: // allpass (approx)
-                                    return input - 2.0f * R * band;
-                                case 8: // bypass
-                                    return input;
-                                case 9: // low+mid
-                                    return low + band;
-                                default:
-                                    return low;
-                            }
-                        };
-
-                        left = applyFilterMode(left, lowL, bandL, highL);
-                        right = applyFilterMode(right, lowR, bandR, highR);
-                    }
-                }
+    // Voices accumulate into planar per-bus blocks in runs that need no per-frame bounds
+    // checks; each touched bus is interleaved into its bus buffer once at the end.
+    std::array<bool, 6> voiceBusUsed{};
+    for (int v = 0; v < m_voiceCount;) {
+        Voice &voice = m_voices[static_cast<size_t>(v)];
+        if (!voice.buffer || !voice.buffer->isValid()) {
+            removeVoice(v);
+            continue;
+        }
+
+        const float *floatData = voice.buffer->floatData();
+        const int16_t *int16Data = voice.buffer->int16Data();
+        const int channels = voice.buffer->channels();
+        // Streaming voices read past their head; the rest stop where their buffer does.
+        const bool streaming = voice.streamSlot >= 0;
+        const int lastFrame =
+            streaming ? voice.endFrame - 1 : std::min(voice.endFrame, voice.buffer->frames()) - 1;
+        const int streamFirst =
+            streaming ? m_streamSlots[static_cast<size_t>(voice.streamSlot)].first : 0;
+        const size_t busIndex = static_cast<size_t>(
+            std::max(0, std::min(static_cast<int>(m_busBuffers.size() - 1), voice.bus)));
+        float *left = m_voiceLeft[busIndex].data();
+        float *right = m_voiceRight[busIndex].data();
+        if (!voiceBusUsed[busIndex]) {
+            std::fill(left, left + frames, 0.0f);
+            std::fill(right, right + frames, 0.0f);
+            voiceBusUsed[busIndex] = true;
+        }
 
-                const int idx = i * m_channels;
-                busOut[idx] += left * synth.gainL * env;
-                if (m_channels > 1) {
-                    busOut[idx + 1] += right * synth.gainR * env;
+        if (voice.releaseRequested && voice.envStage != EnvStage::Release) {
+            voice.envStage = EnvStage::Release;
+        }
+        bool done = false;
+        int audible = frames;
+        const float *env = nullptr;
+        if (voice.useEnv) {
+            audible = renderVoiceEnv(voice, m_voiceEnv.data(), frames, done);
+            env = m_voiceEnv.data();
+        }
+
+        double pos = voice.position;
+        const double rate = voice.rate;
+        int i = 0;
+        while (i < audible && lastFrame >= 0) {
+            if (pos >= lastFrame + 1) {
+                if (!voice.loop) {
+                    done = true;
+                    break;
                 }
-                if (!useExternalEnv && !hasNotes) {
-                    const float peakL = std::fabs(left * synth.gainL);
-                    const float peakR = std::fabs(right * synth.gainR);
-                    tailPeak = std::max(tailPeak, std::max(peakL, peakR));
+                pos = static_cast<double>(voice.startFrame);
+                if (streaming) {
+                    ++voice.streamPass;
                 }
             }
-            if (!useExternalEnv && !hasNotes) {
-                if (tailPeak < 0.00008f) {
-                    synth.releaseRequested = false;
-                    synth.env = 0.0f;
-                }
+            if (streaming && pos >= streamFirst) {
+                const int run =
+                    mixStreamRun(voice, lastFrame, pos, audible - i, env ? env + i : nullptr,
+                                 left + i, right + i);
+                pos += run * rate;
+                i += run;
+                continue;
+            }
+            // Frames left before the read position crosses the end of the region, or for a
+            // streaming voice, before it needs a frame the head does not have.
+            const double limit = static_cast<double>(streaming ? streamFirst : lastFrame + 1);
+            int run = static_cast<int>(std::ceil((limit - pos) / rate));
+            run = std::max(1, std::min(run, audible - i));
+            while (run > 1 && pos + (run - 1) * rate >= limit) {
+                --run;
             }
+            if (int16Data) {
+                VoiceKernel::mixLinear(int16Data, channels, lastFrame, pos, rate,
+                                       env ? env + i : nullptr, voice.gainL, voice.gainR,
+                                       left + i, right + i, run);
+            } else {
+                VoiceKernel::mixLinear(floatData, channels, lastFrame, pos, rate,
+                                       env ? env + i : nullptr, voice.gainL, voice.gainR,
+                                       left + i, right + i, run);
+            }
+            pos += run * rate;
+            i += run;
+        }
+        if (lastFrame < 0) {
+            done = true;
+        }
+
+        voice.position = pos;
+        if (voice.padId >= 0 && voice.padId < static_cast<int>(padPlayhead.size())) {
+            const int denom = std::max(1, voice.endFrame - voice.startFrame);
+            float ratio = static_cast<float>((pos - voice.startFrame) / static_cast<double>(denom));
+            ratio = std::max(0.0f, std::min(1.0f, ratio));
+            const size_t padIdx = static_cast<size_t>(voice.padId);
+            if (padPlayhead[padIdx] < 0.0f) {
+                padPlayhead[padIdx] = ratio;
+            } else if (ratio > padPlayhead[padIdx]) {
+                padPlayhead[padIdx] = ratio;
+            }
+        }
+        if (done) {
+            removeVoice(v);
+        } else {
+            ++v;
+        }
+    }
+    for (size_t bus = 0; bus < voiceBusUsed.size(); ++bus) {
+        if (voiceBusUsed[bus]) {
+            VoiceKernel::interleaveAdd(m_voiceLeft[bus].data(), m_voiceRight[bus].data(),
+                                       m_busBuffers[bus].data(), m_channels, frames);
         }
     }
 
+    for (size_t i = 0; i < m_padPlayheads.size(); ++i) {
+        m_padPlayheads[i].store(padPlayhead[i], std::memory_order_relaxed);
+    }
+    std::array<bool, 8> padActive{};
+    for (int v = 0; v < m_voiceCount; ++v) {
+        const Voice &voice = m_voices[static_cast<size_t>(v)];
+        if (voice.padId >= 0 && voice.padId < static_cast<int>(padActive.size())) {
+            padActive[static_cast<size_t>(voice.padId)] = true;
+        }
+    }
+    for (size_t i = 0; i < m_padActive.size(); ++i) {
+        m_padActive[i].store(padActive[i], std::memory_order_relaxed);
+    }
+
+    // Synth pads render into their own blocks, spread over the worker pool, and are summed into
+    // their buses afterwards so no two jobs ever write the same buffer.
+    if (frames > 0) {
+        auto synthJob = [this, frames](int pad) {
+            SynthBlock &block = m_synthBlocks[static_cast<size_t>(pad)];
+            const auto synthBegin = std::chrono::steady_clock::now();
+            block.active = renderSynth(static_cast<size_t>(pad), frames);
+            m_dspStats.addSynth(pad, elapsedNs(synthBegin));
+        };
+        m_workers.run(static_cast<int>(m_synthStates.size()), synthJob);
+        for (size_t pad = 0; pad < m_synthStates.size(); ++pad) {
+            const SynthBlock &block = m_synthBlocks[pad];
+            if (!block.active) {
+                continue;
+            }
+            const int busIndex = std::max(
+                0, std::min(static_cast<int>(m_busBuffers.size() - 1), m_synthStates[pad].bus));
+            float *busOut = m_busBuffers[static_cast<size_t>(busIndex)].data();
+            for (int i = 0; i < samples; ++i) {
+                busOut[i] += block.out[static_cast<size_t>(i)];
+            }
+        }
+    }
+    for (size_t pad = 0; pad < m_synthStates.size(); ++pad) {
+        const SynthState &synth = m_synthStates[pad];
+        const bool active =
+            synth.enabled && (std::any_of(synth.activeNotes.begin(), synth.activeNotes.end(),
+                                          [](bool v) { return v; }) ||
+                              synth.env > 0.0005f);
+        m_synthActive[pad].store(active, std::memory_order_relaxed);
+    }
+
     // Compute sidechain envelope from sum of all buses pre-effects.
-    std::vector<float> drySum(frames * m_channels, 0.0f);
+    float *drySum = m_drySum.data();
+    std::fill(drySum, drySum + samples, 0.0f);
     for (const auto &buf : m_busBuffers) {
-        for (int i = 0; i < frames * m_channels; ++i) {
+        for (int i = 0; i < samples; ++i) {
             drySum[i] += buf[i];
         }
     }
 
     float sideEnv = 0.0f;
     if (m_hasSidechain.load()) {
-        sideEnv = computeEnv(drySum.data(), frames);
+        sideEnv = computeEnv(drySum, frames);
     }
 
     // Start master with bus 0 only (avoid double-counting).
-    std::vector<float> master(frames * m_channels, 0.0f);
-    if (!m_busBuffers.empty()) {
-        std::copy(m_busBuffers[0].begin(), m_busBuffers[0].end(), master.begin());
-    }
-
-    // Process buses 1..5 into master.
-    for (size_t bus = 1; bus < m_busBuffers.size(); ++bus) {
+    float *master = m_master.data();
+    std::copy(m_busBuffers[0].begin(), m_busBuffers[0].begin() + samples, master);
+
+    // Process buses 1..5 in parallel; each job only touches its own chain and buffer. The sum
+    // into master waits for all of them.
+    auto busJob = [this, frames, sideEnv](int job) {
+        const size_t bus = static_cast<size_t>(job + 1);
+        const auto busBegin = std::chrono::steady_clock::now();
         processBus(static_cast<int>(bus), m_busBuffers[bus].data(), frames, sideEnv);
         const float gain = m_busGains[bus].load();
         for (int i = 0; i < frames * m_channels; ++i) {
             m_busBuffers[bus][i] *= gain;
         }
+        if (m_busTaps[bus]) {
+            std::copy(m_busBuffers[bus].begin(), m_busBuffers[bus].begin() + frames * m_channels,
+                      m_busTaps[bus] + m_blockOffset * m_channels);
+        }
+        m_busMeters[bus].store(computePeak(m_busBuffers[bus].data(), frames));
+        m_dspStats.addBus(static_cast<int>(bus), elapsedNs(busBegin));
+    };
+    m_workers.run(static_cast<int>(m_busBuffers.size()) - 1, busJob);
+    for (size_t bus = 1; bus < m_busBuffers.size(); ++bus) {
         for (int i = 0; i < frames * m_channels; ++i) {
             master[i] += m_busBuffers[bus][i];
         }
-        const float meter = computePeak(m_busBuffers[bus].data(), frames);
-        m_busMeters[bus].store(meter);
     }
 
     // Process master chain (bus 0).
     if (!m_busBuffers.empty()) {
-        processBus(0, master.data(), frames, sideEnv);
+        const auto masterBegin = std::chrono::steady_clock::now();
+        processBus(0, master, frames, sideEnv);
+        m_dspStats.addBus(0, elapsedNs(masterBegin));
     }
     const float masterGain = m_busGains[0].load();
     for (int i = 0; i < frames * m_channels; ++i) {
         master[i] *= masterGain;
     }
-    m_busMeters[0].store(computePeak(master.data(), frames));
+    m_busMeters[0].store(computePeak(master, frames));
 
-    // Recording tap (float).
-    if (m_recording.load()) {
-        std::lock_guard<std::mutex> lock(m_recordMutex);
-        if (m_recording.load() && m_recordFramesLeft > 0) {
-            const int framesToWrite = std::min(frames, m_recordFramesLeft);
-            m_recordFloat.insert(m_recordFloat.end(), master.begin(),
-                                 master.begin() + framesToWrite * m_channels);
-            m_recordFramesLeft -= framesToWrite;
-            if (m_recordFramesLeft <= 0) {
-                m_recording.store(false);
-                writeWavFile(m_recordPath, m_recordFloat, m_sampleRate, m_recordTargetRate,
-                             m_channels);
-                m_recordFloat.clear();
+    // Recording tap: hand the block to the writer thread, never wait for it.
+    if (m_recording.load(std::memory_order_acquire)) {
+        if (m_recordStop.load(std::memory_order_relaxed)) {
+            m_recording.store(false, std::memory_order_release);
+        } else {
+            int framesToWrite = frames;
+            if (m_recordFramesLeft >= 0) {
+                framesToWrite = static_cast<int>(std::min<qint64>(frames, m_recordFramesLeft));
+            }
+            const int room =
+                static_cast<int>(m_recordRing.writeAvailable() / static_cast<size_t>(m_channels));
+            const int written = std::min(framesToWrite, room);
+            m_recordRing.write(master, static_cast<size_t>(written * m_channels));
+            if (written < framesToWrite) {
+                m_recordDropped.fetch_add(static_cast<quint64>(framesToWrite - written),
+                                          std::memory_order_relaxed);
+            }
+            if (m_recordFramesLeft >= 0) {
+                m_recordFramesLeft -= framesToWrite;
+                if (m_recordFramesLeft <= 0) {
+                    m_recording.store(false, std::memory_order_release);
+                }
             }
         }
     }
 
-    std::copy(master.begin(), master.end(), out);
-    if (static_cast<int>(m_lastOut.size()) != frames * m_channels) {
-        m_lastOut.resize(frames * m_channels);
-    }
-    std::copy(master.begin(), master.end(), m_lastOut.begin());
-    m_lastOutValid = true;
-}
-
-float AudioEngine::computeEnv(const float *buffer, int frames) const {
-    double sum = 0.0;
-    const int count = frames * m_channels;
-    for (int i = 0; i < count; ++i) {
-        const float v = buffer[i];
-        sum += static_cast<double>(v * v);
-    }
-    const double rms = (count > 0) ? std::sqrt(sum / static_cast<double>(count)) : 0.0;
-    return static_cast<float>(rms);
+    std::copy(master, master + samples, out);
 }
 
-float AudioEngine::computePeak(const float *buffer, int frames) const {
-    float peak = 0.0f;
-    const int count = frames * m_channels;
-    for (int i = 0; i < count; ++i) {
-        const float v = std::fabs(buffer[i]);
-        if (v > peak) {
-            peak = v;
+// Fills env[] for one block and advances the voice envelope. Returns how many frames are
+// audible; finished is set when the release runs out inside the block.
+int AudioEngine::renderVoiceEnv(Voice &voice, float *env, int frames, bool &finished) const {
+    const int padIndex = qBound(0, voice.padId, static_cast<int>(m_padAttack.size()) - 1);
+    const float attack = m_padAttack[static_cast<size_t>(padIndex)].load();
+    const float decay = m_padDecay[static_cast<size_t>(padIndex)].load();
+    const float sustain = m_padSustain[static_cast<size_t>(padIndex)].load();
+    const float release = m_padRelease[static_cast<size_t>(padIndex)].load();
+
+    const float attackSec = attack * 1.2f;
+    const float decaySec = decay * 1.2f;
+    const float releaseSec = voice.choked ? kChokeReleaseSec : release * 1.6f;
+    const float attackStep = attackSec > 0.0f ? 1.0f / (attackSec * m_sampleRate) : 1.0f;
+    const float decayStep = decaySec > 0.0f ? (1.0f - sustain) / (decaySec * m_sampleRate) : 1.0f;
+    const float releaseStep = releaseSec > 0.0f ? 1.0f / (releaseSec * m_sampleRate) : 1.0f;
+
+    float value = voice.env;
+    int i = 0;
+    while (i < frames) {
+        switch (voice.envStage) {
+            case EnvStage::Attack:
+                while (i < frames && voice.envStage == EnvStage::Attack) {
+                    value += attackStep;
+                    if (value >= 1.0f) {
+                        value = 1.0f;
+                        voice.envStage = EnvStage::Decay;
+                    }
+                    env[i++] = value;
+                }
+                break;
+            case EnvStage::Decay:
+                while (i < frames && voice.envStage == EnvStage::Decay) {
+                    value -= decayStep;
+                    if (value <= sustain || decaySec <= 0.0f) {
+                        value = sustain;
+                        voice.envStage = EnvStage::Sustain;
+                    }
+                    env[i++] = value;
+                }
+                break;
+            case EnvStage::Sustain:
+                value = sustain;
+                std::fill(env + i, env + frames, sustain);
+                i = frames;
+                break;
+            case EnvStage::Release:
+                while (i < frames) {
+                    value -= releaseStep * std::max(0.1f, value);
+                    if (value <= 0.0005f || releaseSec <= 0.0f) {
+                        env[i++] = 0.0f;
+                        voice.env = 0.0f;
+                        finished = true;
+                        return i;
+                    }
+                    env[i++] = value;
+                }
+                break;
         }
     }
-    return peak;
+    voice.env = value;
+    return frames;
 }
 
-void AudioEngine::processBus(int busIndex, float *buffer, int frames, float sidechainEnv) {
-    if (busIndex < 0 || busIndex >= static_cast<int>(m_busChains.size())) {
-        return;
+bool AudioEngine::renderSynth(size_t pad, int frames) {
+    SynthState &synth = m_synthStates[pad];
+    if (!synth.enabled || !synth.engine) {
+        return false;
     }
-    BusChain &chain = m_busChains[static_cast<size_t>(busIndex)];
-    if (chain.effects.empty()) {
-        return;
+    SynthCore &engine = *synth.engine;
+    SynthBlock &block = m_synthBlocks[pad];
+    float *out = block.out.data();
+    std::fill(out, out + frames * m_channels, 0.0f);
+
+    const int padIndex = qBound(0, static_cast<int>(pad),
+                                static_cast<int>(m_padAttack.size()) - 1);
+    const float attack = m_padAttack[static_cast<size_t>(padIndex)].load();
+    const float decay = m_padDecay[static_cast<size_t>(padIndex)].load();
+    const float sustain = m_padSustain[static_cast<size_t>(padIndex)].load();
+    const float release = m_padRelease[static_cast<size_t>(padIndex)].load();
+
+    const float attackSec = attack * 1.2f;
+    const float decaySec = decay * 1.2f;
+    const float releaseSec = release * 1.6f;
+    const float attackStep =
+        attackSec > 0.0f ? 1.0f / (attackSec * m_sampleRate) : 1.0f;
+    const float decayStep =
+        decaySec > 0.0f ? (1.0f - sustain) / (decaySec * m_sampleRate) : 1.0f;
+    const float releaseStep =
+        releaseSec > 0.0f ? 1.0f / (releaseSec * m_sampleRate) : 1.0f;
+
+    const bool isDx7 = (engine.kind == SynthKind::Dx7);
+    const bool isSimple = (engine.kind == SynthKind::Simple);
+    const bool neutralEnv =
+        (attack <= 0.001f && decay <= 0.001f && release <= 0.001f && sustain >= 0.999f);
+    const bool useExternalEnv = isDx7 ? !neutralEnv : true;
+
+    const bool hasNotes = std::any_of(synth.activeNotes.begin(),
+                                     synth.activeNotes.end(),
+                                     [](bool v) { return v; });
+    if (!hasNotes && !synth.releaseRequested) {
+        synth.env = 0.0f;
+        synth.envStage = EnvStage::Attack;
+        return false;
+    }
+    std::array<float, kModTargetCount> blockMods{};
+    const float bpmNow = std::max(30.0f, std::min(300.0f, m_bpm.load()));
+    for (int m = 0; m < kLfoModuleCount; ++m) {
+        const auto &module = synth.fmParams.lfoModules[static_cast<size_t>(m)];
+        if (!module.enabled || module.depth <= 0.0001f) {
+            continue;
+        }
+        const float rateHz =
+            module.sync ? lfoRateFromSyncIndex(module.syncIndex, bpmNow)
+                        : (0.05f + safeParam(module.rate) * 10.0f);
+        const float value = lfoModuleValue(module,
+                                           synth.lfoPhaseModules[static_cast<size_t>(m)],
+                                           synth.lfoHoldModules[static_cast<size_t>(m)]) *
+                            safeParam(module.depth);
+        for (int t = 1; t < kModTargetCount; ++t) {
+            blockMods[static_cast<size_t>(t)] +=
+                value * module.assign[static_cast<size_t>(t)];
+        }
+        float nextPhase = synth.lfoPhaseModules[static_cast<size_t>(m)] +
+                          (2.0f * static_cast<float>(M_PI) * rateHz / m_sampleRate) *
+                              std::min(frames, 64);
+        if (module.kind == 1) {
+            nextPhase = std::fmod(nextPhase, 2.0f * static_cast<float>(M_PI));
+        }
+        while (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
+            nextPhase -= 2.0f * static_cast<float>(M_PI);
+        }
+        synth.lfoPhaseModules[static_cast<size_t>(m)] = nextPhase;
     }
+    for (int m = 0; m < kEnvModuleCount; ++m) {
+        const auto &module = synth.fmParams.envModules[static_cast<size_t>(m)];
+        if (!module.enabled) {
+            continue;
+        }
+        const float value = synth.envValues[static_cast<size_t>(m)];
+        for (int t = 1; t < kModTargetCount; ++t) {
+            blockMods[static_cast<size_t>(t)] +=
+                value * module.assign[static_cast<size_t>(t)];
+        }
+    }
+    if (isCustomKind(engine.kind) && engine.op1) {
+        AudioEngine::FmParams modParams = synth.fmParams;
+        for (int m = 0; m < 4; ++m) {
+            const int targetIndex = 13 + m;
+            const float mod = blockMods[static_cast<size_t>(targetIndex)];
+            if (std::fabs(mod) <= 0.0001f) {
+                continue;
+            }
+            applyCustomMacroMod(engine.kind, m, mod, modParams);
+        }
 
-    for (EffectState &fx : chain.effects) {
-        const float p1 = safeParam(fx.p1);
-        const float p2 = safeParam(fx.p2);
-        const float p3 = safeParam(fx.p3);
-        const float p4 = safeParam(fx.p4);
-        const float p5 = safeParam(fx.p5);
-        switch (fx.type) {
-            case 1: {  // reverb
-                if (fx.bufA.empty()) {
-                    const int lenA = static_cast<int>(m_sampleRate * 0.031f);
-                    const int lenB = static_cast<int>(m_sampleRate * 0.037f);
-                    fx.bufA.assign(lenA * m_channels, 0.0f);
-                    fx.bufB.assign(lenB * m_channels, 0.0f);
-                    fx.indexA = 0;
-                    fx.indexB = 0;
-                }
-                const float wet = p1;
-                const float feedback = 0.4f + p2 * 0.5f;
-                for (int i = 0; i < frames; ++i) {
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int idx = i * m_channels + ch;
-                        const int ia = (fx.indexA * m_channels + ch) % fx.bufA.size();
-                        const int ib = (fx.indexB * m_channels + ch) % fx.bufB.size();
-                        const float a = fx.bufA[ia];
-                        const float b = fx.bufB[ib];
-                        fx.bufA[ia] = buffer[idx] + a * feedback;
-                        fx.bufB[ib] = buffer[idx] + b * feedback;
-                        const float mix = (a + b) * 0.5f;
-                        buffer[idx] = buffer[idx] * (1.0f - wet) + mix * wet;
-                    }
-                    fx.indexA = (fx.indexA + 1) % (fx.bufA.size() / m_channels);
-                    fx.indexB = (fx.indexB + 1) % (fx.bufB.size() / m_channels);
-                }
-                break;
+        auto applyDirect = [&](int target, auto applyFn) {
+            if (target <= 0 || target >= AudioEngine::kModTargetCount) {
+                return;
             }
-            case 2: {  // comp
-                const float threshold = 0.15f + p1 * 0.5f;
-                const float ratio = 1.5f + p2 * 6.5f;
-                const float attack = 0.01f + p3 * 0.12f;
-                const float release = 0.03f + p4 * 0.35f;
-                for (int i = 0; i < frames; ++i) {
-                    float env = 0.0f;
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const float v = std::fabs(buffer[i * m_channels + ch]);
-                        if (v > env) {
-                            env = v;
-                        }
-                    }
-                    const float coeff = (env > fx.env) ? attack : release;
-                    fx.env = fx.env + (env - fx.env) * coeff;
-                    float gain = 1.0f;
-                    if (fx.env > threshold) {
-                        const float over = fx.env / threshold;
-                        gain = std::pow(over, -(ratio - 1.0f) / ratio);
-                    }
-                    const float makeup = (p5 >= 0.5f) ? 1.35f : 1.0f;
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        buffer[i * m_channels + ch] *= (gain * makeup);
-                    }
-                }
-                break;
+            const float mod = blockMods[static_cast<size_t>(target)];
+            if (std::fabs(mod) <= 0.0001f) {
+                return;
             }
-            case 3: {  // dist
-                const float drive = 1.0f + p1 * 6.0f;
-                const float mix = p2;
-                for (int i = 0; i < frames * m_channels; ++i) {
-                    const float v = buffer[i] * drive;
-                    const float d = std::tanh(v);
-                    buffer[i] = buffer[i] * (1.0f - mix) + d * mix;
-                }
+            applyFn(mod);
+        };
+
+        applyDirect(1, [&](float mod) { // Osc1Detune
+            modParams.osc1Detune = modClamp(modParams.osc1Detune + mod * 0.5f, 0.0f, 1.0f);
+        });
+        applyDirect(2, [&](float mod) { // Osc1Gain
+            modParams.osc1Gain = modClamp(modParams.osc1Gain + mod * 0.5f, 0.0f, 1.0f);
+        });
+        applyDirect(3, [&](float mod) { // Osc1Pan
+            modParams.osc1Pan = modClamp(modParams.osc1Pan + mod * 0.5f, -1.0f, 1.0f);
+        });
+        applyDirect(4, [&](float mod) { // Osc2Detune
+            modParams.osc2Detune = modClamp(modParams.osc2Detune + mod * 0.5f, 0.0f, 1.0f);
+        });
+        applyDirect(5, [&](float mod) { // Osc2Gain
+            modParams.osc2Gain = modClamp(modParams.osc2Gain + mod * 0.5f, 0.0f, 1.0f);
+        });
+        applyDirect(6, [&](float mod) { // Osc2Pan
+            modParams.osc2Pan = modClamp(modParams.osc2Pan + mod * 0.5f, -1.0f, 1.0f);
+        });
+        applyDirect(10, [&](float mod) { // FmAmount
+            modParams.fmAmount = modClamp(modParams.fmAmount + mod * 0.6f, 0.0f, 1.0f);
+        });
+        applyDirect(11, [&](float mod) { // Ratio
+            modParams.ratio = modClamp(modParams.ratio + mod * 2.0f, 0.1f, 8.0f);
+        });
+        applyDirect(12, [&](float mod) { // Feedback
+            modParams.feedback = modClamp(modParams.feedback + mod * 0.6f, 0.0f, 1.0f);
+        });
+
+        engine.op1->setParams(toOp1Params(modParams));
+    }
+
+    if (engine.kind == SynthKind::Simple) {
+        engine.simple.render(block.left.data(), block.right.data(), frames);
+    } else if (engine.kind == SynthKind::Dx7) {
+        engine.core.render(block.left.data(), block.right.data(), frames);
+    } else if (engine.op1) {
+        engine.op1->render(block.left.data(), block.right.data(), frames);
+    } else {
+        std::fill(block.left.begin(), block.left.end(), 0.0f);
+        std::fill(block.right.begin(), block.right.end(), 0.0f);
+    }
+
+    const bool useFilter = (synth.filterType != 8);
+    float baseCutoff = synth.filterCutoff;
+    float baseRes = synth.filterResonance;
+    float baseEnv = synth.filterEnvAmount;
+    const float lfoDepth = synth.lfoDepth;
+    float lfoRateHz = 0.1f + synth.lfoRate * 8.0f;
+    if (synth.lfoSync) {
+        static const float syncBeats[] = {4.0f, 2.0f, 1.0f, 0.5f, 0.25f, 0.125f, 0.333f,
+                                          0.166f};
+        const int idx = std::max(0, std::min(7, synth.lfoSyncIndex));
+        const float beats = syncBeats[idx];
+        const float bpm = std::max(30.0f, std::min(300.0f, m_bpm.load()));
+        const float bps = bpm / 60.0f;
+        if (beats > 0.0f) {
+            lfoRateHz = bps / beats;
+        }
+    }
+    const float lfoInc = 2.0f * static_cast<float>(M_PI) * lfoRateHz / m_sampleRate;
+    bool lfoActive = lfoDepth > 0.0001f;
+    if (!lfoActive) {
+        for (float v : synth.fmParams.lfoAssign) {
+            if (v > 0.0001f) {
+                lfoActive = true;
                 break;
             }
-            case 4: {  // lofi
-                const int hold = std::max(1, 1 + static_cast<int>(p2 * 7.0f));
-                const float bits = 4.0f + p1 * 8.0f;
-                const float step = 1.0f / std::pow(2.0f, bits);
-                for (int i = 0; i < frames; ++i) {
-                    if ((i % hold) == 0) {
-                        fx.z1L = buffer[i * m_channels];
-                        if (m_channels > 1) {
-                            fx.z1R = buffer[i * m_channels + 1];
-                        }
+        }
+    }
+    float staticG = 0.0f;
+    float staticR = 0.0f;
+    if (useFilter && lfoDepth <= 0.0001f) {
+        const float cutoff = std::max(0.02f, std::min(0.98f, baseCutoff));
+        const float hz = 40.0f * std::pow(2.0f, cutoff * 8.0f);
+        const float g = std::tan(static_cast<float>(M_PI) * hz / m_sampleRate);
+        const float q = 0.7f + baseRes * 7.0f;
+        staticG = g;
+        staticR = 1.0f / (2.0f * q);
+    }
+
+    float tailPeak = 0.0f;
+    for (int i = 0; i < frames; ++i) {
+        float env = 1.0f;
+        if (useExternalEnv) {
+            if (synth.releaseRequested && !hasNotes &&
+                synth.envStage != EnvStage::Release) {
+                synth.envStage = EnvStage::Release;
+            }
+            env = synth.env;
+            switch (synth.envStage) {
+                case EnvStage::Attack:
+                    env += attackStep;
+                    if (env >= 1.0f) {
+                        env = 1.0f;
+                        synth.envStage = EnvStage::Decay;
                     }
-                    float left = std::round(fx.z1L / step) * step;
-                    float right = (m_channels > 1) ? std::round(fx.z1R / step) * step : left;
-                    buffer[i * m_channels] = left;
-                    if (m_channels > 1) {
-                        buffer[i * m_channels + 1] = right;
+                    break;
+                case EnvStage::Decay:
+                    env -= decayStep;
+                    if (env <= sustain || decaySec <= 0.0f) {
+                        env = sustain;
+                        synth.envStage = EnvStage::Sustain;
                     }
-                }
-                break;
+                    break;
+                case EnvStage::Sustain:
+                    env = sustain;
+                    break;
+                case EnvStage::Release:
+                    env -= releaseStep * std::max(0.1f, env);
+                    if (env <= 0.0005f || releaseSec <= 0.0f) {
+                        env = 0.0f;
+                        synth.releaseRequested = false;
+                    }
+                    break;
             }
-            case 5: {  // cassette
-                const float noiseAmount = p1 * 0.05f;
-                const float lpf = 0.05f + p2 * 0.3f;
-                for (int i = 0; i < frames * m_channels; ++i) {
-                    const float noise = (static_cast<float>(std::rand()) / RAND_MAX - 0.5f) *
-                                        noiseAmount;
-                    fx.z1L = fx.z1L + lpf * (buffer[i] - fx.z1L);
-                    buffer[i] = std::tanh(fx.z1L + noise);
-                }
-                break;
+            synth.env = env;
+        } else {
+            synth.envStage = EnvStage::Sustain;
+            synth.env = 1.0f;
+        }
+
+        std::array<float, kModTargetCount> moduleMods{};
+        for (int m = 0; m < kEnvModuleCount; ++m) {
+            const auto &module = synth.fmParams.envModules[static_cast<size_t>(m)];
+            if (!module.enabled) {
+                continue;
             }
-            case 6: {  // chorus
-                if (fx.bufA.empty()) {
-                    const int len = static_cast<int>(m_sampleRate * 0.03f);
-                    fx.bufA.assign(len * m_channels, 0.0f);
-                    fx.indexA = 0;
-                    fx.phase = 0.0f;
-                }
-                const float depth = 0.002f + p1 * 0.008f;
-                const float rate = 0.1f + p2 * 0.8f;
-                const float mix = p3;
-                for (int i = 0; i < frames; ++i) {
-                    const float lfoL = (std::sin(fx.phase) + 1.0f) * 0.5f;
-                    const float lfoR = (std::sin(fx.phase + static_cast<float>(M_PI) * 0.5f) + 1.0f) * 0.5f;
-                    const int delayL = static_cast<int>((0.005f + depth * lfoL) * m_sampleRate);
-                    const int delayR = static_cast<int>((0.005f + depth * lfoR) * m_sampleRate);
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int writeIdx = (fx.indexA * m_channels + ch) % fx.bufA.size();
-                        fx.bufA[writeIdx] = buffer[i * m_channels + ch];
-                        int readIndex = fx.indexA - (ch == 0 ? delayL : delayR);
-                        if (readIndex < 0) {
-                            readIndex += fx.bufA.size() / m_channels;
-                        }
-                        const int readIdx = (readIndex * m_channels + ch) % fx.bufA.size();
-                        const float delayed = fx.bufA[readIdx];
-                        buffer[i * m_channels + ch] =
-                            buffer[i * m_channels + ch] * (1.0f - mix) + delayed * mix;
+            if (synth.envReleaseRequested[static_cast<size_t>(m)] && !hasNotes &&
+                synth.envStages[static_cast<size_t>(m)] != EnvStage::Release) {
+                synth.envStages[static_cast<size_t>(m)] = EnvStage::Release;
+            }
+            float value = synth.envValues[static_cast<size_t>(m)];
+            const float aSec = safeParam(module.attack) * 1.2f;
+            const float dSec = safeParam(module.decay) * 1.2f;
+            const float rSec = safeParam(module.release) * 1.6f;
+            const float sus = safeParam(module.sustain);
+            const float aStep = aSec > 0.0f ? 1.0f / (aSec * m_sampleRate) : 1.0f;
+            const float dStep =
+                dSec > 0.0f ? (1.0f - sus) / (dSec * m_sampleRate) : 1.0f;
+            const float rStep = rSec > 0.0f ? 1.0f / (rSec * m_sampleRate) : 1.0f;
+            switch (synth.envStages[static_cast<size_t>(m)]) {
+                case EnvStage::Attack:
+                    value += aStep;
+                    if (value >= 1.0f || aSec <= 0.0f) {
+                        value = 1.0f;
+                        synth.envStages[static_cast<size_t>(m)] = EnvStage::Decay;
                     }
-                    fx.indexA = (fx.indexA + 1) % (fx.bufA.size() / m_channels);
-                    fx.phase += 2.0f * static_cast<float>(M_PI) * rate / m_sampleRate;
-                    if (fx.phase > 2.0f * static_cast<float>(M_PI)) {
-                        fx.phase -= 2.0f * static_cast<float>(M_PI);
+                    break;
+                case EnvStage::Decay:
+                    value -= dStep;
+                    if (value <= sus || dSec <= 0.0f) {
+                        value = sus;
+                        synth.envStages[static_cast<size_t>(m)] = EnvStage::Sustain;
                     }
-                }
-                break;
+                    break;
+                case EnvStage::Sustain:
+                    value = sus;
+                    break;
+                case EnvStage::Release:
+                    value -= rStep * std::max(0.1f, value);
+                    if (value <= 0.0005f || rSec <= 0.0f) {
+                        value = 0.0f;
+                        synth.envReleaseRequested[static_cast<size_t>(m)] = false;
+                    }
+                    break;
             }
-            case 7: {  // eq (low/high cut)
-                float lowCut = 30.0f * std::pow(2.0f, p1 * 5.5f);
-                float highCut = 800.0f * std::pow(2.0f, p2 * 4.5f);
-                lowCut = std::min(lowCut, 4000.0f);
-                highCut = std::min(highCut, static_cast<float>(m_sampleRate * 0.45f));
-                if (highCut < lowCut * 1.5f) {
-                    highCut = lowCut * 1.5f;
-                }
-
-                auto alphaFor = [&](float hz) {
-                    const float x = -2.0f * static_cast<float>(M_PI) * hz / m_sampleRate;
-                    return std::exp(x);
-                };
-                const float aLow = alphaFor(lowCut);
-                const float aHigh = alphaFor(highCut);
+            synth.envValues[static_cast<size_t>(m)] = value;
+            for (int t = 1; t < kModTargetCount; ++t) {
+                moduleMods[static_cast<size_t>(t)] +=
+                    value * module.assign[static_cast<size_t>(t)];
+            }
+        }
 
-                auto onePoleLow = [](float x, float &z, float a) {
-                    z = a * z + (1.0f - a) * x;
-                    return z;
-                };
-                auto onePoleHigh = [](float x, float &z, float a) {
-                    z = a * z + (1.0f - a) * x;
-                    return x - z;
-                };
+        for (int m = 0; m < kLfoModuleCount; ++m) {
+            const auto &module = synth.fmParams.lfoModules[static_cast<size_t>(m)];
+            if (!module.enabled || module.depth <= 0.0001f) {
+                continue;
+            }
+            const float rateHz =
+                module.sync ? lfoRateFromSyncIndex(module.syncIndex, bpmNow)
+                            : (0.05f + safeParam(module.rate) * 10.0f);
+            const float phase = synth.lfoPhaseModules[static_cast<size_t>(m)];
+            const float value =
+                lfoModuleValue(module, phase, synth.lfoHoldModules[static_cast<size_t>(m)]) *
+                safeParam(module.depth);
+            for (int t = 1; t < kModTargetCount; ++t) {
+                moduleMods[static_cast<size_t>(t)] +=
+                    value * module.assign[static_cast<size_t>(t)];
+            }
+            float nextPhase =
+                phase + 2.0f * static_cast<float>(M_PI) * rateHz / m_sampleRate;
+            if (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
+                nextPhase -= 2.0f * static_cast<float>(M_PI);
+                synth.lfoNoiseModules[static_cast<size_t>(m)] =
+                    1664525u * synth.lfoNoiseModules[static_cast<size_t>(m)] +
+                    1013904223u;
+                const float r =
+                    (static_cast<int>(synth.lfoNoiseModules[static_cast<size_t>(m)] >> 8) &
+                     0xFFFF) /
+                        32768.0f -
+                    1.0f;
+                synth.lfoHoldModules[static_cast<size_t>(m)] = r;
+            }
+            synth.lfoPhaseModules[static_cast<size_t>(m)] = nextPhase;
+        }
 
-                for (int i = 0; i < frames; ++i) {
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int idx = i * m_channels + ch;
-                        float x = buffer[idx];
-                        float hp = (ch == 0)
-                                       ? onePoleHigh(x, fx.eqLowL, aLow)
-                                       : onePoleHigh(x, fx.eqLowR, aLow);
-                        float lp = (ch == 0)
-                                       ? onePoleLow(hp, fx.eqHighL, aHigh)
-                                       : onePoleLow(hp, fx.eqHighR, aHigh);
-                        buffer[idx] = lp;
-                    }
+        float left = block.left[static_cast<size_t>(i)];
+        float right = block.right[static_cast<size_t>(i)];
+
+        float lfoValue = 0.0f;
+        if (lfoActive) {
+            if (synth.lfoShape == 4) {
+                const float nextPhase = synth.lfoPhase + lfoInc;
+                if (nextPhase >= 2.0f * static_cast<float>(M_PI)) {
+                    synth.lfoNoise = 1664525u * synth.lfoNoise + 1013904223u;
+                    const float r =
+                        (static_cast<int>(synth.lfoNoise >> 8) & 0xFFFF) / 32768.0f -
+                        1.0f;
+                    synth.lfoHold = r;
                 }
-                break;
             }
-            case 8: {  // sidechain
-                const float threshold = 0.05f + p1 * 0.2f;
-                const float amount = p2;
-                float gain = 1.0f;
-                if (sidechainEnv > threshold) {
-                    const float over = (sidechainEnv - threshold) / (1.0f - threshold);
-                    gain = 1.0f - amount * over;
-                }
-                for (int i = 0; i < frames * m_channels; ++i) {
-                    buffer[i] *= gain;
-                }
-                break;
+            lfoValue =
+                lfoShapeValue(synth.lfoShape, synth.lfoPhase, synth.lfoHold);
+            synth.lfoPhase += lfoInc;
+            if (synth.lfoPhase > 2.0f * static_cast<float>(M_PI)) {
+                synth.lfoPhase -= 2.0f * static_cast<float>(M_PI);
             }
-            case 9: {  // delay
-                const float maxDelay = 0.9f;
-                const float timeSec = 0.03f + p1 * maxDelay;
-                const int delaySamples = std::max(1, static_cast<int>(timeSec * m_sampleRate));
-                const bool stereo = (p4 >= 0.5f);
-                const float feedback = 0.1f + p2 * 0.85f;
-                const float mix = p3;
-                const int needed = delaySamples * m_channels;
-                if (fx.bufA.size() < needed) {
-                    fx.bufA.assign(needed, 0.0f);
-                    fx.indexA = 0;
-                }
-                const int framesDelay = fx.bufA.size() / m_channels;
-                int stereoOffset = stereo ? std::max(1, delaySamples / 8) : 0;
-                stereoOffset = std::min(stereoOffset, std::max(1, framesDelay - 1));
-                for (int i = 0; i < frames; ++i) {
-                    const int readIndexL = (fx.indexA - delaySamples + framesDelay) % framesDelay;
-                    const int readIndexR =
-                        (fx.indexA - delaySamples - stereoOffset + framesDelay * 2) % framesDelay;
-                    const int writeIndex = fx.indexA;
-                    float inL = buffer[i * m_channels];
-                    float inR = (m_channels > 1) ? buffer[i * m_channels + 1] : inL;
-                    float dl = fx.bufA[readIndexL * m_channels];
-                    float dr = (m_channels > 1) ? fx.bufA[readIndexR * m_channels + 1] : dl;
-                    float fbL = stereo ? dr : dl;
-                    float fbR = stereo ? dl : dr;
-                    fx.bufA[writeIndex * m_channels] = inL + fbL * feedback;
-                    if (m_channels > 1) {
-                        fx.bufA[writeIndex * m_channels + 1] = inR + fbR * feedback;
-                    }
-                    buffer[i * m_channels] = inL * (1.0f - mix) + dl * mix;
-                    if (m_channels > 1) {
-                        buffer[i * m_channels + 1] = inR * (1.0f - mix) + dr * mix;
-                    }
-                    fx.indexA = (fx.indexA + 1) % framesDelay;
-                }
-                break;
+        }
+        if (lfoActive && synth.lfoTarget == 1 && lfoDepth > 0.0001f) {
+            env = std::max(0.0f, std::min(1.5f, env + lfoValue * lfoDepth));
+        }
+        if (useFilter) {
+            float g = staticG;
+            float R = staticR;
+            float cutoff = baseCutoff;
+            float envAmount = baseEnv;
+            if (synth.fmParams.envAssign[7] > 0.0001f ||
+                synth.fmParams.lfoAssign[7] > 0.0001f) {
+                cutoff += (synth.fmParams.lfoAssign[7] * lfoValue +
+                           synth.fmParams.envAssign[7] * env) *
+                          0.5f;
             }
-            case 10: {  // tremolo
-                const float depth = p1;
-                const bool sync = (p3 >= 0.5f);
-                float rate = 0.5f + p2 * 6.0f;
-                if (sync) {
-                    const float bpm = std::max(30.0f, m_bpm.load());
-                    const float base = bpm / 60.0f;
-                    const int divIndex = qBound(0, static_cast<int>(p2 * 4.99f), 4);
-                    static const float mults[] = {0.25f, 0.5f, 1.0f, 2.0f, 4.0f};
-                    rate = base * mults[divIndex];
-                }
-                for (int i = 0; i < frames; ++i) {
-                    const float lfo = (std::sin(fx.phase) + 1.0f) * 0.5f;
-                    const float gain = 1.0f - depth * (1.0f - lfo);
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        buffer[i * m_channels + ch] *= gain;
-                    }
-                    fx.phase += 2.0f * static_cast<float>(M_PI) * rate / m_sampleRate;
-                    if (fx.phase > 2.0f * static_cast<float>(M_PI)) {
-                        fx.phase -= 2.0f * static_cast<float>(M_PI);
-                    }
-                }
-                break;
+            if (synth.fmParams.envAssign[8] > 0.0001f ||
+                synth.fmParams.lfoAssign[8] > 0.0001f) {
+                baseRes += (synth.fmParams.lfoAssign[8] * lfoValue +
+                            synth.fmParams.envAssign[8] * env) *
+                           0.5f;
             }
-            case 11: {  // ring modulation
-                const float freq = 50.0f * std::pow(2.0f, p1 * 5.0f);
-                const float mix = p2;
-                for (int i = 0; i < frames; ++i) {
-                    const float mod = std::sin(fx.phase);
-                    fx.phase += 2.0f * static_cast<float>(M_PI) * freq / m_sampleRate;
-                    if (fx.phase > 2.0f * static_cast<float>(M_PI)) {
-                        fx.phase -= 2.0f * static_cast<float>(M_PI);
-                    }
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int idx = i * m_channels + ch;
-                        const float dry = buffer[idx];
-                        const float wet = dry * mod;
-                        buffer[idx] = dry * (1.0f - mix) + wet * mix;
-                    }
-                }
-                break;
+            if (synth.fmParams.envAssign[9] > 0.0001f ||
+                synth.fmParams.lfoAssign[9] > 0.0001f) {
+                baseEnv += (synth.fmParams.lfoAssign[9] * lfoValue +
+                            synth.fmParams.envAssign[9] * env) *
+                           0.5f;
             }
-            case 12: {  // robot (short delay/comb)
-                const float timeSec = 0.002f + p1 * 0.02f;
-                const float feedback = p2 * 0.6f;
-                const float mix = p3;
-                const int delaySamples = std::max(1, static_cast<int>(timeSec * m_sampleRate));
-                const int needed = delaySamples * m_channels;
-                if (fx.bufA.size() < needed) {
-                    fx.bufA.assign(needed, 0.0f);
-                    fx.indexA = 0;
-                }
-                const int framesDelay = fx.bufA.size() / m_channels;
-                for (int i = 0; i < frames; ++i) {
-                    const int readIndex = (fx.indexA - delaySamples + framesDelay) % framesDelay;
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int idx = i * m_channels + ch;
-                        const float delayed = fx.bufA[readIndex * m_channels + ch];
-                        const float dry = buffer[idx];
-                        const float wet = dry + delayed * feedback;
-                        fx.bufA[fx.indexA * m_channels + ch] = wet;
-                        buffer[idx] = dry * (1.0f - mix) + wet * mix;
-                    }
-                    fx.indexA = (fx.indexA + 1) % framesDelay;
-                }
-                break;
+            cutoff += moduleMods[7] * 0.5f;
+            baseRes += moduleMods[8] * 0.5f;
+            baseEnv += moduleMods[9] * 0.5f;
+            if (synth.fmParams.envAssign[7] > 0.0001f ||
+                synth.fmParams.lfoAssign[7] > 0.0001f) {
+                cutoff = std::max(0.02f, std::min(0.98f, cutoff));
             }
-            case 13: {  // punch (transient boost)
-                const float amount = 1.0f + p1 * 2.5f;
-                const float attack = 0.2f + p2 * 0.6f;
-                const float release = 0.02f + p3 * 0.2f;
-                for (int i = 0; i < frames; ++i) {
-                    float env = 0.0f;
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        env += std::fabs(buffer[i * m_channels + ch]);
-                    }
-                    env /= std::max(1, m_channels);
-                    fx.z1L += (env - fx.z1L) * attack;
-                    fx.env += (env - fx.env) * release;
-                    const float transient = std::max(0.0f, fx.z1L - fx.env);
-                    const float gain = 1.0f + transient * amount;
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        buffer[i * m_channels + ch] *= gain;
-                    }
-                }
-                break;
+            baseRes = std::max(0.0f, std::min(1.0f, baseRes));
+            baseEnv = std::max(0.0f, std::min(1.0f, baseEnv));
+            if (envAmount > 0.0001f) {
+                cutoff = std::max(0.02f, std::min(0.98f, cutoff + env * envAmount));
             }
-            case 14: {  // subharmonic generator
-                const float amount = p1 * 0.7f;
-                auto onePoleLow = [](float x, float &z, float a) {
-                    z = a * z + (1.0f - a) * x;
-                    return z;
-                };
-                const float a = std::exp(-2.0f * static_cast<float>(M_PI) * 180.0f / m_sampleRate);
-                if (fx.env == 0.0f) {
-                    fx.env = 1.0f;
-                }
-                for (int i = 0; i < frames; ++i) {
-                    for (int ch = 0; ch < m_channels; ++ch) {
-                        const int idx = i * m_channels + ch;
-                        const float x = buffer[idx];
-                        const float prev = (ch == 0) ? fx.z1L : fx.z1R;
-                        if ((x >= 0.0f && prev < 0.0f) || (x < 0.0f && prev >= 0.0f)) {
-                            fx.env = -fx.env;
-                        }
-                        if (ch == 0) {
-                            fx.z1L = x;
-                        } else {
-                            fx.z1R = x;
-                        }
-                        float sub = fx.env * std::fabs(x);
-                        sub = (ch == 0) ? onePoleLow(sub, fx.eqLowL, a)
-                                        : onePoleLow(sub, fx.eqLowR, a);
-                        buffer[idx] = x + sub * amount;
-                    }
-                }
-                break;
+            if (lfoActive && lfoDepth > 0.0001f) {
+                cutoff = std::max(0.02f,
+                                  std::min(0.98f, cutoff + lfoValue * lfoDepth * 0.5f));
             }
-            case 15: {  // key harmonizer (simple pitch-shifted voices)
-                const float mix = 0.2f + p1 * 0.8f;
-                const int keyIndex = qBound(0, static_cast<int>(p2 * 11.99f), 11);
-                const bool minor = (p3 >= 0.5f);
-                const int third = minor ? 3 : 4;
-                const int fifth = 7;
-                int interval1 = third + keyIndex;
-                int interval2 = fifth + keyIndex;
-                if (interval1 >= 12) {
-                    interval1 -= 12;
-                }
-                if (interval2 >= 12) {
-                    interval2 -= 12;
-                }
-                const float ratio1 = std::pow(2.0f, interval1 / 12.0f);
-                const float ratio2 = std::pow(2.0f, interval2 / 12.0f);
-
-                const int grain = 4096;
-                const int bufFrames = grain * 2;
-                if (fx.bufA.size() != bufFrames) {
-                    fx.bufA.assign(bufFrames, 0.0f);
-                    fx.indexA = 0;
-                    fx.readPosA = 0.0f;
-                    fx.readPosB = 0.0f;
-                    fx.readPosC = 0.0f;
-                    fx.readPosD = 0.0f;
-                    fx.phaseA = 0.0f;
-                    fx.phaseB = 0.5f;
-                    fx.phaseC = 0.0f;
-                    fx.phaseD = 0.5f;
-                    fx.grainSize = grain;
-                    fx.bufB.assign(grain, 0.0f);
-                    for (int i = 0; i < grain; ++i) {
-                        const float t = static_cast<float>(i) / static_cast<float>(grain - 1);
-                        fx.bufB[static_cast<size_t>(i)] =
-                            0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * t));
-                    }
-                }
+            if (g == 0.0f || lfoDepth > 0.0001f || synth.filterEnvAmount > 0.0001f) {
+                const float hz = 40.0f * std::pow(2.0f, cutoff * 8.0f);
+                g = std::tan(static_cast<float>(M_PI) * hz / m_sampleRate);
+                const float q = 0.7f + baseRes * 7.0f;
+                R = 1.0f / (2.0f * q);
+            }
+            if (g > 0.0f) {
+                auto svf = [&](float input, float &ic1, float &ic2, float &low,
+                               float &band, float &high) {
+                    const float v3 = input - ic2;
+                    const float v1 = (g * v3 + ic1) / (1.0f + g * (g + R));
+                    const float v2 = ic2 + g * v1;
+                    ic1 = 2.0f * v1 - ic1;
+                    ic2 = 2.0f * v2 - ic2;
+                    low = v2;
+                    band = v1;
+                    high = v3 - R * v1 - v2;
+                };
 
-                auto wrapPos = [&](float &pos) {
-                    while (pos < 0.0f) {
-                        pos += bufFrames;
+                float lowL = 0.0f, bandL = 0.0f, highL = 0.0f;
+                float lowR = 0.0f, bandR = 0.0f, highR = 0.0f;
+                svf(left, synth.filterIc1L, synth.filterIc2L, lowL, bandL, highL);
+                svf(right, synth.filterIc1R, synth.filterIc2R, lowR, bandR, highR);
+
+                auto applyFilterMode = [&](float input, float low, float band, float high) {
+                    switch (synth.filterType) {
+                        case 0: // lowpass
+                            return low;
+                        case 1: // highpass
+                            return high;
+                        case 2: // bandpass
+                            return band;
+                        case 3: // notch
+                            return low + high;
+                        case 4: // peak
+                            return band;
+                        case 5: // low shelf
+                            return input + low * 0.6f;
+                        case 6: // high shelf
+                            return input + high * 0.6f;
+                        case 7: // allpass (approx)
+                            return input - 2.0f * R * band;
+                        case 8: // bypass
+                            return input;
+                        case 9: // low+mid
+                            return low + band;
+                        default:
+                            return low;
                     }
-                    while (pos >= bufFrames) {
-                        pos -= bufFrames;
-                    }
-                };
-                auto readInterp = [&](float pos, int ch) {
-                    const int i0 = static_cast<int>(pos);
-                    const int i1 = (i0 + 1) % bufFrames;
-                    const float frac = pos - i0;
-                    const float s0 = fx.bufA[i0];
-                    const float s1 = fx.bufA[i1];
-                    return s0 + (s1 - s0) * frac;
                 };
 
-                const float phaseInc = 1.0f / static_cast<float>(grain);
-
-                for (int i = 0; i < frames; ++i) {
-                    const int writePos = fx.indexA;
-                    const float inL = buffer[i * m_channels];
-                    const float inR = (m_channels > 1) ? buffer[i * m_channels + 1] : inL;
-                    const float mono = 0.5f * (inL + inR);
-                    fx.bufA[writePos] = mono;
-
-                    const int wiA = qBound(0, static_cast<int>(fx.phaseA * (grain - 1)), grain - 1);
-                    const int wiB = qBound(0, static_cast<int>(fx.phaseB * (grain - 1)), grain - 1);
-                    const int wiC = qBound(0, static_cast<int>(fx.phaseC * (grain - 1)), grain - 1);
-                    const int wiD = qBound(0, static_cast<int>(fx.phaseD * (grain - 1)), grain - 1);
-                    const float wA = fx.bufB[static_cast<size_t>(wiA)];
-                    const float wB = fx.bufB[static_cast<size_t>(wiB)];
-                    const float wC = fx.bufB[static_cast<size_t>(wiC)];
-                    const float wD = fx.bufB[static_cast<size_t>(wiD)];
-
-                    const float v1 = readInterp(fx.readPosA, 0) * wA +
-                                     readInterp(fx.readPosB, 0) * wB;
-                    const float v2 = readInterp(fx.readPosC, 0) * wC +
-                                     readInterp(fx.readPosD, 0) * wD;
-                    const float add = (v1 + v2) * 0.5f * mix;
-                    buffer[i * m_channels] += add;
-                    if (m_channels > 1) {
-                        buffer[i * m_channels + 1] += add;
-                    }
+                left = applyFilterMode(left, lowL, bandL, highL);
+                right = applyFilterMode(right, lowR, bandR, highR);
+            }
+        }
 
-                    fx.readPosA += ratio1;
-                    fx.readPosB += ratio1;
-                    fx.readPosC += ratio2;
-                    fx.readPosD += ratio2;
-                    wrapPos(fx.readPosA);
-                    wrapPos(fx.readPosB);
-                    wrapPos(fx.readPosC);
-                    wrapPos(fx.readPosD);
-
-                    fx.phaseA += phaseInc;
-                    fx.phaseB += phaseInc;
-                    fx.phaseC += phaseInc;
-                    fx.phaseD += phaseInc;
-                    if (fx.phaseA >= 1.0f) {
-                        fx.phaseA -= 1.0f;
-                        fx.readPosA = static_cast<float>(writePos - grain);
-                        wrapPos(fx.readPosA);
-                    }
-                    if (fx.phaseB >= 1.0f) {
-                        fx.phaseB -= 1.0f;
-                        fx.readPosB = static_cast<float>(writePos - grain / 2);
-                        wrapPos(fx.readPosB);
-                    }
-                    if (fx.phaseC >= 1.0f) {
-                        fx.phaseC -= 1.0f;
-                        fx.readPosC = static_cast<float>(writePos - grain);
-                        wrapPos(fx.readPosC);
-                    }
-                    if (fx.phaseD >= 1.0f) {
-                        fx.phaseD -= 1.0f;
-                        fx.readPosD = static_cast<float>(writePos - grain / 2);
-                        wrapPos(fx.readPosD);
-                    }
+        const int idx = i * m_channels;
+        out[idx] += left * synth.gainL * env;
+        if (m_channels > 1) {
+            out[idx + 1] += right * synth.gainR * env;
+        }
+        if (!useExternalEnv && !hasNotes) {
+            const float peakL = std::fabs(left * synth.gainL);
+            const float peakR = std::fabs(right * synth.gainR);
+            tailPeak = std::max(tailPeak, std::max(peakL, peakR));
+        }
+    }
+    if (!useExternalEnv && !hasNotes) {
+        if (tailPeak < 0.00008f) {
+            synth.releaseRequested = false;
+            synth.env = 0.0f;
+        }
+    }
+    return true;
+}
 
-                    fx.indexA = (fx.indexA + 1) % bufFrames;
-                }
-                break;
-            }
-            case 16: {  // pad freeze
-                const float lenSec = 0.15f + p1 * 0.85f;
-                const float mix = p2;
-                const bool refresh = (p3 >= 0.5f);
-                const int length = std::max(1, static_cast<int>(lenSec * m_sampleRate));
-                const int needed = length * m_channels;
-                if (fx.bufA.size() != needed) {
-                    fx.bufA.assign(needed, 0.0f);
-                    fx.indexA = 0;
-                    fx.indexB = 0;
-                    fx.env = 0.0f;
-                }
-                const int framesLen = fx.bufA.size() / m_channels;
-                for (int i = 0; i < frames; ++i) {
-                    float inL = buffer[i * m_channels];
-                    float inR = (m_channels > 1) ? buffer[i * m_channels + 1] : inL;
-                    if (fx.env < 1.0f || refresh) {
-                        fx.bufA[fx.indexB * m_channels] = inL;
-                        if (m_channels > 1) {
-                            fx.bufA[fx.indexB * m_channels + 1] = inR;
-                        }
-                        fx.indexB = (fx.indexB + 1) % framesLen;
-                        fx.env = std::min(1.0f, fx.env + 1.0f / framesLen);
-                        if (refresh) {
-                            fx.indexA = fx.indexB;
-                        }
-                    }
-                    const float frL = fx.bufA[fx.indexA * m_channels];
-                    const float frR =
-                        (m_channels > 1) ? fx.bufA[fx.indexA * m_channels + 1] : frL;
-                    fx.indexA = (fx.indexA + 1) % framesLen;
-                    buffer[i * m_channels] = inL * (1.0f - mix) + frL * mix;
-                    if (m_channels > 1) {
-                        buffer[i * m_channels + 1] = inR * (1.0f - mix) + frR * mix;
-                    }
-                }
-                break;
-            }
-            default:
-                break;
+float AudioEngine::computeEnv(const float *buffer, int frames) const {
+    double sum = 0.0;
+    const int count = frames * m_channels;
+    for (int i = 0; i < count; ++i) {
+        const float v = buffer[i];
+        sum += static_cast<double>(v * v);
+    }
+    const double rms = (count > 0) ? std::sqrt(sum / static_cast<double>(count)) : 0.0;
+    return static_cast<float>(rms);
+}
+
+float AudioEngine::computePeak(const float *buffer, int frames) const {
+    float peak = 0.0f;
+    const int count = frames * m_channels;
+    for (int i = 0; i < count; ++i) {
+        const float v = std::fabs(buffer[i]);
+        if (v > peak) {
+            peak = v;
         }
     }
+    return peak;
+}
+
+void AudioEngine::prepareEffect(EffectState &fx) const {
+    // Every buffer an effect touches is sized here; processBus() never allocates.
+    EffectKernels::prepare(fx.type, fx.params, m_sampleRate, fx.state);
+    if (fx.type == EffectKernels::Convolution && fx.impulse) {
+        // The long partitions get their own helper below the mix workers unless
+        // GROOVEBOX_CONV_THREAD=0, in which case they run inline every 2048 frames.
+        const RtScheduling::Config &rt = RtScheduling::config();
+        const int priority =
+            rt.priority > 0 ? std::max(1, rt.priority - 2 * RtScheduling::kWorkerPriorityGap) : 0;
+        bool ok = false;
+        const int thread = qEnvironmentVariableIntValue("GROOVEBOX_CONV_THREAD", &ok);
+        fx.state.convolver = std::make_unique<Convolver>(fx.impulse, !ok || thread != 0, priority);
+    }
+}
+
+std::shared_ptr<const ConvolverImpulse> AudioEngine::loadImpulse(const QString &path) {
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_impulseMutex);
+    if (std::shared_ptr<const ConvolverImpulse> cached = m_impulses.value(path).lock()) {
+        return cached;
+    }
+    const qint64 maxFrames = static_cast<qint64>(m_sampleRate) * kMaxImpulseSeconds;
+    const std::shared_ptr<const Buffer> buffer =
+        SampleDecoder::decode(path, m_sampleRate, maxFrames);
+    if (!buffer || !buffer->isValid()) {
+        return nullptr;
+    }
+    std::vector<float> frames(static_cast<size_t>(buffer->frames()) * buffer->channels());
+    buffer->readFloat(0, buffer->frames(), frames.data());
+    std::shared_ptr<const ConvolverImpulse> impulse = ConvolverImpulse::create(
+        frames.data(), buffer->frames(), buffer->channels(), buffer->frames());
+    // Drop entries whose chains are gone, so browsing through files does not pile up.
+    for (auto it = m_impulses.begin(); it != m_impulses.end();) {
+        it = it.value().expired() ? m_impulses.erase(it) : std::next(it);
+    }
+    if (impulse) {
+        m_impulses.insert(path, impulse);
+    }
+    return impulse;
+}
+
+void AudioEngine::processBus(int busIndex, float *buffer, int frames, float sidechainEnv) {
+    if (busIndex < 0 || busIndex >= static_cast<int>(m_busChains.size())) {
+        return;
+    }
+    BusChain &chain = m_busChains[static_cast<size_t>(busIndex)];
+    if (chain.effects.empty() || frames > m_mixCapacity) {
+        return;
+    }
+    float *left = m_fxLeft[static_cast<size_t>(busIndex)].data();
+    float *right = m_fxRight[static_cast<size_t>(busIndex)].data();
+
+    EffectKernels::Context context;
+    context.sampleRate = m_sampleRate;
+    context.bpm = m_bpm.load();
+    context.sidechainEnv = sidechainEnv;
+    EffectKernels::deinterleave(buffer, left, right, frames);
+    for (EffectState &fx : chain.effects) {
+        const auto fxBegin = std::chrono::steady_clock::now();
+        EffectKernels::process(fx.type, fx.params, context, fx.state, left, right, frames);
+        m_dspStats.addEffect(busIndex, fx.type, elapsedNs(fxBegin));
+    }
+    EffectKernels::interleave(left, right, buffer, frames);
 }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
 #include <QVector>
 #include <QString>
+#include <QStringList>
 #include <array>
 #include <atomic>
 #include <memory>
@@ -10,10 +12,18 @@
 #include <thread>
 #include <vector>
 
+#include "DspStats.h"
+#include "EffectKernels.h"
+#include "RtWorkerPool.h"
+#include "SampleBuffer.h"
+#include "SpscQueue.h"
+#include "SpscRingBuffer.h"
 #include "dx7_core.h"
 #include "simple_fm.h"
 #include "op1_engines.h"
 
+class SampleStream;
+
 class AudioEngine : public QObject {
     Q_OBJECT
 public:
@@ -114,47 +124,114 @@ public:
         float p3 = 0.5f;
         float p4 = 0.5f;
         float p5 = 0.0f;
+        // Impulse response file for the convolution effect.
+        QString impulse;
     };
 
-    struct Buffer {
-        QVector<float> samples;
-        int channels = 2;
-        int sampleRate = 0;
+    using Buffer = SampleBuffer;
 
-        int frames() const {
-            return channels > 0 ? samples.size() / channels : 0;
-        }
+    // One thing the step sequencer plays. Sample events start a voice like trigger(); synth
+    // events play midiNote for lengthFrames.
+    struct SeqEvent {
+        int step = 0;
+        int padId = -1;
+        bool synth = false;
+        std::shared_ptr<const Buffer> buffer;
+        // Set for samples played from disk; buffer is then ignored.
+        std::shared_ptr<const SampleStream> stream;
+        int startFrame = 0;
+        int endFrame = 0;
+        bool loop = false;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        float rate = 1.0f;
+        int bus = 0;
+        int midiNote = 60;
+        int lengthFrames = 0;
+    };
 
-        bool isValid() const {
-            return sampleRate > 0 && !samples.isEmpty();
-        }
+    struct SeqPattern {
+        int steps = 64;
+        std::vector<SeqEvent> events;
+        bool metronome = false;
+        std::shared_ptr<const Buffer> click;
+        std::shared_ptr<const Buffer> accent;
+        // While the sequencer runs, hold the pattern back until the next bar starts, so a
+        // batch of re-rendered buffers changes over on a downbeat rather than mid-phrase.
+        bool atBar = false;
     };
 
+    enum class VoiceSteal {
+        Oldest,
+        Quietest
+    };
+
+    static constexpr int kMaxVoices = 64;
+    static constexpr int kMaxPolyphony = 16;
+    static constexpr int kChokeGroups = 4;
+
     explicit AudioEngine(QObject *parent = nullptr);
+    // Offline engine: never opens a device. Drive it with renderOffline().
+    AudioEngine(int sampleRate, int blockFrames, QObject *parent = nullptr);
     ~AudioEngine() override;
 
     bool isAvailable() const { return m_available; }
     int sampleRate() const { return m_sampleRate; }
     int channels() const { return m_channels; }
+    // Picking a device means ALSA, whatever GROOVEBOX_AUDIO_BACKEND says.
     bool setAlsaDevice(const QString &device);
     QString alsaDevice() const { return m_activeDevice; }
+    // "jack", "alsa" or empty when no device is open.
+    QString backendName() const;
 
-    void trigger(int padId, const std::shared_ptr<Buffer> &buffer, int startFrame, int endFrame,
-                 bool loop, float volume, float pan, float rate, int bus);
-    void stopPad(int padId);
-    void stopAll();
+    // The bool setters below return false when the change did not reach the audio thread: the
+    // engine was stopped, or its queue stayed full for kPostTimeoutMs. What the control side
+    // reports back (isPadActive(), isSequencerRunning(), synthVoiceParam(), ...) then still
+    // describes what the engine is actually doing.
+    bool trigger(int padId, const std::shared_ptr<const Buffer> &buffer, int startFrame,
+                 int endFrame, bool loop, float volume, float pan, float rate, int bus);
+    // Plays the stream's head from memory while a reader thread fetches the rest from disk.
+    bool trigger(int padId, const std::shared_ptr<const SampleStream> &stream, int startFrame,
+                 int endFrame, bool loop, float volume, float pan, float rate, int bus);
+    bool stopPad(int padId);
+    bool stopAll();
     bool isPadActive(int padId) const;
 
     void setPadAdsr(int padId, float attack, float decay, float sustain, float release);
+    // How many voices of a sample pad may sound at once (1 cuts the previous hit, as before),
+    // and its choke group: starting a pad fades out every other pad in the same group (0 for
+    // none). Past its polyphony a pad takes over its own oldest voice.
+    void setPadVoicing(int padId, int polyphony, int chokeGroup);
+    // Which voice a trigger takes over when every voice in the pool is busy.
+    void setVoiceSteal(VoiceSteal mode);
 
-    void setSynthEnabled(int padId, bool enabled);
+    bool setSynthEnabled(int padId, bool enabled);
     void setSynthKind(int padId, SynthKind kind);
-    void setSynthParams(int padId, float volume, float pan, int bus);
+    bool setSynthParams(int padId, float volume, float pan, int bus);
     void setSynthVoices(int padId, int voices);
-    void setFmParams(int padId, const FmParams &params);
-    void synthNoteOn(int padId, int midiNote, int velocity);
+    bool setFmParams(int padId, const FmParams &params);
+    // Changes one macro of the pad's current FmParams, for controllers that move a knob at a time.
+    bool setSynthMacro(int padId, int macro, float value);
+    // With lengthFrames > 0 the engine ends the note itself after that many frames.
+    bool synthNoteOn(int padId, int midiNote, int velocity, int lengthFrames = 0);
     void synthNoteOff(int padId, int midiNote);
     void synthAllNotesOff(int padId);
+    // MIDI input thread: trigger(), stopPad(), synthNoteOn() with its mix, synthNoteOff() and
+    // setSynthMacro() without taking m_mutex, which the GUI may hold across a synth core build.
+    // They go through m_midiCommands and leave the control-side mirror alone. False when the
+    // event could not go that way (engine stopped, synth core or stream reader not up yet,
+    // queue full); the caller then replays it through the locked calls on another thread.
+    // Events the locked calls would ignore as well (bad pad, nothing to play) return true.
+    bool midiTrigger(int padId, const std::shared_ptr<const Buffer> &buffer, int startFrame,
+                     int endFrame, bool loop, float volume, float pan, float rate, int bus);
+    bool midiTrigger(int padId, const std::shared_ptr<const SampleStream> &stream,
+                     int startFrame, int endFrame, bool loop, float volume, float pan,
+                     float rate, int bus);
+    bool midiStopPad(int padId);
+    bool midiSynthNoteOn(int padId, int midiNote, int velocity, int lengthFrames, float volume,
+                         float pan, int bus);
+    bool midiSynthNoteOff(int padId, int midiNote);
+    bool midiSynthMacro(int padId, int macro, float value);
     bool isSynthActive(int padId) const;
     bool loadSynthSysex(int padId, const QString &path);
     bool setSynthProgram(int padId, int program);
@@ -165,13 +242,42 @@ public:
 
     void setBusEffects(int bus, const std::vector<EffectSettings> &effects);
     float busMeter(int bus) const;
+    // Threads sharing the mix: 0 is the audio thread, the rest are pool workers. Load is the
+    // smoothed share of each period the thread spent busy.
+    int workerCount() const { return m_workers.helperCount() + 1; }
+    float workerLoad(int index) const { return m_workers.load(index); }
+    // Callback timing, per-bus/synth/effect load and xruns; read from any thread.
+    const DspStats &dspStats() const { return m_dspStats; }
+    void resetDspStats() { m_dspStats.reset(); }
     void setBusGain(int bus, float gain);
     void setBpm(int bpm);
+    // Streams the master output to a WAV file. totalFrames <= 0 records until stopRecording().
     bool startRecording(const QString &path, int totalFrames, int targetSampleRate);
+    void stopRecording();
     bool isRecording() const { return m_recording.load(); }
     float padPlayhead(int padId) const;
 
+    // Step sequencer clocked by the audio thread. Steps fire on exact frames; a new pattern takes
+    // over at the next step without restarting the transport.
+    bool setSequencerPattern(const SeqPattern &pattern);
+    bool startSequencer(int step);
+    bool stopSequencer();
+    bool isSequencerRunning() const { return m_seqRunningFlag.load(std::memory_order_relaxed); }
+    int sequencerStep() const { return m_seqPlayStep.load(std::memory_order_relaxed); }
+    // How far the transport is into sequencerStep(), 0..1.
+    float sequencerStepPhase() const { return m_seqStepPhase.load(std::memory_order_relaxed); }
+    // Frees whatever the audio thread has finished with. Safe to call from a UI timer.
+    void releaseRetired();
+
+    // Mixes the next block on the caller's thread. Offline engines only.
+    void renderOffline(float *out, int frames);
+    // Replays bus, pad and synth settings into another (offline) engine.
+    void copyStateTo(AudioEngine &target) const;
+
 private:
+    static constexpr int kDx7VoiceParamCount = 156;
+    static constexpr int kStreamSlots = 16;
+
     enum class EnvStage {
         Attack,
         Decay,
@@ -182,7 +288,7 @@ private:
     struct Voice {
         int padId = -1;
         int bus = 0;
-        std::shared_ptr<Buffer> buffer;
+        std::shared_ptr<const Buffer> buffer;
         int startFrame = 0;
         int endFrame = 0;
         double position = 0.0;
@@ -193,67 +299,96 @@ private:
         float env = 0.0f;
         EnvStage envStage = EnvStage::Attack;
         bool releaseRequested = false;
+        // Cut by its choke group: releases over a few milliseconds whatever the pad's ADSR.
+        bool choked = false;
         bool useEnv = true;
+        // Start order, for stealing the oldest voice.
+        quint64 serial = 0;
+        // Streaming voices play buffer, the stream's head, until the ring of
+        // m_streamSlots[streamSlot] takes over. The stream moves into that slot when the voice
+        // starts; a voice that finds no free slot plays the head alone.
+        std::shared_ptr<const SampleStream> stream;
+        int streamSlot = -1;
+        qint64 streamPass = 0;
+    };
+
+    enum class StreamState {
+        Free,
+        Active,
+        Releasing
+    };
+
+    // Frames read ahead of one streaming voice. They are numbered along the voice's path, each
+    // pass through the region adding frames [first, end) again, so a looping voice never has to
+    // seek its ring back. The audio thread claims a Free slot and marks it Releasing when the
+    // voice ends; in between the reader thread owns everything but `consumed`, and it drops the
+    // stream before handing the slot back as Free.
+    struct StreamSlot {
+        std::atomic<StreamState> state{StreamState::Free};
+        std::shared_ptr<const SampleStream> stream;
+        int first = 0;
+        int end = 0;
+        bool loop = false;
+        int channels = 0;
+        bool failed = false;
+        std::vector<float> ring;
+        // Frames written so far (reader) and frames the voice is done with (audio thread).
+        std::atomic<qint64> filled{0};
+        std::atomic<qint64> consumed{0};
     };
 
     struct EffectState {
         int type = 0;
-        float p1 = 0.0f;
-        float p2 = 0.0f;
-        float p3 = 0.0f;
-        float p4 = 0.0f;
-        float p5 = 0.0f;
-        std::vector<float> bufA;
-        std::vector<float> bufB;
-        int indexA = 0;
-        int indexB = 0;
-        float phase = 0.0f;
-        float env = 0.0f;
-        float z1L = 0.0f;
-        float z1R = 0.0f;
-        float readPosA = 0.0f;
-        float readPosB = 0.0f;
-        float readPosC = 0.0f;
-        float readPosD = 0.0f;
-        float phaseA = 0.0f;
-        float phaseB = 0.5f;
-        float phaseC = 0.0f;
-        float phaseD = 0.5f;
-        int grainSize = 0;
-        float eqLp1L = 0.0f;
-        float eqLp1R = 0.0f;
-        float eqHp1L = 0.0f;
-        float eqHp1R = 0.0f;
-        float eqLp2L = 0.0f;
-        float eqLp2R = 0.0f;
-        float eqHp2L = 0.0f;
-        float eqHp2R = 0.0f;
-        float eqLowL = 0.0f;
-        float eqLowR = 0.0f;
-        float eqHighL = 0.0f;
-        float eqHighR = 0.0f;
+        // Clamped to 0..1 when the chain is built.
+        EffectKernels::Params params;
+        EffectKernels::State state;
+        std::shared_ptr<const ConvolverImpulse> impulse;
     };
 
     struct BusChain {
         std::vector<EffectState> effects;
     };
 
-    struct SynthState {
+    struct SeqStep {
+        bool synth = false;
+        int padId = -1;
+        int midiNote = 60;
+        int lengthFrames = 0;
+        Voice voice;
+    };
+
+    // Audio-side form of a SeqPattern: voices prepared up front, events bucketed by step.
+    struct SeqProgram {
+        std::vector<std::vector<SeqStep>> steps;
+        bool metronome = false;
+        bool atBar = false;
+        Voice click;
+        Voice accent;
+    };
+
+    struct PendingNoteOff {
+        int padId = -1;
+        int midiNote = 0;
+        qint64 frame = 0;
+    };
+
+    // Sound-generating cores for one synth pad. Built and initialised on the control thread,
+    // then handed to the audio thread whole, so allocation and sysex I/O never happen there.
+    struct SynthCore {
         Dx7Core core;
         SimpleFmCore simple;
         std::unique_ptr<Op1Engine> op1;
-        SynthKind op1Kind = SynthKind::Dx7;
         SynthKind kind = SynthKind::Dx7;
+    };
+
+    // Audio-thread view of a synth pad. Only mix() and applyCommand() touch it.
+    struct SynthState {
+        std::unique_ptr<SynthCore> engine;
         bool enabled = false;
-        bool initialized = false;
         int bus = 0;
         float gainL = 1.0f;
         float gainR = 1.0f;
-        int voices = 8;
         std::array<bool, 128> activeNotes{};
-        QString bankPath;
-        bool bankLoaded = false;
-        int programIndex = 0;
         FmParams fmParams;
         float filterCutoff = 0.8f;
         float filterResonance = 0.1f;
@@ -287,38 +422,229 @@ private:
         std::array<bool, kEnvModuleCount> envReleaseRequested{};
     };
 
+    // Per-pad render target, so synth pads can render on different workers at once.
+    struct SynthBlock {
+        std::vector<float> left;
+        std::vector<float> right;
+        std::vector<float> out;
+        bool active = false;
+    };
+
+    // Control-thread view of a synth pad, guarded by m_mutex. Mirrors what has been sent to the
+    // audio thread so getters never have to look at audio-owned state.
+    struct SynthControl {
+        SynthKind kind = SynthKind::Dx7;
+        int voices = 8;
+        bool enabled = false;
+        bool coreDirty = true;
+        bool resetOnSwap = false;
+        bool bankLoaded = false;
+        QString bankPath;
+        int programIndex = 0;
+        QStringList programNames;
+        FmParams fmParams;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        int bus = 0;
+    };
+
+    struct Command {
+        enum class Type {
+            None,
+            Trigger,
+            StopPad,
+            StopAll,
+            SynthEnable,
+            SynthMix,
+            SynthFmParams,
+            SynthSwapCore,
+            SynthProgram,
+            SynthVoiceParam,
+            SynthNoteOn,
+            SynthNoteOff,
+            SynthAllNotesOff,
+            SynthMacro,
+            BusEffects,
+            SeqSetPattern,
+            SeqTransport
+        };
+        Type type = Type::None;
+        int padId = -1;
+        int arg1 = 0;
+        int arg2 = 0;
+        int arg3 = 0;
+        float gainL = 1.0f;
+        float gainR = 1.0f;
+        Voice voice;
+        std::unique_ptr<FmParams> fmParams;
+        std::unique_ptr<SynthCore> core;
+        std::unique_ptr<BusChain> chain;
+        std::unique_ptr<SeqProgram> seq;
+    };
+
+    void initState();
     void start();
     void stop();
     void run();
+    bool startJack();
+    int processJack(int frames);
+    int mixWorkerCount() const;
+    void startWorkers();
+    // True while a device callback (ALSA thread or JACK process) consumes m_commands.
+    bool audioThreadActive() const;
     void mix(float *out, int frames);
+    void mixBlock(float *out, int frames);
+    int runSequencer(int maxFrames);
+    double seqStepFrames() const;
+    // Makes the queued pattern current and hands the old one back for freeing.
+    void promoteQueuedPattern();
+    void fireStep(int step);
+    void startVoice(const Voice &voice);
+    void scheduleNoteOff(int padId, int midiNote, qint64 frame);
+    bool makeVoice(int padId, const std::shared_ptr<const Buffer> &buffer,
+                   const std::shared_ptr<const SampleStream> &stream, int startFrame,
+                   int endFrame, bool loop, float volume, float pan, float rate, int bus,
+                   Voice &voice) const;
+    void prepareBuffers(int frames);
+    void prepareEffect(EffectState &fx) const;
+    std::shared_ptr<const ConvolverImpulse> loadImpulse(const QString &path);
     void processBus(int busIndex, float *buffer, int frames, float sidechainEnv);
+    int renderVoiceEnv(Voice &voice, float *env, int frames, bool &finished) const;
+    bool renderSynth(size_t pad, int frames);
     float computeEnv(const float *buffer, int frames) const;
     float computePeak(const float *buffer, int frames) const;
-    void ensureSynthInit(SynthState &state);
+
+    // False when the audio thread did not take the command within kPostTimeoutMs; callers
+    // then leave their control-side mirror untouched.
+    bool post(Command &&cmd);
+    bool postMidi(Command &&cmd);
+    void collectRetired();
+    void drainCommands();
+    // Applies cmd and retires its payload.
+    void runCommand(Command &cmd);
+    void applyCommand(Command &cmd);
+    // Audio side: hands a command's payload back to the control thread for freeing.
+    void retire(Command &&cmd);
+    void flushRetireOverflow();
+    void retireVoice(Voice &voice);
+    // The slot a new voice for padId goes into: one of the pad's own past its polyphony, else a
+    // free one, else whichever voice m_voiceSteal picks.
+    Voice *claimVoice(int padId);
+    // Retires m_voices[index] and fills the hole with the last voice.
+    void removeVoice(int index);
+    void prepareStreaming();
+    void stopStreamReader();
+    void runStreamReader();
+    void bindStream(Voice &voice);
+    void releaseStream(Voice &voice);
+    bool fillStream(StreamSlot &slot);
+    int mixStreamRun(Voice &voice, int lastFrame, double pos, int run, const float *env,
+                     float *left, float *right);
+    void stopRecordWriter();
+    void ensureSynthCore(int padId);
+    // Refreshes m_synthLive for the pad; call with m_mutex held after enabled/coreDirty change.
+    void publishSynthLive(int padId);
+    std::unique_ptr<SynthCore> buildSynthCore(const SynthControl &control) const;
+    void publishVoiceParams(int padId, const SynthCore &core);
 
     bool m_available = false;
+    bool m_offline = false;
     int m_sampleRate = 48000;
     int m_channels = 2;
     int m_periodFrames = 256;
 
     std::atomic<bool> m_running{false};
     std::thread m_thread;
+    RtWorkerPool m_workers;
+    DspStats m_dspStats;
+    // Serialises control-side callers. The audio thread never takes it, nor does the MIDI
+    // thread; everything the audio thread needs arrives through m_commands or m_midiCommands.
     mutable std::mutex m_mutex;
-    std::vector<Voice> m_voices;
+    SpscQueue<Command, 1024> m_commands;
+    // The MIDI thread's own producer side, so it never waits on m_mutex for m_commands.
+    SpscQueue<Command, 256> m_midiCommands;
+    SpscQueue<Command, 2048> m_retired;
+    // Audio-thread-only spill for when m_retired is full, pushed on at the next retire().
+    static constexpr int kRetireOverflow = 256;
+    std::array<Command, kRetireOverflow> m_retireOverflow;
+    int m_retireOverflowHead = 0;
+    int m_retireOverflowCount = 0;
+    // Last resort once the spill is full as well: payloads are moved in here and never
+    // destroyed, so they leak instead of being freed on the audio thread.
+    alignas(Command) unsigned char m_retireLeak[sizeof(Command)];
+    // Sounding voices are m_voices[0, m_voiceCount); a finished voice is swapped with the last
+    // one, so the pool never allocates or shifts.
+    std::array<Voice, kMaxVoices> m_voices;
+    int m_voiceCount = 0;
+    quint64 m_voiceSerial = 0;
     std::array<BusChain, 6> m_busChains;
+    std::array<bool, 6> m_busSidechain{};
+    std::array<std::vector<EffectSettings>, 6> m_busEffectSettings;
+    // Impulse responses by path while some chain still holds them.
+    std::mutex m_impulseMutex;
+    QHash<QString, std::weak_ptr<const ConvolverImpulse>> m_impulses;
     std::array<std::vector<float>, 6> m_busBuffers;
+    // Sized by prepareBuffers(); mix() never grows them.
+    int m_mixCapacity = 0;
+    std::vector<float> m_drySum;
+    // Planar sample-voice sums per bus plus one envelope block, see VoiceKernel.
+    std::array<std::vector<float>, 6> m_voiceLeft;
+    std::array<std::vector<float>, 6> m_voiceRight;
+    std::vector<float> m_voiceEnv;
+    // Planar copy of each bus while its effect chain runs; buses process in parallel.
+    std::array<std::vector<float>, 6> m_fxLeft;
+    std::array<std::vector<float>, 6> m_fxRight;
+    std::vector<float> m_master;
     std::array<std::atomic<float>, 6> m_busMeters{};
     std::array<std::atomic<float>, 6> m_busGains{};
     std::atomic<bool> m_hasSidechain{false};
     std::atomic<float> m_bpm{120.0f};
 
+    // Sequencer. m_seqPattern is the control-side copy; the rest belongs to the audio thread
+    // apart from the atomics published for the UI.
+    SeqPattern m_seqPattern;
+    std::unique_ptr<SeqProgram> m_seq;
+    // An atBar pattern waiting for the next bar line.
+    std::unique_ptr<SeqProgram> m_seqQueued;
+    bool m_seqRunning = false;
+    int m_seqStep = 0;
+    double m_seqCountdown = 0.0;
+    qint64 m_frameClock = 0;
+    std::array<PendingNoteOff, 128> m_noteOffs{};
+    int m_noteOffCount = 0;
+    std::atomic<bool> m_seqRunningFlag{false};
+    std::atomic<int> m_seqPlayStep{0};
+    std::atomic<float> m_seqStepPhase{0.0f};
+
+    // Only the audio thread clears m_recording once a take is running, after its last write
+    // into m_recordRing; the writer thread drains the ring to disk until then.
     std::atomic<bool> m_recording{false};
-    int m_recordFramesLeft = 0;
-    int m_recordTargetRate = 0;
-    QString m_recordPath;
-    std::vector<float> m_recordFloat;
-    std::mutex m_recordMutex;
+    std::atomic<bool> m_recordStop{false};
+    qint64 m_recordFramesLeft = 0;
+    SpscRingBuffer<float> m_recordRing;
+    std::atomic<quint64> m_recordDropped{0};
+    std::thread m_recordWriter;
+
+    // Streaming voices. Rings are allocated by the first stream trigger; offline engines fill
+    // them on the mixing thread instead of running the reader.
+    std::array<StreamSlot, kStreamSlots> m_streamSlots;
+    bool m_streamingReady = false;
+    std::atomic<bool> m_streamRunning{false};
+    std::thread m_streamReader;
+    std::vector<float> m_streamScratch;
     void *m_pcmHandle = nullptr;
+    // snd_pcm_format_t picked by start(), and whether run() mixes into the mmap'd ring.
+    int m_pcmFormat = 0;
+    bool m_pcmMmap = false;
+    // JACK backend: the client, ports master L/R then bus 1-5 L/R, and interleaved scratch for
+    // the period. m_busTaps point into m_jackBusMix while JACK runs; mixBlock() copies each
+    // bus's post-gain block there at m_blockOffset so the bus ports get it as a direct out.
+    void *m_jackClient = nullptr;
+    std::array<void *, 12> m_jackPorts{};
+    std::vector<float> m_jackMix;
+    std::array<std::vector<float>, 6> m_jackBusMix;
+    std::array<float *, 6> m_busTaps{};
+    int m_blockOffset = 0;
     QString m_deviceOverride;
     QString m_activeDevice;
 
@@ -326,10 +652,16 @@ private:
     std::array<std::atomic<float>, 8> m_padDecay{};
     std::array<std::atomic<float>, 8> m_padSustain{};
     std::array<std::atomic<float>, 8> m_padRelease{};
+    std::array<std::atomic<int>, 8> m_padPolyphony{};
+    std::array<std::atomic<int>, 8> m_padChoke{};
+    std::atomic<VoiceSteal> m_voiceSteal{VoiceSteal::Oldest};
     std::array<SynthState, 8> m_synthStates{};
-    std::vector<float> m_synthScratchL;
-    std::vector<float> m_synthScratchR;
-    std::vector<float> m_lastOut;
-    bool m_lastOutValid = false;
+    std::array<SynthControl, 8> m_synthControls{};
+    std::array<SynthBlock, 8> m_synthBlocks{};
     std::array<std::atomic<float>, 8> m_padPlayheads{};
+    std::array<std::atomic<bool>, 8> m_padActive{};
+    std::array<std::atomic<bool>, 8> m_synthActive{};
+    // Enabled with its core handed to the audio thread: MIDI notes can skip ensureSynthCore().
+    std::array<std::atomic<bool>, 8> m_synthLive{};
+    std::array<std::array<std::atomic<uint8_t>, kDx7VoiceParamCount>, 8> m_synthVoiceParams{};
 };
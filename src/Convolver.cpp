@@ -0,0 +1,315 @@
+#include "Convolver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+
+#include "RtScheduling.h"
+#include "SimdVec.h"
+
+namespace {
+using namespace SimdVec;
+
+constexpr int kHead = ConvolverImpulse::kHeadFrames;
+constexpr int kTail = ConvolverImpulse::kTailFrames;
+
+// a and b hold n floats, n a multiple of 4.
+float dot(const float *a, const float *b, int n) {
+    Vec acc0 = splat(0.0f);
+    Vec acc1 = splat(0.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = add(acc0, mul(load(a + i), load(b + i)));
+        acc1 = add(acc1, mul(load(a + i + 4), load(b + i + 4)));
+    }
+    for (; i < n; i += 4) {
+        acc0 = add(acc0, mul(load(a + i), load(b + i)));
+    }
+    return hsum(add(acc0, acc1));
+}
+
+// acc += x * h over bins complex values in split form.
+void multiplyAdd(const float *xRe, const float *xIm, const float *hRe, const float *hIm,
+                 float *accRe, float *accIm, int bins) {
+    int k = 0;
+    for (; k + 4 <= bins; k += 4) {
+        const Vec xr = load(xRe + k);
+        const Vec xi = load(xIm + k);
+        const Vec hr = load(hRe + k);
+        const Vec hi = load(hIm + k);
+        store(accRe + k, add(load(accRe + k), sub(mul(xr, hr), mul(xi, hi))));
+        store(accIm + k, add(load(accIm + k), add(mul(xr, hi), mul(xi, hr))));
+    }
+    for (; k < bins; ++k) {
+        accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+        accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+    }
+}
+
+void waitFor(sem_t *sem) {
+    while (sem_wait(sem) != 0 && errno == EINTR) {
+    }
+}
+}  // namespace
+
+std::shared_ptr<const ConvolverImpulse> ConvolverImpulse::create(const float *ir, int frames,
+                                                                 int channels, int maxFrames) {
+    if (!ir || frames <= 0 || channels <= 0) {
+        return nullptr;
+    }
+    const int length = maxFrames > 0 ? std::min(frames, maxFrames) : frames;
+    std::vector<float> h[2];
+    double energy = 0.0;
+    for (int ch = 0; ch < 2; ++ch) {
+        const int source = std::min(ch, channels - 1);
+        h[ch].resize(static_cast<size_t>(length));
+        for (int i = 0; i < length; ++i) {
+            const float v = ir[static_cast<size_t>(i) * channels + source];
+            h[ch][static_cast<size_t>(i)] = v;
+            energy += static_cast<double>(v) * v;
+        }
+    }
+    // Unit energy per channel, so a long hall is no louder than a short cabinet.
+    energy *= 0.5;
+    if (energy < 1e-12) {
+        return nullptr;
+    }
+    const float gain = static_cast<float>(1.0 / std::sqrt(energy));
+
+    auto impulse = std::make_shared<ConvolverImpulse>();
+    impulse->m_frames = length;
+    for (int ch = 0; ch < 2; ++ch) {
+        impulse->m_head[ch].assign(kHead, 0.0f);
+        for (int i = 0; i < std::min(kHead, length); ++i) {
+            impulse->m_head[ch][static_cast<size_t>(kHead - 1 - i)] =
+                h[ch][static_cast<size_t>(i)] * gain;
+        }
+    }
+
+    // Each partition of h[begin, end) zero-padded to twice its size, with the inverse FFT's
+    // 1 / N folded in.
+    auto cut = [&](Spectra &out, int begin, int end, int size) {
+        out.size = size;
+        out.partitions = end > begin ? (end - begin + size - 1) / size : 0;
+        if (out.partitions == 0) {
+            return;
+        }
+        const int fftSize = size * 2;
+        const int bins = size + 1;
+        const float scale = gain / static_cast<float>(fftSize);
+        out.re.assign(static_cast<size_t>(2 * out.partitions * bins), 0.0f);
+        out.im.assign(out.re.size(), 0.0f);
+        kiss_fftr_cfg forward = kiss_fftr_alloc(fftSize, 0, nullptr, nullptr);
+        std::vector<float> time(static_cast<size_t>(fftSize));
+        std::vector<kiss_fft_cpx> spectrum(static_cast<size_t>(bins));
+        for (int ch = 0; ch < 2; ++ch) {
+            for (int p = 0; p < out.partitions; ++p) {
+                std::fill(time.begin(), time.end(), 0.0f);
+                const int start = begin + p * size;
+                const int count = std::min(size, end - start);
+                std::copy(h[ch].begin() + start, h[ch].begin() + start + count, time.begin());
+                kiss_fftr(forward, time.data(), spectrum.data());
+                const size_t base = static_cast<size_t>((ch * out.partitions + p) * bins);
+                for (int k = 0; k < bins; ++k) {
+                    const kiss_fft_cpx &bin = spectrum[static_cast<size_t>(k)];
+                    out.re[base + static_cast<size_t>(k)] = bin.r * scale;
+                    out.im[base + static_cast<size_t>(k)] = bin.i * scale;
+                }
+            }
+        }
+        kiss_fftr_free(forward);
+    };
+    const int earlyEnd = std::min(length, 2 * kTail);
+    cut(impulse->m_early, kHead, earlyEnd, kHead);
+    cut(impulse->m_tail, 2 * kTail, length, kTail);
+    return impulse;
+}
+
+void Convolver::Segment::init(const ConvolverImpulse::Spectra &source) {
+    spectra = &source;
+    if (source.partitions == 0) {
+        return;
+    }
+    const int bins = source.size + 1;
+    forward = kiss_fftr_alloc(source.size * 2, 0, nullptr, nullptr);
+    inverse = kiss_fftr_alloc(source.size * 2, 1, nullptr, nullptr);
+    historyRe.assign(static_cast<size_t>(2 * source.partitions * bins), 0.0f);
+    historyIm.assign(historyRe.size(), 0.0f);
+    head = 0;
+    accRe.assign(static_cast<size_t>(bins), 0.0f);
+    accIm.assign(static_cast<size_t>(bins), 0.0f);
+    spectrum.assign(static_cast<size_t>(bins), kiss_fft_cpx{});
+    time.assign(static_cast<size_t>(source.size * 2), 0.0f);
+}
+
+void Convolver::Segment::release() {
+    kiss_fftr_free(forward);
+    kiss_fftr_free(inverse);
+    forward = nullptr;
+    inverse = nullptr;
+}
+
+void Convolver::Segment::run(int channel, const float *window, float *out) {
+    const int size = spectra->size;
+    const int partitions = spectra->partitions;
+    const int bins = size + 1;
+    const size_t channelBase = static_cast<size_t>(channel * partitions * bins);
+
+    kiss_fftr(forward, window, spectrum.data());
+    float *newRe = historyRe.data() + channelBase + static_cast<size_t>(head * bins);
+    float *newIm = historyIm.data() + channelBase + static_cast<size_t>(head * bins);
+    for (int k = 0; k < bins; ++k) {
+        newRe[k] = spectrum[static_cast<size_t>(k)].r;
+        newIm[k] = spectrum[static_cast<size_t>(k)].i;
+    }
+
+    // Partition p meets the input spectrum from p blocks ago.
+    std::fill(accRe.begin(), accRe.end(), 0.0f);
+    std::fill(accIm.begin(), accIm.end(), 0.0f);
+    int slot = head;
+    for (int p = 0; p < partitions; ++p) {
+        const size_t x = channelBase + static_cast<size_t>(slot * bins);
+        const size_t h = channelBase + static_cast<size_t>(p * bins);
+        multiplyAdd(historyRe.data() + x, historyIm.data() + x, spectra->re.data() + h,
+                    spectra->im.data() + h, accRe.data(), accIm.data(), bins);
+        slot = slot == 0 ? partitions - 1 : slot - 1;
+    }
+
+    for (int k = 0; k < bins; ++k) {
+        spectrum[static_cast<size_t>(k)].r = accRe[static_cast<size_t>(k)];
+        spectrum[static_cast<size_t>(k)].i = accIm[static_cast<size_t>(k)];
+    }
+    kiss_fftri(inverse, spectrum.data(), time.data());
+    // Overlap-save: the first half wrapped around, the second half is the block.
+    std::copy(time.begin() + size, time.end(), out);
+}
+
+void Convolver::Segment::advance() {
+    head = head + 1 == spectra->partitions ? 0 : head + 1;
+}
+
+Convolver::Convolver(std::shared_ptr<const ConvolverImpulse> impulse, bool background,
+                     int priority)
+    : m_impulse(std::move(impulse)), m_priority(priority) {
+    for (int ch = 0; ch < 2; ++ch) {
+        m_headWindow[ch].assign(2 * kHead, 0.0f);
+        m_earlyOut[ch].assign(kHead, 0.0f);
+        m_tailIn[ch].assign(kTail, 0.0f);
+        m_tailOut[0][ch].assign(kTail, 0.0f);
+        m_tailOut[1][ch].assign(kTail, 0.0f);
+        m_tailJob[ch].assign(kTail, 0.0f);
+        m_tailWindow[ch].assign(2 * kTail, 0.0f);
+    }
+    m_early.init(m_impulse->m_early);
+    m_tail.init(m_impulse->m_tail);
+    sem_init(&m_wake, 0, 0);
+    sem_init(&m_done, 0, 0);
+    m_background = background && m_impulse->m_tail.partitions > 0;
+    if (m_background) {
+        m_thread = std::thread([this] { tailLoop(); });
+    }
+}
+
+Convolver::~Convolver() {
+    if (m_thread.joinable()) {
+        m_quit.store(true, std::memory_order_release);
+        sem_post(&m_wake);
+        m_thread.join();
+    }
+    sem_destroy(&m_wake);
+    sem_destroy(&m_done);
+    m_early.release();
+    m_tail.release();
+}
+
+void Convolver::process(float *left, float *right, int frames, float wet) {
+    const float dry = 1.0f - wet;
+    float *io[2] = {left, right};
+    for (int done = 0; done < frames;) {
+        const int n = std::min(frames - done, kHead - m_headPos);
+        for (int ch = 0; ch < 2; ++ch) {
+            float *x = io[ch] + done;
+            float *window = m_headWindow[ch].data();
+            std::copy(x, x + n, window + kHead + m_headPos);
+            std::copy(x, x + n, m_tailIn[ch].data() + m_tailPos);
+            const float *taps = m_impulse->m_head[ch].data();
+            const float *early = m_earlyOut[ch].data() + m_headPos;
+            const float *tail = m_tailOut[m_tailPlaying][ch].data() + m_tailPos;
+            for (int i = 0; i < n; ++i) {
+                // The head FIR ends at the newest input: window[kHead + m_headPos + i].
+                const float y = dot(window + m_headPos + i + 1, taps, kHead) + early[i] + tail[i];
+                x[i] = x[i] * dry + y * wet;
+            }
+        }
+        m_headPos += n;
+        m_tailPos += n;
+        done += n;
+        if (m_headPos == kHead) {
+            headBoundary();
+        }
+        if (m_tailPos == kTail) {
+            tailBoundary();
+        }
+    }
+}
+
+void Convolver::headBoundary() {
+    const bool early = m_early.spectra->partitions > 0;
+    for (int ch = 0; ch < 2; ++ch) {
+        float *window = m_headWindow[ch].data();
+        if (early) {
+            m_early.run(ch, window, m_earlyOut[ch].data());
+        }
+        std::copy(window + kHead, window + 2 * kHead, window);
+    }
+    if (early) {
+        m_early.advance();
+    }
+    m_headPos = 0;
+}
+
+void Convolver::tailBoundary() {
+    m_tailPos = 0;
+    if (m_tail.spectra->partitions == 0) {
+        return;
+    }
+    // The block started at the previous boundary plays from here on.
+    if (m_tailPending && m_background) {
+        waitFor(&m_done);
+    }
+    m_tailPlaying ^= 1;
+    for (int ch = 0; ch < 2; ++ch) {
+        std::copy(m_tailIn[ch].begin(), m_tailIn[ch].end(), m_tailJob[ch].begin());
+    }
+    m_tailPending = true;
+    if (m_background) {
+        sem_post(&m_wake);
+    } else {
+        runTail();
+    }
+}
+
+void Convolver::runTail() {
+    // Fills the block that is not playing; m_tailPlaying only changes after m_done.
+    const int target = m_tailPlaying ^ 1;
+    for (int ch = 0; ch < 2; ++ch) {
+        float *window = m_tailWindow[ch].data();
+        std::copy(m_tailJob[ch].begin(), m_tailJob[ch].end(), window + kTail);
+        m_tail.run(ch, window, m_tailOut[target][ch].data());
+        std::copy(window + kTail, window + 2 * kTail, window);
+    }
+    m_tail.advance();
+}
+
+void Convolver::tailLoop() {
+    RtScheduling::enterRealtime(m_priority, -1);
+    RtScheduling::prefaultStack();
+    for (;;) {
+        waitFor(&m_wake);
+        if (m_quit.load(std::memory_order_acquire)) {
+            break;
+        }
+        runTail();
+        sem_post(&m_done);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <semaphore.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "kiss_fftr.h"
+
+// Impulse response cut up for Convolver: the first kHeadFrames taps as a direct FIR, then
+// uniform partitions of kHeadFrames up to 2 * kTailFrames, then partitions of kTailFrames for
+// the rest, each stored as its spectrum. Immutable once built, so one copy serves every bus
+// that uses the same file.
+class ConvolverImpulse {
+public:
+    static constexpr int kHeadFrames = 64;
+    static constexpr int kTailFrames = 2048;
+
+    // ir is interleaved with 1 or 2 channels at the engine rate; mono feeds both sides. The
+    // response is trimmed to maxFrames and normalised to unit energy. Allocates and runs the
+    // FFTs, so it belongs on a control thread. Null for an empty response.
+    static std::shared_ptr<const ConvolverImpulse> create(const float *ir, int frames,
+                                                          int channels, int maxFrames);
+
+    int frames() const { return m_frames; }
+
+private:
+    friend class Convolver;
+
+    // Partition spectra in split complex form: [channel][partition][bin], bins = size + 1.
+    struct Spectra {
+        int size = 0;
+        int partitions = 0;
+        std::vector<float> re;
+        std::vector<float> im;
+    };
+
+    int m_frames = 0;
+    // Head taps per channel, reversed so the FIR is a forward dot product.
+    std::vector<float> m_head[2];
+    Spectra m_early;
+    Spectra m_tail;
+};
+
+// Zero-latency stereo convolution. The head FIR covers the first kHeadFrames of the response
+// while the short partitions buffer up; the short partitions are computed on the audio thread
+// each time kHeadFrames of input are in. The long partitions start 2 * kTailFrames into the
+// response, so the tail of each block has a whole kTailFrames of time to finish: on a helper
+// thread when background is set, inline at the block boundary otherwise. The audio thread only
+// waits on the helper if it is still busy one block later.
+class Convolver {
+public:
+    // priority > 0 runs the helper SCHED_FIFO at that priority when allowed.
+    Convolver(std::shared_ptr<const ConvolverImpulse> impulse, bool background, int priority);
+    ~Convolver();
+    Convolver(const Convolver &) = delete;
+    Convolver &operator=(const Convolver &) = delete;
+
+    // In place: left/right become dry * (1 - wet) + convolved * wet.
+    void process(float *left, float *right, int frames, float wet);
+
+private:
+    // Uniformly partitioned overlap-save over one Spectra set: an input window of two
+    // partitions, a ring of past input spectra and one accumulator.
+    struct Segment {
+        const ConvolverImpulse::Spectra *spectra = nullptr;
+        kiss_fftr_cfg forward = nullptr;
+        kiss_fftr_cfg inverse = nullptr;
+        // [channel][partition][bin], newest at head.
+        std::vector<float> historyRe;
+        std::vector<float> historyIm;
+        int head = 0;
+        std::vector<float> accRe;
+        std::vector<float> accIm;
+        std::vector<kiss_fft_cpx> spectrum;
+        std::vector<float> time;
+
+        void init(const ConvolverImpulse::Spectra &source);
+        void release();
+        // window holds 2 * size samples, oldest first; writes the last size outputs to out.
+        void run(int channel, const float *window, float *out);
+        // Called after both channels have run.
+        void advance();
+    };
+
+    void headBoundary();
+    void tailBoundary();
+    void runTail();
+    void tailLoop();
+
+    std::shared_ptr<const ConvolverImpulse> m_impulse;
+    bool m_background = false;
+    int m_priority = 0;
+
+    // Previous and current head block per channel.
+    std::vector<float> m_headWindow[2];
+    std::vector<float> m_earlyOut[2];
+    int m_headPos = 0;
+    Segment m_early;
+
+    // Audio side: input gathered for the current tail block and the two output blocks, one
+    // playing, the other being computed.
+    std::vector<float> m_tailIn[2];
+    std::vector<float> m_tailOut[2][2];
+    int m_tailPlaying = 0;
+    int m_tailPos = 0;
+    bool m_tailPending = false;
+    // Helper side: the block handed over and the window it slides into.
+    std::vector<float> m_tailJob[2];
+    std::vector<float> m_tailWindow[2];
+    Segment m_tail;
+
+    std::thread m_thread;
+    sem_t m_wake;
+    sem_t m_done;
+    std::atomic<bool> m_quit{false};
+};
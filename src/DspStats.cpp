@@ -0,0 +1,92 @@
+#include "DspStats.h"
+
+#include <algorithm>
+
+namespace {
+// Same smoothing as the worker pool's load readout.
+constexpr float kLoadSmoothing = 0.1f;
+
+void smooth(std::atomic<float> &target, double busyNs, double periodNs) {
+    const float now = static_cast<float>(busyNs / periodNs);
+    const float prev = target.load(std::memory_order_relaxed);
+    target.store(prev + (now - prev) * kLoadSmoothing, std::memory_order_relaxed);
+}
+}  // namespace
+
+void DspStats::addEffect(int bus, int type, long long ns) {
+    if (type <= 0 || type >= kEffectTypes) {
+        return;
+    }
+    m_effectNs[static_cast<size_t>(bus)][static_cast<size_t>(type)] += ns;
+}
+
+void DspStats::endPeriod(long long mixNs, double periodNs) {
+    if (periodNs <= 0.0) {
+        return;
+    }
+    if (m_resetPending.exchange(false, std::memory_order_relaxed)) {
+        m_worst.store(0.0f, std::memory_order_relaxed);
+        for (auto &bin : m_histogram) {
+            bin.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    const float now = static_cast<float>(mixNs / periodNs);
+    smooth(m_load, static_cast<double>(mixNs), periodNs);
+    if (now > m_worst.load(std::memory_order_relaxed)) {
+        m_worst.store(now, std::memory_order_relaxed);
+    }
+    const int bin = std::min(kHistogramBins - 1, static_cast<int>(now * 10.0f));
+    auto &count = m_histogram[static_cast<size_t>(bin)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_periods.store(m_periods.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    for (int bus = 0; bus < kBuses; ++bus) {
+        auto &ns = m_busNs[static_cast<size_t>(bus)];
+        smooth(m_busLoad[static_cast<size_t>(bus)], static_cast<double>(ns), periodNs);
+        ns = 0;
+    }
+    for (int pad = 0; pad < kSynthPads; ++pad) {
+        auto &ns = m_synthNs[static_cast<size_t>(pad)];
+        smooth(m_synthLoad[static_cast<size_t>(pad)], static_cast<double>(ns), periodNs);
+        ns = 0;
+    }
+    for (int type = 1; type < kEffectTypes; ++type) {
+        long long total = 0;
+        for (auto &busEffects : m_effectNs) {
+            total += busEffects[static_cast<size_t>(type)];
+            busEffects[static_cast<size_t>(type)] = 0;
+        }
+        smooth(m_effectLoad[static_cast<size_t>(type)], static_cast<double>(total), periodNs);
+    }
+}
+
+float DspStats::busLoad(int bus) const {
+    if (bus < 0 || bus >= kBuses) {
+        return 0.0f;
+    }
+    return m_busLoad[static_cast<size_t>(bus)].load(std::memory_order_relaxed);
+}
+
+float DspStats::synthLoad(int pad) const {
+    if (pad < 0 || pad >= kSynthPads) {
+        return 0.0f;
+    }
+    return m_synthLoad[static_cast<size_t>(pad)].load(std::memory_order_relaxed);
+}
+
+float DspStats::effectLoad(int type) const {
+    if (type <= 0 || type >= kEffectTypes) {
+        return 0.0f;
+    }
+    return m_effectLoad[static_cast<size_t>(type)].load(std::memory_order_relaxed);
+}
+
+DspStats::Histogram DspStats::histogram() const {
+    Histogram out{};
+    for (int i = 0; i < kHistogramBins; ++i) {
+        out[static_cast<size_t>(i)] = m_histogram[static_cast<size_t>(i)].load(
+            std::memory_order_relaxed);
+    }
+    return out;
+}
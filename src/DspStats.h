@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "EffectKernels.h"
+
+// Timing of the audio callback for the UI. The audio thread adds the time spent per bus, synth
+// pad and effect type while it mixes and closes each period with endPeriod(); the mix workers
+// only ever write their own bus or pad slot, and the worker pool's barrier orders those writes
+// before endPeriod() reads them. Everything the UI reads is a relaxed atomic, so neither side
+// locks or waits. Loads are shares of the period: 1.0 means the deadline was just met.
+class DspStats {
+public:
+    static constexpr int kBuses = 6;
+    static constexpr int kSynthPads = 8;
+    // Indexed by effect type; 0 is unused.
+    static constexpr int kEffectTypes = EffectKernels::TypeCount;
+    // 10% wide up to 100%; the last bin counts every period that overran.
+    static constexpr int kHistogramBins = 11;
+
+    using Histogram = std::array<uint32_t, kHistogramBins>;
+
+    // Audio side.
+    void addBus(int bus, long long ns) { m_busNs[static_cast<size_t>(bus)] += ns; }
+    void addSynth(int pad, long long ns) { m_synthNs[static_cast<size_t>(pad)] += ns; }
+    void addEffect(int bus, int type, long long ns);
+    void endPeriod(long long mixNs, double periodNs);
+    // Safe from any thread: JACK reports xruns from its notification thread.
+    void countXrun() { m_xruns.fetch_add(1, std::memory_order_relaxed); }
+
+    // UI side.
+    float load() const { return m_load.load(std::memory_order_relaxed); }
+    float worstLoad() const { return m_worst.load(std::memory_order_relaxed); }
+    float busLoad(int bus) const;
+    float synthLoad(int pad) const;
+    float effectLoad(int type) const;
+    uint64_t periods() const { return m_periods.load(std::memory_order_relaxed); }
+    uint64_t xruns() const { return m_xruns.load(std::memory_order_relaxed); }
+    Histogram histogram() const;
+    // Clears the worst case and histogram at the next period end.
+    void reset() { m_resetPending.store(true, std::memory_order_relaxed); }
+
+private:
+    // Plain accumulators, owned by the mixing threads.
+    std::array<long long, kBuses> m_busNs{};
+    std::array<long long, kSynthPads> m_synthNs{};
+    std::array<std::array<long long, kEffectTypes>, kBuses> m_effectNs{};
+
+    std::atomic<float> m_load{0.0f};
+    std::atomic<float> m_worst{0.0f};
+    std::array<std::atomic<float>, kBuses> m_busLoad{};
+    std::array<std::atomic<float>, kSynthPads> m_synthLoad{};
+    std::array<std::atomic<float>, kEffectTypes> m_effectLoad{};
+    std::array<std::atomic<uint32_t>, kHistogramBins> m_histogram{};
+    std::atomic<uint64_t> m_periods{0};
+    std::atomic<uint64_t> m_xruns{0};
+    std::atomic<bool> m_resetPending{false};
+};
@@ -0,0 +1,800 @@
+#include "EffectKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "SimdVec.h"
+
+namespace EffectKernels {
+namespace {
+
+using namespace SimdVec;
+
+constexpr float kTwoPi = 6.283185307179586f;
+// Gain curves are worked out this many frames at a time into a stack block.
+constexpr int kChunk = 256;
+constexpr int kGrainFrames = 4096;
+
+// Rational tanh, exact at 0 and reaching 1 at |x| = 3; within 0.025 of std::tanh everywhere,
+// which a drive stage cannot hear and which vectorises.
+inline float fastTanh(float x) {
+    x = std::max(-3.0f, std::min(3.0f, x));
+    const float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+#if defined(GROOVEBOX_SIMD)
+inline Vec fastTanh(Vec x) {
+    x = vmax(splat(-3.0f), vmin(splat(3.0f), x));
+    const Vec x2 = mul(x, x);
+    return div(mul(x, add(splat(27.0f), x2)), add(splat(27.0f), mul(splat(9.0f), x2)));
+}
+#endif
+
+inline float wrapPhase(float phase, float inc, int frames) {
+    return std::fmod(phase + inc * static_cast<float>(frames), kTwoPi);
+}
+
+inline float onePoleLow(float x, float &z, float a) {
+    z = a * z + (1.0f - a) * x;
+    return z;
+}
+
+// Sine LFO by rotation: one sin/cos pair per block instead of one sin per frame.
+struct Phasor {
+    Phasor(float phase, float inc)
+        : s(std::sin(phase)), c(std::cos(phase)), ds(std::sin(inc)), dc(std::cos(inc)) {}
+    float sin() const { return s; }
+    float cos() const { return c; }
+    void next() {
+        const float nextS = s * dc + c * ds;
+        c = c * dc - s * ds;
+        s = nextS;
+    }
+    float s;
+    float c;
+    float ds;
+    float dc;
+};
+
+// x[i] *= gain[i] on both channels.
+void applyGain(float *left, float *right, const float *gain, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    for (; i + 4 <= frames; i += 4) {
+        const Vec g = load(gain + i);
+        store(left + i, mul(load(left + i), g));
+        store(right + i, mul(load(right + i), g));
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] *= gain[i];
+        right[i] *= gain[i];
+    }
+}
+
+void scale(float *left, float *right, float gain, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    const Vec g = splat(gain);
+    for (; i + 4 <= frames; i += 4) {
+        store(left + i, mul(load(left + i), g));
+        store(right + i, mul(load(right + i), g));
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] *= gain;
+        right[i] *= gain;
+    }
+}
+
+// Frames from the write position on that wrap neither the write nor a tap `delay` frames back,
+// and never read what the same run writes. Within such a run a feedback line has no
+// frame-to-frame dependency, so it can be processed a vector at a time.
+int runFor(const Ring &ring, int delay, int limit) {
+    const int capacity = static_cast<int>(ring.mask + 1);
+    const int write = static_cast<int>(ring.write);
+    const int read = static_cast<int>((ring.write - static_cast<uint32_t>(delay)) & ring.mask);
+    return std::min({limit, delay, capacity - delay, capacity - write, capacity - read});
+}
+
+const float *tap(const Ring &ring, int delay) {
+    return ring.data.data() + ((ring.write - static_cast<uint32_t>(delay)) & ring.mask);
+}
+
+void advance(Ring &ring, int frames) {
+    ring.write = (ring.write + static_cast<uint32_t>(frames)) & ring.mask;
+}
+
+// Line lengths in ms at size 1: spread over a little more than an octave, no common factors
+// in frames at the usual rates.
+constexpr float kFdnDelayMs[Fdn::kLines] = {29.7f, 33.3f, 37.9f, 41.3f,
+                                            46.9f, 53.1f, 59.7f, 67.3f};
+constexpr float kFdnLfoHz[Fdn::kLines] = {0.13f, 0.21f, 0.29f, 0.37f,
+                                          0.43f, 0.53f, 0.61f, 0.71f};
+// Left feeds the even lines and right the odd ones; the two outputs take orthogonal sign
+// patterns over all eight, which keeps them decorrelated.
+constexpr float kFdnInLeft[Fdn::kLines] = {1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f};
+constexpr float kFdnInRight[Fdn::kLines] = {0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, -1.0f};
+constexpr float kFdnOutLeft[Fdn::kLines] = {1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f};
+constexpr float kFdnOutRight[Fdn::kLines] = {1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, 1.0f};
+constexpr float kFdnInGain = 0.5f;
+constexpr float kFdnOutGain = 0.6f;
+// Frames between updates of the modulated line lengths.
+constexpr int kFdnModStep = 16;
+
+
+void prepareFdn(const Params &p, int sampleRate, Fdn &fdn) {
+    const float sr = static_cast<float>(sampleRate);
+    const float size = 0.4f + p.p3 * 1.2f;
+    const float rt60 = 0.2f * std::pow(2.0f, p.p2 * 5.5f);
+    const float cutoff = std::min(2000.0f * std::pow(2.0f, p.p4 * 3.0f), sr * 0.45f);
+    fdn.damp = 1.0f - std::exp(-kTwoPi * cutoff / sr);
+    fdn.modDepth = 0.0003f * sr;
+    float longest = 0.0f;
+    for (int k = 0; k < Fdn::kLines; ++k) {
+        // Longer than a modulation step, which reverb() reads ahead in one go.
+        fdn.delay[k] =
+            std::max(static_cast<float>(kFdnModStep + 2), kFdnDelayMs[k] * 0.001f * size * sr);
+        // -60 dB after rt60 seconds, whatever the line length.
+        fdn.gain[k] = std::pow(10.0f, -3.0f * fdn.delay[k] / (sr * rt60));
+        const float phase = 0.7f * static_cast<float>(k);
+        const float inc = kTwoPi * kFdnLfoHz[k] * static_cast<float>(kFdnModStep) / sr;
+        fdn.lfoSin[k] = std::sin(phase);
+        fdn.lfoCos[k] = std::cos(phase);
+        fdn.lfoStepSin[k] = std::sin(inc);
+        fdn.lfoStepCos[k] = std::cos(inc);
+        longest = std::max(longest, fdn.delay[k]);
+    }
+    uint32_t capacity = 2;
+    while (capacity < static_cast<uint32_t>(longest + 2.0f * fdn.modDepth + 2.0f)) {
+        capacity <<= 1;
+    }
+    fdn.lines.assign(static_cast<size_t>(capacity) * Fdn::kLines, 0.0f);
+    fdn.mask = capacity - 1;
+    fdn.write = 0;
+}
+
+void reverb(const Params &p, State &s, float *left, float *right, int frames) {
+    Fdn &fdn = s.fdn;
+    if (fdn.lines.empty()) {
+        return;
+    }
+    const float wet = p.p1;
+    const float dry = 1.0f - wet;
+    const Vec damp = splat(fdn.damp);
+    const Vec gain0 = load(fdn.gain);
+    const Vec gain1 = load(fdn.gain + 4);
+    const Vec inL0 = mul(load(kFdnInLeft), splat(kFdnInGain));
+    const Vec inL1 = mul(load(kFdnInLeft + 4), splat(kFdnInGain));
+    const Vec inR0 = mul(load(kFdnInRight), splat(kFdnInGain));
+    const Vec inR1 = mul(load(kFdnInRight + 4), splat(kFdnInGain));
+    const Vec outL0 = mul(load(kFdnOutLeft), splat(kFdnOutGain));
+    const Vec outL1 = mul(load(kFdnOutLeft + 4), splat(kFdnOutGain));
+    const Vec outR0 = mul(load(kFdnOutRight), splat(kFdnOutGain));
+    const Vec outR1 = mul(load(kFdnOutRight + 4), splat(kFdnOutGain));
+    // Householder reflection I - 2/N * ones: lossless, and every line feeds every other.
+    const float reflect = 2.0f / static_cast<float>(Fdn::kLines);
+    Vec low0 = load(fdn.low);
+    Vec low1 = load(fdn.low + 4);
+    float *lines = fdn.lines.data();
+    const uint32_t mask = fdn.mask;
+    uint32_t write = fdn.write;
+    uint32_t whole[Fdn::kLines];
+    float frac[Fdn::kLines];
+    float taps[kFdnModStep * Fdn::kLines];
+
+    for (int done = 0; done < frames; done += kFdnModStep) {
+        // The modulated lengths move by a fraction of a frame per step, so they are worked out
+        // once per step rather than per frame.
+        for (int k = 0; k < Fdn::kLines; ++k) {
+            const float delay = fdn.delay[k] + fdn.modDepth * (1.0f + fdn.lfoSin[k]);
+            whole[k] = static_cast<uint32_t>(delay);
+            frac[k] = delay - static_cast<float>(whole[k]);
+            const float nextSin = fdn.lfoSin[k] * fdn.lfoStepCos[k] +
+                                  fdn.lfoCos[k] * fdn.lfoStepSin[k];
+            fdn.lfoCos[k] = fdn.lfoCos[k] * fdn.lfoStepCos[k] - fdn.lfoSin[k] * fdn.lfoStepSin[k];
+            fdn.lfoSin[k] = nextSin;
+        }
+        // Every line is longer than a step, so the whole step can be read before any of it is
+        // written.
+        const int count = std::min(kFdnModStep, frames - done);
+        for (int k = 0; k < Fdn::kLines; ++k) {
+            uint32_t read = write - whole[k];
+            for (int i = 0; i < count; ++i) {
+                const float a = lines[(read & mask) * Fdn::kLines + k];
+                const float b = lines[((read - 1) & mask) * Fdn::kLines + k];
+                taps[i * Fdn::kLines + k] = a + (b - a) * frac[k];
+                ++read;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            const float *tap = taps + i * Fdn::kLines;
+            const int frame = done + i;
+            low0 = add(low0, mul(damp, sub(load(tap), low0)));
+            low1 = add(low1, mul(damp, sub(load(tap + 4), low1)));
+
+            const Vec y0 = mul(low0, gain0);
+            const Vec y1 = mul(low1, gain1);
+            const Vec reflected = splat(hsum(add(y0, y1)) * reflect);
+            const Vec inLeft = splat(left[frame]);
+            const Vec inRight = splat(right[frame]);
+            float *row = lines + static_cast<size_t>(write) * Fdn::kLines;
+            store(row, add(sub(y0, reflected), add(mul(inLeft, inL0), mul(inRight, inR0))));
+            store(row + 4, add(sub(y1, reflected), add(mul(inLeft, inL1), mul(inRight, inR1))));
+
+            const float wetL = hsum(add(mul(low0, outL0), mul(low1, outL1)));
+            const float wetR = hsum(add(mul(low0, outR0), mul(low1, outR1)));
+            left[frame] = left[frame] * dry + wetL * wet;
+            right[frame] = right[frame] * dry + wetR * wet;
+            write = (write + 1) & mask;
+        }
+    }
+    store(fdn.low, low0);
+    store(fdn.low + 4, low1);
+    fdn.write = write;
+}
+
+void comp(const Params &p, State &s, float *left, float *right, int frames) {
+    const float threshold = 0.15f + p.p1 * 0.5f;
+    const float ratio = 1.5f + p.p2 * 6.5f;
+    const float attack = 0.01f + p.p3 * 0.12f;
+    const float release = 0.03f + p.p4 * 0.35f;
+    const float makeup = (p.p5 >= 0.5f) ? 1.35f : 1.0f;
+    const float exponent = -(ratio - 1.0f) / ratio;
+    float gain[kChunk];
+    for (int done = 0; done < frames; done += kChunk) {
+        const int n = std::min(kChunk, frames - done);
+        for (int i = 0; i < n; ++i) {
+            const float env = std::max(std::fabs(left[done + i]), std::fabs(right[done + i]));
+            const float coeff = (env > s.env) ? attack : release;
+            s.env = s.env + (env - s.env) * coeff;
+            gain[i] = (s.env > threshold ? std::pow(s.env / threshold, exponent) : 1.0f) * makeup;
+        }
+        applyGain(left + done, right + done, gain, n);
+    }
+}
+
+void distChannel(float *x, float drive, float mix, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    const Vec vdrive = splat(drive);
+    const Vec vdry = splat(1.0f - mix);
+    const Vec vwet = splat(mix);
+    for (; i + 4 <= frames; i += 4) {
+        const Vec in = load(x + i);
+        store(x + i, add(mul(in, vdry), mul(fastTanh(mul(in, vdrive)), vwet)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        x[i] = x[i] * (1.0f - mix) + fastTanh(x[i] * drive) * mix;
+    }
+}
+
+void dist(const Params &p, float *left, float *right, int frames) {
+    const float drive = 1.0f + p.p1 * 6.0f;
+    distChannel(left, drive, p.p2, frames);
+    distChannel(right, drive, p.p2, frames);
+}
+
+void lofi(const Params &p, State &s, float *left, float *right, int frames) {
+    const int hold = std::max(1, 1 + static_cast<int>(p.p2 * 7.0f));
+    const float bits = 4.0f + p.p1 * 8.0f;
+    const float step = 1.0f / std::pow(2.0f, bits);
+    const float invStep = 1.0f / step;
+    for (int i = 0; i < frames; ++i) {
+        // The hold count runs across blocks, so the rate reduction does not restart each block.
+        if (s.hold <= 0) {
+            s.z1L = left[i];
+            s.z1R = right[i];
+            s.hold = hold;
+        }
+        --s.hold;
+        left[i] = std::round(s.z1L * invStep) * step;
+        right[i] = std::round(s.z1R * invStep) * step;
+    }
+}
+
+void cassetteChannel(float *x, float &z, uint32_t &noise, float lpf, float noiseAmount,
+                     int frames) {
+    for (int i = 0; i < frames; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        const float n = (static_cast<float>(noise >> 8) * (1.0f / 16777216.0f) - 0.5f) *
+                        noiseAmount;
+        z = z + lpf * (x[i] - z);
+        x[i] = fastTanh(z + n);
+    }
+}
+
+void cassette(const Params &p, State &s, float *left, float *right, int frames) {
+    const float noiseAmount = p.p1 * 0.05f;
+    const float lpf = 0.05f + p.p2 * 0.3f;
+    cassetteChannel(left, s.z1L, s.noise, lpf, noiseAmount, frames);
+    cassetteChannel(right, s.z1R, s.noise, lpf, noiseAmount, frames);
+}
+
+void chorus(const Params &p, const Context &ctx, State &s, float *left, float *right,
+            int frames) {
+    if (s.ringL.empty()) {
+        return;
+    }
+    const float depth = 0.002f + p.p1 * 0.008f;
+    const float rate = 0.1f + p.p2 * 0.8f;
+    const float mix = p.p3;
+    const float sr = static_cast<float>(ctx.sampleRate);
+    const float inc = kTwoPi * rate / sr;
+    // Right runs a quarter cycle ahead, which is the cosine of the same phasor.
+    Phasor lfo(s.phase, inc);
+    const uint32_t mask = s.ringL.mask;
+    float *bufL = s.ringL.data.data();
+    float *bufR = s.ringR.data.data();
+    uint32_t write = s.ringL.write;
+    for (int i = 0; i < frames; ++i) {
+        const int delayL = static_cast<int>((0.005f + depth * (lfo.sin() + 1.0f) * 0.5f) * sr);
+        const int delayR = static_cast<int>((0.005f + depth * (lfo.cos() + 1.0f) * 0.5f) * sr);
+        bufL[write] = left[i];
+        bufR[write] = right[i];
+        const float dl = bufL[(write - static_cast<uint32_t>(delayL)) & mask];
+        const float dr = bufR[(write - static_cast<uint32_t>(delayR)) & mask];
+        left[i] = left[i] * (1.0f - mix) + dl * mix;
+        right[i] = right[i] * (1.0f - mix) + dr * mix;
+        write = (write + 1) & mask;
+        lfo.next();
+    }
+    s.ringL.write = write;
+    s.ringR.write = write;
+    s.phase = wrapPhase(s.phase, inc, frames);
+}
+
+void eq(const Params &p, const Context &ctx, State &s, float *left, float *right, int frames) {
+    const float sr = static_cast<float>(ctx.sampleRate);
+    float lowCut = 30.0f * std::pow(2.0f, p.p1 * 5.5f);
+    float highCut = 800.0f * std::pow(2.0f, p.p2 * 4.5f);
+    lowCut = std::min(lowCut, 4000.0f);
+    highCut = std::min(highCut, sr * 0.45f);
+    if (highCut < lowCut * 1.5f) {
+        highCut = lowCut * 1.5f;
+    }
+    const float aLow = std::exp(-kTwoPi * lowCut / sr);
+    const float aHigh = std::exp(-kTwoPi * highCut / sr);
+    auto channel = [&](float *x, float &low, float &high) {
+        for (int i = 0; i < frames; ++i) {
+            const float hp = x[i] - onePoleLow(x[i], low, aLow);
+            x[i] = onePoleLow(hp, high, aHigh);
+        }
+    };
+    channel(left, s.z1L, s.z2L);
+    channel(right, s.z1R, s.z2R);
+}
+
+void sidechain(const Params &p, const Context &ctx, float *left, float *right, int frames) {
+    const float threshold = 0.05f + p.p1 * 0.2f;
+    if (ctx.sidechainEnv <= threshold) {
+        return;
+    }
+    const float over = (ctx.sidechainEnv - threshold) / (1.0f - threshold);
+    scale(left, right, 1.0f - p.p2 * over, frames);
+}
+
+// One channel of a feedback delay: the line takes in + fb * feedback, the output mixes in the
+// tap. fb is the tap of this or the other channel.
+void delayChannel(float *x, float *write, const float *tapped, const float *fb, float feedback,
+                  float mix, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    const Vec vfb = splat(feedback);
+    const Vec vdry = splat(1.0f - mix);
+    const Vec vwet = splat(mix);
+    for (; i + 4 <= frames; i += 4) {
+        const Vec in = load(x + i);
+        store(write + i, add(in, mul(load(fb + i), vfb)));
+        store(x + i, add(mul(in, vdry), mul(load(tapped + i), vwet)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        const float in = x[i];
+        write[i] = in + fb[i] * feedback;
+        x[i] = in * (1.0f - mix) + tapped[i] * mix;
+    }
+}
+
+void delay(const Params &p, State &s, float *left, float *right, int frames) {
+    if (s.ringL.empty()) {
+        return;
+    }
+    const bool stereo = (p.p4 >= 0.5f);
+    const float feedback = 0.1f + p.p2 * 0.85f;
+    const float mix = p.p3;
+    for (int done = 0; done < frames;) {
+        const int run = std::min(runFor(s.ringL, s.delayA, frames - done),
+                                 runFor(s.ringR, s.delayB, frames - done));
+        const float *dl = tap(s.ringL, s.delayA);
+        const float *dr = tap(s.ringR, s.delayB);
+        // Ping-pong feeds each side from the other.
+        delayChannel(left + done, s.ringL.data.data() + s.ringL.write, dl, stereo ? dr : dl,
+                     feedback, mix, run);
+        delayChannel(right + done, s.ringR.data.data() + s.ringR.write, dr, stereo ? dl : dr,
+                     feedback, mix, run);
+        advance(s.ringL, run);
+        advance(s.ringR, run);
+        done += run;
+    }
+}
+
+void tremolo(const Params &p, const Context &ctx, State &s, float *left, float *right,
+             int frames) {
+    const float depth = p.p1;
+    float rate = 0.5f + p.p2 * 6.0f;
+    if (p.p3 >= 0.5f) {
+        const float base = std::max(30.0f, ctx.bpm) / 60.0f;
+        const int divIndex = std::max(0, std::min(4, static_cast<int>(p.p2 * 4.99f)));
+        static const float mults[] = {0.25f, 0.5f, 1.0f, 2.0f, 4.0f};
+        rate = base * mults[divIndex];
+    }
+    const float inc = kTwoPi * rate / static_cast<float>(ctx.sampleRate);
+    Phasor lfo(s.phase, inc);
+    float gain[kChunk];
+    for (int done = 0; done < frames; done += kChunk) {
+        const int n = std::min(kChunk, frames - done);
+        for (int i = 0; i < n; ++i) {
+            gain[i] = 1.0f - depth * (1.0f - (lfo.sin() + 1.0f) * 0.5f);
+            lfo.next();
+        }
+        applyGain(left + done, right + done, gain, n);
+    }
+    s.phase = wrapPhase(s.phase, inc, frames);
+}
+
+void ringMod(const Params &p, const Context &ctx, State &s, float *left, float *right,
+             int frames) {
+    const float freq = 50.0f * std::pow(2.0f, p.p1 * 5.0f);
+    const float mix = p.p2;
+    const float inc = kTwoPi * freq / static_cast<float>(ctx.sampleRate);
+    Phasor osc(s.phase, inc);
+    // dry * (1 - mix) + dry * mod * mix is one gain per frame.
+    float gain[kChunk];
+    for (int done = 0; done < frames; done += kChunk) {
+        const int n = std::min(kChunk, frames - done);
+        for (int i = 0; i < n; ++i) {
+            gain[i] = (1.0f - mix) + osc.sin() * mix;
+            osc.next();
+        }
+        applyGain(left + done, right + done, gain, n);
+    }
+    s.phase = wrapPhase(s.phase, inc, frames);
+}
+
+void robotChannel(float *x, float *write, const float *tapped, float feedback, float mix,
+                  int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    const Vec vfb = splat(feedback);
+    const Vec vdry = splat(1.0f - mix);
+    const Vec vwet = splat(mix);
+    for (; i + 4 <= frames; i += 4) {
+        const Vec in = load(x + i);
+        const Vec wet = add(in, mul(load(tapped + i), vfb));
+        store(write + i, wet);
+        store(x + i, add(mul(in, vdry), mul(wet, vwet)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        const float in = x[i];
+        const float wet = in + tapped[i] * feedback;
+        write[i] = wet;
+        x[i] = in * (1.0f - mix) + wet * mix;
+    }
+}
+
+void robot(const Params &p, State &s, float *left, float *right, int frames) {
+    if (s.ringL.empty()) {
+        return;
+    }
+    const float feedback = p.p2 * 0.6f;
+    const float mix = p.p3;
+    for (int done = 0; done < frames;) {
+        const int run = runFor(s.ringL, s.delayA, frames - done);
+        robotChannel(left + done, s.ringL.data.data() + s.ringL.write, tap(s.ringL, s.delayA),
+                     feedback, mix, run);
+        robotChannel(right + done, s.ringR.data.data() + s.ringR.write, tap(s.ringR, s.delayA),
+                     feedback, mix, run);
+        advance(s.ringL, run);
+        advance(s.ringR, run);
+        done += run;
+    }
+}
+
+void punch(const Params &p, State &s, float *left, float *right, int frames) {
+    const float amount = 1.0f + p.p1 * 2.5f;
+    const float attack = 0.2f + p.p2 * 0.6f;
+    const float release = 0.02f + p.p3 * 0.2f;
+    float gain[kChunk];
+    for (int done = 0; done < frames; done += kChunk) {
+        const int n = std::min(kChunk, frames - done);
+        for (int i = 0; i < n; ++i) {
+            const float env = (std::fabs(left[done + i]) + std::fabs(right[done + i])) * 0.5f;
+            s.z1L += (env - s.z1L) * attack;
+            s.env += (env - s.env) * release;
+            gain[i] = 1.0f + std::max(0.0f, s.z1L - s.env) * amount;
+        }
+        applyGain(left + done, right + done, gain, n);
+    }
+}
+
+void subHarmonic(const Params &p, const Context &ctx, State &s, float *left, float *right,
+                 int frames) {
+    const float amount = p.p1 * 0.7f;
+    const float a = std::exp(-kTwoPi * 180.0f / static_cast<float>(ctx.sampleRate));
+    // One square-wave sign for both channels, flipped by a zero crossing on either, in frame
+    // order: left then right.
+    auto step = [&](float &x, float &prev, float &low) {
+        if ((x >= 0.0f) != (prev >= 0.0f)) {
+            s.env = -s.env;
+        }
+        prev = x;
+        x += onePoleLow(s.env * std::fabs(x), low, a) * amount;
+    };
+    for (int i = 0; i < frames; ++i) {
+        step(left[i], s.z1L, s.z2L);
+        step(right[i], s.z1R, s.z2R);
+    }
+}
+
+void harmonizer(const Params &p, State &s, float *left, float *right, int frames) {
+    if (s.grain.empty() || static_cast<int>(s.window.size()) != kGrainFrames) {
+        return;
+    }
+    const float mix = 0.2f + p.p1 * 0.8f;
+    const int keyIndex = std::max(0, std::min(11, static_cast<int>(p.p2 * 11.99f)));
+    const int third = (p.p3 >= 0.5f) ? 3 : 4;
+    const int interval1 = (third + keyIndex) % 12;
+    const int interval2 = (7 + keyIndex) % 12;
+    const float ratios[4] = {std::pow(2.0f, interval1 / 12.0f), std::pow(2.0f, interval1 / 12.0f),
+                             std::pow(2.0f, interval2 / 12.0f), std::pow(2.0f, interval2 / 12.0f)};
+    // Heads 0 and 2 restart a whole grain back, 1 and 3 half a grain back.
+    const int restart[4] = {kGrainFrames, kGrainFrames / 2, kGrainFrames, kGrainFrames / 2};
+
+    const uint32_t mask = s.grain.mask;
+    const float length = static_cast<float>(mask + 1);
+    const float *buf = s.grain.data.data();
+    float *history = s.grain.data.data();
+    const float phaseInc = 1.0f / static_cast<float>(kGrainFrames);
+    auto wrap = [length](float pos) {
+        while (pos < 0.0f) {
+            pos += length;
+        }
+        while (pos >= length) {
+            pos -= length;
+        }
+        return pos;
+    };
+
+    for (int i = 0; i < frames; ++i) {
+        const uint32_t writePos = s.grain.write;
+        history[writePos] = 0.5f * (left[i] + right[i]);
+
+        float voices = 0.0f;
+        for (int head = 0; head < 4; ++head) {
+            const float pos = s.readPos[head];
+            const uint32_t i0 = static_cast<uint32_t>(pos);
+            const float frac = pos - static_cast<float>(i0);
+            const float s0 = buf[i0 & mask];
+            const float s1 = buf[(i0 + 1) & mask];
+            const int wi = std::max(
+                0, std::min(kGrainFrames - 1,
+                            static_cast<int>(s.grainPhase[head] * (kGrainFrames - 1))));
+            voices += (s0 + (s1 - s0) * frac) * s.window[static_cast<size_t>(wi)];
+        }
+        // Two heads per interval; the pair sums are averaged as before.
+        const float add = voices * 0.5f * mix;
+        left[i] += add;
+        right[i] += add;
+
+        for (int head = 0; head < 4; ++head) {
+            s.readPos[head] = wrap(s.readPos[head] + ratios[head]);
+            s.grainPhase[head] += phaseInc;
+            if (s.grainPhase[head] >= 1.0f) {
+                s.grainPhase[head] -= 1.0f;
+                s.readPos[head] =
+                    wrap(static_cast<float>(static_cast<int>(writePos) - restart[head]));
+            }
+        }
+        s.grain.write = (writePos + 1) & mask;
+    }
+}
+
+void freeze(const Params &p, State &s, float *left, float *right, int frames) {
+    const int length = static_cast<int>(s.loopL.size());
+    if (length <= 0) {
+        return;
+    }
+    const float mix = p.p2;
+    const bool refresh = (p.p3 >= 0.5f);
+    const float fillStep = 1.0f / static_cast<float>(length);
+    for (int i = 0; i < frames; ++i) {
+        const float inL = left[i];
+        const float inR = right[i];
+        // Records until the loop is full once, or all the time in refresh mode.
+        if (s.env < 1.0f || refresh) {
+            s.loopL[static_cast<size_t>(s.loopWrite)] = inL;
+            s.loopR[static_cast<size_t>(s.loopWrite)] = inR;
+            s.loopWrite = s.loopWrite + 1 == length ? 0 : s.loopWrite + 1;
+            s.env = std::min(1.0f, s.env + fillStep);
+            if (refresh) {
+                s.loopRead = s.loopWrite;
+            }
+        }
+        const float frL = s.loopL[static_cast<size_t>(s.loopRead)];
+        const float frR = s.loopR[static_cast<size_t>(s.loopRead)];
+        s.loopRead = s.loopRead + 1 == length ? 0 : s.loopRead + 1;
+        left[i] = inL * (1.0f - mix) + frL * mix;
+        right[i] = inR * (1.0f - mix) + frR * mix;
+    }
+}
+
+int framesFor(float seconds, int sampleRate) {
+    return std::max(1, static_cast<int>(seconds * static_cast<float>(sampleRate)));
+}
+
+}  // namespace
+
+void Ring::reset(int minFrames) {
+    uint32_t capacity = 2;
+    while (capacity < static_cast<uint32_t>(std::max(1, minFrames))) {
+        capacity <<= 1;
+    }
+    data.assign(capacity, 0.0f);
+    mask = capacity - 1;
+    write = 0;
+}
+
+void prepare(int type, const Params &params, int sampleRate, State &state) {
+    state = State();
+    switch (type) {
+        case Reverb:
+            prepareFdn(params, sampleRate, state.fdn);
+            break;
+        case Chorus:
+            state.ringL.reset(framesFor(0.03f, sampleRate));
+            state.ringR.reset(framesFor(0.03f, sampleRate));
+            break;
+        case Delay: {
+            const int delay = framesFor(0.03f + params.p1 * 0.9f, sampleRate);
+            // The ping-pong right tap sits an eighth of the time back, as it always has.
+            const int offset =
+                params.p4 >= 0.5f ? std::min(std::max(1, delay / 8), std::max(1, delay - 1)) : 0;
+            state.delayA = delay;
+            state.delayB = offset > 0 ? offset : delay;
+            state.ringL.reset(delay + 1);
+            state.ringR.reset(delay + 1);
+            break;
+        }
+        case Robot:
+            state.delayA = framesFor(0.002f + params.p1 * 0.02f, sampleRate);
+            state.ringL.reset(state.delayA + 1);
+            state.ringR.reset(state.delayA + 1);
+            break;
+        case SubHarmonic:
+            state.env = 1.0f;
+            break;
+        case Harmonizer:
+            state.grain.reset(kGrainFrames * 2);
+            state.window.resize(kGrainFrames);
+            for (int i = 0; i < kGrainFrames; ++i) {
+                const float t = static_cast<float>(i) / static_cast<float>(kGrainFrames - 1);
+                state.window[static_cast<size_t>(i)] = 0.5f * (1.0f - std::cos(kTwoPi * t));
+            }
+            break;
+        case Freeze: {
+            const int length = framesFor(0.15f + params.p1 * 0.85f, sampleRate);
+            state.loopL.assign(static_cast<size_t>(length), 0.0f);
+            state.loopR.assign(static_cast<size_t>(length), 0.0f);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void process(int type, const Params &params, const Context &context, State &state, float *left,
+             float *right, int frames) {
+    if (frames <= 0) {
+        return;
+    }
+    switch (type) {
+        case Reverb:
+            reverb(params, state, left, right, frames);
+            break;
+        case Comp:
+            comp(params, state, left, right, frames);
+            break;
+        case Dist:
+            dist(params, left, right, frames);
+            break;
+        case Lofi:
+            lofi(params, state, left, right, frames);
+            break;
+        case Cassette:
+            cassette(params, state, left, right, frames);
+            break;
+        case Chorus:
+            chorus(params, context, state, left, right, frames);
+            break;
+        case Eq:
+            eq(params, context, state, left, right, frames);
+            break;
+        case Sidechain:
+            sidechain(params, context, left, right, frames);
+            break;
+        case Delay:
+            delay(params, state, left, right, frames);
+            break;
+        case Tremolo:
+            tremolo(params, context, state, left, right, frames);
+            break;
+        case RingMod:
+            ringMod(params, context, state, left, right, frames);
+            break;
+        case Robot:
+            robot(params, state, left, right, frames);
+            break;
+        case Punch:
+            punch(params, state, left, right, frames);
+            break;
+        case SubHarmonic:
+            subHarmonic(params, context, state, left, right, frames);
+            break;
+        case Harmonizer:
+            harmonizer(params, state, left, right, frames);
+            break;
+        case Freeze:
+            freeze(params, state, left, right, frames);
+            break;
+        case Convolution:
+            if (state.convolver) {
+                state.convolver->process(left, right, frames, params.p1);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void deinterleave(const float *in, float *left, float *right, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    for (; i + 4 <= frames; i += 4) {
+        Vec l;
+        Vec r;
+        loadStereo(in + i * 2, l, r);
+        store(left + i, l);
+        store(right + i, r);
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] = in[i * 2];
+        right[i] = in[i * 2 + 1];
+    }
+}
+
+void interleave(const float *left, const float *right, float *out, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    for (; i + 4 <= frames; i += 4) {
+        storeStereo(out + i * 2, load(left + i), load(right + i));
+    }
+#endif
+    for (; i < frames; ++i) {
+        out[i * 2] = left[i];
+        out[i * 2 + 1] = right[i];
+    }
+}
+
+const char *typeName(int type) {
+    static const char *const kNames[TypeCount] = {
+        "none",   "reverb",  "comp",      "dist",  "lofi",  "cassette",
+        "chorus", "eq",      "sidechain", "delay", "tremolo", "ring",
+        "robot",  "punch",   "sub",       "harmonizer", "freeze", "conv"};
+    return type >= 0 && type < TypeCount ? kNames[type] : "unknown";
+}
+
+}  // namespace EffectKernels
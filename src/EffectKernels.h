@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Convolver.h"
+
+// Block kernels for the bus effects. Every kernel works on one planar stereo block in place;
+// the engine deinterleaves a bus once, runs its whole chain and interleaves it back. Delay
+// lines are power-of-two rings indexed by mask, and wherever a kernel has no sample-to-sample
+// feedback shorter than the block (delays, gain stages) the inner loop runs four frames at a
+// time. The reverb runs its delay lines as the lanes instead. prepare() is the only call that
+// allocates.
+namespace EffectKernels {
+
+enum Type {
+    None = 0,
+    Reverb = 1,
+    Comp = 2,
+    Dist = 3,
+    Lofi = 4,
+    Cassette = 5,
+    Chorus = 6,
+    Eq = 7,
+    Sidechain = 8,
+    Delay = 9,
+    Tremolo = 10,
+    RingMod = 11,
+    Robot = 12,
+    Punch = 13,
+    SubHarmonic = 14,
+    Harmonizer = 15,
+    Freeze = 16,
+    Convolution = 17,
+    TypeCount = 18
+};
+
+// One channel of delay memory. Capacity is a power of two, so positions wrap with a mask.
+struct Ring {
+    std::vector<float> data;
+    uint32_t mask = 0;
+    uint32_t write = 0;
+
+    // Zeroed, at least minFrames long.
+    void reset(int minFrames);
+    bool empty() const { return data.empty(); }
+};
+
+struct Params {
+    // Each 0..1.
+    float p1 = 0.0f;
+    float p2 = 0.0f;
+    float p3 = 0.0f;
+    float p4 = 0.0f;
+    float p5 = 0.0f;
+};
+
+struct Context {
+    int sampleRate = 48000;
+    float bpm = 120.0f;
+    // RMS of all buses before effects, for the sidechain ducker.
+    float sidechainEnv = 0.0f;
+};
+
+// Reverb: a feedback delay network of eight modulated, damped lines mixed through a
+// Householder matrix. The lines share one ring, frame-major, so a frame of all eight is two
+// vector stores.
+struct Fdn {
+    static constexpr int kLines = 8;
+    std::vector<float> lines;
+    // In frames.
+    uint32_t mask = 0;
+    uint32_t write = 0;
+    float delay[kLines] = {};
+    // Per-line loop gain for the decay time.
+    float gain[kLines] = {};
+    float low[kLines] = {};
+    float lfoSin[kLines] = {};
+    float lfoCos[kLines] = {};
+    // LFO rotation per modulation step.
+    float lfoStepSin[kLines] = {};
+    float lfoStepCos[kLines] = {};
+    // One-pole coefficient of the damping in the loop.
+    float damp = 1.0f;
+    float modDepth = 0.0f;
+};
+
+struct State {
+    // Delay lines for chorus, delay and robot.
+    Ring ringL;
+    Ring ringR;
+    // Lengths fixed by prepare(), in frames.
+    int delayA = 0;
+    int delayB = 0;
+    Fdn fdn;
+    // LFO phase in radians.
+    float phase = 0.0f;
+    float env = 0.0f;
+    float z1L = 0.0f;
+    float z1R = 0.0f;
+    float z2L = 0.0f;
+    float z2R = 0.0f;
+    int hold = 0;
+    uint32_t noise = 0x2545f491u;
+    // Harmonizer: mono history, grain window, four read heads and their window phases.
+    Ring grain;
+    std::vector<float> window;
+    float readPos[4] = {};
+    float grainPhase[4] = {0.0f, 0.5f, 0.0f, 0.5f};
+    // Freeze: an exact-length loop per channel rather than a ring, so the loop length holds.
+    std::vector<float> loopL;
+    std::vector<float> loopR;
+    int loopRead = 0;
+    int loopWrite = 0;
+    // Convolution: built by the owner after prepare(), since it needs an impulse response.
+    std::unique_ptr<Convolver> convolver;
+};
+
+// Sizes the state for type at sampleRate; params that set a buffer length are read here.
+void prepare(int type, const Params &params, int sampleRate, State &state);
+// Runs one effect over frames of left/right in place.
+void process(int type, const Params &params, const Context &context, State &state, float *left,
+             float *right, int frames);
+
+// Splits interleaved stereo into planar blocks and back.
+void deinterleave(const float *in, float *left, float *right, int frames);
+void interleave(const float *left, const float *right, float *out, int frames);
+
+// Short lowercase name of a type, for benchmarks and logs.
+const char *typeName(int type);
+
+}  // namespace EffectKernels
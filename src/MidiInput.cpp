@@ -0,0 +1,154 @@
+#include "MidiInput.h"
+
+#include <vector>
+
+#ifdef GROOVEBOX_WITH_ALSA
+#include <alsa/asoundlib.h>
+#include <poll.h>
+#endif
+
+#include "RtScheduling.h"
+
+namespace {
+// Long enough to idle cheaply, short enough that stop() returns promptly.
+constexpr int kPollTimeoutMs = 100;
+}  // namespace
+
+MidiInput::~MidiInput() {
+    stop();
+}
+
+bool MidiInput::start(Callback callback, int priority) {
+    stop();
+#ifdef GROOVEBOX_WITH_ALSA
+    snd_seq_t *seq = nullptr;
+    if (snd_seq_open(&seq, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+        return false;
+    }
+    snd_seq_set_client_name(seq, "GrooveBox");
+    const int port = snd_seq_create_simple_port(
+        seq, "MIDI In", SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+        SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (port < 0) {
+        snd_seq_close(seq);
+        return false;
+    }
+    m_seq = seq;
+    m_port = port;
+    m_callback = std::move(callback);
+    // Port announcements, so controllers plugged in later get connected too.
+    snd_seq_connect_from(seq, port, SND_SEQ_CLIENT_SYSTEM, SND_SEQ_PORT_SYSTEM_ANNOUNCE);
+    connectAll();
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread([this, priority]() {
+        RtScheduling::enterRealtime(priority, -1);
+        run();
+    });
+    return true;
+#else
+    (void)callback;
+    (void)priority;
+    return false;
+#endif
+}
+
+void MidiInput::stop() {
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+#ifdef GROOVEBOX_WITH_ALSA
+    if (m_seq) {
+        snd_seq_close(static_cast<snd_seq_t *>(m_seq));
+    }
+#endif
+    m_seq = nullptr;
+    m_port = -1;
+    m_callback = nullptr;
+}
+
+void MidiInput::run() {
+#ifdef GROOVEBOX_WITH_ALSA
+    snd_seq_t *seq = static_cast<snd_seq_t *>(m_seq);
+    std::vector<pollfd> fds(static_cast<size_t>(snd_seq_poll_descriptors_count(seq, POLLIN)));
+    snd_seq_poll_descriptors(seq, fds.data(), static_cast<unsigned int>(fds.size()), POLLIN);
+    while (m_running.load(std::memory_order_acquire)) {
+        if (poll(fds.data(), fds.size(), kPollTimeoutMs) <= 0) {
+            continue;
+        }
+        snd_seq_event_t *ev = nullptr;
+        while (snd_seq_event_input(seq, &ev) >= 0 && ev) {
+            Event event;
+            switch (ev->type) {
+            case SND_SEQ_EVENT_NOTEON:
+            case SND_SEQ_EVENT_NOTEOFF:
+                event.type = ev->type == SND_SEQ_EVENT_NOTEON && ev->data.note.velocity > 0
+                                 ? Event::Type::NoteOn
+                                 : Event::Type::NoteOff;
+                event.channel = ev->data.note.channel & 0x0f;
+                event.number = ev->data.note.note & 0x7f;
+                event.value = ev->data.note.velocity & 0x7f;
+                m_callback(event);
+                break;
+            case SND_SEQ_EVENT_CONTROLLER:
+                event.type = Event::Type::Control;
+                event.channel = ev->data.control.channel & 0x0f;
+                event.number = static_cast<int>(ev->data.control.param & 0x7f);
+                event.value = ev->data.control.value & 0x7f;
+                m_callback(event);
+                break;
+            case SND_SEQ_EVENT_PORT_START:
+                connectPort(ev->data.addr.client, ev->data.addr.port);
+                break;
+            default:
+                break;
+            }
+            ev = nullptr;
+        }
+    }
+#endif
+}
+
+void MidiInput::connectPort(int client, int port) {
+#ifdef GROOVEBOX_WITH_ALSA
+    snd_seq_t *seq = static_cast<snd_seq_t *>(m_seq);
+    if (client == SND_SEQ_CLIENT_SYSTEM || client == snd_seq_client_id(seq)) {
+        return;
+    }
+    snd_seq_port_info_t *info = nullptr;
+    snd_seq_port_info_alloca(&info);
+    if (snd_seq_get_any_port_info(seq, client, port, info) < 0) {
+        return;
+    }
+    // Hardware only: software ports such as Midi Through would echo whatever they are fed.
+    const unsigned int caps = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+    if ((snd_seq_port_info_get_capability(info) & caps) != caps ||
+        !(snd_seq_port_info_get_type(info) & SND_SEQ_PORT_TYPE_HARDWARE)) {
+        return;
+    }
+    snd_seq_connect_from(seq, m_port, client, port);
+#else
+    (void)client;
+    (void)port;
+#endif
+}
+
+void MidiInput::connectAll() {
+#ifdef GROOVEBOX_WITH_ALSA
+    snd_seq_t *seq = static_cast<snd_seq_t *>(m_seq);
+    snd_seq_client_info_t *client = nullptr;
+    snd_seq_port_info_t *port = nullptr;
+    snd_seq_client_info_alloca(&client);
+    snd_seq_port_info_alloca(&port);
+    snd_seq_client_info_set_client(client, -1);
+    while (snd_seq_query_next_client(seq, client) >= 0) {
+        const int id = snd_seq_client_info_get_client(client);
+        snd_seq_port_info_set_client(port, id);
+        snd_seq_port_info_set_port(port, -1);
+        while (snd_seq_query_next_port(seq, port) >= 0) {
+            connectPort(id, snd_seq_port_info_get_port(port));
+        }
+    }
+#endif
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// MIDI input from every hardware port on the ALSA sequencer, USB controllers included, and any
+// plugged in later. Events are decoded on a thread of their own, SCHED_FIFO when the process
+// may use it, and handed to the callback right there: no Qt event loop between a key and the
+// engine, so the callback has to be quick and thread-safe. Without ALSA start() fails.
+class MidiInput {
+public:
+    struct Event {
+        enum class Type {
+            NoteOn,
+            NoteOff,
+            Control
+        };
+        Type type = Type::NoteOn;
+        // 0-15.
+        int channel = 0;
+        // Note number or controller number.
+        int number = 0;
+        // Velocity or controller value, 0-127. A note-on with velocity 0 arrives as NoteOff.
+        int value = 0;
+    };
+    using Callback = std::function<void(const Event &event)>;
+
+    MidiInput() = default;
+    ~MidiInput();
+    MidiInput(const MidiInput &) = delete;
+    MidiInput &operator=(const MidiInput &) = delete;
+
+    // Opens the sequencer client, connects the hardware ports and starts the thread. The
+    // callback must stay valid until stop().
+    bool start(Callback callback, int priority);
+    void stop();
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    void connectPort(int client, int port);
+    void connectAll();
+
+    void *m_seq = nullptr;
+    int m_port = -1;
+    Callback m_callback;
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+};
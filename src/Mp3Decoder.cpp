@@ -0,0 +1,1128 @@
+#include "Mp3Decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Mp3Decoder {
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kLines = 576;
+constexpr int kSubbands = 32;
+constexpr int kSubbandLines = 18;
+// Only the last main_data_begin (at most 511) bytes are ever looked back on.
+constexpr size_t kReservoirKeep = 1024;
+// Output delay of the hybrid and polyphase filterbanks, which LAME tags do not include.
+constexpr int kDecoderDelay = 529;
+constexpr int kMaxQuantized = 8206;
+
+constexpr int kSampleRates[9] = {44100, 48000, 32000, 22050, 24000, 16000, 11025, 12000, 8000};
+constexpr int kBitrates[2][15] = {
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+    {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}};
+
+// Scalefactor band widths per sample rate, in kSampleRates order.
+constexpr uint8_t kLongBands[9][22] = {
+    {4, 4, 4, 4, 4, 4, 6, 6, 8, 8, 10, 12, 16, 20, 24, 28, 34, 42, 50, 54, 76, 158},
+    {4, 4, 4, 4, 4, 4, 6, 6, 6, 8, 10, 12, 16, 18, 22, 28, 34, 40, 46, 54, 54, 192},
+    {4, 4, 4, 4, 4, 4, 6, 6, 8, 10, 12, 16, 20, 24, 30, 38, 46, 56, 68, 84, 102, 26},
+    {6, 6, 6, 6, 6, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+    {6, 6, 6, 6, 6, 6, 8, 10, 12, 14, 16, 18, 22, 26, 32, 38, 46, 54, 62, 70, 76, 36},
+    {6, 6, 6, 6, 6, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+    {6, 6, 6, 6, 6, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+    {6, 6, 6, 6, 6, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 38, 46, 52, 60, 68, 58, 54},
+    {12, 12, 12, 12, 12, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 76, 90, 2, 2, 2, 2, 2}};
+constexpr uint8_t kShortBands[9][13] = {
+    {4, 4, 4, 4, 6, 8, 10, 12, 14, 18, 22, 30, 56},
+    {4, 4, 4, 4, 6, 6, 10, 12, 14, 16, 20, 26, 66},
+    {4, 4, 4, 4, 6, 8, 12, 16, 20, 26, 34, 42, 12},
+    {4, 4, 4, 6, 6, 8, 10, 14, 18, 26, 32, 42, 18},
+    {4, 4, 4, 6, 8, 10, 12, 14, 18, 24, 32, 44, 12},
+    {4, 4, 4, 6, 8, 10, 12, 14, 18, 24, 30, 40, 18},
+    {4, 4, 4, 6, 8, 10, 12, 14, 18, 24, 30, 40, 18},
+    {4, 4, 4, 6, 8, 10, 12, 14, 18, 24, 30, 40, 18},
+    {8, 8, 8, 12, 16, 20, 24, 28, 36, 2, 2, 2, 26}};
+
+constexpr uint8_t kPretab[22] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 3, 2, 0};
+constexpr uint8_t kSlen[2][16] = {{0, 0, 0, 0, 3, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4},
+                                  {0, 1, 2, 3, 0, 1, 2, 3, 1, 2, 3, 1, 2, 3, 2, 3}};
+// MPEG-2 scalefactor partitions: bands per slen, by scalefac_compress range and block kind
+// (long, short, mixed).
+constexpr uint8_t kLsfPartitions[6][3][4] = {
+    {{6, 5, 5, 5}, {9, 9, 9, 9}, {6, 9, 9, 9}},
+    {{6, 5, 7, 3}, {9, 9, 12, 6}, {6, 9, 12, 6}},
+    {{11, 10, 0, 0}, {18, 18, 0, 0}, {15, 18, 0, 0}},
+    {{7, 7, 7, 0}, {12, 12, 12, 0}, {6, 15, 12, 0}},
+    {{6, 6, 6, 3}, {12, 9, 9, 6}, {6, 12, 9, 6}},
+    {{8, 8, 5, 0}, {15, 12, 9, 0}, {6, 18, 9, 0}}};
+
+// Big-value Huffman tables 1-3, 5-13, 15, 16 and 24, one after another: code lengths and
+// (x << 4 | y) symbols, with codes counting up in this order.
+constexpr int kHuffSizes[15] = {4, 9, 9, 16, 16, 36, 36, 36, 64, 64, 64, 256, 256, 256, 256};
+constexpr uint8_t kHuffLengths[1378] = {
+    3, 3, 2, 1, 6, 6, 5, 5, 5, 3, 3, 3, 1, 6, 6, 5, 5, 5, 3, 2, 2, 2, 8, 8, 7, 6, 7, 7, 7, 7, 6, 6,
+    6, 6, 3, 3, 3, 1, 7, 7, 6, 6, 6, 5, 5, 5, 5, 4, 4, 4, 3, 2, 3, 3, 10, 10, 10, 10, 9, 9, 9, 9,
+    8, 8, 9, 9, 8, 9, 9, 8, 8, 7, 7, 7, 8, 8, 8, 8, 7, 7, 7, 7, 6, 5, 6, 6, 4, 3, 3, 1, 11, 11, 10,
+    9, 10, 10, 9, 9, 9, 8, 8, 9, 9, 9, 9, 8, 8, 8, 7, 8, 8, 8, 8, 8, 8, 8, 8, 6, 6, 6, 4, 4, 2, 3,
+    3, 2, 9, 9, 8, 8, 9, 9, 8, 8, 8, 8, 7, 7, 7, 8, 8, 7, 7, 7, 7, 6, 6, 6, 6, 5, 5, 6, 6, 5, 5, 4,
+    4, 4, 3, 3, 3, 3, 11, 11, 11, 11, 11, 11, 10, 10, 10, 10, 10, 10, 10, 11, 11, 10, 9, 9, 10, 10,
+    9, 9, 10, 10, 9, 10, 10, 8, 8, 9, 9, 10, 10, 9, 9, 10, 10, 8, 8, 8, 9, 9, 9, 9, 9, 9, 8, 8, 8,
+    8, 8, 8, 7, 7, 7, 7, 6, 6, 6, 6, 4, 3, 3, 1, 10, 10, 10, 10, 10, 10, 10, 11, 11, 10, 10, 9, 9,
+    9, 10, 10, 10, 10, 8, 8, 9, 9, 7, 8, 8, 8, 8, 8, 9, 9, 9, 9, 8, 7, 8, 8, 7, 7, 8, 8, 8, 9, 9,
+    8, 8, 8, 8, 8, 8, 7, 7, 6, 6, 7, 7, 6, 5, 4, 5, 5, 3, 3, 3, 2, 10, 10, 9, 9, 9, 9, 9, 9, 9, 8,
+    8, 9, 9, 8, 8, 8, 8, 8, 8, 9, 9, 8, 8, 8, 8, 8, 9, 9, 7, 7, 7, 8, 8, 8, 8, 8, 8, 7, 7, 7, 7, 8,
+    8, 7, 7, 7, 6, 6, 6, 6, 7, 7, 6, 5, 5, 5, 4, 4, 5, 5, 4, 3, 3, 3, 19, 19, 18, 17, 16, 16, 16,
+    16, 16, 16, 16, 16, 16, 16, 17, 17, 15, 15, 16, 16, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16,
+    16, 15, 16, 16, 14, 14, 15, 15, 15, 15, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 14,
+    13, 14, 14, 13, 13, 14, 14, 13, 14, 14, 13, 14, 14, 13, 14, 14, 13, 13, 14, 14, 12, 12, 12, 13,
+    13, 13, 13, 13, 13, 12, 13, 13, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 12,
+    13, 13, 12, 12, 12, 12, 13, 13, 13, 13, 12, 13, 13, 12, 11, 12, 12, 12, 12, 12, 12, 12, 12, 11,
+    11, 11, 11, 12, 12, 11, 11, 12, 12, 11, 12, 12, 12, 12, 11, 11, 12, 12, 11, 12, 12, 11, 12, 12,
+    11, 12, 12, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 10, 10, 10, 10, 11, 11, 10, 11, 11, 10,
+    11, 11, 11, 11, 10, 10, 11, 11, 10, 10, 11, 11, 11, 11, 11, 11, 9, 9, 10, 10, 10, 10, 10, 11,
+    11, 9, 9, 9, 10, 10, 9, 9, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 8, 9, 9, 9, 9, 9, 9, 10, 10,
+    9, 9, 9, 8, 8, 9, 9, 9, 9, 9, 9, 8, 7, 8, 8, 8, 8, 7, 7, 7, 7, 7, 6, 6, 6, 6, 4, 4, 3, 1, 13,
+    13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 12, 13, 13, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 11, 11, 12, 12, 12, 12, 11, 11, 11, 11,
+    11, 11, 12, 12, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 11, 11, 11, 11, 11, 11, 10,
+    11, 11, 11, 11, 11, 11, 10, 10, 11, 11, 10, 10, 10, 10, 11, 11, 10, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 11, 11, 9, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 9, 10, 10,
+    10, 10, 9, 10, 10, 9, 10, 10, 10, 10, 10, 10, 10, 10, 9, 9, 9, 9, 9, 9, 9, 10, 10, 9, 9, 9, 9,
+    9, 9, 10, 10, 9, 9, 9, 9, 9, 9, 8, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9,
+    9, 9, 8, 8, 8, 8, 8, 8, 9, 9, 8, 8, 8, 8, 8, 8, 8, 9, 9, 8, 7, 8, 8, 7, 7, 7, 7, 8, 8, 7, 7, 7,
+    7, 7, 6, 7, 7, 6, 6, 7, 7, 6, 6, 6, 5, 5, 5, 5, 5, 3, 4, 4, 3, 11, 11, 11, 11, 11, 11, 11, 11,
+    10, 11, 11, 11, 11, 10, 10, 10, 10, 10, 8, 10, 10, 9, 9, 9, 9, 10, 16, 17, 17, 15, 15, 16, 16,
+    14, 15, 15, 14, 14, 15, 15, 14, 14, 15, 15, 15, 15, 14, 15, 15, 14, 13, 8, 9, 9, 8, 8, 13, 14,
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 13, 13, 14, 14, 14, 14, 13, 14, 14, 13, 13, 13, 14, 14, 14,
+    14, 13, 13, 14, 14, 13, 14, 14, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12,
+    13, 13, 13, 13, 13, 13, 12, 13, 13, 12, 12, 13, 13, 11, 12, 12, 12, 12, 12, 12, 12, 13, 13, 11,
+    12, 12, 12, 12, 11, 12, 12, 12, 12, 12, 12, 12, 12, 11, 12, 12, 11, 11, 11, 11, 12, 12, 12, 12,
+    12, 12, 12, 12, 11, 12, 12, 11, 12, 12, 11, 12, 12, 11, 12, 12, 11, 10, 10, 11, 11, 11, 11, 11,
+    11, 10, 10, 11, 11, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 10, 11, 11, 10, 10, 10, 11, 11, 10,
+    10, 11, 11, 10, 10, 11, 11, 10, 9, 9, 10, 10, 10, 10, 10, 10, 9, 9, 9, 10, 10, 9, 10, 10, 9, 9,
+    8, 9, 9, 9, 9, 9, 9, 9, 9, 8, 8, 9, 9, 8, 8, 7, 7, 8, 8, 7, 6, 6, 6, 6, 4, 4, 3, 1, 8, 8, 8, 8,
+    8, 8, 8, 8, 7, 8, 8, 7, 7, 8, 8, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 8, 9, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    4, 11, 11, 11, 11, 12, 12, 11, 10, 11, 11, 10, 10, 10, 10, 11, 11, 10, 10, 10, 10, 11, 11, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 11, 11, 10, 11, 11, 10, 9, 10, 10, 10, 10, 11, 11, 10, 9, 9, 10, 10, 9, 10,
+    10, 10, 10, 9, 9, 10, 10, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 10, 10, 9, 9, 9, 10, 10, 8, 9, 9, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 9, 9, 8, 8, 8, 8, 8, 8, 9, 9, 7, 8, 8, 7, 7, 7, 7, 7, 8, 8, 7, 7, 6, 6, 7, 7,
+    6, 5, 5, 6, 6, 4, 4, 4, 4
+};
+
+constexpr uint8_t kHuffSymbols[1378] = {
+    0x11, 0x01, 0x10, 0x00, 0x22, 0x02, 0x12, 0x21, 0x20, 0x11, 0x01, 0x10, 0x00, 0x22, 0x02, 0x12,
+    0x21, 0x20, 0x10, 0x11, 0x01, 0x00, 0x33, 0x23, 0x32, 0x31, 0x13, 0x03, 0x30, 0x22, 0x12, 0x21,
+    0x02, 0x20, 0x11, 0x01, 0x10, 0x00, 0x33, 0x03, 0x23, 0x32, 0x30, 0x13, 0x31, 0x22, 0x02, 0x12,
+    0x21, 0x20, 0x01, 0x11, 0x10, 0x00, 0x55, 0x45, 0x54, 0x53, 0x35, 0x44, 0x25, 0x52, 0x15, 0x51,
+    0x05, 0x34, 0x50, 0x43, 0x33, 0x24, 0x42, 0x14, 0x41, 0x40, 0x04, 0x23, 0x32, 0x03, 0x13, 0x31,
+    0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01, 0x10, 0x00, 0x55, 0x54, 0x45, 0x53, 0x35, 0x44,
+    0x25, 0x52, 0x05, 0x15, 0x51, 0x34, 0x43, 0x50, 0x33, 0x24, 0x42, 0x14, 0x41, 0x04, 0x40, 0x23,
+    0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x02, 0x20, 0x12, 0x21, 0x11, 0x01, 0x10, 0x00, 0x55, 0x45,
+    0x35, 0x53, 0x54, 0x05, 0x44, 0x25, 0x52, 0x15, 0x51, 0x34, 0x43, 0x50, 0x04, 0x24, 0x42, 0x33,
+    0x40, 0x14, 0x41, 0x23, 0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x02, 0x12, 0x21, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0x77, 0x67, 0x76, 0x57, 0x75, 0x66, 0x47, 0x74, 0x56, 0x65, 0x37, 0x73, 0x46, 0x55,
+    0x54, 0x63, 0x27, 0x72, 0x64, 0x07, 0x70, 0x62, 0x45, 0x35, 0x06, 0x53, 0x44, 0x17, 0x71, 0x36,
+    0x26, 0x25, 0x52, 0x15, 0x51, 0x34, 0x43, 0x16, 0x61, 0x60, 0x05, 0x50, 0x24, 0x42, 0x33, 0x04,
+    0x14, 0x41, 0x40, 0x23, 0x32, 0x03, 0x13, 0x31, 0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0x77, 0x67, 0x76, 0x75, 0x66, 0x47, 0x74, 0x57, 0x55, 0x56, 0x65, 0x37, 0x73, 0x46,
+    0x45, 0x54, 0x35, 0x53, 0x27, 0x72, 0x64, 0x07, 0x71, 0x17, 0x70, 0x36, 0x63, 0x60, 0x44, 0x25,
+    0x52, 0x05, 0x15, 0x62, 0x26, 0x06, 0x16, 0x61, 0x51, 0x34, 0x50, 0x43, 0x33, 0x24, 0x42, 0x14,
+    0x41, 0x04, 0x40, 0x23, 0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x21, 0x12, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0x77, 0x67, 0x76, 0x57, 0x75, 0x66, 0x47, 0x74, 0x65, 0x56, 0x37, 0x73, 0x55, 0x27,
+    0x72, 0x46, 0x64, 0x17, 0x71, 0x07, 0x70, 0x36, 0x63, 0x45, 0x54, 0x44, 0x06, 0x05, 0x26, 0x62,
+    0x61, 0x16, 0x60, 0x35, 0x53, 0x25, 0x52, 0x15, 0x51, 0x34, 0x43, 0x50, 0x04, 0x24, 0x42, 0x14,
+    0x33, 0x41, 0x23, 0x32, 0x40, 0x03, 0x30, 0x13, 0x31, 0x22, 0x12, 0x21, 0x02, 0x20, 0x00, 0x11,
+    0x01, 0x10, 0xfe, 0xfc, 0xfd, 0xed, 0xff, 0xef, 0xdf, 0xee, 0xcf, 0xde, 0xbf, 0xfb, 0xce, 0xdc,
+    0xaf, 0xe9, 0xec, 0xdd, 0xfa, 0xcd, 0xbe, 0xeb, 0x9f, 0xf9, 0xea, 0xbd, 0xdb, 0x8f, 0xf8, 0xcc,
+    0xae, 0x9e, 0x8e, 0x7f, 0x7e, 0xf7, 0xda, 0xad, 0xbc, 0xcb, 0xf6, 0x6f, 0xe8, 0x5f, 0x9d, 0xd9,
+    0xf5, 0xe7, 0xac, 0xbb, 0x4f, 0xf4, 0xca, 0xe6, 0xf3, 0x3f, 0x8d, 0xd8, 0x2f, 0xf2, 0x6e, 0x9c,
+    0x0f, 0xc9, 0x5e, 0xab, 0x7d, 0xd7, 0x4e, 0xc8, 0xd6, 0x3e, 0xb9, 0x9b, 0xaa, 0x1f, 0xf1, 0xf0,
+    0xba, 0xe5, 0xe4, 0x8c, 0x6d, 0xe3, 0xe2, 0x2e, 0x0e, 0x1e, 0xe1, 0xe0, 0x5d, 0xd5, 0x7c, 0xc7,
+    0x4d, 0x8b, 0xb8, 0xd4, 0x9a, 0xa9, 0x6c, 0xc6, 0x3d, 0xd3, 0x7b, 0x2d, 0xd2, 0x1d, 0xb7, 0x5c,
+    0xc5, 0x99, 0x7a, 0xc3, 0xa7, 0x97, 0x4b, 0xd1, 0x0d, 0xd0, 0x8a, 0xa8, 0x4c, 0xc4, 0x6b, 0xb6,
+    0x3c, 0x2c, 0xc2, 0x5b, 0xb5, 0x89, 0x1c, 0xc1, 0x98, 0x0c, 0xc0, 0xb4, 0x6a, 0xa6, 0x79, 0x3b,
+    0xb3, 0x88, 0x5a, 0x2b, 0xa5, 0x69, 0xa4, 0x78, 0x87, 0x94, 0x77, 0x76, 0xb2, 0x1b, 0xb1, 0x0b,
+    0xb0, 0x96, 0x4a, 0x3a, 0xa3, 0x59, 0x95, 0x2a, 0xa2, 0x1a, 0xa1, 0x0a, 0x68, 0xa0, 0x86, 0x49,
+    0x93, 0x39, 0x58, 0x85, 0x67, 0x29, 0x92, 0x57, 0x75, 0x38, 0x83, 0x66, 0x47, 0x74, 0x56, 0x65,
+    0x73, 0x19, 0x91, 0x09, 0x90, 0x48, 0x84, 0x72, 0x46, 0x64, 0x28, 0x82, 0x18, 0x37, 0x27, 0x17,
+    0x71, 0x55, 0x07, 0x70, 0x36, 0x63, 0x45, 0x54, 0x26, 0x62, 0x35, 0x81, 0x08, 0x80, 0x16, 0x61,
+    0x06, 0x60, 0x53, 0x44, 0x25, 0x52, 0x05, 0x15, 0x51, 0x34, 0x43, 0x50, 0x24, 0x42, 0x33, 0x14,
+    0x41, 0x04, 0x40, 0x23, 0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0xff, 0xef, 0xfe, 0xdf, 0xee, 0xfd, 0xcf, 0xfc, 0xde, 0xed, 0xbf, 0xfb, 0xce, 0xec,
+    0xdd, 0xaf, 0xfa, 0xbe, 0xeb, 0xcd, 0xdc, 0x9f, 0xf9, 0xea, 0xbd, 0xdb, 0x8f, 0xf8, 0xcc, 0x9e,
+    0xe9, 0x7f, 0xf7, 0xad, 0xda, 0xbc, 0x6f, 0xae, 0x0f, 0xcb, 0xf6, 0x8e, 0xe8, 0x5f, 0x9d, 0xf5,
+    0x7e, 0xe7, 0xac, 0xca, 0xbb, 0xd9, 0x8d, 0x4f, 0xf4, 0x3f, 0xf3, 0xd8, 0xe6, 0x2f, 0xf2, 0x6e,
+    0xf0, 0x1f, 0xf1, 0x9c, 0xc9, 0x5e, 0xab, 0xba, 0xe5, 0x7d, 0xd7, 0x4e, 0xe4, 0x8c, 0xc8, 0x3e,
+    0x6d, 0xd6, 0xe3, 0x9b, 0xb9, 0x2e, 0xaa, 0xe2, 0x1e, 0xe1, 0x0e, 0xe0, 0x5d, 0xd5, 0x7c, 0xc7,
+    0x4d, 0x8b, 0xd4, 0xb8, 0x9a, 0xa9, 0x6c, 0xc6, 0x3d, 0xd3, 0xd2, 0x2d, 0x0d, 0x1d, 0x7b, 0xb7,
+    0xd1, 0x5c, 0xd0, 0xc5, 0x8a, 0xa8, 0x4c, 0xc4, 0x6b, 0xb6, 0x99, 0x0c, 0x3c, 0xc3, 0x7a, 0xa7,
+    0xa6, 0xc0, 0x0b, 0xc2, 0x2c, 0x5b, 0xb5, 0x1c, 0x89, 0x98, 0xc1, 0x4b, 0xb4, 0x6a, 0x3b, 0x79,
+    0xb3, 0x97, 0x88, 0x2b, 0x5a, 0xb2, 0xa5, 0x1b, 0xb1, 0xb0, 0x69, 0x96, 0x4a, 0xa4, 0x78, 0x87,
+    0x3a, 0xa3, 0x59, 0x95, 0x2a, 0xa2, 0x1a, 0xa1, 0x0a, 0xa0, 0x68, 0x86, 0x49, 0x94, 0x39, 0x93,
+    0x77, 0x09, 0x58, 0x85, 0x29, 0x67, 0x76, 0x92, 0x91, 0x19, 0x90, 0x48, 0x84, 0x57, 0x75, 0x38,
+    0x83, 0x66, 0x47, 0x28, 0x82, 0x18, 0x81, 0x74, 0x08, 0x80, 0x56, 0x65, 0x37, 0x73, 0x46, 0x27,
+    0x72, 0x64, 0x17, 0x55, 0x71, 0x07, 0x70, 0x36, 0x63, 0x45, 0x54, 0x26, 0x62, 0x16, 0x06, 0x60,
+    0x35, 0x61, 0x53, 0x44, 0x25, 0x52, 0x15, 0x51, 0x05, 0x50, 0x34, 0x43, 0x24, 0x42, 0x33, 0x41,
+    0x14, 0x04, 0x23, 0x32, 0x40, 0x03, 0x13, 0x31, 0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0xef, 0xfe, 0xdf, 0xfd, 0xcf, 0xfc, 0xbf, 0xfb, 0xaf, 0xfa, 0x9f, 0xf9, 0xf8, 0x8f,
+    0x7f, 0xf7, 0x6f, 0xf6, 0xff, 0x5f, 0xf5, 0x4f, 0xf4, 0xf3, 0xf0, 0x3f, 0xce, 0xec, 0xdd, 0xde,
+    0xe9, 0xea, 0xd9, 0xee, 0xed, 0xeb, 0xbe, 0xcd, 0xdc, 0xdb, 0xae, 0xcc, 0xad, 0xda, 0x7e, 0xac,
+    0xca, 0xc9, 0x7d, 0x5e, 0xbd, 0xf2, 0x2f, 0x0f, 0x1f, 0xf1, 0x9e, 0xbc, 0xcb, 0x8e, 0xe8, 0x9d,
+    0xe7, 0xbb, 0x8d, 0xd8, 0x6e, 0xe6, 0x9c, 0xab, 0xba, 0xe5, 0xd7, 0x4e, 0xe4, 0x8c, 0xc8, 0x3e,
+    0x6d, 0xd6, 0x9b, 0xb9, 0xaa, 0xe1, 0xd4, 0xb8, 0xa9, 0x7b, 0xb7, 0xd0, 0xe3, 0x0e, 0xe0, 0x5d,
+    0xd5, 0x7c, 0xc7, 0x4d, 0x8b, 0x9a, 0x6c, 0xc6, 0x3d, 0x5c, 0xc5, 0x0d, 0x8a, 0xa8, 0x99, 0x4c,
+    0xb6, 0x7a, 0x3c, 0x5b, 0x89, 0x1c, 0xc0, 0x98, 0x79, 0xe2, 0x2e, 0x1e, 0xd3, 0x2d, 0xd2, 0xd1,
+    0x3b, 0x97, 0x88, 0x1d, 0xc4, 0x6b, 0xc3, 0xa7, 0x2c, 0xc2, 0xb5, 0xc1, 0x0c, 0x4b, 0xb4, 0x6a,
+    0xa6, 0xb3, 0x5a, 0xa5, 0x2b, 0xb2, 0x1b, 0xb1, 0x0b, 0xb0, 0x69, 0x96, 0x4a, 0xa4, 0x78, 0x87,
+    0xa3, 0x3a, 0x59, 0x2a, 0x95, 0x68, 0xa1, 0x86, 0x77, 0x94, 0x49, 0x57, 0x67, 0xa2, 0x1a, 0x0a,
+    0xa0, 0x39, 0x93, 0x58, 0x85, 0x29, 0x92, 0x76, 0x09, 0x19, 0x91, 0x90, 0x48, 0x84, 0x75, 0x38,
+    0x83, 0x66, 0x28, 0x82, 0x47, 0x74, 0x18, 0x81, 0x80, 0x08, 0x56, 0x37, 0x73, 0x65, 0x46, 0x27,
+    0x72, 0x64, 0x55, 0x07, 0x17, 0x71, 0x70, 0x36, 0x63, 0x45, 0x54, 0x26, 0x62, 0x16, 0x61, 0x06,
+    0x60, 0x53, 0x35, 0x44, 0x25, 0x52, 0x51, 0x15, 0x05, 0x34, 0x43, 0x50, 0x24, 0x42, 0x33, 0x14,
+    0x41, 0x04, 0x40, 0x23, 0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00, 0xef, 0xfe, 0xdf, 0xfd, 0xcf, 0xfc, 0xbf, 0xfb, 0xfa, 0xaf, 0x9f, 0xf9, 0xf8, 0x8f,
+    0x7f, 0xf7, 0x6f, 0xf6, 0x5f, 0xf5, 0x4f, 0xf4, 0x3f, 0xf3, 0x2f, 0xf2, 0xf1, 0x1f, 0xf0, 0x0f,
+    0xee, 0xde, 0xed, 0xce, 0xec, 0xdd, 0xbe, 0xeb, 0xcd, 0xdc, 0xae, 0xea, 0xbd, 0xdb, 0xcc, 0x9e,
+    0xe9, 0xad, 0xda, 0xbc, 0xcb, 0x8e, 0xe8, 0x9d, 0xd9, 0x7e, 0xe7, 0xac, 0xff, 0xca, 0xbb, 0x8d,
+    0xd8, 0x0e, 0xe0, 0x0d, 0xe6, 0x6e, 0x9c, 0xc9, 0x5e, 0xba, 0xe5, 0xab, 0x7d, 0xd7, 0xe4, 0x8c,
+    0xc8, 0x4e, 0x2e, 0x3e, 0x6d, 0xd6, 0xe3, 0x9b, 0xb9, 0xaa, 0xe2, 0x1e, 0xe1, 0x5d, 0xd5, 0x7c,
+    0xc7, 0x4d, 0x8b, 0xb8, 0xd4, 0x9a, 0xa9, 0x6c, 0xc6, 0x3d, 0xd3, 0x2d, 0xd2, 0x1d, 0x7b, 0xb7,
+    0xd1, 0x5c, 0xc5, 0x8a, 0xa8, 0x99, 0x4c, 0xc4, 0x6b, 0xb6, 0xd0, 0x0c, 0x3c, 0xc3, 0x7a, 0xa7,
+    0x2c, 0xc2, 0x5b, 0xb5, 0x1c, 0x89, 0x98, 0xc1, 0x4b, 0xc0, 0x0b, 0x3b, 0xb0, 0x0a, 0x1a, 0xb4,
+    0x6a, 0xa6, 0x79, 0x97, 0xa0, 0x09, 0x90, 0xb3, 0x88, 0x2b, 0x5a, 0xb2, 0xa5, 0x1b, 0xb1, 0x69,
+    0x96, 0xa4, 0x4a, 0x78, 0x87, 0x3a, 0xa3, 0x59, 0x95, 0x2a, 0xa2, 0xa1, 0x68, 0x86, 0x77, 0x49,
+    0x94, 0x39, 0x93, 0x58, 0x85, 0x29, 0x67, 0x76, 0x92, 0x19, 0x91, 0x48, 0x84, 0x57, 0x75, 0x38,
+    0x83, 0x66, 0x28, 0x82, 0x18, 0x47, 0x74, 0x81, 0x08, 0x80, 0x56, 0x65, 0x17, 0x07, 0x70, 0x73,
+    0x37, 0x27, 0x72, 0x46, 0x64, 0x55, 0x71, 0x36, 0x63, 0x45, 0x54, 0x26, 0x62, 0x16, 0x61, 0x06,
+    0x60, 0x35, 0x53, 0x44, 0x25, 0x52, 0x15, 0x05, 0x50, 0x51, 0x34, 0x43, 0x24, 0x42, 0x33, 0x14,
+    0x41, 0x04, 0x40, 0x23, 0x32, 0x13, 0x31, 0x03, 0x30, 0x22, 0x12, 0x21, 0x02, 0x20, 0x11, 0x01,
+    0x10, 0x00
+};
+
+// First half of the synthesis window in 1/65536 units; the rest mirrors it.
+constexpr int32_t kSynthWindow[257] = {
+    0, -1, -1, -1, -1, -1, -1, -2, -2, -2, -2, -3, -3, -4, -4, -5, -5, -6, -7, -7, -8, -9, -10,
+    -11, -13, -14, -16, -17, -19, -21, -24, -26, -29, -31, -35, -38, -41, -45, -49, -53, -58, -63,
+    -68, -73, -79, -85, -91, -97, -104, -111, -117, -125, -132, -139, -147, -154, -161, -169, -176,
+    -183, -190, -196, -202, -208, 213, 218, 222, 225, 227, 228, 228, 227, 224, 221, 215, 208, 200,
+    189, 177, 163, 146, 127, 106, 83, 57, 29, -2, -36, -72, -111, -153, -197, -244, -294, -347,
+    -401, -459, -519, -581, -645, -711, -779, -848, -919, -991, -1064, -1137, -1210, -1283, -1356,
+    -1428, -1498, -1567, -1634, -1698, -1759, -1817, -1870, -1919, -1962, -2001, -2032, -2057,
+    -2075, -2085, -2087, -2080, -2063, 2037, 2000, 1952, 1893, 1822, 1739, 1644, 1535, 1414, 1280,
+    1131, 970, 794, 605, 402, 185, -45, -288, -545, -814, -1095, -1388, -1692, -2006, -2330, -2663,
+    -3004, -3351, -3705, -4063, -4425, -4788, -5153, -5517, -5879, -6237, -6589, -6935, -7271,
+    -7597, -7910, -8209, -8491, -8755, -8998, -9219, -9416, -9585, -9727, -9838, -9916, -9959,
+    -9966, -9935, -9863, -9750, -9592, -9389, -9139, -8840, -8492, -8092, -7640, -7134, 6574, 5959,
+    5288, 4561, 3776, 2935, 2037, 1082, 70, -998, -2122, -3300, -4533, -5818, -7154, -8540, -9975,
+    -11455, -12980, -14548, -16155, -17799, -19478, -21189, -22929, -24694, -26482, -28289, -30112,
+    -31947, -33791, -35640, -37489, -39336, -41176, -43006, -44821, -46617, -48390, -50137, -51853,
+    -53534, -55178, -56778, -58333, -59838, -61289, -62684, -64019, -65290, -66494, -67629, -68692,
+    -69679, -70590, -71420, -72169, -72835, -73415, -73908, -74313, -74630, -74856, -74992, 75038
+};
+// Count1 table A, indexed by v << 3 | w << 2 | x << 1 | y. Table B is the 4-bit complement.
+constexpr uint8_t kQuadCodes[16] = {1, 5, 4, 5, 6, 5, 4, 4, 7, 3, 6, 0, 7, 2, 3, 1};
+constexpr uint8_t kQuadLengths[16] = {1, 4, 4, 5, 4, 6, 5, 6, 4, 5, 5, 6, 5, 6, 6, 6};
+
+struct TableSelect {
+    int8_t table;  // into kHuffSizes; -1 for the all-zero table 0, -2 for the unused 4 and 14
+    uint8_t linbits;
+};
+constexpr TableSelect kTableSelect[32] = {
+    {-1, 0}, {0, 0},  {1, 0},  {2, 0},  {-2, 0}, {3, 0},  {4, 0},   {5, 0},
+    {6, 0},  {7, 0},  {8, 0},  {9, 0},  {10, 0}, {11, 0}, {-2, 0},  {12, 0},
+    {13, 1}, {13, 2}, {13, 3}, {13, 4}, {13, 6}, {13, 8}, {13, 10}, {13, 13},
+    {14, 4}, {14, 5}, {14, 6}, {14, 7}, {14, 8}, {14, 9}, {14, 11}, {14, 13}};
+
+uint32_t be32(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+    uint32_t read(int bits) {
+        uint32_t value = 0;
+        while (bits > 0) {
+            const size_t byte = m_pos >> 3;
+            const int offset = static_cast<int>(m_pos & 7);
+            const int take = std::min(bits, 8 - offset);
+            const uint32_t b = byte < m_size ? m_data[byte] : 0;
+            value = (value << take) | ((b >> (8 - offset - take)) & ((1u << take) - 1));
+            m_pos += static_cast<size_t>(take);
+            bits -= take;
+        }
+        return value;
+    }
+
+    size_t position() const { return m_pos; }
+    void seek(size_t bit) { m_pos = bit; }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+// A binary decoding tree. Node n keeps its children at [2n] and [2n + 1]: a positive entry is
+// another node, a negative one is the leaf ~symbol and zero is a code the table lacks.
+class HuffTree {
+public:
+    HuffTree() : m_nodes(2, 0) {}
+
+    void add(uint32_t code, int length, int symbol) {
+        int node = 0;
+        for (int bit = length - 1; bit > 0; --bit) {
+            const size_t slot = static_cast<size_t>(2 * node) + ((code >> bit) & 1);
+            if (m_nodes[slot] == 0) {
+                m_nodes[slot] = static_cast<int>(m_nodes.size() / 2);
+                m_nodes.resize(m_nodes.size() + 2, 0);
+            }
+            node = m_nodes[slot];
+        }
+        m_nodes[static_cast<size_t>(2 * node) + (code & 1)] = ~symbol;
+    }
+
+    int decode(BitReader &bits) const {
+        int node = 0;
+        while (true) {
+            const int next = m_nodes[static_cast<size_t>(2 * node) + bits.read(1)];
+            if (next <= 0) {
+                return next < 0 ? ~next : 0;
+            }
+            node = next;
+        }
+    }
+
+private:
+    std::vector<int> m_nodes;
+};
+
+struct Tables {
+    Tables() {
+        size_t offset = 0;
+        for (int t = 0; t < 15; ++t) {
+            uint32_t code = 0;
+            for (int i = 0; i < kHuffSizes[t]; ++i, ++offset) {
+                const int length = kHuffLengths[offset];
+                huff[t].add(code >> (32 - length), length, kHuffSymbols[offset]);
+                code += 1u << (32 - length);
+            }
+        }
+        for (int i = 0; i < 16; ++i) {
+            quad.add(kQuadCodes[i], kQuadLengths[i], i);
+        }
+        for (int i = 0; i <= kMaxQuantized; ++i) {
+            pow43[i] = static_cast<float>(std::pow(static_cast<double>(i), 4.0 / 3.0));
+        }
+        for (int i = 0; i < 8; ++i) {
+            static constexpr double kCoefficients[8] = {-0.6,   -0.535, -0.33,   -0.185,
+                                                        -0.095, -0.041, -0.0142, -0.0037};
+            const double c = kCoefficients[i];
+            aliasCs[i] = static_cast<float>(1.0 / std::sqrt(1.0 + c * c));
+            aliasCa[i] = static_cast<float>(c / std::sqrt(1.0 + c * c));
+        }
+        for (int i = 0; i < 36; ++i) {
+            for (int k = 0; k < 18; ++k) {
+                imdctLong[i][k] =
+                    static_cast<float>(std::cos(kPi / 72.0 * (2 * i + 19) * (2 * k + 1)));
+            }
+        }
+        for (int i = 0; i < 12; ++i) {
+            for (int k = 0; k < 6; ++k) {
+                imdctShort[i][k] =
+                    static_cast<float>(std::cos(kPi / 24.0 * (2 * i + 7) * (2 * k + 1)));
+            }
+            shortWindow[i] = static_cast<float>(std::sin(kPi / 12.0 * (i + 0.5)));
+        }
+        // Long windows by block type: normal, start and stop (2 is short and handled apart).
+        for (int i = 0; i < 36; ++i) {
+            const float sine = static_cast<float>(std::sin(kPi / 36.0 * (i + 0.5)));
+            longWindow[0][i] = sine;
+            longWindow[2][i] = sine;
+            if (i < 18) {
+                longWindow[1][i] = sine;
+            } else if (i < 24) {
+                longWindow[1][i] = 1.0f;
+            } else if (i < 30) {
+                longWindow[1][i] = static_cast<float>(std::sin(kPi / 12.0 * (i - 18 + 0.5)));
+            } else {
+                longWindow[1][i] = 0.0f;
+            }
+            if (i < 6) {
+                longWindow[3][i] = 0.0f;
+            } else if (i < 12) {
+                longWindow[3][i] = static_cast<float>(std::sin(kPi / 12.0 * (i - 6 + 0.5)));
+            } else if (i < 18) {
+                longWindow[3][i] = 1.0f;
+            } else {
+                longWindow[3][i] = sine;
+            }
+        }
+        for (int i = 0; i < 64; ++i) {
+            for (int k = 0; k < 32; ++k) {
+                synthCos[i][k] =
+                    static_cast<float>(std::cos((16 + i) * (2 * k + 1) * kPi / 64.0));
+            }
+        }
+        for (int i = 0; i <= 256; ++i) {
+            const float v = static_cast<float>(kSynthWindow[i] / 65536.0);
+            synthWindow[i] = v;
+            if (i > 0) {
+                synthWindow[512 - i] = (i % 64) != 0 ? -v : v;
+            }
+        }
+    }
+
+    std::array<HuffTree, 15> huff;
+    HuffTree quad;
+    float pow43[kMaxQuantized + 1];
+    float aliasCs[8];
+    float aliasCa[8];
+    float imdctLong[36][18];
+    float imdctShort[12][6];
+    float longWindow[4][36];
+    float shortWindow[12];
+    float synthCos[64][32];
+    float synthWindow[512];
+};
+
+const Tables &tables() {
+    static const Tables t;
+    return t;
+}
+
+struct Header {
+    bool lsf = false;  // MPEG-2 or 2.5: one granule per frame, MPEG-2 scalefactors
+    int rateIndex = 0;
+    int channels = 0;
+    int mode = 0;  // 1 = joint stereo, 3 = mono
+    int modeExtension = 0;
+    bool crc = false;
+    size_t frameBytes = 0;
+
+    int granules() const { return lsf ? 1 : 2; }
+    size_t sideInfoBytes() const {
+        return lsf ? (channels == 1 ? 9 : 17) : (channels == 1 ? 17 : 32);
+    }
+    size_t audioOffset() const { return (crc ? 6 : 4) + sideInfoBytes(); }
+};
+
+// Fixed-bitrate Layer III headers only.
+bool parseHeader(const uint8_t *h, Header &out) {
+    if (h[0] != 0xff || (h[1] & 0xe0) != 0xe0) {
+        return false;
+    }
+    const int version = (h[1] >> 3) & 0x03;  // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+    const int layer = (h[1] >> 1) & 0x03;
+    const int bitrateIndex = h[2] >> 4;
+    const int rate = (h[2] >> 2) & 0x03;
+    if (version == 1 || layer != 1 || bitrateIndex == 0 || bitrateIndex == 15 || rate == 3) {
+        return false;
+    }
+    out.lsf = version != 3;
+    out.rateIndex = rate + (version == 3 ? 0 : version == 2 ? 3 : 6);
+    out.mode = h[3] >> 6;
+    out.modeExtension = (h[3] >> 4) & 0x03;
+    out.channels = out.mode == 3 ? 1 : 2;
+    out.crc = (h[1] & 0x01) == 0;
+    const int padding = (h[2] >> 1) & 0x01;
+    out.frameBytes = static_cast<size_t>((out.lsf ? 72 : 144) * 1000 *
+                                             kBitrates[out.lsf ? 1 : 0][bitrateIndex] /
+                                             kSampleRates[out.rateIndex] +
+                                         padding);
+    return true;
+}
+
+bool sameStream(const Header &a, const Header &b) {
+    return a.lsf == b.lsf && a.rateIndex == b.rateIndex && a.channels == b.channels;
+}
+
+// A header at pos whose successor, when the data reaches that far, is a matching header.
+bool frameAt(const uint8_t *data, size_t size, size_t pos, Header &out) {
+    if (pos + 4 > size || !parseHeader(data + pos, out)) {
+        return false;
+    }
+    const size_t next = pos + out.frameBytes;
+    Header following;
+    return next + 4 > size || (parseHeader(data + next, following) && sameStream(out, following));
+}
+
+// Side information of one channel in one granule.
+struct GranuleInfo {
+    int part23Length = 0;
+    int bigValues = 0;
+    int globalGain = 0;
+    int scalefacCompress = 0;
+    int blockType = 0;
+    bool mixed = false;
+    int tableSelect[3] = {};
+    int subblockGain[3] = {};
+    int region1Start = 0;
+    int region2Start = 0;
+    bool preflag = false;
+    bool scalefacScale = false;
+    bool count1TableB = false;
+    // Long scalefactor bands end and short ones start here; mixed blocks have both.
+    int longEnd = 22;
+    int shortStart = 13;
+};
+
+struct Scalefactors {
+    int longBands[22] = {};
+    int shortBands[13][3] = {};
+    // MPEG-2 intensity stereo: the position that marks a band as not intensity coded.
+    int illegalLong[22] = {};
+    int illegalShort[13] = {};
+};
+
+class Decoder {
+public:
+    Decoder(int64_t maxFrames, Pcm &out) : m_maxFrames(maxFrames), m_out(out) {
+        std::memset(m_overlap, 0, sizeof(m_overlap));
+        std::memset(m_synth, 0, sizeof(m_synth));
+    }
+
+    bool run(const uint8_t *data, size_t size);
+
+private:
+    void decodeFrame(const Header &header, const uint8_t *frame);
+    bool readSideInfo(BitReader &bits, const Header &header);
+    void readScalefactors(BitReader &bits, const Header &header, int gr, int ch);
+    bool readSpectrum(BitReader &bits, const GranuleInfo &g, size_t end, int *values);
+    void requantize(const GranuleInfo &g, const Scalefactors &sf, const int *values, float *xr);
+    void stereo(const Header &header, int gr);
+    void intensity(const Header &header, int gr, int line, int position, int illegal);
+    void reorder(const GranuleInfo &g, float *xr);
+    void antialias(const GranuleInfo &g, float *xr);
+    void hybrid(const GranuleInfo &g, int ch, float *xr);
+    void synthesize(int ch, const float *xr, float *out, int stride);
+
+    int64_t m_maxFrames;
+    Pcm &m_out;
+    int m_rateIndex = 0;
+    int m_channels = 0;
+    int m_lineStartLong[23] = {};
+    int m_lineStartShort[14] = {};
+
+    std::vector<uint8_t> m_reservoir;
+    int m_mainDataBegin = 0;
+    int m_scfsi[2] = {};
+    GranuleInfo m_side[2][2];
+    Scalefactors m_scalefactors[2];
+    int m_values[2][kLines];
+    float m_xr[2][kLines];
+    bool m_intensity[kLines];
+
+    float m_overlap[2][kSubbands][kSubbandLines];
+    float m_synth[2][1024];
+    int m_synthOffset[2] = {};
+};
+
+bool Decoder::run(const uint8_t *data, size_t size) {
+    size_t pos = 0;
+    Header first;
+    while (pos + 4 <= size && !frameAt(data, size, pos, first)) {
+        ++pos;
+    }
+    if (pos + 4 > size) {
+        return false;
+    }
+    m_rateIndex = first.rateIndex;
+    m_channels = first.channels;
+    for (int i = 0; i < 22; ++i) {
+        m_lineStartLong[i + 1] = m_lineStartLong[i] + kLongBands[m_rateIndex][i];
+    }
+    for (int i = 0; i < 13; ++i) {
+        m_lineStartShort[i + 1] = m_lineStartShort[i] + kShortBands[m_rateIndex][i];
+    }
+    const int frameSamples = first.granules() * kLines;
+
+    // A Xing/Info frame carries no audio; LAME and ffmpeg append the encoder delay and
+    // padding to it.
+    int64_t taggedFrames = 0;
+    int delay = -1;
+    int padding = 0;
+    const uint8_t *tag = data + pos + (first.crc ? 6 : 4) + first.sideInfoBytes();
+    const uint8_t *frameEnd = data + std::min(size, pos + first.frameBytes);
+    if (tag + 8 <= frameEnd &&
+        (std::memcmp(tag, "Xing", 4) == 0 || std::memcmp(tag, "Info", 4) == 0)) {
+        const uint32_t flags = be32(tag + 4);
+        const uint8_t *field = tag + 8;
+        if ((flags & 0x01) && field + 4 <= frameEnd) {
+            taggedFrames = be32(field);
+            field += 4;
+        }
+        field += ((flags & 0x02) ? 4 : 0) + ((flags & 0x04) ? 100 : 0) + ((flags & 0x08) ? 4 : 0);
+        if (field + 24 <= frameEnd &&
+            (std::memcmp(field, "LAME", 4) == 0 || std::memcmp(field, "Lavf", 4) == 0 ||
+             std::memcmp(field, "Lavc", 4) == 0)) {
+            delay = (field[21] << 4) | (field[22] >> 4);
+            padding = ((field[22] & 0x0f) << 8) | field[23];
+        }
+        pos += first.frameBytes;
+    } else if (pos + 4 + 32 + 4 <= size && std::memcmp(data + pos + 36, "VBRI", 4) == 0) {
+        pos += first.frameBytes;
+    }
+
+    const int64_t skip = delay >= 0 ? delay + kDecoderDelay : 0;
+    const int64_t wanted = m_maxFrames > 0 ? skip + m_maxFrames : 0;
+    m_out.channels = m_channels;
+    m_out.sampleRate = kSampleRates[m_rateIndex];
+    m_out.samples.clear();
+    int64_t decodedFrames = 0;
+    while (pos + 4 <= size) {
+        Header header;
+        if (!parseHeader(data + pos, header) || !sameStream(header, first)) {
+            // Lost sync (a damaged frame or a trailing tag): look for the next frame.
+            ++pos;
+            while (pos + 4 <= size &&
+                   !(frameAt(data, size, pos, header) && sameStream(header, first))) {
+                ++pos;
+            }
+            continue;
+        }
+        if (pos + header.frameBytes > size) {
+            break;
+        }
+        decodeFrame(header, data + pos);
+        pos += header.frameBytes;
+        ++decodedFrames;
+        if (wanted > 0 && decodedFrames * frameSamples >= wanted) {
+            break;
+        }
+    }
+    if (decodedFrames == 0) {
+        return false;
+    }
+
+    const size_t channels = static_cast<size_t>(m_channels);
+    int64_t total = static_cast<int64_t>(m_out.samples.size() / channels);
+    if (delay >= 0) {
+        const int64_t frames = taggedFrames > 0 ? taggedFrames : decodedFrames;
+        total = std::min(total, frames * frameSamples + kDecoderDelay - padding);
+    }
+    if (wanted > 0) {
+        total = std::min(total, wanted);
+    }
+    total = std::max(total, skip);
+    m_out.samples.resize(static_cast<size_t>(total) * channels);
+    m_out.samples.erase(m_out.samples.begin(),
+                        m_out.samples.begin() + static_cast<std::ptrdiff_t>(skip * m_channels));
+    return true;
+}
+
+void Decoder::decodeFrame(const Header &header, const uint8_t *frame) {
+    const size_t offset = header.audioOffset();
+    BitReader side(frame + (header.crc ? 6 : 4), header.sideInfoBytes());
+    const bool valid = header.frameBytes > offset && readSideInfo(side, header);
+
+    // The main data of this frame may start up to main_data_begin bytes back, in frames
+    // already seen; a stream that starts mid-reservoir decodes those granules as silence.
+    bool haveData = valid && static_cast<size_t>(m_mainDataBegin) <= m_reservoir.size();
+    const size_t start = haveData ? m_reservoir.size() - static_cast<size_t>(m_mainDataBegin) : 0;
+    if (header.frameBytes > offset) {
+        m_reservoir.insert(m_reservoir.end(), frame + offset, frame + header.frameBytes);
+    }
+    BitReader bits(m_reservoir.data() + start, m_reservoir.size() - start);
+
+    const int granules = header.granules();
+    for (int gr = 0; gr < granules; ++gr) {
+        for (int ch = 0; ch < m_channels; ++ch) {
+            const GranuleInfo &g = m_side[gr][ch];
+            bool ok = haveData;
+            if (ok) {
+                const size_t part2 = bits.position();
+                const size_t end = part2 + static_cast<size_t>(g.part23Length);
+                readScalefactors(bits, header, gr, ch);
+                ok = readSpectrum(bits, g, end, m_values[ch]);
+                bits.seek(end);
+            }
+            if (ok) {
+                requantize(g, m_scalefactors[ch], m_values[ch], m_xr[ch]);
+            } else {
+                std::fill(m_values[ch], m_values[ch] + kLines, 0);
+                std::fill(m_xr[ch], m_xr[ch] + kLines, 0.0f);
+            }
+        }
+        if (m_channels == 2) {
+            stereo(header, gr);
+        }
+
+        const size_t base = m_out.samples.size();
+        m_out.samples.resize(base + static_cast<size_t>(kLines * m_channels));
+        for (int ch = 0; ch < m_channels; ++ch) {
+            const GranuleInfo &g = m_side[gr][ch];
+            float *xr = m_xr[ch];
+            if (g.blockType == 2) {
+                reorder(g, xr);
+            }
+            antialias(g, xr);
+            hybrid(g, ch, xr);
+            synthesize(ch, xr, m_out.samples.data() + base + ch, m_channels);
+        }
+    }
+
+    if (m_reservoir.size() > 4 * kReservoirKeep) {
+        m_reservoir.erase(m_reservoir.begin(),
+                          m_reservoir.end() - static_cast<std::ptrdiff_t>(kReservoirKeep));
+    }
+}
+
+bool Decoder::readSideInfo(BitReader &bits, const Header &header) {
+    const bool lsf = header.lsf;
+    const bool mono = m_channels == 1;
+    m_mainDataBegin = static_cast<int>(bits.read(lsf ? 8 : 9));
+    bits.read(lsf ? (mono ? 1 : 2) : (mono ? 5 : 3));
+    if (!lsf) {
+        for (int ch = 0; ch < m_channels; ++ch) {
+            m_scfsi[ch] = static_cast<int>(bits.read(4));
+        }
+    }
+    for (int gr = 0; gr < header.granules(); ++gr) {
+        for (int ch = 0; ch < m_channels; ++ch) {
+            GranuleInfo &g = m_side[gr][ch];
+            g = GranuleInfo();
+            g.part23Length = static_cast<int>(bits.read(12));
+            g.bigValues = static_cast<int>(bits.read(9));
+            g.globalGain = static_cast<int>(bits.read(8));
+            g.scalefacCompress = static_cast<int>(bits.read(lsf ? 9 : 4));
+            if (g.bigValues > kLines / 2) {
+                return false;
+            }
+            if (bits.read(1)) {
+                g.blockType = static_cast<int>(bits.read(2));
+                g.mixed = bits.read(1) != 0;
+                if (g.blockType == 0) {
+                    return false;
+                }
+                for (int r = 0; r < 2; ++r) {
+                    g.tableSelect[r] = static_cast<int>(bits.read(5));
+                }
+                for (int w = 0; w < 3; ++w) {
+                    g.subblockGain[w] = static_cast<int>(bits.read(3));
+                }
+                // Region 0 is the first 8 long or 3 short bands; region 2 is empty.
+                g.region1Start =
+                    g.blockType == 2 ? 3 * m_lineStartShort[3] : m_lineStartLong[8];
+                g.region2Start = kLines;
+            } else {
+                for (int r = 0; r < 3; ++r) {
+                    g.tableSelect[r] = static_cast<int>(bits.read(5));
+                }
+                const int region0 = static_cast<int>(bits.read(4));
+                const int region1 = static_cast<int>(bits.read(3));
+                g.region1Start = m_lineStartLong[std::min(region0 + 1, 22)];
+                g.region2Start = m_lineStartLong[std::min(region0 + region1 + 2, 22)];
+            }
+            if (!lsf) {
+                g.preflag = bits.read(1) != 0;
+            }
+            g.scalefacScale = bits.read(1) != 0;
+            g.count1TableB = bits.read(1) != 0;
+            if (g.blockType == 2) {
+                g.longEnd = g.mixed ? (m_rateIndex <= 2 ? 8 : 6) : 0;
+                g.shortStart = g.mixed ? 3 : 0;
+            }
+        }
+    }
+    return true;
+}
+
+void Decoder::readScalefactors(BitReader &bits, const Header &header, int gr, int ch) {
+    GranuleInfo &g = m_side[gr][ch];
+    Scalefactors &sf = m_scalefactors[ch];
+    if (!header.lsf) {
+        const int slen1 = kSlen[0][g.scalefacCompress];
+        const int slen2 = kSlen[1][g.scalefacCompress];
+        if (g.blockType == 2) {
+            for (int sfb = 0; sfb < g.longEnd; ++sfb) {
+                sf.longBands[sfb] = static_cast<int>(bits.read(slen1));
+            }
+            for (int sfb = g.shortStart; sfb < 12; ++sfb) {
+                for (int w = 0; w < 3; ++w) {
+                    sf.shortBands[sfb][w] = static_cast<int>(bits.read(sfb < 6 ? slen1 : slen2));
+                }
+            }
+            sf.shortBands[12][0] = sf.shortBands[12][1] = sf.shortBands[12][2] = 0;
+        } else {
+            // scfsi lets the second granule reuse the first one's factors, band group by group.
+            static constexpr int kGroups[5] = {0, 6, 11, 16, 21};
+            for (int group = 0; group < 4; ++group) {
+                if (gr > 0 && (m_scfsi[ch] & (8 >> group))) {
+                    continue;
+                }
+                for (int sfb = kGroups[group]; sfb < kGroups[group + 1]; ++sfb) {
+                    sf.longBands[sfb] = static_cast<int>(bits.read(group < 2 ? slen1 : slen2));
+                }
+            }
+            sf.longBands[21] = 0;
+        }
+        return;
+    }
+
+    int slen[4] = {};
+    int partition = 0;
+    int compress = g.scalefacCompress;
+    if (ch == 1 && header.mode == 1 && (header.modeExtension & 1)) {
+        compress >>= 1;
+        if (compress < 180) {
+            slen[0] = compress / 36;
+            slen[1] = (compress % 36) / 6;
+            slen[2] = compress % 6;
+            partition = 3;
+        } else if (compress < 244) {
+            compress -= 180;
+            slen[0] = compress >> 4;
+            slen[1] = (compress >> 2) & 3;
+            slen[2] = compress & 3;
+            partition = 4;
+        } else {
+            compress -= 244;
+            slen[0] = compress / 3;
+            slen[1] = compress % 3;
+            partition = 5;
+        }
+    } else if (compress < 400) {
+        slen[0] = (compress >> 4) / 5;
+        slen[1] = (compress >> 4) % 5;
+        slen[2] = (compress >> 2) & 3;
+        slen[3] = compress & 3;
+        partition = 0;
+    } else if (compress < 500) {
+        compress -= 400;
+        slen[0] = (compress >> 2) / 5;
+        slen[1] = (compress >> 2) % 5;
+        slen[2] = compress & 3;
+        partition = 1;
+    } else {
+        compress -= 500;
+        slen[0] = compress / 3;
+        slen[1] = compress % 3;
+        partition = 2;
+        g.preflag = true;
+    }
+    const int kind = g.blockType == 2 ? (g.mixed ? 2 : 1) : 0;
+    const int longCount = g.blockType == 2 ? g.longEnd : 21;
+    int sfb = 0;
+    int shortSfb = g.shortStart;
+    int window = 0;
+    for (int p = 0; p < 4; ++p) {
+        const int illegal = (1 << slen[p]) - 1;
+        for (int n = 0; n < kLsfPartitions[partition][kind][p]; ++n) {
+            const int value = static_cast<int>(bits.read(slen[p]));
+            if (sfb < longCount) {
+                sf.longBands[sfb] = value;
+                sf.illegalLong[sfb] = illegal;
+                ++sfb;
+            } else if (shortSfb < 13) {
+                sf.shortBands[shortSfb][window] = value;
+                sf.illegalShort[shortSfb] = illegal;
+                if (++window == 3) {
+                    window = 0;
+                    ++shortSfb;
+                }
+            }
+        }
+    }
+    for (; sfb < 22; ++sfb) {
+        sf.longBands[sfb] = 0;
+        sf.illegalLong[sfb] = sfb > 0 ? sf.illegalLong[sfb - 1] : 0;
+    }
+    for (; shortSfb < 13; ++shortSfb, window = 0) {
+        for (; window < 3; ++window) {
+            sf.shortBands[shortSfb][window] = 0;
+        }
+        sf.illegalShort[shortSfb] = shortSfb > 0 ? sf.illegalShort[shortSfb - 1] : 0;
+    }
+}
+
+bool Decoder::readSpectrum(BitReader &bits, const GranuleInfo &g, size_t end, int *values) {
+    const Tables &t = tables();
+    const int bigEnd = g.bigValues * 2;
+    const int regionEnds[3] = {std::min(g.region1Start, bigEnd), std::min(g.region2Start, bigEnd),
+                               bigEnd};
+    int i = 0;
+    for (int r = 0; r < 3; ++r) {
+        const TableSelect select = kTableSelect[g.tableSelect[r]];
+        if (select.table == -2) {
+            return false;
+        }
+        for (; i < regionEnds[r]; i += 2) {
+            if (select.table < 0) {
+                values[i] = values[i + 1] = 0;
+                continue;
+            }
+            const int symbol = t.huff[static_cast<size_t>(select.table)].decode(bits);
+            int x = symbol >> 4;
+            int y = symbol & 0x0f;
+            if (x == 15 && select.linbits > 0) {
+                x += static_cast<int>(bits.read(select.linbits));
+            }
+            if (x != 0 && bits.read(1)) {
+                x = -x;
+            }
+            if (y == 15 && select.linbits > 0) {
+                y += static_cast<int>(bits.read(select.linbits));
+            }
+            if (y != 0 && bits.read(1)) {
+                y = -y;
+            }
+            values[i] = x;
+            values[i + 1] = y;
+        }
+    }
+    // Count1 region: quadruples of -1/0/1 until part2_3_length runs out. A quadruple that
+    // overruns it is stuffing, not data.
+    while (i + 4 <= kLines && bits.position() < end) {
+        const int quad = g.count1TableB ? 15 - static_cast<int>(bits.read(4)) : t.quad.decode(bits);
+        int v[4];
+        for (int k = 0; k < 4; ++k) {
+            v[k] = (quad >> (3 - k)) & 1;
+            if (v[k] != 0 && bits.read(1)) {
+                v[k] = -1;
+            }
+        }
+        if (bits.position() > end) {
+            break;
+        }
+        std::copy(v, v + 4, values + i);
+        i += 4;
+    }
+    std::fill(values + i, values + kLines, 0);
+    return true;
+}
+
+void Decoder::requantize(const GranuleInfo &g, const Scalefactors &sf, const int *values,
+                         float *xr) {
+    const float *pow43 = tables().pow43;
+    const double gain = 0.25 * (g.globalGain - 210);
+    const double shift = g.scalefacScale ? 1.0 : 0.5;
+    auto scale = [&](int line, int count, double exponent) {
+        const float factor = static_cast<float>(std::exp2(exponent));
+        for (int i = line; i < line + count; ++i) {
+            const int v = values[i];
+            const float magnitude = pow43[std::min(std::abs(v), kMaxQuantized)] * factor;
+            xr[i] = v < 0 ? -magnitude : magnitude;
+        }
+    };
+    for (int sfb = 0; sfb < g.longEnd; ++sfb) {
+        const int boost = sf.longBands[sfb] + (g.preflag ? kPretab[sfb] : 0);
+        scale(m_lineStartLong[sfb], kLongBands[m_rateIndex][sfb], gain - shift * boost);
+    }
+    for (int sfb = g.shortStart; sfb < 13; ++sfb) {
+        const int width = kShortBands[m_rateIndex][sfb];
+        for (int w = 0; w < 3; ++w) {
+            const double exponent =
+                gain - 2.0 * g.subblockGain[w] - shift * sf.shortBands[sfb][w];
+            scale(3 * m_lineStartShort[sfb] + w * width, width, exponent);
+        }
+    }
+}
+
+void Decoder::stereo(const Header &header, int gr) {
+    if (header.mode != 1) {
+        return;
+    }
+    const bool midSide = (header.modeExtension & 2) != 0;
+    std::fill(m_intensity, m_intensity + kLines, false);
+    if (header.modeExtension & 1) {
+        // Intensity coding covers the bands above the highest nonzero line of the right
+        // channel, which carries the positions in its scalefactors; short blocks per window.
+        const GranuleInfo &g = m_side[gr][1];
+        const Scalefactors &sf = m_scalefactors[1];
+        const int *right = m_values[1];
+        bool shortNonzero = false;
+        for (int w = 0; w < 3; ++w) {
+            int sfb = 12;
+            for (; sfb >= g.shortStart && g.shortStart < 13; --sfb) {
+                const int width = kShortBands[m_rateIndex][sfb];
+                const int line = 3 * m_lineStartShort[sfb] + w * width;
+                if (std::any_of(right + line, right + line + width, [](int v) { return v; })) {
+                    break;
+                }
+            }
+            shortNonzero = shortNonzero || sfb >= g.shortStart;
+            for (int band = std::max(sfb + 1, g.shortStart); band < 13; ++band) {
+                const int width = kShortBands[m_rateIndex][band];
+                const int line = 3 * m_lineStartShort[band] + w * width;
+                const int source = std::min(band, 11);
+                for (int i = line; i < line + width; ++i) {
+                    intensity(header, gr, i, sf.shortBands[source][w],
+                              header.lsf ? sf.illegalShort[source] : 7);
+                }
+            }
+        }
+        if (g.longEnd > 0 && !shortNonzero) {
+            int sfb = g.longEnd - 1;
+            for (; sfb >= 0; --sfb) {
+                const int line = m_lineStartLong[sfb];
+                const int width = kLongBands[m_rateIndex][sfb];
+                if (std::any_of(right + line, right + line + width, [](int v) { return v; })) {
+                    break;
+                }
+            }
+            for (int band = sfb + 1; band < g.longEnd; ++band) {
+                const int source = std::min(band, 20);
+                for (int i = m_lineStartLong[band]; i < m_lineStartLong[band + 1]; ++i) {
+                    intensity(header, gr, i, sf.longBands[source],
+                              header.lsf ? sf.illegalLong[source] : 7);
+                }
+            }
+        }
+    }
+    if (midSide) {
+        const float norm = static_cast<float>(1.0 / std::sqrt(2.0));
+        for (int i = 0; i < kLines; ++i) {
+            if (!m_intensity[i]) {
+                const float m = m_xr[0][i];
+                const float s = m_xr[1][i];
+                m_xr[0][i] = (m + s) * norm;
+                m_xr[1][i] = (m - s) * norm;
+            }
+        }
+    }
+}
+
+void Decoder::intensity(const Header &header, int gr, int line, int position, int illegal) {
+    if (position == illegal) {
+        return;
+    }
+    double left = 1.0;
+    double right = 1.0;
+    if (!header.lsf) {
+        const double ratio = std::tan(position * kPi / 12.0);
+        left = position == 6 ? 1.0 : ratio / (1.0 + ratio);
+        right = position == 6 ? 0.0 : 1.0 / (1.0 + ratio);
+    } else if (position > 0) {
+        const double base = (m_side[gr][1].scalefacCompress & 1) ? std::sqrt(0.5)
+                                                                   : std::pow(2.0, -0.25);
+        if (position & 1) {
+            left = std::pow(base, (position + 1) / 2);
+        } else {
+            right = std::pow(base, position / 2);
+        }
+    }
+    const float x = m_xr[0][line];
+    m_xr[0][line] = static_cast<float>(x * left);
+    m_xr[1][line] = static_cast<float>(x * right);
+    m_intensity[line] = true;
+}
+
+// Short bands arrive window by window; the IMDCT wants each subband's lines interleaved by
+// window, which is what sorting them by frequency gives.
+void Decoder::reorder(const GranuleInfo &g, float *xr) {
+    float sorted[kLines];
+    const int first = 3 * m_lineStartShort[g.shortStart];
+    for (int sfb = g.shortStart; sfb < 13; ++sfb) {
+        const int width = kShortBands[m_rateIndex][sfb];
+        const int line = 3 * m_lineStartShort[sfb];
+        for (int w = 0; w < 3; ++w) {
+            for (int j = 0; j < width; ++j) {
+                sorted[line + 3 * j + w] = xr[line + w * width + j];
+            }
+        }
+    }
+    std::copy(sorted + first, sorted + kLines, xr + first);
+}
+
+void Decoder::antialias(const GranuleInfo &g, float *xr) {
+    if (g.blockType == 2 && !g.mixed) {
+        return;
+    }
+    const Tables &t = tables();
+    const int last = g.blockType == 2 ? 1 : kSubbands - 1;
+    for (int sb = 1; sb <= last; ++sb) {
+        float *upper = xr + sb * kSubbandLines;
+        for (int i = 0; i < 8; ++i) {
+            const float a = upper[-1 - i];
+            const float b = upper[i];
+            upper[-1 - i] = a * t.aliasCs[i] - b * t.aliasCa[i];
+            upper[i] = b * t.aliasCs[i] + a * t.aliasCa[i];
+        }
+    }
+}
+
+// IMDCT, windowing and overlap-add per subband, then the frequency inversion of odd subbands.
+// xr comes back holding 18 time samples per subband.
+void Decoder::hybrid(const GranuleInfo &g, int ch, float *xr) {
+    const Tables &t = tables();
+    for (int sb = 0; sb < kSubbands; ++sb) {
+        float *in = xr + sb * kSubbandLines;
+        float *overlap = m_overlap[ch][sb];
+        const int type = g.blockType == 2 && g.mixed && sb < 2 ? 0 : g.blockType;
+        float out[36] = {};
+        if (type == 2) {
+            for (int w = 0; w < 3; ++w) {
+                for (int i = 0; i < 12; ++i) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < 6; ++k) {
+                        sum += in[3 * k + w] * t.imdctShort[i][k];
+                    }
+                    out[6 + 6 * w + i] += sum * t.shortWindow[i];
+                }
+            }
+        } else {
+            for (int i = 0; i < 36; ++i) {
+                float sum = 0.0f;
+                for (int k = 0; k < 18; ++k) {
+                    sum += in[k] * t.imdctLong[i][k];
+                }
+                out[i] = sum * t.longWindow[type][i];
+            }
+        }
+        for (int i = 0; i < kSubbandLines; ++i) {
+            in[i] = out[i] + overlap[i];
+            overlap[i] = out[i + kSubbandLines];
+            if ((sb & 1) && (i & 1)) {
+                in[i] = -in[i];
+            }
+        }
+    }
+}
+
+// Polyphase synthesis of one granule: 18 slots of 32 subband samples to 576 output samples.
+void Decoder::synthesize(int ch, const float *xr, float *out, int stride) {
+    const Tables &t = tables();
+    float *v = m_synth[ch];
+    for (int slot = 0; slot < kSubbandLines; ++slot) {
+        float s[kSubbands];
+        for (int sb = 0; sb < kSubbands; ++sb) {
+            s[sb] = xr[sb * kSubbandLines + slot];
+        }
+        m_synthOffset[ch] = (m_synthOffset[ch] + 1024 - 64) & 1023;
+        const int offset = m_synthOffset[ch];
+        for (int i = 0; i < 64; ++i) {
+            float sum = 0.0f;
+            for (int k = 0; k < kSubbands; ++k) {
+                sum += t.synthCos[i][k] * s[k];
+            }
+            v[(offset + i) & 1023] = sum;
+        }
+        for (int j = 0; j < 32; ++j) {
+            float sum = 0.0f;
+            for (int i = 0; i < 8; ++i) {
+                sum += v[(offset + 128 * i + j) & 1023] * t.synthWindow[64 * i + j];
+                sum += v[(offset + 128 * i + 96 + j) & 1023] * t.synthWindow[64 * i + 32 + j];
+            }
+            *out = sum;
+            out += stride;
+        }
+    }
+}
+
+}  // namespace
+
+bool decode(const uint8_t *data, size_t size, int64_t maxFrames, Pcm &out) {
+    return Decoder(maxFrames, out).run(data, size);
+}
+
+}  // namespace Mp3Decoder
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// In-process MPEG audio Layer III decoding (MPEG-1, MPEG-2 and MPEG-2.5) for sample loading.
+// Floating point throughout, with direct-form transforms that favour clarity over speed: fine
+// on the render pool, not meant for the audio thread. LAME/Xing gapless headers are honoured,
+// so a loop encoded with LAME comes back at its original length.
+namespace Mp3Decoder {
+
+struct Pcm {
+    // Interleaved; mono streams stay mono.
+    std::vector<float> samples;
+    int channels = 0;
+    int sampleRate = 0;
+};
+
+// Decodes the stream in data[0, size), which starts after any ID3v2 tag. maxFrames > 0 stops
+// after that many frames. Returns false when the stream has no Layer III frame with a fixed
+// bitrate; Layer I/II and free-format files are left to ffmpeg.
+bool decode(const uint8_t *data, size_t size, int64_t maxFrames, Pcm &out);
+
+}  // namespace Mp3Decoder
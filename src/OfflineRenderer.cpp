@@ -0,0 +1,43 @@
+#include "OfflineRenderer.h"
+
+#include <QFile>
+#include <algorithm>
+#include <vector>
+
+#include "WavStreamWriter.h"
+
+namespace {
+constexpr int kRenderBlockFrames = 1024;
+}  // namespace
+
+OfflineRenderer::OfflineRenderer(std::unique_ptr<AudioEngine> engine, qint64 totalFrames)
+    : m_engine(std::move(engine)), m_totalFrames(totalFrames) {}
+
+bool OfflineRenderer::render(const QString &path, int targetRate) {
+    bool ok = false;
+    WavStreamWriter writer;
+    const int channels = m_engine ? m_engine->channels() : 2;
+    if (m_engine && m_totalFrames > 0 &&
+        writer.open(path, m_engine->sampleRate(), targetRate, channels)) {
+        std::vector<float> block(static_cast<size_t>(kRenderBlockFrames * channels), 0.0f);
+        qint64 pos = 0;
+        ok = true;
+        while (ok && pos < m_totalFrames && !cancelled()) {
+            const int frames = static_cast<int>(std::min<qint64>(kRenderBlockFrames,
+                                                                 m_totalFrames - pos));
+            m_engine->renderOffline(block.data(), frames);
+            ok = writer.write(block.data(), frames);
+            pos += frames;
+            m_progress.store(static_cast<float>(pos) / static_cast<float>(m_totalFrames),
+                             std::memory_order_relaxed);
+        }
+        ok = writer.close() && ok;
+        if (cancelled()) {
+            ok = false;
+            QFile::remove(path);
+        }
+    }
+    m_ok.store(ok, std::memory_order_release);
+    m_finished.store(true, std::memory_order_release);
+    return ok;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <memory>
+
+#include "AudioEngine.h"
+
+// Runs a device-less AudioEngine for a fixed number of frames and writes the result to a WAV
+// file, as fast as the CPU allows. Whatever the engine plays (usually its own sequencer) ends
+// up in the file. render() blocks, so run it off the UI thread and poll progress() /
+// finished() from there.
+class OfflineRenderer {
+public:
+    OfflineRenderer(std::unique_ptr<AudioEngine> engine, qint64 totalFrames);
+
+    bool render(const QString &path, int targetRate);
+    void cancel() { m_cancel.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return m_cancel.load(std::memory_order_relaxed); }
+    float progress() const { return m_progress.load(std::memory_order_relaxed); }
+    bool finished() const { return m_finished.load(std::memory_order_acquire); }
+    bool succeeded() const { return m_ok.load(std::memory_order_acquire); }
+
+private:
+    std::unique_ptr<AudioEngine> m_engine;
+    qint64 m_totalFrames = 0;
+    std::atomic<bool> m_cancel{false};
+    std::atomic<float> m_progress{0.0f};
+    std::atomic<bool> m_finished{false};
+    std::atomic<bool> m_ok{false};
+};
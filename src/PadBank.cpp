@@ -1,6 +1,12 @@
 #include "PadBank.h"
 
 #include "AudioEngine.h"
+#include "MidiInput.h"
+#include "RtScheduling.h"
+#include "SampleCache.h"
+#include "SampleDecoder.h"
+#include "SampleStream.h"
+#include "TimeStretch.h"
 
 #include <QAudioOutput>
 #include <QCoreApplication>
@@ -18,6 +24,7 @@
 #include <QStandardPaths>
 #include <QStringList>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrl>
 #include <QSet>
@@ -25,14 +32,23 @@
 #include <QtMath>
 #include <QDirIterator>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
+#include <functional>
+#include <list>
 #include <mutex>
 
 #include "dx7_core.h"
 
 namespace {
 constexpr int kPadCount = 8;
+// Samples at least this long play from disk instead of being decoded into memory.
+constexpr int kDefaultStreamMinSec = 20;
+// Above the mix workers, so a key press is never queued behind a mix.
+constexpr int kMidiPriority = 75;
+// Memory kept for pitch/stretch renders other than the ones pads currently use.
+constexpr int kDefaultRenderCacheMb = 256;
 constexpr int kSliceCounts[] = {1, 4, 8, 16};
 constexpr const char *kStretchLabels[] = {
     "OFF",
@@ -54,6 +70,18 @@ constexpr const char *kFxBusLabels[] = {
 
 QString defaultMiniDexedType();
 
+qint64 streamMinMs() {
+    bool ok = false;
+    const int env = qEnvironmentVariableIntValue("GROOVEBOX_STREAM_MIN_SEC", &ok);
+    return (ok && env > 0 ? env : kDefaultStreamMinSec) * 1000LL;
+}
+
+size_t renderCacheBudget() {
+    bool ok = false;
+    const int env = qEnvironmentVariableIntValue("GROOVEBOX_RENDER_CACHE_MB", &ok);
+    return static_cast<size_t>(ok && env >= 0 ? env : kDefaultRenderCacheMb) * 1024 * 1024;
+}
+
 QString canonicalType(const QString &name) {
     QString upper = name.trimmed().toUpper();
     upper.remove(' ');
@@ -1113,22 +1141,6 @@ QString buildAudioFilter(const PadBank::PadParams &params, double tempoFactor, d
     return filters.join(',');
 }
 
-QString buildRenderFilter(double tempoFactor, double pitchRate) {
-    QStringList filters;
-    const bool pitchActive = !isNear(pitchRate, 1.0);
-    if (pitchActive) {
-        filters << QString("asetrate=sample_rate*%1").arg(pitchRate, 0, 'f', 4);
-        filters << "aresample=sample_rate";
-    }
-
-    double atempoFactor = tempoFactor;
-    if (pitchActive) {
-        atempoFactor = tempoFactor / pitchRate;
-    }
-    filters.append(buildAtempoFilters(atempoFactor));
-    return filters.join(',');
-}
-
 }  // namespace
 
 static AudioEngine::FmParams buildFmParams(const PadBank::SynthParams &sp);
@@ -1155,6 +1167,68 @@ struct RenderSignature {
 
 static RenderSignature makeSignature(const QString &path, const PadBank::PadParams &params, int bpm);
 
+// Finished pitch/stretch renders by signature, least recently used first out, so returning a
+// pad to a setting it had before skips the render. An entry only counts for the raw decode it
+// was rendered from; once that decode is gone the entry is dropped. The budget comes from
+// GROOVEBOX_RENDER_CACHE_MB (default 256); 0 disables the cache.
+struct PadBank::RenderCache {
+    struct Entry {
+        RenderSignature sig;
+        std::weak_ptr<const AudioEngine::Buffer> source;
+        std::shared_ptr<const AudioEngine::Buffer> buffer;
+    };
+
+    size_t budget = renderCacheBudget();
+    size_t bytes = 0;
+    // Most recently used at the front.
+    std::list<Entry> entries;
+
+    std::shared_ptr<const AudioEngine::Buffer> find(
+        const RenderSignature &sig, const std::shared_ptr<const AudioEngine::Buffer> &source) {
+        prune();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->sig == sig && it->source.lock() == source) {
+                entries.splice(entries.begin(), entries, it);
+                return it->buffer;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(const RenderSignature &sig,
+                const std::shared_ptr<const AudioEngine::Buffer> &source,
+                const std::shared_ptr<const AudioEngine::Buffer> &buffer) {
+        if (!buffer || buffer->bytes() > budget) {
+            return;
+        }
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->sig == sig) {
+                bytes -= it->buffer->bytes();
+                entries.erase(it);
+                break;
+            }
+        }
+        entries.push_front(Entry{sig, source, buffer});
+        bytes += buffer->bytes();
+        prune();
+        while (bytes > budget && !entries.empty()) {
+            bytes -= entries.back().buffer->bytes();
+            entries.pop_back();
+        }
+    }
+
+    void prune() {
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->source.expired()) {
+                bytes -= it->buffer->bytes();
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
 struct PadBank::PadRuntime {
     QMediaPlayer *player = nullptr;
     QAudioOutput *output = nullptr;
@@ -1171,17 +1245,16 @@ struct PadBank::PadRuntime {
     QString effectPath;
     bool effectReady = false;
 
-    std::shared_ptr<AudioEngine::Buffer> rawBuffer;
-    std::shared_ptr<AudioEngine::Buffer> processedBuffer;
+    std::shared_ptr<const AudioEngine::Buffer> rawBuffer;
+    std::shared_ptr<const AudioEngine::Buffer> processedBuffer;
+    // Long samples stream from disk; rawBuffer then holds only the stream's head.
+    std::shared_ptr<const SampleStream> rawStream;
     QString rawPath;
     qint64 rawDurationMs = 0;
 
-    QProcess *renderProcess = nullptr;
-    QByteArray renderBytes;
-    QByteArray renderInput;
-    bool renderProcessed = false;
-    RenderSignature renderSignature;
-    int renderSampleRate = 0;
+    // Path being decoded into rawBuffer, empty when idle.
+    QString decodingPath;
+    std::shared_ptr<std::atomic<bool>> stretchCancel;
     RenderSignature processedSignature;
     bool processedReady = false;
     bool pendingProcessed = false;
@@ -1193,6 +1266,7 @@ struct PadBank::PadRuntime {
 
 PadBank::PadBank(QObject *parent) : QObject(parent) {
     m_paths.fill(QString());
+    m_renderCache = std::make_unique<RenderCache>();
     m_engine = std::make_unique<AudioEngine>(this);
     m_engineAvailable = m_engine && m_engine->isAvailable();
     if (m_engineAvailable) {
@@ -1205,7 +1279,6 @@ PadBank::PadBank(QObject *parent) : QObject(parent) {
         }
         m_engine->setBpm(m_bpm);
     }
-    m_ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
 
     bool forceExternal = false;
 #ifdef Q_OS_LINUX
@@ -1298,10 +1371,46 @@ PadBank::PadBank(QObject *parent) : QObject(parent) {
             m_engine->setPadAdsr(i, 0.0f, 0.0f, 1.0f, 0.0f);
         }
     }
+    if (m_engineAvailable && m_engine &&
+        qEnvironmentVariable("GROOVEBOX_VOICE_STEAL").compare(QStringLiteral("quietest"),
+                                                              Qt::CaseInsensitive) == 0) {
+        m_engine->setVoiceSteal(AudioEngine::VoiceSteal::Quietest);
+    }
 
+    // MIDI: the pad channel (10 by default) triggers pads from GROOVEBOX_MIDI_PAD_NOTE up,
+    // other channels play the active pad chromatically, and eight CCs from
+    // GROOVEBOX_MIDI_MACRO_CC move its macros. GROOVEBOX_MIDI=0 turns input off.
+    if (m_engineAvailable && m_engine && qEnvironmentVariable("GROOVEBOX_MIDI") != "0") {
+        bool ok = false;
+        const int channel = qEnvironmentVariableIntValue("GROOVEBOX_MIDI_PAD_CHANNEL", &ok);
+        if (ok && channel >= 1 && channel <= 16) {
+            m_midiPadChannel = channel - 1;
+        }
+        const int note = qEnvironmentVariableIntValue("GROOVEBOX_MIDI_PAD_NOTE", &ok);
+        if (ok && note >= 0 && note + kPadCount <= 128) {
+            m_midiPadNote = note;
+        }
+        const int cc = qEnvironmentVariableIntValue("GROOVEBOX_MIDI_MACRO_CC", &ok);
+        if (ok && cc >= 0 && cc + 8 <= 128) {
+            m_midiMacroCc = cc;
+        }
+        connect(this, &PadBank::padChanged, this, &PadBank::refreshMidiTrigger);
+        connect(this, &PadBank::padParamsChanged, this, &PadBank::refreshMidiTrigger);
+        connect(this, &PadBank::engineBufferChanged, this, &PadBank::refreshMidiTrigger);
+        connect(this, &PadBank::activePadChanged, this,
+                [this](int index) { m_midiActivePad.store(index); });
+        connect(this, &PadBank::bpmChanged, this, [this](int) {
+            for (int i = 0; i < kPadCount; ++i) {
+                refreshMidiTrigger(i);
+            }
+        });
+        m_midi.start([this](const MidiInput::Event &event) { handleMidi(event); },
+                     RtScheduling::config().priority > 0 ? kMidiPriority : 0);
+    }
 }
 
 PadBank::~PadBank() {
+    m_midi.stop();
     for (int i = 0; i < kPadCount; ++i) {
         PadRuntime *rt = m_runtime[i];
         if (!rt) {
@@ -1311,18 +1420,16 @@ PadBank::~PadBank() {
             rt->external->kill();
             rt->external->deleteLater();
         }
-        if (rt->renderProcess) {
-            rt->renderProcess->kill();
-            rt->renderProcess->deleteLater();
+        if (rt->stretchCancel) {
+            rt->stretchCancel->store(true);
         }
+    }
+    m_renderPool.waitForDone();
+    for (int i = 0; i < kPadCount; ++i) {
+        PadRuntime *rt = m_runtime[i];
         delete rt;
         m_runtime[i] = nullptr;
     }
-    if (m_previewProcess) {
-        m_previewProcess->kill();
-        m_previewProcess->deleteLater();
-        m_previewProcess = nullptr;
-    }
 }
 
 void PadBank::setActivePad(int index) {
@@ -1355,6 +1462,7 @@ void PadBank::setPadPath(int index, const QString &path) {
     PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
     if (rt) {
         rt->rawBuffer.reset();
+        rt->rawStream.reset();
         rt->processedBuffer.reset();
         rt->processedReady = false;
         rt->pendingProcessed = false;
@@ -1412,6 +1520,9 @@ void PadBank::copyPad(int from, int to) {
             scheduleRawRender(to);
         }
     }
+    if (m_engineAvailable && m_engine) {
+        m_engine->setPadVoicing(to, srcParams.polyphony, srcParams.chokeGroup);
+    }
     emit padChanged(to);
     emit padParamsChanged(to);
 }
@@ -1467,8 +1578,8 @@ QString PadBank::synthId(int index) const {
     return m_synthNames[static_cast<size_t>(index)];
 }
 
-static std::shared_ptr<AudioEngine::Buffer> buildSynthBuffer(const QString &name, int sampleRate,
-                                                            int baseMidi, const PadBank::SynthParams &params) {
+static std::shared_ptr<const AudioEngine::Buffer> buildSynthBuffer(
+    const QString &name, int sampleRate, int baseMidi, const PadBank::SynthParams &params) {
     const QString preset = synthPresetFromName(name);
 
     const QStringList waves = {"SINE", "SAW", "SQUARE", "TRI", "NOISE"};
@@ -1488,10 +1599,11 @@ static std::shared_ptr<AudioEngine::Buffer> buildSynthBuffer(const QString &name
     }
 
     const int frames = sampleRate * 2;
-    auto buffer = std::make_shared<AudioEngine::Buffer>();
-    buffer->channels = 2;
-    buffer->sampleRate = sampleRate;
-    buffer->samples.resize(frames * 2);
+    auto buffer = SampleBuffer::create(frames, 1, sampleRate);
+    if (!buffer) {
+        return nullptr;
+    }
+    float *out = buffer->writableFloat();
 
     const int voices = qBound(1, params.voices, 8);
     const float detune = qBound(0.0f, params.detune, 0.9f);
@@ -1528,9 +1640,7 @@ static std::shared_ptr<AudioEngine::Buffer> buildSynthBuffer(const QString &name
             }
             sum += vout;
         }
-        float v = sum / static_cast<float>(voices);
-        buffer->samples[i * 2] = v;
-        buffer->samples[i * 2 + 1] = v;
+        out[i] = sum / static_cast<float>(voices);
     }
 
     return buffer;
@@ -1542,13 +1652,14 @@ void PadBank::rebuildSynthRuntime(PadRuntime *rt, const QString &name, int sampl
         return;
     }
     rt->rawBuffer = buildSynthBuffer(name, sampleRate, baseMidi, params);
+    rt->rawStream.reset();
     rt->processedBuffer = rt->rawBuffer;
     rt->processedReady = true;
     rt->pendingProcessed = false;
     rt->rawPath = QString("synth:%1").arg(name);
     if (rt->rawBuffer && rt->rawBuffer->isValid()) {
         rt->rawDurationMs =
-            static_cast<qint64>((rt->rawBuffer->frames() * 1000) / rt->rawBuffer->sampleRate);
+            static_cast<qint64>((rt->rawBuffer->frames() * 1000) / rt->rawBuffer->sampleRate());
     } else {
         rt->rawDurationMs = 1000;
     }
@@ -1611,6 +1722,7 @@ void PadBank::setSynth(int index, const QString &name) {
         PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
         if (rt) {
             rt->rawBuffer.reset();
+            rt->rawStream.reset();
             rt->processedBuffer.reset();
             rt->processedReady = false;
             rt->pendingProcessed = false;
@@ -1688,6 +1800,7 @@ void PadBank::setSynth(int index, const QString &name) {
     if (rt) {
         if (isMiniDexedType(type)) {
             rt->rawBuffer.reset();
+            rt->rawStream.reset();
             rt->processedBuffer.reset();
             rt->processedReady = false;
             rt->pendingProcessed = false;
@@ -1856,20 +1969,39 @@ void PadBank::setLoop(int index, bool loop) {
     emit padParamsChanged(index);
 }
 
+void PadBank::setPolyphony(int index, int voices) {
+    if (index < 0 || index >= padCount()) {
+        return;
+    }
+    PadParams &pp = m_params[static_cast<size_t>(index)];
+    pp.polyphony = qBound(1, voices, AudioEngine::kMaxPolyphony);
+    if (m_engineAvailable && m_engine) {
+        m_engine->setPadVoicing(index, pp.polyphony, pp.chokeGroup);
+    }
+    emit padParamsChanged(index);
+}
+
+void PadBank::setChokeGroup(int index, int group) {
+    if (index < 0 || index >= padCount()) {
+        return;
+    }
+    PadParams &pp = m_params[static_cast<size_t>(index)];
+    pp.chokeGroup = qBound(0, group, AudioEngine::kChokeGroups);
+    if (m_engineAvailable && m_engine) {
+        m_engine->setPadVoicing(index, pp.polyphony, pp.chokeGroup);
+    }
+    emit padParamsChanged(index);
+}
+
 void PadBank::setNormalize(int index, bool enabled) {
     if (index < 0 || index >= padCount()) {
         return;
     }
     m_params[static_cast<size_t>(index)].normalize = enabled;
     PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-    if (rt && rt->rawBuffer && rt->rawBuffer->isValid()) {
-        float peak = 0.0f;
-        for (float v : rt->rawBuffer->samples) {
-            const float a = std::fabs(v);
-            if (a > peak) {
-                peak = a;
-            }
-        }
+    // A streamed pad's gain comes from the scan of the whole file in scheduleRawRender().
+    if (rt && rt->rawBuffer && rt->rawBuffer->isValid() && !rt->rawStream) {
+        const float peak = rt->rawBuffer->peak();
         if (peak > 0.0001f) {
             rt->normalizeGain = qBound(0.5f, 1.0f / peak, 2.5f);
         } else {
@@ -2414,7 +2546,7 @@ float PadBank::padPlayhead(int index) const {
     return -1.0f;
 }
 
-std::shared_ptr<AudioEngine::Buffer> PadBank::rawBuffer(int index) const {
+std::shared_ptr<const AudioEngine::Buffer> PadBank::rawBuffer(int index) const {
     if (index < 0 || index >= padCount()) {
         return nullptr;
     }
@@ -2550,35 +2682,8 @@ static qint64 stretchTargetMs(int bpm, int stretchIndex) {
 }
 
 static qint64 probeDurationMs(const QString &path) {
-#ifdef Q_OS_LINUX
-    const QString ffprobe = QStandardPaths::findExecutable("ffprobe");
-    if (ffprobe.isEmpty()) {
-        return 0;
-    }
-
-    QProcess proc;
-    proc.setProgram(ffprobe);
-    proc.setArguments({"-v", "error",
-                       "-show_entries", "format=duration",
-                       "-of", "default=noprint_wrappers=1:nokey=1",
-                       path});
-    proc.start();
-    if (!proc.waitForFinished(700)) {
-        proc.kill();
-        return 0;
-    }
-
-    const QString out = QString::fromUtf8(proc.readAllStandardOutput()).trimmed();
-    bool ok = false;
-    const double seconds = out.toDouble(&ok);
-    if (!ok || seconds <= 0.0) {
-        return 0;
-    }
-    return static_cast<qint64>(seconds * 1000.0);
-#else
-    Q_UNUSED(path);
-    return 0;
-#endif
+    SampleDecoder::Info info;
+    return SampleDecoder::probe(path, &info) ? info.durationMs : 0;
 }
 
 static RenderSignature makeSignature(const QString &path, const PadBank::PadParams &params, int bpm) {
@@ -2597,73 +2702,6 @@ static RenderSignature makeSignature(const QString &path, const PadBank::PadPara
     return sig;
 }
 
-static std::shared_ptr<AudioEngine::Buffer> decodePcm16(const QByteArray &bytes, int sampleRate,
-                                                        int channels) {
-    if (bytes.isEmpty() || channels <= 0 || sampleRate <= 0) {
-        return nullptr;
-    }
-    const int sampleCount = bytes.size() / static_cast<int>(sizeof(int16_t));
-    if (sampleCount <= 0) {
-        return nullptr;
-    }
-    auto buffer = std::make_shared<AudioEngine::Buffer>();
-    buffer->channels = channels;
-    buffer->sampleRate = sampleRate;
-    buffer->samples.resize(sampleCount);
-    const int16_t *src = reinterpret_cast<const int16_t *>(bytes.constData());
-    for (int i = 0; i < sampleCount; ++i) {
-        buffer->samples[i] = static_cast<float>(src[i]) / 32768.0f;
-    }
-    return buffer;
-}
-
-static QStringList buildFfmpegArgs(const QString &path, const QString &filter, int sampleRate,
-                                   int channels) {
-    QStringList args = {"-v", "error", "-i", path, "-vn"};
-    if (!filter.isEmpty()) {
-        args << "-af" << filter;
-    }
-    args << "-ac" << QString::number(qMax(1, channels));
-    args << "-ar" << QString::number(qMax(8000, sampleRate));
-    args << "-f" << "s16le" << "-";
-    return args;
-}
-
-static QStringList buildFfmpegArgsSegment(const QString &path, const QString &filter, int sampleRate,
-                                          int channels, qint64 startMs, qint64 durationMs) {
-    QStringList args = {"-v", "error"};
-    if (startMs > 0) {
-        args << "-ss" << QString::number(static_cast<double>(startMs) / 1000.0, 'f', 3);
-    }
-    if (durationMs > 0) {
-        args << "-t" << QString::number(static_cast<double>(durationMs) / 1000.0, 'f', 3);
-    }
-    args << "-i" << path << "-vn";
-    if (!filter.isEmpty()) {
-        args << "-af" << filter;
-    }
-    args << "-ac" << QString::number(qMax(1, channels));
-    args << "-ar" << QString::number(qMax(8000, sampleRate));
-    args << "-f" << "s16le" << "-";
-    return args;
-}
-
-static QStringList buildFfmpegArgsRaw(const QString &filter, int sampleRate, int channels) {
-    QStringList args = {"-v", "error",
-                        "-f", "f32le",
-                        "-ac", QString::number(qMax(1, channels)),
-                        "-ar", QString::number(qMax(8000, sampleRate)),
-                        "-i", "-",
-                        "-vn"};
-    if (!filter.isEmpty()) {
-        args << "-af" << filter;
-    }
-    args << "-ac" << QString::number(qMax(1, channels));
-    args << "-ar" << QString::number(qMax(8000, sampleRate));
-    args << "-f" << "s16le" << "-";
-    return args;
-}
-
 bool PadBank::needsProcessing(const PadParams &params) const {
     return params.stretchIndex > 0 && params.stretchMode > 0;
 }
@@ -2683,80 +2721,66 @@ void PadBank::scheduleRawRender(int index) {
     if (path.isEmpty()) {
         return;
     }
-    if (rt->rawPath == path && rt->rawBuffer && rt->rawBuffer->isValid()) {
-        if (needsProcessing(m_params[static_cast<size_t>(index)])) {
+    // Stretching needs the whole take in memory, not just a stream's head.
+    const bool allowStream = !needsProcessing(m_params[static_cast<size_t>(index)]);
+    if (rt->rawPath == path && rt->rawBuffer && rt->rawBuffer->isValid() &&
+        (allowStream || !rt->rawStream)) {
+        if (!allowStream) {
             scheduleProcessedRender(index);
         }
         return;
     }
-    if (m_ffmpegPath.isEmpty()) {
+    if (rt->decodingPath == path) {
         return;
     }
 
-    if (rt->renderProcess) {
-        rt->renderProcess->kill();
-        rt->renderProcess->deleteLater();
-        rt->renderProcess = nullptr;
+    if (rt->stretchCancel) {
+        rt->stretchCancel->store(true);
+        rt->stretchCancel.reset();
     }
 
-    rt->renderBytes.clear();
-    rt->renderProcessed = false;
-    rt->renderSignature = RenderSignature();
-    rt->renderSignature.path = path;
+    rt->decodingPath = path;
     rt->pendingProcessed = false;
     const int jobId = ++m_renderSerial;
     rt->renderJobId = jobId;
+    const int sampleRate = m_engineRate;
 
-    QProcess *proc = new QProcess(this);
-    rt->renderProcess = proc;
-    proc->setProgram(m_ffmpegPath);
-    proc->setArguments(buildFfmpegArgs(path, QString(), m_engineRate, 2));
-    proc->setProcessChannelMode(QProcess::SeparateChannels);
-
-    connect(proc, &QProcess::readyReadStandardOutput, this, [this, index, jobId]() {
-        PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-        if (!rt || rt->renderJobId != jobId || !rt->renderProcess) {
-            return;
+    m_renderPool.start([this, index, jobId, path, sampleRate, allowStream]() {
+        std::shared_ptr<const SampleStream> stream;
+        SampleDecoder::Info info;
+        if (allowStream && SampleDecoder::probe(path, &info) &&
+            info.durationMs >= streamMinMs()) {
+            stream = SampleStream::open(path, sampleRate);
         }
-        rt->renderBytes.append(rt->renderProcess->readAllStandardOutput());
-    });
-    connect(proc, &QProcess::errorOccurred, this, [this, index, jobId](QProcess::ProcessError) {
-        PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-        if (!rt || rt->renderJobId != jobId) {
-            return;
-        }
-        if (rt->renderProcess) {
-            rt->renderProcess->deleteLater();
-            rt->renderProcess = nullptr;
+        float peak = 0.0f;
+        std::shared_ptr<const AudioEngine::Buffer> buffer;
+        if (stream) {
+            buffer = stream->head();
+        } else {
+            buffer = SampleCache::load(path, sampleRate, &peak);
+            if (!buffer) {
+                buffer = SampleDecoder::decode(path, sampleRate);
+                if (buffer) {
+                    peak = buffer->peak();
+                    SampleCache::store(path, *buffer, peak);
+                }
+            }
         }
-    });
-    connect(proc,
-            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
-            [this, index, jobId](int, QProcess::ExitStatus) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, index, jobId, path, buffer, stream, peak]() {
                 PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
                 if (!rt || rt->renderJobId != jobId) {
                     return;
                 }
-                if (rt->renderProcess) {
-                    rt->renderProcess->deleteLater();
-                    rt->renderProcess = nullptr;
-                }
-                const QByteArray bytes = rt->renderBytes;
-                rt->renderBytes.clear();
-                auto buffer = decodePcm16(bytes, m_engineRate, 2);
+                rt->decodingPath.clear();
                 if (buffer && buffer->isValid()) {
+                    const int frames = stream ? stream->frames() : buffer->frames();
                     rt->rawBuffer = buffer;
-                    rt->rawPath = rt->renderSignature.path;
-                    rt->rawDurationMs =
-                        (buffer->frames() * 1000LL) / qMax(1, buffer->sampleRate);
+                    rt->rawStream = stream;
+                    rt->rawPath = path;
+                    rt->rawDurationMs = (frames * 1000LL) / qMax(1, buffer->sampleRate());
                     rt->durationMs = rt->rawDurationMs;
-                    float peak = 0.0f;
-                    for (float v : buffer->samples) {
-                        const float a = std::fabs(v);
-                        if (a > peak) {
-                            peak = a;
-                        }
-                    }
                     if (peak > 0.0001f) {
                         rt->normalizeGain = qBound(0.5f, 1.0f / peak, 2.5f);
                     } else {
@@ -2769,12 +2793,27 @@ void PadBank::scheduleRawRender(int index) {
                     rt->pendingTrigger = false;
                     triggerPad(index);
                 }
-            });
-
-    proc->start();
+                emit engineBufferChanged(index);
+            },
+            Qt::QueuedConnection);
+        if (!stream) {
+            return;
+        }
+        // Normalizing needs the peak of the whole file; the pad already plays meanwhile.
+        const float streamPeak = stream->scanPeak();
+        QMetaObject::invokeMethod(
+            this,
+            [this, index, jobId, streamPeak]() {
+                PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
+                if (rt && rt->renderJobId == jobId && rt->rawStream && streamPeak > 0.0001f) {
+                    rt->normalizeGain = qBound(0.5f, 1.0f / streamPeak, 2.5f);
+                }
+            },
+            Qt::QueuedConnection);
+    });
 }
 
-void PadBank::scheduleProcessedRender(int index) {
+void PadBank::scheduleProcessedRender(int index, int priority) {
     if (!m_engineAvailable) {
         return;
     }
@@ -2792,20 +2831,16 @@ void PadBank::scheduleProcessedRender(int index) {
     }
     const PadParams params = m_params[static_cast<size_t>(index)];
     if (!needsProcessing(params)) {
-        if (rt->renderProcess) {
-            rt->renderProcess->kill();
-            rt->renderProcess->deleteLater();
-            rt->renderProcess = nullptr;
+        if (rt->stretchCancel) {
+            rt->stretchCancel->store(true);
+            rt->stretchCancel.reset();
         }
         rt->processedBuffer.reset();
         rt->processedReady = false;
         return;
     }
-    if (m_ffmpegPath.isEmpty()) {
-        return;
-    }
 
-    if (!rt->rawBuffer || !rt->rawBuffer->isValid() || rt->rawPath != path) {
+    if (!rt->rawBuffer || !rt->rawBuffer->isValid() || rt->rawPath != path || rt->rawStream) {
         rt->pendingProcessed = true;
         scheduleRawRender(index);
         return;
@@ -2816,10 +2851,9 @@ void PadBank::scheduleProcessedRender(int index) {
         return;
     }
 
-    if (rt->renderProcess) {
-        rt->renderProcess->kill();
-        rt->renderProcess->deleteLater();
-        rt->renderProcess = nullptr;
+    if (rt->stretchCancel) {
+        rt->stretchCancel->store(true);
+        rt->stretchCancel.reset();
     }
 
     double tempoFactor = 1.0;
@@ -2851,121 +2885,192 @@ void PadBank::scheduleProcessedRender(int index) {
     tempoFactor = qBound(0.25, tempoFactor, 4.0);
 
     const double pitchRate = pitchToRate(params.pitch);
-    const QString filter = buildRenderFilter(tempoFactor, pitchRate);
-    if (filter.isEmpty()) {
+    if (isNear(tempoFactor, 1.0) && isNear(pitchRate, 1.0)) {
         rt->processedBuffer = rt->rawBuffer;
         rt->processedSignature = sig;
         rt->processedReady = true;
+        emit engineBufferChanged(index);
+        return;
+    }
+
+    const std::shared_ptr<const AudioEngine::Buffer> raw = rt->rawBuffer;
+    if (std::shared_ptr<const AudioEngine::Buffer> cached = m_renderCache->find(sig, raw)) {
+        rt->processedBuffer = std::move(cached);
+        rt->processedSignature = sig;
+        rt->processedReady = true;
+        emit engineBufferChanged(index);
         return;
     }
+    const int totalFrames = raw->frames();
+    const int sampleRate = raw->sampleRate();
+    int startFrame = static_cast<int>((renderStartMs * sampleRate) / 1000);
+    int endFrame = totalFrames;
+    if (renderDurationMs > 0) {
+        endFrame = startFrame + static_cast<int>((renderDurationMs * sampleRate) / 1000);
+    }
+    startFrame = qBound(0, startFrame, qMax(0, totalFrames - 1));
+    endFrame = qBound(startFrame + 1, endFrame, totalFrames);
 
-    rt->renderBytes.clear();
-    rt->renderInput.clear();
-    rt->renderProcessed = true;
-    rt->renderSignature = sig;
     rt->pendingProcessed = false;
     rt->processedReady = false;
     const int jobId = ++m_renderSerial;
     rt->renderJobId = jobId;
-
-    QProcess *proc = new QProcess(this);
-    rt->renderProcess = proc;
-    proc->setProgram(m_ffmpegPath);
-
-    bool useRawInput = false;
-    int renderSampleRate = m_engineRate;
-    if (rt->rawBuffer && rt->rawBuffer->isValid()) {
-        const int totalFrames = rt->rawBuffer->frames();
-        const int sampleRate = rt->rawBuffer->sampleRate;
-        const int channels = rt->rawBuffer->channels;
-        int startFrame = 0;
-        int endFrame = totalFrames;
-        if (renderStartMs > 0) {
-            startFrame = static_cast<int>((renderStartMs * sampleRate) / 1000);
-        }
-        if (renderDurationMs > 0) {
-            endFrame = startFrame + static_cast<int>((renderDurationMs * sampleRate) / 1000);
-        }
-        startFrame = qBound(0, startFrame, totalFrames);
-        endFrame = qBound(startFrame + 1, endFrame, totalFrames);
-        const int frames = qMax(0, endFrame - startFrame);
-        if (frames > 0 && channels > 0) {
-            rt->renderInput.resize(frames * channels * static_cast<int>(sizeof(float)));
-            float *dst = reinterpret_cast<float *>(rt->renderInput.data());
-            const int offset = startFrame * channels;
-            const int count = frames * channels;
-            for (int i = 0; i < count; ++i) {
-                dst[i] = rt->rawBuffer->samples[offset + i];
-            }
-            proc->setArguments(buildFfmpegArgsRaw(filter, sampleRate, channels));
-            renderSampleRate = sampleRate;
-            useRawInput = true;
-        }
-    }
-    if (!useRawInput) {
-        proc->setArguments(
-            buildFfmpegArgsSegment(path, filter, m_engineRate, 2, renderStartMs, renderDurationMs));
-    }
-    rt->renderSampleRate = renderSampleRate;
-    proc->setProcessChannelMode(QProcess::SeparateChannels);
-
-    if (useRawInput) {
-        connect(proc, &QProcess::started, this, [this, index, jobId]() {
-            PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-            if (!rt || rt->renderJobId != jobId || !rt->renderProcess) {
-                return;
-            }
-            if (!rt->renderInput.isEmpty()) {
-                rt->renderProcess->write(rt->renderInput);
-                rt->renderProcess->closeWriteChannel();
-            }
-        });
-    }
-
-    connect(proc, &QProcess::readyReadStandardOutput, this, [this, index, jobId]() {
-        PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-        if (!rt || rt->renderJobId != jobId || !rt->renderProcess) {
-            return;
-        }
-        rt->renderBytes.append(rt->renderProcess->readAllStandardOutput());
-    });
-    connect(proc, &QProcess::errorOccurred, this, [this, index, jobId](QProcess::ProcessError) {
-        PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
-        if (!rt || rt->renderJobId != jobId) {
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    rt->stretchCancel = cancel;
+
+    m_renderPool.start([this, index, jobId, sig, raw, cancel, startFrame, endFrame, tempoFactor,
+                        pitchRate]() {
+        std::shared_ptr<const AudioEngine::Buffer> buffer =
+            TimeStretch::render(*raw, startFrame, endFrame, tempoFactor, pitchRate, cancel.get());
+        if (cancel->load()) {
             return;
         }
-        if (rt->renderProcess) {
-            rt->renderProcess->deleteLater();
-            rt->renderProcess = nullptr;
-        }
-    });
-    connect(proc,
-            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
-            [this, index, jobId](int, QProcess::ExitStatus) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, index, jobId, sig, raw, buffer]() {
                 PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
                 if (!rt || rt->renderJobId != jobId) {
                     return;
                 }
-                if (rt->renderProcess) {
-                    rt->renderProcess->deleteLater();
-                    rt->renderProcess = nullptr;
-                }
-                const QByteArray bytes = rt->renderBytes;
-                rt->renderBytes.clear();
-                rt->renderInput.clear();
-                auto buffer = decodePcm16(bytes, rt->renderSampleRate, 2);
+                rt->stretchCancel.reset();
                 if (buffer && buffer->isValid()) {
+                    m_renderCache->insert(sig, raw, buffer);
                     rt->processedBuffer = buffer;
-                    rt->processedSignature = rt->renderSignature;
+                    rt->processedSignature = sig;
                     rt->processedReady = true;
                 }
                 if (rt->pendingTrigger) {
                     rt->pendingTrigger = false;
                     triggerPad(index);
                 }
-            });
+                emit engineBufferChanged(index);
+            },
+            Qt::QueuedConnection);
+    }, priority);
+}
+
+bool PadBank::resolveEngineTrigger(int index, EngineTrigger &out, bool *processedStale) const {
+    if (processedStale) {
+        *processedStale = false;
+    }
+    if (index < 0 || index >= padCount()) {
+        return false;
+    }
+    const PadRuntime *rt = m_runtime[static_cast<size_t>(index)];
+    if (!rt) {
+        return false;
+    }
+    const PadParams &params = m_params[static_cast<size_t>(index)];
+    out = EngineTrigger();
+    out.volume = params.volume;
+    out.pan = params.pan;
+    out.bus = params.fxBus;
+
+    if (isSynth(index)) {
+        const SynthParams &sp = m_synthParams[static_cast<size_t>(index)];
+        const bool isDx7 =
+            isMiniDexedType(synthTypeFromName(m_synthNames[static_cast<size_t>(index)]));
+        out.synth = true;
+        out.midiNote = m_synthBaseMidi[static_cast<size_t>(index)];
+        const int lengthMs = isDx7
+                                 ? qBound(500, static_cast<int>(3000 + sp.release * 3500.0f), 8000)
+                                 : qBound(80, static_cast<int>(300 + sp.release * 900.0f), 2000);
+        out.lengthFrames = static_cast<int>(static_cast<qint64>(lengthMs) * m_engineRate / 1000);
+        return true;
+    }
 
-    proc->start();
+    const QString path = padPath(index);
+    if (path.isEmpty()) {
+        return false;
+    }
+    std::shared_ptr<const AudioEngine::Buffer> buffer;
+    bool useProcessed = false;
+    if (needsProcessing(params)) {
+        const RenderSignature sig = makeSignature(path, params, m_bpm);
+        if (rt->processedReady && sig == rt->processedSignature) {
+            buffer = rt->processedBuffer;
+            useProcessed = true;
+        } else {
+            buffer = rt->rawBuffer;
+            if (processedStale) {
+                *processedStale = true;
+            }
+        }
+    } else {
+        buffer = rt->rawBuffer;
+    }
+    if (!buffer || !buffer->isValid()) {
+        return false;
+    }
+    const std::shared_ptr<const SampleStream> stream =
+        !useProcessed && buffer == rt->rawBuffer ? rt->rawStream : nullptr;
+
+    float start = clamp01(params.start);
+    float end = clamp01(params.end);
+    if (end <= start) {
+        end = qMin(1.0f, start + 0.01f);
+    }
+
+    const int sliceCount = sliceCountForIndex(params.sliceCountIndex);
+    const int sliceIndex = qBound(0, params.sliceIndex, sliceCount - 1);
+    const float sliceLen = (end - start) / static_cast<float>(sliceCount);
+    const float sliceStart = start + sliceLen * sliceIndex;
+    const float sliceEnd = sliceStart + sliceLen;
+
+    const int totalFrames = stream ? stream->frames() : buffer->frames();
+    int startFrame = static_cast<int>(sliceStart * totalFrames);
+    int endFrame = static_cast<int>(sliceEnd * totalFrames);
+    if (endFrame <= startFrame) {
+        endFrame = qMin(totalFrames, startFrame + 1);
+    }
+
+    if (useProcessed) {
+        startFrame = 0;
+        endFrame = totalFrames;
+    }
+    float tempoFactor = 1.0f;
+    if (!useProcessed && params.stretchIndex > 0) {
+        const int segmentFrames = qMax(1, endFrame - startFrame);
+        const qint64 segmentMs =
+            static_cast<qint64>(segmentFrames * 1000.0 / qMax(1, buffer->sampleRate()));
+        const qint64 targetMs = stretchTargetMs(m_bpm, params.stretchIndex);
+        if (targetMs > 0) {
+            tempoFactor = static_cast<float>(static_cast<double>(segmentMs) /
+                                             static_cast<double>(targetMs));
+        }
+        tempoFactor = qBound(0.25f, tempoFactor, 4.0f);
+    }
+
+    const float normalizeGain = params.normalize ? rt->normalizeGain : 1.0f;
+    out.buffer = buffer;
+    out.stream = stream;
+    out.startFrame = startFrame;
+    out.endFrame = endFrame;
+    out.loop = params.loop;
+    out.rate = useProcessed ? 1.0f : static_cast<float>(pitchToRate(params.pitch)) * tempoFactor;
+    out.volume = params.volume * normalizeGain;
+    return true;
+}
+
+bool PadBank::sequencerTrigger(int index, EngineTrigger &out) {
+    bool processedStale = false;
+    const bool ok = resolveEngineTrigger(index, out, &processedStale);
+    if (ok && !processedStale) {
+        return true;
+    }
+    PadRuntime *rt = (index >= 0 && index < padCount()) ? m_runtime[static_cast<size_t>(index)]
+                                                         : nullptr;
+    // A render already in flight reports back through engineBufferChanged().
+    if (!rt || !rt->decodingPath.isEmpty() || rt->stretchCancel || isSynth(index) ||
+        padPath(index).isEmpty()) {
+        return ok;
+    }
+    if (needsProcessing(m_params[static_cast<size_t>(index)])) {
+        scheduleProcessedRender(index);
+    } else {
+        scheduleRawRender(index);
+    }
+    return ok;
 }
 
 void PadBank::triggerPad(int index) {
@@ -2988,22 +3093,14 @@ void PadBank::triggerPad(int index) {
         if (!m_engineAvailable || !m_engine) {
             return;
         }
-        const SynthParams &sp = m_synthParams[static_cast<size_t>(index)];
-        const int baseMidi = m_synthBaseMidi[static_cast<size_t>(index)];
+        EngineTrigger trig;
+        if (!resolveEngineTrigger(index, trig)) {
+            return;
+        }
         const int velocity = 127;
-        const bool isDx7 =
-            isMiniDexedType(synthTypeFromName(m_synthNames[static_cast<size_t>(index)]));
         m_engine->setSynthEnabled(index, true);
-        m_engine->setSynthParams(index, params.volume, params.pan, params.fxBus);
-        m_engine->synthNoteOn(index, baseMidi, velocity);
-        const int lengthMs = isDx7
-                                 ? qBound(500, static_cast<int>(3000 + sp.release * 3500.0f), 8000)
-                                 : qBound(80, static_cast<int>(300 + sp.release * 900.0f), 2000);
-        QTimer::singleShot(lengthMs, this, [this, index, baseMidi]() {
-            if (m_engine) {
-                m_engine->synthNoteOff(index, baseMidi);
-            }
-        });
+        m_engine->setSynthParams(index, trig.volume, trig.pan, trig.bus);
+        m_engine->synthNoteOn(index, trig.midiNote, velocity, trig.lengthFrames);
         return;
     }
 
@@ -3013,76 +3110,29 @@ void PadBank::triggerPad(int index) {
     const bool stretchHq = stretchEnabled && params.stretchMode > 0;
     const float normalizeGain = (params.normalize && rt) ? rt->normalizeGain : 1.0f;
     if (rt->useEngine && m_engineAvailable && m_engine) {
-        std::shared_ptr<AudioEngine::Buffer> buffer;
-        bool useProcessed = false;
-        if (wantsProcessing) {
-            const RenderSignature sig = makeSignature(path, params, m_bpm);
-            if (rt->processedReady && sig == rt->processedSignature) {
-                buffer = rt->processedBuffer;
-                useProcessed = true;
+        EngineTrigger trig;
+        bool processedStale = false;
+        if (!resolveEngineTrigger(index, trig, &processedStale)) {
+            rt->pendingTrigger = true;
+            if (wantsProcessing) {
+                scheduleProcessedRender(index);
             } else {
-                if (rt->rawBuffer && rt->rawBuffer->isValid()) {
-                    buffer = rt->rawBuffer;
-                    useProcessed = false;
-                    scheduleProcessedRender(index);
-                } else {
-                    rt->pendingTrigger = true;
-                    scheduleProcessedRender(index);
-                    return;
-                }
+                scheduleRawRender(index);
             }
-        } else {
-            buffer = rt->rawBuffer;
-        }
-        if (!buffer || !buffer->isValid()) {
-            rt->pendingTrigger = true;
-            scheduleRawRender(index);
             return;
         }
-        if (buffer && buffer->isValid()) {
-            float start = clamp01(params.start);
-            float end = clamp01(params.end);
-            if (end <= start) {
-                end = qMin(1.0f, start + 0.01f);
-            }
-
-            const int sliceCount = sliceCountForIndex(params.sliceCountIndex);
-            const int sliceIndex = qBound(0, params.sliceIndex, sliceCount - 1);
-            const float sliceLen = (end - start) / static_cast<float>(sliceCount);
-            const float sliceStart = start + sliceLen * sliceIndex;
-            const float sliceEnd = sliceStart + sliceLen;
-
-            const int totalFrames = buffer->frames();
-            int startFrame = static_cast<int>(sliceStart * totalFrames);
-            int endFrame = static_cast<int>(sliceEnd * totalFrames);
-            if (endFrame <= startFrame) {
-                endFrame = qMin(totalFrames, startFrame + 1);
-            }
-
-            if (useProcessed) {
-                startFrame = 0;
-                endFrame = totalFrames;
-            }
-            float tempoFactor = 1.0f;
-            if (!useProcessed && stretchEnabled) {
-                const int segmentFrames = qMax(1, endFrame - startFrame);
-                const qint64 segmentMs =
-                    static_cast<qint64>(segmentFrames * 1000.0 / qMax(1, buffer->sampleRate));
-                const qint64 targetMs = stretchTargetMs(m_bpm, params.stretchIndex);
-                if (targetMs > 0) {
-                    tempoFactor = static_cast<float>(
-                        static_cast<double>(segmentMs) / static_cast<double>(targetMs));
-                }
-                tempoFactor = qBound(0.25f, tempoFactor, 4.0f);
-            }
-
-            const float rate = useProcessed ? 1.0f : static_cast<float>(pitchRate) * tempoFactor;
-            const float volume = params.volume * normalizeGain;
-            m_engine->trigger(index, buffer, startFrame, endFrame, params.loop, volume,
-                              params.pan, rate, params.fxBus);
-            rt->pendingTrigger = false;
-            return;
+        if (processedStale) {
+            scheduleProcessedRender(index);
+        }
+        if (trig.stream) {
+            m_engine->trigger(index, trig.stream, trig.startFrame, trig.endFrame, trig.loop,
+                              trig.volume, trig.pan, trig.rate, trig.bus);
+        } else {
+            m_engine->trigger(index, trig.buffer, trig.startFrame, trig.endFrame, trig.loop,
+                              trig.volume, trig.pan, trig.rate, trig.bus);
         }
+        rt->pendingTrigger = false;
+        return;
     }
 
     const bool needsSlice = (params.sliceCountIndex > 0) || !isNear(params.start, 0.0) ||
@@ -3230,19 +3280,120 @@ void PadBank::triggerPadMidi(int index, int midiNote, int lengthSteps) {
     }
 
     PadParams &params = m_params[static_cast<size_t>(index)];
-    const int bpm = m_bpm;
-    const int stepMs = 60000 / qMax(1, bpm) / 4;
+    const double stepFrames = m_engineRate * 60.0 / qMax(1, m_bpm) / 4.0;
     const int steps = qMax(1, lengthSteps);
-    const int lengthMs = qBound(60, steps * stepMs, 4000);
+    const int lengthFrames = qBound(m_engineRate * 60 / 1000,
+                                    static_cast<int>(std::llround(steps * stepFrames)),
+                                    m_engineRate * 4);
     const int velocity = 127;
     m_engine->setSynthEnabled(index, true);
     m_engine->setSynthParams(index, params.volume, params.pan, params.fxBus);
-    m_engine->synthNoteOn(index, midiNote, velocity);
-    QTimer::singleShot(lengthMs, this, [this, index, midiNote]() {
-        if (m_engine) {
-            m_engine->synthNoteOff(index, midiNote);
+    m_engine->synthNoteOn(index, midiNote, velocity, lengthFrames);
+}
+
+void PadBank::refreshMidiTrigger(int index) {
+    if (index < 0 || index >= padCount()) {
+        return;
+    }
+    EngineTrigger trig;
+    const bool ready = resolveEngineTrigger(index, trig);
+    const bool fm =
+        isSynth(index) && isFmType(synthTypeFromName(m_synthNames[static_cast<size_t>(index)]));
+    std::lock_guard<std::mutex> lock(m_midiMutex);
+    m_midiTriggers[static_cast<size_t>(index)] = std::move(trig);
+    m_midiReady[static_cast<size_t>(index)] = ready;
+    m_midiFm[static_cast<size_t>(index)] = fm;
+}
+
+void PadBank::handleMidi(const MidiInput::Event &event) {
+    // Runs on the MIDI thread: only the engine's midi*() calls and the m_midi* snapshot may be
+    // touched here. What those cannot take is replayed through the locked calls on the GUI
+    // thread, later but never lost.
+    const bool padChannel = event.channel == m_midiPadChannel;
+    const int pad = padChannel ? event.number - m_midiPadNote : m_midiActivePad.load();
+    if (pad < 0 || pad >= kPadCount) {
+        return;
+    }
+    EngineTrigger trig;
+    bool fm = false;
+    {
+        std::lock_guard<std::mutex> lock(m_midiMutex);
+        if (!m_midiReady[static_cast<size_t>(pad)]) {
+            return;
         }
-    });
+        trig = m_midiTriggers[static_cast<size_t>(pad)];
+        fm = m_midiFm[static_cast<size_t>(pad)];
+    }
+    auto replay = [this](std::function<void()> call) {
+        QMetaObject::invokeMethod(this, std::move(call), Qt::QueuedConnection);
+    };
+
+    if (event.type == MidiInput::Event::Type::Control) {
+        const int macro = event.number - m_midiMacroCc;
+        if (padChannel || macro < 0 || macro >= 8 || !trig.synth) {
+            return;
+        }
+        const float value = event.value / 127.0f;
+        if (fm) {
+            m_engine->midiSynthMacro(pad, macro, value);
+        }
+        // The knob on screen follows later, and with it the engine's own copy of the macros;
+        // the sound already has.
+        replay([this, pad, macro, value]() { setSynthMacro(pad, macro, value); });
+        return;
+    }
+
+    const bool noteOn = event.type == MidiInput::Event::Type::NoteOn;
+    if (trig.synth) {
+        // Pad-channel hits are one-shots like a touch; keys hold until released.
+        const int midiNote = padChannel ? trig.midiNote : event.number;
+        if (!noteOn) {
+            if (!padChannel && !m_engine->midiSynthNoteOff(pad, midiNote)) {
+                replay([this, pad, midiNote]() { m_engine->synthNoteOff(pad, midiNote); });
+            }
+            return;
+        }
+        const int velocity = event.value;
+        const int lengthFrames = padChannel ? trig.lengthFrames : 0;
+        if (!m_engine->midiSynthNoteOn(pad, midiNote, velocity, lengthFrames, trig.volume,
+                                       trig.pan, trig.bus)) {
+            // The core is still to be built, which only the locked path does.
+            replay([this, pad, midiNote, velocity, lengthFrames, trig]() {
+                m_engine->setSynthEnabled(pad, true);
+                m_engine->setSynthParams(pad, trig.volume, trig.pan, trig.bus);
+                m_engine->synthNoteOn(pad, midiNote, velocity, lengthFrames);
+            });
+        }
+        return;
+    }
+
+    if (!noteOn) {
+        if (trig.loop && !m_engine->midiStopPad(pad)) {
+            replay([this, pad]() { m_engine->stopPad(pad); });
+        }
+        return;
+    }
+    const float volume = trig.volume * static_cast<float>(event.value) / 127.0f;
+    float rate = trig.rate;
+    if (!padChannel) {
+        rate *= static_cast<float>(std::pow(2.0, (event.number - 60) / 12.0));
+    }
+    if (trig.stream) {
+        if (!m_engine->midiTrigger(pad, trig.stream, trig.startFrame, trig.endFrame,
+                                   trig.loop, volume, trig.pan, rate, trig.bus)) {
+            // First streamed hit: the reader thread is started under the engine lock.
+            replay([this, pad, trig, volume, rate]() {
+                m_engine->trigger(pad, trig.stream, trig.startFrame, trig.endFrame, trig.loop,
+                                  volume, trig.pan, rate, trig.bus);
+            });
+        }
+    } else if (!m_engine->midiTrigger(pad, trig.buffer, trig.startFrame, trig.endFrame,
+                                      trig.loop, volume, trig.pan, rate, trig.bus)) {
+        replay([this, pad, trig, volume, rate]() {
+            m_engine->trigger(pad, trig.buffer, trig.startFrame, trig.endFrame, trig.loop,
+                              volume, trig.pan, rate, trig.bus);
+        });
+    }
 }
 
 void PadBank::stopPad(int index) {
@@ -3291,9 +3442,14 @@ void PadBank::setBpm(int bpm) {
     if (m_engineAvailable && m_engine) {
         m_engine->setBpm(m_bpm);
     }
-    for (int i = 0; i < padCount(); ++i) {
-        if (m_params[static_cast<size_t>(i)].stretchIndex > 0) {
-            scheduleProcessedRender(i);
+    // Re-render every stretched pad now rather than on its next hit, the ones the sequencer is
+    // playing first; until each lands, its pad plays the raw sample at a stretched rate.
+    for (const bool inPattern : {true, false}) {
+        for (int i = 0; i < padCount(); ++i) {
+            if (m_params[static_cast<size_t>(i)].stretchIndex > 0 &&
+                m_patternPads[static_cast<size_t>(i)] == inPattern) {
+                scheduleProcessedRender(i, inPattern ? 1 : 0);
+            }
         }
     }
     emit bpmChanged(m_bpm);
@@ -3316,6 +3472,7 @@ void PadBank::setBusEffects(int bus, const QVector<BusEffect> &effects) {
         cfg.p3 = fx.p3;
         cfg.p4 = fx.p4;
         cfg.p5 = fx.p5;
+        cfg.impulse = fx.impulse;
         settings.push_back(cfg);
     }
     m_engine->setBusEffects(bus, settings);
@@ -3328,6 +3485,41 @@ float PadBank::busMeter(int bus) const {
     return m_engine->busMeter(bus);
 }
 
+int PadBank::engineWorkerCount() const {
+    if (!m_engineAvailable || !m_engine) {
+        return 0;
+    }
+    return m_engine->workerCount();
+}
+
+float PadBank::engineWorkerLoad(int index) const {
+    if (!m_engineAvailable || !m_engine) {
+        return 0.0f;
+    }
+    return m_engine->workerLoad(index);
+}
+
+QStringList PadBank::realtimeProblems() const {
+    QStringList problems;
+    for (const std::string &problem : RtScheduling::problems()) {
+        problems << QString::fromStdString(problem);
+    }
+    return problems;
+}
+
+const DspStats *PadBank::engineDspStats() const {
+    if (!m_engineAvailable || !m_engine) {
+        return nullptr;
+    }
+    return &m_engine->dspStats();
+}
+
+void PadBank::resetEngineDspStats() {
+    if (m_engine) {
+        m_engine->resetDspStats();
+    }
+}
+
 float PadBank::busGain(int bus) const {
     if (bus < 0 || bus >= static_cast<int>(m_busGain.size())) {
         return 1.0f;
@@ -3379,17 +3571,6 @@ QString PadBank::audioDevice() const {
     return QString();
 }
 
-bool PadBank::startRecording(const QString &path, int durationMs, int targetRate) {
-    if (!m_engineAvailable || !m_engine) {
-        return false;
-    }
-    if (durationMs <= 0 || path.isEmpty()) {
-        return false;
-    }
-    const int frames = qMax(1, static_cast<int>((durationMs * m_engineRate) / 1000.0));
-    return m_engine->startRecording(path, frames, targetRate);
-}
-
 bool PadBank::previewSample(const QString &path, int *durationMs) {
     if (durationMs) {
         *durationMs = 0;
@@ -3403,12 +3584,7 @@ bool PadBank::previewSample(const QString &path, int *durationMs) {
 
     stopPreview();
 
-#ifdef Q_OS_LINUX
-    const QString ffmpeg = QStandardPaths::findExecutable("ffmpeg");
-    if (ffmpeg.isEmpty()) {
-        return false;
-    }
-    int rate = m_engineRate > 0 ? m_engineRate : 48000;
+    const int rate = m_engineRate > 0 ? m_engineRate : 48000;
     int maxSec = 20;
     {
         bool ok = false;
@@ -3417,83 +3593,40 @@ bool PadBank::previewSample(const QString &path, int *durationMs) {
             maxSec = qMin(120, env);
         }
     }
+    SampleDecoder::Info info;
+    if (durationMs && SampleDecoder::probe(path, &info)) {
+        *durationMs = static_cast<int>(qMin<qint64>(info.durationMs, maxSec * 1000LL));
+    }
 
-    m_previewBytes.clear();
     m_previewPath = path;
-    m_previewSampleRate = rate;
-
-    PadBank *self = this;
-    m_previewProcess = new QProcess(this);
-    QProcess *proc = m_previewProcess;
-    proc->setProgram(ffmpeg);
-    proc->setArguments(
-        {"-v", "error",
-         "-i", path,
-         "-f", "s16le",
-         "-ac", "2",
-         "-ar", QString::number(rate),
-         "-t", QString::number(maxSec),
-         "-"});
-    proc->setProcessChannelMode(QProcess::SeparateChannels);
-
-    connect(proc, &QProcess::readyReadStandardOutput, this, [self, proc]() {
-        if (self->m_previewProcess != proc) {
-            return;
-        }
-        self->m_previewBytes.append(proc->readAllStandardOutput());
-    });
-
-    connect(proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
-            this, [self, durationMs, proc](int, QProcess::ExitStatus) {
-                if (self->m_previewProcess != proc) {
-                    return;
-                }
-                const QByteArray bytes = self->m_previewBytes;
-                self->m_previewBytes.clear();
-                proc->deleteLater();
-                self->m_previewProcess = nullptr;
-
-                auto buffer = decodePcm16(bytes, self->m_previewSampleRate, 2);
-                if (!buffer || !buffer->isValid()) {
+    const int job = ++m_previewJob;
+    const qint64 maxFrames = static_cast<qint64>(maxSec) * rate;
+    m_renderPool.start([this, path, rate, maxFrames, job]() {
+        std::shared_ptr<const AudioEngine::Buffer> buffer =
+            SampleDecoder::decode(path, rate, maxFrames);
+        QMetaObject::invokeMethod(
+            this,
+            [this, buffer, job]() {
+                if (job != m_previewJob || !buffer || !buffer->isValid()) {
                     return;
                 }
-                self->m_previewBuffer = buffer;
+                m_previewBuffer = buffer;
                 const int frames = buffer->frames();
                 const int ms =
-                    qMax(1, static_cast<int>((frames * 1000.0) / qMax(1, buffer->sampleRate)));
-                if (durationMs) {
-                    *durationMs = ms;
-                }
-                if (self->m_engine) {
-                    self->m_engine->trigger(-2, buffer, 0, frames, false, 1.0f, 0.0f, 1.0f, 0);
+                    qMax(1, static_cast<int>((frames * 1000.0) / qMax(1, buffer->sampleRate())));
+                if (m_engine) {
+                    m_engine->trigger(-2, buffer, 0, frames, false, 1.0f, 0.0f, 1.0f, 0);
                 }
-                self->m_previewActive = true;
-                QTimer::singleShot(ms, self, [self]() { self->m_previewActive = false; });
-            });
-
-    connect(proc, &QProcess::errorOccurred, this, [self, proc](QProcess::ProcessError) {
-                if (self->m_previewProcess == proc) {
-                    proc->deleteLater();
-                    self->m_previewProcess = nullptr;
-                }
-                self->m_previewBytes.clear();
-            });
-
-    proc->start();
+                m_previewActive = true;
+                QTimer::singleShot(ms, this, [this]() { m_previewActive = false; });
+            },
+            Qt::QueuedConnection);
+    });
     return true;
-#else
-    Q_UNUSED(path);
-    return false;
-#endif
 }
 
 void PadBank::stopPreview() {
-    if (m_previewProcess) {
-        m_previewProcess->kill();
-        m_previewProcess->deleteLater();
-        m_previewProcess = nullptr;
-    }
-    m_previewBytes.clear();
+    ++m_previewJob;
     m_previewBuffer.reset();
     m_previewActive = false;
     if (m_engineAvailable && m_engine) {
@@ -3501,35 +3634,87 @@ void PadBank::stopPreview() {
     }
 }
 
-static std::shared_ptr<AudioEngine::Buffer> makeMetronomeBuffer(int sampleRate, float freq,
-                                                                float lengthSec) {
+static std::shared_ptr<const AudioEngine::Buffer> makeMetronomeBuffer(int sampleRate, float freq,
+                                                                      float lengthSec) {
     if (sampleRate <= 0) {
         sampleRate = 48000;
     }
     const int frames = qMax(1, static_cast<int>(sampleRate * lengthSec));
-    auto buffer = std::make_shared<AudioEngine::Buffer>();
-    buffer->channels = 2;
-    buffer->sampleRate = sampleRate;
-    buffer->samples.resize(frames * buffer->channels);
+    auto buffer = SampleBuffer::create(frames, 1, sampleRate);
+    float *out = buffer->writableFloat();
     for (int i = 0; i < frames; ++i) {
         const float t = static_cast<float>(i) / sampleRate;
         const float env = std::exp(-t * 12.0f);
-        const float v = std::sin(2.0f * static_cast<float>(M_PI) * freq * t) * env;
-        buffer->samples[i * 2] = v;
-        buffer->samples[i * 2 + 1] = v;
+        out[i] = std::sin(2.0f * static_cast<float>(M_PI) * freq * t) * env;
     }
     return buffer;
 }
 
-void PadBank::triggerMetronome(bool accent) {
-    if (!m_engineAvailable || !m_engine) {
-        return;
-    }
+std::shared_ptr<const AudioEngine::Buffer> PadBank::metronomeBuffer(bool accent) {
     if (!m_metronomeBuffer || !m_metronomeAccent) {
         m_metronomeBuffer = makeMetronomeBuffer(m_engineRate, 1600.0f, 0.05f);
         m_metronomeAccent = makeMetronomeBuffer(m_engineRate, 2200.0f, 0.06f);
     }
-    auto buffer = accent ? m_metronomeAccent : m_metronomeBuffer;
+    return accent ? m_metronomeAccent : m_metronomeBuffer;
+}
+
+std::unique_ptr<AudioEngine> PadBank::createOfflineEngine(int blockFrames) const {
+    if (!m_engine) {
+        return nullptr;
+    }
+    auto engine = std::make_unique<AudioEngine>(m_engine->sampleRate(), blockFrames);
+    m_engine->copyStateTo(*engine);
+    return engine;
+}
+
+void PadBank::setSequencerPattern(const AudioEngine::SeqPattern &pattern) {
+    if (!m_engineAvailable || !m_engine) {
+        return;
+    }
+    m_patternPads.fill(false);
+    for (const AudioEngine::SeqEvent &event : pattern.events) {
+        if (event.padId >= 0 && event.padId < padCount()) {
+            m_patternPads[static_cast<size_t>(event.padId)] = true;
+        }
+    }
+    m_engine->setSequencerPattern(pattern);
+}
+
+bool PadBank::startSequencer(int step) {
+    if (!m_engineAvailable || !m_engine) {
+        return false;
+    }
+    return m_engine->startSequencer(step);
+}
+
+bool PadBank::stopSequencer() {
+    if (!m_engineAvailable || !m_engine) {
+        return false;
+    }
+    return m_engine->stopSequencer();
+}
+
+int PadBank::sequencerPosition(float *phase) {
+    if (phase) {
+        *phase = 0.0f;
+    }
+    if (!m_engineAvailable || !m_engine) {
+        return 0;
+    }
+    // Polled while the transport runs, which is also when voices it started pile up for
+    // reclaiming.
+    m_engine->releaseRetired();
+    if (phase) {
+        *phase = m_engine->sequencerStepPhase();
+    }
+    return m_engine->sequencerStep();
+}
+
+void PadBank::triggerMetronome(bool accent) {
+    if (!m_engineAvailable || !m_engine) {
+        return;
+    }
+    auto buffer = metronomeBuffer(accent);
     if (!buffer || !buffer->isValid()) {
         return;
     }
@@ -3,10 +3,14 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
 #include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 #include "AudioEngine.h"
+#include "MidiInput.h"
 
 class QTimer;
 class QProcess;
@@ -71,6 +75,9 @@ public:
         bool loop = false;
         int fxBus = 0;
         bool normalize = false;
+        // Hits that may ring at once, and the choke group (0 = none) that cuts other pads.
+        int polyphony = 1;
+        int chokeGroup = 0;
     };
 
     struct SynthParams {
@@ -148,6 +155,23 @@ public:
         std::array<FilterModule, kFilterModuleCount> filterModules{};
     };
 
+    // What triggering a pad through the engine plays, resolved from the pad's current state.
+    struct EngineTrigger {
+        bool synth = false;
+        std::shared_ptr<const AudioEngine::Buffer> buffer;
+        // Set for long samples played from disk; buffer is then the stream's head.
+        std::shared_ptr<const SampleStream> stream;
+        int startFrame = 0;
+        int endFrame = 0;
+        bool loop = false;
+        float rate = 1.0f;
+        int midiNote = 60;
+        int lengthFrames = 0;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        int bus = 0;
+    };
+
     struct BusEffect {
         int type = 0;
         float p1 = 0.5f;
@@ -155,6 +179,7 @@ public:
         float p3 = 0.5f;
         float p4 = 0.5f;
         float p5 = 0.0f;
+        QString impulse;
     };
 
     PadParams params(int index) const;
@@ -170,6 +195,8 @@ public:
     void setSliceIndex(int index, int sliceIndex);
     void setLoop(int index, bool loop);
     void setNormalize(int index, bool enabled);
+    void setPolyphony(int index, int voices);
+    void setChokeGroup(int index, int group);
     void setSynthAdsr(int index, float attack, float decay, float sustain, float release);
     void setSynthWave(int index, int wave);
     void setSynthVoices(int index, int voices);
@@ -196,10 +223,13 @@ public:
     bool isPlaying(int index) const;
     bool isPadReady(int index) const;
     float padPlayhead(int index) const;
-    std::shared_ptr<AudioEngine::Buffer> rawBuffer(int index) const;
+    std::shared_ptr<const AudioEngine::Buffer> rawBuffer(int index) const;
     void requestRawBuffer(int index);
     void triggerPad(int index);
     void triggerPadMidi(int index, int midiNote, int lengthSteps);
+    bool resolveEngineTrigger(int index, EngineTrigger &out, bool *processedStale = nullptr) const;
+    // resolveEngineTrigger() for the sequencer: kicks off any render the pad still needs.
+    bool sequencerTrigger(int index, EngineTrigger &out);
     void stopPad(int index);
     void stopAll();
 
@@ -220,13 +250,28 @@ public:
     void setSynthVoiceParam(int index, int param, int value);
     void setBusEffects(int bus, const QVector<BusEffect> &effects);
     float busMeter(int bus) const;
+    // Audio thread plus mix workers; load is each one's share of the period, 0..1.
+    int engineWorkerCount() const;
+    float engineWorkerLoad(int index) const;
+    // Callback timing and xruns, or nullptr without an engine.
+    const DspStats *engineDspStats() const;
+    void resetEngineDspStats();
+    // Real-time settings the process was not allowed to apply, see RtScheduling.
+    QStringList realtimeProblems() const;
     float busGain(int bus) const;
     void setBusGain(int bus, float gain);
     bool setAudioDevice(const QString &device);
     QString audioDevice() const;
     int engineSampleRate() const { return m_engineRate; }
-    bool startRecording(const QString &path, int durationMs, int targetRate);
     void triggerMetronome(bool accent);
+    bool sequencerAvailable() const { return m_engineAvailable && m_engine; }
+    void setSequencerPattern(const AudioEngine::SeqPattern &pattern);
+    // False when the engine did not take the transport change; it keeps its previous state.
+    bool startSequencer(int step);
+    bool stopSequencer();
+    int sequencerPosition(float *phase = nullptr);
+    std::shared_ptr<const AudioEngine::Buffer> metronomeBuffer(bool accent);
+    std::unique_ptr<AudioEngine> createOfflineEngine(int blockFrames) const;
     float normalizeGainForPad(int index) const;
     bool previewSample(const QString &path, int *durationMs = nullptr);
     void stopPreview();
@@ -237,13 +282,20 @@ signals:
     void activePadChanged(int index);
     void padParamsChanged(int index);
     void bpmChanged(int bpm);
+    // A pad's decoded or processed engine buffer was replaced.
+    void engineBufferChanged(int index);
 
 private:
     struct PadRuntime;
+    struct RenderCache;
     static void rebuildSynthRuntime(PadRuntime *rt, const QString &name, int sampleRate,
                                     int baseMidi, const SynthParams &params);
     void scheduleRawRender(int index);
-    void scheduleProcessedRender(int index);
+    // Copies what a MIDI note on the pad should play where the MIDI thread can read it.
+    void refreshMidiTrigger(int index);
+    // MIDI thread: plays the event on the engine straight away, without the engine lock.
+    void handleMidi(const MidiInput::Event &event);
+    void scheduleProcessedRender(int index, int priority = 0);
     bool needsProcessing(const PadParams &params) const;
 
     std::array<QString, 8> m_paths;
@@ -260,16 +312,29 @@ private:
     int m_engineRate = 48000;
     bool m_engineAvailable = false;
     int m_renderSerial = 0;
-    QString m_ffmpegPath;
+    // Pads the last sequencer pattern plays; their renders go first after a tempo change.
+    std::array<bool, 8> m_patternPads{};
+    // Sample decodes and pitch/stretch renders; drained before pad runtimes are torn down.
+    QThreadPool m_renderPool;
+    std::unique_ptr<RenderCache> m_renderCache;
     std::unique_ptr<class AudioEngine> m_engine;
+    // Controller input. m_midiTriggers is resolveEngineTrigger() for each pad as of its last
+    // change, false in m_midiReady when the pad has nothing to play.
+    MidiInput m_midi;
+    std::mutex m_midiMutex;
+    std::array<EngineTrigger, 8> m_midiTriggers;
+    std::array<bool, 8> m_midiReady{};
+    std::array<bool, 8> m_midiFm{};
+    std::atomic<int> m_midiActivePad{0};
+    int m_midiPadChannel = 9;
+    int m_midiPadNote = 36;
+    int m_midiMacroCc = 70;
     std::array<float, 6> m_busGain{};
     QTimer *m_synthConnectTimer = nullptr;
-    std::shared_ptr<AudioEngine::Buffer> m_metronomeBuffer;
-    std::shared_ptr<AudioEngine::Buffer> m_metronomeAccent;
-    QProcess *m_previewProcess = nullptr;
-    QByteArray m_previewBytes;
-    std::shared_ptr<AudioEngine::Buffer> m_previewBuffer;
+    std::shared_ptr<const AudioEngine::Buffer> m_metronomeBuffer;
+    std::shared_ptr<const AudioEngine::Buffer> m_metronomeAccent;
+    std::shared_ptr<const AudioEngine::Buffer> m_previewBuffer;
     QString m_previewPath;
-    int m_previewSampleRate = 0;
+    int m_previewJob = 0;
     bool m_previewActive = false;
 };
@@ -0,0 +1,81 @@
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Resampler {
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kZeroCrossings = 12;
+constexpr int kTableSteps = 512;
+constexpr int kTableSize = kZeroCrossings * kTableSteps;
+
+const std::vector<float> &sincTable() {
+    static const std::vector<float> table = []() {
+        std::vector<float> t(static_cast<size_t>(kTableSize + 2), 0.0f);
+        for (int i = 0; i <= kTableSize; ++i) {
+            const double x = static_cast<double>(i) / kTableSteps;
+            const double sinc = i == 0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+            const double phase = 0.5 + 0.5 * x / kZeroCrossings;
+            const double window = 0.42 - 0.5 * std::cos(2.0 * kPi * phase) +
+                                  0.08 * std::cos(4.0 * kPi * phase);
+            t[static_cast<size_t>(i)] = static_cast<float>(sinc * window);
+        }
+        return t;
+    }();
+    return table;
+}
+
+}  // namespace
+
+int reach(double step) {
+    const double cutoff = std::min(1.0, 1.0 / step);
+    return static_cast<int>(std::ceil(kZeroCrossings / cutoff)) + 1;
+}
+
+void resample(const float *data, int channels, int start, int end, double step, float *out,
+              int outFrames) {
+    resample(data, channels, start, end, static_cast<double>(start), step, out, outFrames);
+}
+
+void resample(const float *data, int channels, int start, int end, double pos, double step,
+              float *out, int outFrames) {
+    if (!data || !out || channels <= 0 || outFrames <= 0 || step <= 0.0) {
+        return;
+    }
+    const std::vector<float> &table = sincTable();
+    const double cutoff = std::min(1.0, 1.0 / step);
+    const int half = static_cast<int>(std::ceil(kZeroCrossings / cutoff));
+    const double tableScale = cutoff * kTableSteps;
+    std::vector<double> acc(static_cast<size_t>(channels));
+    for (int i = 0; i < outFrames; ++i) {
+        const double at = pos + i * step;
+        const int center = static_cast<int>(std::floor(at));
+        const int first = std::max(start, center - half + 1);
+        const int last = std::min(end - 1, center + half);
+        std::fill(acc.begin(), acc.end(), 0.0);
+        for (int j = first; j <= last; ++j) {
+            const double x = std::abs(j - at) * tableScale;
+            const int idx = static_cast<int>(x);
+            if (idx >= kTableSize) {
+                continue;
+            }
+            const float frac = static_cast<float>(x - idx);
+            const float a = table[static_cast<size_t>(idx)];
+            const double w = a + (table[static_cast<size_t>(idx) + 1] - a) * frac;
+            const float *frame = data + static_cast<ptrdiff_t>(j) * channels;
+            for (int ch = 0; ch < channels; ++ch) {
+                acc[static_cast<size_t>(ch)] += frame[ch] * w;
+            }
+        }
+        float *dst = out + static_cast<ptrdiff_t>(i) * channels;
+        for (int ch = 0; ch < channels; ++ch) {
+            dst[ch] = static_cast<float>(acc[static_cast<size_t>(ch)] * cutoff);
+        }
+    }
+}
+
+}  // namespace Resampler
@@ -0,0 +1,21 @@
+#pragma once
+
+// Band-limited sample-rate conversion for offline work (decoding, pitch renders): a tabulated
+// Blackman-windowed sinc whose cutoff follows the read step so reading faster does not alias.
+namespace Resampler {
+
+// Writes outFrames interleaved frames to out, reading frames [start, end) of the interleaved
+// `channels`-wide data at `step` source frames per output frame, beginning at `start`. Taps
+// outside [start, end) count as silence.
+void resample(const float *data, int channels, int start, int end, double step, float *out,
+              int outFrames);
+
+// Same, but the first output frame sits at the fractional source position `pos` rather than at
+// `start`, so a long source can be converted window by window.
+void resample(const float *data, int channels, int start, int end, double pos, double step,
+              float *out, int outFrames);
+
+// Source frames either side of a read position that contribute to its output at `step`.
+int reach(double step);
+
+}  // namespace Resampler
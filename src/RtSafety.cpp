@@ -0,0 +1,315 @@
+// Fortified headers turn open()/fopen() into inline wrappers, which would clash with the
+// interposers below.
+#undef _FORTIFY_SOURCE
+
+#include "RtSafety.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+thread_local bool t_audioThread = false;
+thread_local bool t_reporting = false;
+std::atomic<size_t> g_violations{0};
+std::atomic<size_t> g_allocations{0};
+
+#ifdef __USE_FILE_OFFSET64
+// open()/fopen()/pread()/pwrite() below are already bound to the 64-bit symbols by the
+// headers.
+constexpr const char *kOpenName = "open64";
+constexpr const char *kOpenatName = "openat64";
+constexpr const char *kFopenName = "fopen64";
+constexpr const char *kPreadName = "pread64";
+constexpr const char *kPwriteName = "pwrite64";
+#else
+constexpr const char *kOpenName = "open";
+constexpr const char *kOpenatName = "openat";
+constexpr const char *kFopenName = "fopen";
+constexpr const char *kPreadName = "pread";
+constexpr const char *kPwriteName = "pwrite";
+#endif
+
+using OpenFn = int (*)(const char *, int, ...);
+using OpenatFn = int (*)(int, const char *, int, ...);
+using FopenFn = FILE *(*)(const char *, const char *);
+using ReadFn = ssize_t (*)(int, void *, size_t);
+using WriteFn = ssize_t (*)(int, const void *, size_t);
+using PreadFn = ssize_t (*)(int, void *, size_t, off_t);
+using PwriteFn = ssize_t (*)(int, const void *, size_t, off_t);
+
+std::atomic<OpenFn> g_open{nullptr};
+std::atomic<OpenatFn> g_openat{nullptr};
+std::atomic<FopenFn> g_fopen{nullptr};
+std::atomic<ReadFn> g_read{nullptr};
+std::atomic<WriteFn> g_write{nullptr};
+std::atomic<PreadFn> g_pread{nullptr};
+std::atomic<PwriteFn> g_pwrite{nullptr};
+#ifndef __USE_FILE_OFFSET64
+std::atomic<OpenFn> g_open64{nullptr};
+std::atomic<FopenFn> g_fopen64{nullptr};
+using Pread64Fn = ssize_t (*)(int, void *, size_t, off64_t);
+using Pwrite64Fn = ssize_t (*)(int, const void *, size_t, off64_t);
+std::atomic<Pread64Fn> g_pread64{nullptr};
+std::atomic<Pwrite64Fn> g_pwrite64{nullptr};
+#endif
+
+template <typename Fn>
+Fn resolve(std::atomic<Fn> &slot, const char *name) {
+    Fn fn = slot.load(std::memory_order_acquire);
+    if (!fn) {
+        // dlsym may allocate; keep that out of the report.
+        const bool wasReporting = t_reporting;
+        t_reporting = true;
+        fn = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+        t_reporting = wasReporting;
+        slot.store(fn, std::memory_order_release);
+    }
+    return fn;
+}
+
+void resolveAll() {
+    resolve(g_open, kOpenName);
+    resolve(g_openat, kOpenatName);
+    resolve(g_fopen, kFopenName);
+    resolve(g_read, "read");
+    resolve(g_write, "write");
+    resolve(g_pread, kPreadName);
+    resolve(g_pwrite, kPwriteName);
+#ifndef __USE_FILE_OFFSET64
+    resolve(g_open64, "open64");
+    resolve(g_fopen64, "fopen64");
+    resolve(g_pread64, "pread64");
+    resolve(g_pwrite64, "pwrite64");
+#endif
+}
+
+bool abortOnViolation() {
+    static const bool enabled = [] {
+        const char *value = std::getenv("GROOVEBOX_RT_CHECK_ABORT");
+        return value && value[0] == '1';
+    }();
+    return enabled;
+}
+
+// Counting only, for the benchmarks.
+bool quiet() {
+    static const bool enabled = [] {
+        const char *value = std::getenv("GROOVEBOX_RT_CHECK_QUIET");
+        return value && value[0] == '1';
+    }();
+    return enabled;
+}
+
+// Only called with t_reporting set, so the write() interposer below lets it through.
+void writeText(const char *text) {
+    if (text) {
+        const ssize_t ignored = ::write(STDERR_FILENO, text, std::strlen(text));
+        (void)ignored;
+    }
+}
+
+void report(const char *what, const char *detail = nullptr) {
+    if (!t_audioThread || t_reporting) {
+        return;
+    }
+    t_reporting = true;
+    g_violations.fetch_add(1, std::memory_order_relaxed);
+    if (quiet()) {
+        t_reporting = false;
+        return;
+    }
+    writeText("[rt-check] ");
+    writeText(what);
+    if (detail) {
+        writeText(" ");
+        writeText(detail);
+    }
+    writeText(" on the audio thread\n");
+    void *frames[32];
+    const int depth = backtrace(frames, 32);
+    if (depth > 1) {
+        backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+    }
+    if (abortOnViolation()) {
+        std::abort();
+    }
+    t_reporting = false;
+}
+
+void countAllocation(const char *what) {
+    if (!t_audioThread || t_reporting) {
+        return;
+    }
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    report(what);
+}
+
+}  // namespace
+
+namespace RtSafety {
+
+AudioThreadScope::AudioThreadScope() : m_previous(t_audioThread) {
+    if (!m_previous) {
+        // First use of backtrace() and dlsym() allocates; get that done before the scope opens.
+        static const bool primed = [] {
+            void *frame = nullptr;
+            backtrace(&frame, 1);
+            resolveAll();
+            return true;
+        }();
+        (void)primed;
+    }
+    t_audioThread = true;
+}
+
+AudioThreadScope::~AudioThreadScope() {
+    t_audioThread = m_previous;
+}
+
+size_t violationCount() {
+    return g_violations.load(std::memory_order_relaxed);
+}
+
+size_t allocationCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace RtSafety
+
+extern "C" {
+
+void *malloc(size_t size) noexcept {
+    countAllocation("malloc()");
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    countAllocation("calloc()");
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+    countAllocation("realloc()");
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) noexcept {
+    countAllocation("posix_memalign()");
+    void *ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+    countAllocation("aligned_alloc()");
+    return __libc_memalign(alignment, size);
+}
+
+void free(void *ptr) noexcept {
+    if (ptr) {
+        report("free()");
+    }
+    __libc_free(ptr);
+}
+
+int open(const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    report("open()", path);
+    return resolve(g_open, kOpenName)(path, flags, mode);
+}
+
+int openat(int dirfd, const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    report("openat()", path);
+    return resolve(g_openat, kOpenatName)(dirfd, path, flags, mode);
+}
+
+FILE *fopen(const char *path, const char *mode) {
+    report("fopen()", path);
+    return resolve(g_fopen, kFopenName)(path, mode);
+}
+
+// I/O on descriptors that are already open: a stream or cache file read from the mix, or a
+// stray log line. stdio goes through these as well.
+ssize_t read(int fd, void *buffer, size_t count) {
+    report("read()");
+    return resolve(g_read, "read")(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void *buffer, size_t count) {
+    report("write()");
+    return resolve(g_write, "write")(fd, buffer, count);
+}
+
+ssize_t pread(int fd, void *buffer, size_t count, off_t offset) {
+    report("pread()");
+    return resolve(g_pread, kPreadName)(fd, buffer, count, offset);
+}
+
+ssize_t pwrite(int fd, const void *buffer, size_t count, off_t offset) {
+    report("pwrite()");
+    return resolve(g_pwrite, kPwriteName)(fd, buffer, count, offset);
+}
+
+#ifndef __USE_FILE_OFFSET64
+int open64(const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    report("open64()", path);
+    return resolve(g_open64, "open64")(path, flags, mode);
+}
+
+FILE *fopen64(const char *path, const char *mode) {
+    report("fopen64()", path);
+    return resolve(g_fopen64, "fopen64")(path, mode);
+}
+
+ssize_t pread64(int fd, void *buffer, size_t count, off64_t offset) {
+    report("pread64()");
+    return resolve(g_pread64, "pread64")(fd, buffer, count, offset);
+}
+
+ssize_t pwrite64(int fd, const void *buffer, size_t count, off64_t offset) {
+    report("pwrite64()");
+    return resolve(g_pwrite64, "pwrite64")(fd, buffer, count, offset);
+}
+#endif
+
+}  // extern "C"
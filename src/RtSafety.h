@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+// Debug aid for the audio thread. When built with GROOVEBOX_RT_CHECK, heap traffic and file
+// I/O (opens, and reads or writes on open descriptors) made while an AudioThreadScope is alive
+// are counted and reported on stderr with a backtrace (set GROOVEBOX_RT_CHECK_ABORT=1 to abort on the first one, or
+// GROOVEBOX_RT_CHECK_QUIET=1 to only count them). In normal builds everything here compiles
+// away.
+namespace RtSafety {
+
+#ifdef GROOVEBOX_RT_CHECK
+class AudioThreadScope {
+public:
+    AudioThreadScope();
+    ~AudioThreadScope();
+    AudioThreadScope(const AudioThreadScope &) = delete;
+    AudioThreadScope &operator=(const AudioThreadScope &) = delete;
+
+private:
+    bool m_previous = false;
+};
+
+// Reported calls (allocations, frees, file I/O) since startup.
+size_t violationCount();
+// malloc/calloc/realloc calls made inside any scope since startup.
+size_t allocationCount();
+#else
+class AudioThreadScope {
+public:
+    AudioThreadScope() {}
+};
+
+inline size_t violationCount() { return 0; }
+inline size_t allocationCount() { return 0; }
+#endif
+
+}  // namespace RtSafety
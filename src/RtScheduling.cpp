@@ -0,0 +1,141 @@
+#include "RtScheduling.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace RtScheduling {
+namespace {
+// Deeper than anything the mix reaches; the default thread stack is far larger.
+constexpr size_t kStackPrefaultBytes = 256 * 1024;
+
+std::mutex g_problemsMutex;
+std::vector<std::string> g_problems;
+
+void report(const std::string &problem) {
+    std::lock_guard<std::mutex> lock(g_problemsMutex);
+    if (std::find(g_problems.begin(), g_problems.end(), problem) != g_problems.end()) {
+        return;
+    }
+    g_problems.push_back(problem);
+    std::fprintf(stderr, "GrooveBox real-time: %s\n", problem.c_str());
+}
+
+Config readConfig() {
+    Config config;
+    if (const char *priority = std::getenv("GROOVEBOX_RT_PRIORITY")) {
+        config.priority = std::max(0, std::min(99, std::atoi(priority)));
+    }
+    if (const char *cpus = std::getenv("GROOVEBOX_RT_CPUS")) {
+        std::stringstream list(cpus);
+        std::string item;
+        const int cores = static_cast<int>(std::thread::hardware_concurrency());
+        while (std::getline(list, item, ',')) {
+            char *end = nullptr;
+            const long cpu = std::strtol(item.c_str(), &end, 10);
+            if (end == item.c_str() || cpu < 0 || (cores > 0 && cpu >= cores)) {
+                report("ignoring core '" + item + "' in GROOVEBOX_RT_CPUS");
+                continue;
+            }
+            config.cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    if (const char *lock = std::getenv("GROOVEBOX_MLOCK")) {
+        config.lockMemory = std::atoi(lock) != 0;
+    }
+    return config;
+}
+}  // namespace
+
+const Config &config() {
+    static const Config config = readConfig();
+    return config;
+}
+
+void setupProcess() {
+    const Config &cfg = config();
+    if (cfg.lockMemory) {
+        // MCL_FUTURE makes later mappings (decoded samples, the mapped sample cache) resident as
+        // they are created, but once the memlock limit is reached it fails those mappings
+        // outright. Only ask for it when the limit cannot be hit.
+        rlimit limit{};
+        const bool unlimited = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+                               (limit.rlim_cur == RLIM_INFINITY || geteuid() == 0);
+        const int flags = unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT;
+        if (mlockall(flags) != 0) {
+            report(std::string("mlockall failed (") + std::strerror(errno) +
+                   "); raise the memlock limit in /etc/security/limits.conf");
+        } else if (!unlimited) {
+            report("memlock limit is " + std::to_string(limit.rlim_cur / 1024) +
+                   " KiB; memory allocated from now on is not locked");
+        }
+    }
+
+#ifdef __linux__
+    if (!cfg.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu : cfg.cpus) {
+                CPU_CLR(cpu, &set);
+            }
+            if (CPU_COUNT(&set) == 0) {
+                report("GROOVEBOX_RT_CPUS covers every core; the UI shares them");
+            } else if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+                report("could not move the UI off the real-time cores");
+            }
+        }
+    }
+#endif
+}
+
+void enterRealtime(int priority, int cpu) {
+#ifdef __linux__
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cpu >= 0 && cores > 1) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % cores, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            report("could not pin a real-time thread to core " + std::to_string(cpu % cores));
+        }
+    }
+#else
+    (void)cpu;
+#endif
+    if (priority > 0) {
+        sched_param param{};
+        param.sched_priority = priority;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            report("SCHED_FIFO " + std::to_string(priority) + " denied (" + std::strerror(err) +
+                   "); needs CAP_SYS_NICE or an rtprio limit in /etc/security/limits.conf");
+        }
+    }
+}
+
+void prefaultStack() {
+    volatile char stack[kStackPrefaultBytes];
+    for (size_t i = 0; i < kStackPrefaultBytes; i += 4096) {
+        stack[i] = 0;
+    }
+    (void)stack[0];
+}
+
+std::vector<std::string> problems() {
+    std::lock_guard<std::mutex> lock(g_problemsMutex);
+    return g_problems;
+}
+
+}  // namespace RtScheduling
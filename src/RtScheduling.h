@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Real-time setup for the audio side, read once from the environment:
+//   GROOVEBOX_RT_PRIORITY  SCHED_FIFO priority of the audio thread, default 80, 0 turns real-time
+//                          scheduling off. Mix workers run kWorkerPriorityGap below it.
+//   GROOVEBOX_RT_CPUS      cores for the audio thread and then the mix workers, e.g. "2,3". The
+//                          rest of the process, UI included, is kept off them; pair it with
+//                          isolcpus= on the kernel command line to keep other tasks off too.
+//   GROOVEBOX_MLOCK        0 skips mlockall().
+// Nothing here fails loudly: whatever the process is not allowed to do is skipped, printed to
+// stderr once and listed by problems().
+namespace RtScheduling {
+
+constexpr int kWorkerPriorityGap = 10;
+
+struct Config {
+    int priority = 80;
+    std::vector<int> cpus;
+    bool lockMemory = true;
+};
+
+const Config &config();
+
+// Call from main() before any other thread exists: locks memory and moves the calling thread,
+// and so every thread created after it, off the real-time cores.
+void setupProcess();
+
+// Call on the thread itself, before its real-time loop. cpu < 0 leaves the affinity alone;
+// priority <= 0 leaves the policy alone.
+void enterRealtime(int priority, int cpu);
+
+// Touches enough of the calling thread's stack that the real-time loop never page-faults on it.
+void prefaultStack();
+
+// What could not be applied, one line each; empty when everything asked for is in effect.
+std::vector<std::string> problems();
+
+}  // namespace RtScheduling
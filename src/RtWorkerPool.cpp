@@ -0,0 +1,157 @@
+#include "RtWorkerPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include "RtSafety.h"
+#include "RtScheduling.h"
+
+namespace {
+// Checks of the helper count before run() sleeps on m_finished instead.
+constexpr int kSpinsBeforeBlock = 2000;
+constexpr float kLoadSmoothing = 0.1f;
+}  // namespace
+
+RtWorkerPool::~RtWorkerPool() {
+    stop();
+}
+
+void RtWorkerPool::start(int helpers, int priority, const std::vector<int> &cores) {
+    stop();
+    m_quit.store(false, std::memory_order_relaxed);
+    helpers = std::max(0, helpers);
+    if (helpers == 0 || sem_init(&m_finished, 0, 0) != 0) {
+        return;
+    }
+    m_finishedReady = true;
+    m_helpers.reserve(static_cast<size_t>(helpers));
+    for (int i = 0; i < helpers; ++i) {
+        auto helper = std::make_unique<Helper>();
+        if (sem_init(&helper->wake, 0, 0) != 0) {
+            break;
+        }
+        Helper *raw = helper.get();
+        // Unpinned helpers inherit the control thread's affinity, which setupProcess() keeps off
+        // the real-time cores, so they cannot starve the audio thread they report back to.
+        const int core = cores.empty() ? -1 : cores[static_cast<size_t>(i) % cores.size()];
+        raw->thread = std::thread([this, raw, core, priority]() {
+            RtScheduling::enterRealtime(priority, core);
+            RtScheduling::prefaultStack();
+            helperLoop(*raw);
+        });
+        m_helpers.push_back(std::move(helper));
+    }
+}
+
+void RtWorkerPool::stop() {
+    if (m_helpers.empty()) {
+        return;
+    }
+    m_quit.store(true, std::memory_order_relaxed);
+    for (auto &helper : m_helpers) {
+        sem_post(&helper->wake);
+    }
+    for (auto &helper : m_helpers) {
+        if (helper->thread.joinable()) {
+            helper->thread.join();
+        }
+        sem_destroy(&helper->wake);
+    }
+    m_helpers.clear();
+    if (m_finishedReady) {
+        sem_destroy(&m_finished);
+        m_finishedReady = false;
+    }
+}
+
+void RtWorkerPool::run(JobFn fn, void *context, int jobs) {
+    if (!fn || jobs <= 0) {
+        return;
+    }
+    const int helpers = std::min(static_cast<int>(m_helpers.size()), jobs - 1);
+    if (helpers <= 0) {
+        for (int job = 0; job < jobs; ++job) {
+            fn(context, job);
+        }
+        return;
+    }
+    m_fn = fn;
+    m_context = context;
+    m_jobCount = jobs;
+    m_nextJob.store(0, std::memory_order_relaxed);
+    m_busyHelpers.store(helpers, std::memory_order_relaxed);
+    for (int i = 0; i < helpers; ++i) {
+        sem_post(&m_helpers[static_cast<size_t>(i)]->wake);
+    }
+    drainJobs();
+    // Every woken helper checks out before we return, so none can still be reading m_fn when
+    // the next run() replaces it. The last one posts m_finished exactly once per run(), so a
+    // short spin covers the usual case and a preempted helper costs a sleep, not a busy period.
+    for (int spins = 0; spins < kSpinsBeforeBlock; ++spins) {
+        if (m_busyHelpers.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+    }
+    while (sem_wait(&m_finished) != 0 && errno == EINTR) {
+    }
+}
+
+void RtWorkerPool::drainJobs() {
+    int job = 0;
+    while ((job = m_nextJob.fetch_add(1, std::memory_order_relaxed)) < m_jobCount) {
+        m_fn(m_context, job);
+    }
+}
+
+void RtWorkerPool::helperLoop(Helper &helper) {
+    while (true) {
+        if (sem_wait(&helper.wake) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (m_quit.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const auto begin = std::chrono::steady_clock::now();
+        {
+            RtSafety::AudioThreadScope rtScope;
+            drainJobs();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - begin;
+        helper.busyNs.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            std::memory_order_relaxed);
+        if (m_busyHelpers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            sem_post(&m_finished);
+        }
+    }
+}
+
+void RtWorkerPool::publishLoad(double callerNs, double periodNs) {
+    if (periodNs <= 0.0) {
+        return;
+    }
+    auto smooth = [](std::atomic<float> &target, double busyNs, double period) {
+        const float now = static_cast<float>(std::min(1.0, busyNs / period));
+        const float prev = target.load(std::memory_order_relaxed);
+        target.store(prev + (now - prev) * kLoadSmoothing, std::memory_order_relaxed);
+    };
+    smooth(m_callerLoad, callerNs, periodNs);
+    for (auto &helper : m_helpers) {
+        const long long busy = helper->busyNs.exchange(0, std::memory_order_relaxed);
+        smooth(helper->load, static_cast<double>(busy), periodNs);
+    }
+}
+
+float RtWorkerPool::load(int index) const {
+    if (index == 0) {
+        return m_callerLoad.load(std::memory_order_relaxed);
+    }
+    if (index < 0 || index > static_cast<int>(m_helpers.size())) {
+        return 0.0f;
+    }
+    return m_helpers[static_cast<size_t>(index - 1)]->load.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <semaphore.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Fixed set of helper threads for the audio callback. run() hands out job indices to the
+// helpers and the calling thread alike and returns once every job has finished, so it doubles
+// as the barrier before whatever consumes the results. Nothing here allocates or locks after
+// start(); with no helpers (offline engines, single-core machines) run() is a plain loop.
+class RtWorkerPool {
+public:
+    using JobFn = void (*)(void *context, int job);
+
+    RtWorkerPool() = default;
+    ~RtWorkerPool();
+    RtWorkerPool(const RtWorkerPool &) = delete;
+    RtWorkerPool &operator=(const RtWorkerPool &) = delete;
+
+    // Helpers are pinned to cores in turn when given and keep the inherited affinity otherwise,
+    // so they never land on the caller's core by default. They run SCHED_FIFO at priority when
+    // the process is allowed to; otherwise they keep the default policy.
+    void start(int helpers, int priority, const std::vector<int> &cores = {});
+    void stop();
+    int helperCount() const { return static_cast<int>(m_helpers.size()); }
+
+    void run(JobFn fn, void *context, int jobs);
+    template <typename F>
+    void run(int jobs, F &fn) {
+        run([](void *context, int job) { (*static_cast<F *>(context))(job); }, &fn, jobs);
+    }
+
+    // Called once per period by the thread that calls run(): callerNs is the time it spent on
+    // the whole period, periodNs the time the period lasts.
+    void publishLoad(double callerNs, double periodNs);
+    // Smoothed share of the period spent busy. Index 0 is the calling thread, 1.. the helpers.
+    float load(int index) const;
+
+private:
+    struct Helper {
+        std::thread thread;
+        sem_t wake;
+        std::atomic<long long> busyNs{0};
+        std::atomic<float> load{0.0f};
+    };
+
+    void helperLoop(Helper &helper);
+    void drainJobs();
+
+    std::vector<std::unique_ptr<Helper>> m_helpers;
+    std::atomic<bool> m_quit{false};
+    // Written by the caller before the helpers are woken; the semaphore orders them.
+    JobFn m_fn = nullptr;
+    void *m_context = nullptr;
+    int m_jobCount = 0;
+    alignas(64) std::atomic<int> m_nextJob{0};
+    alignas(64) std::atomic<int> m_busyHelpers{0};
+    // Posted by the last helper to check out; run() waits on it once spinning stops paying off.
+    sem_t m_finished;
+    bool m_finishedReady = false;
+    std::atomic<float> m_callerLoad{0.0f};
+};
@@ -0,0 +1,139 @@
+#include "SampleBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+namespace {
+
+size_t sampleBytes(SampleBuffer::Format format) {
+    return format == SampleBuffer::Format::Int16 ? sizeof(int16_t) : sizeof(float);
+}
+
+}  // namespace
+
+std::shared_ptr<SampleBuffer> SampleBuffer::create(int frames, int channels, int sampleRate,
+                                                   Format format) {
+    if (frames <= 0 || channels <= 0) {
+        return nullptr;
+    }
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+    buffer->m_frames = frames;
+    buffer->m_channels = channels;
+    buffer->m_sampleRate = sampleRate;
+    buffer->m_format = format;
+    const size_t bytes = buffer->bytes();
+    // Rounded up to whole cache lines so SIMD tails can never run into a neighbour's line.
+    const size_t padded = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    buffer->m_data = ::operator new(padded, std::align_val_t(kAlignment));
+    buffer->m_owned = true;
+    std::memset(buffer->m_data, 0, padded);
+    return buffer;
+}
+
+std::shared_ptr<const SampleBuffer> SampleBuffer::wrap(const void *data, int frames,
+                                                       int channels, int sampleRate,
+                                                       Format format,
+                                                       std::shared_ptr<const void> owner) {
+    if (!data || frames <= 0 || channels <= 0) {
+        return nullptr;
+    }
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+    buffer->m_data = const_cast<void *>(data);
+    buffer->m_owner = std::move(owner);
+    buffer->m_frames = frames;
+    buffer->m_channels = channels;
+    buffer->m_sampleRate = sampleRate;
+    buffer->m_format = format;
+    return buffer;
+}
+
+std::shared_ptr<const SampleBuffer> SampleBuffer::quantized(const SampleBuffer &source) {
+    const float *src = source.floatData();
+    if (!src) {
+        return nullptr;
+    }
+    std::shared_ptr<SampleBuffer> buffer =
+        create(source.m_frames, source.m_channels, source.m_sampleRate, Format::Int16);
+    if (!buffer) {
+        return nullptr;
+    }
+    int16_t *dst = buffer->writableInt16();
+    const size_t count = static_cast<size_t>(source.m_frames) * source.m_channels;
+    for (size_t i = 0; i < count; ++i) {
+        const long v = std::lrint(src[i] * 32768.0f);
+        if (v < -32768 || v > 32767) {
+            return nullptr;
+        }
+        dst[i] = static_cast<int16_t>(v);
+    }
+    return buffer;
+}
+
+SampleBuffer::~SampleBuffer() {
+    if (m_owned) {
+        ::operator delete(m_data, std::align_val_t(kAlignment));
+    }
+}
+
+size_t SampleBuffer::bytes() const {
+    return static_cast<size_t>(m_frames) * static_cast<size_t>(m_channels) *
+           sampleBytes(m_format);
+}
+
+const float *SampleBuffer::floatData() const {
+    return m_format == Format::Float32 ? static_cast<const float *>(m_data) : nullptr;
+}
+
+const int16_t *SampleBuffer::int16Data() const {
+    return m_format == Format::Int16 ? static_cast<const int16_t *>(m_data) : nullptr;
+}
+
+float SampleBuffer::sample(int frame, int channel) const {
+    const size_t at = static_cast<size_t>(frame) * m_channels +
+                      static_cast<size_t>(std::min(channel, m_channels - 1));
+    if (m_format == Format::Int16) {
+        return static_cast<const int16_t *>(m_data)[at] * kInt16Scale;
+    }
+    return static_cast<const float *>(m_data)[at];
+}
+
+void SampleBuffer::readFloat(int start, int count, float *out) const {
+    const size_t first = static_cast<size_t>(start) * m_channels;
+    const size_t n = static_cast<size_t>(count) * m_channels;
+    if (m_format == Format::Int16) {
+        const int16_t *src = static_cast<const int16_t *>(m_data) + first;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = src[i] * kInt16Scale;
+        }
+        return;
+    }
+    std::memcpy(out, static_cast<const float *>(m_data) + first, n * sizeof(float));
+}
+
+float SampleBuffer::peak() const {
+    const size_t count = static_cast<size_t>(m_frames) * m_channels;
+    if (m_format == Format::Int16) {
+        const int16_t *src = static_cast<const int16_t *>(m_data);
+        int peak = 0;
+        for (size_t i = 0; i < count; ++i) {
+            peak = std::max(peak, std::abs(static_cast<int>(src[i])));
+        }
+        return peak * kInt16Scale;
+    }
+    const float *src = static_cast<const float *>(m_data);
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        peak = std::max(peak, std::fabs(src[i]));
+    }
+    return peak;
+}
+
+float *SampleBuffer::writableFloat() {
+    return m_owned && m_format == Format::Float32 ? static_cast<float *>(m_data) : nullptr;
+}
+
+int16_t *SampleBuffer::writableInt16() {
+    return m_owned && m_format == Format::Int16 ? static_cast<int16_t *>(m_data) : nullptr;
+}
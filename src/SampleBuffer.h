@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Immutable PCM for sample voices: interleaved frames in the source's own channel count, held
+// as float or 16-bit integers in 64-byte aligned memory. Whoever creates a buffer fills it
+// through the writable pointers before handing it out; everyone else holds a
+// shared_ptr<const SampleBuffer>, so nothing can detach or reallocate it under the mixer.
+class SampleBuffer {
+public:
+    enum class Format { Float32, Int16 };
+
+    static constexpr size_t kAlignment = 64;
+    // Int16 samples are full scale at 32768.
+    static constexpr float kInt16Scale = 1.0f / 32768.0f;
+
+    // Zeroed storage for frames x channels samples; null when either is not positive.
+    static std::shared_ptr<SampleBuffer> create(int frames, int channels, int sampleRate,
+                                                Format format = Format::Float32);
+    // Frames living in memory kept alive by owner (a mapped cache file) instead of own storage.
+    static std::shared_ptr<const SampleBuffer> wrap(const void *data, int frames, int channels,
+                                                    int sampleRate, Format format,
+                                                    std::shared_ptr<const void> owner);
+    // An Int16 copy of float data, or null when some sample would clip.
+    static std::shared_ptr<const SampleBuffer> quantized(const SampleBuffer &source);
+
+    ~SampleBuffer();
+    SampleBuffer(const SampleBuffer &) = delete;
+    SampleBuffer &operator=(const SampleBuffer &) = delete;
+
+    int frames() const { return m_frames; }
+    int channels() const { return m_channels; }
+    int sampleRate() const { return m_sampleRate; }
+    Format format() const { return m_format; }
+    bool isValid() const { return m_sampleRate > 0 && m_frames > 0 && m_data; }
+
+    const void *data() const { return m_data; }
+    size_t bytes() const;
+    // Null unless the buffer holds that format.
+    const float *floatData() const;
+    const int16_t *int16Data() const;
+
+    // One sample as float; mono buffers answer every channel.
+    float sample(int frame, int channel) const;
+    // Copies frames [start, start + count) to out as interleaved floats.
+    void readFloat(int start, int count, float *out) const;
+    // Largest absolute sample value, as float.
+    float peak() const;
+
+    // Only for the code that created the buffer, before it is shared.
+    float *writableFloat();
+    int16_t *writableInt16();
+
+private:
+    SampleBuffer() = default;
+
+    void *m_data = nullptr;
+    bool m_owned = false;
+    std::shared_ptr<const void> m_owner;
+    int m_frames = 0;
+    int m_channels = 0;
+    int m_sampleRate = 0;
+    Format m_format = Format::Float32;
+};
@@ -0,0 +1,199 @@
+#include "SampleCache.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtGlobal>
+#include <climits>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SampleCache {
+namespace {
+
+constexpr quint32 kVersion = 2;
+constexpr qint64 kDefaultBudgetMb = 512;
+// Frames start here so the samples stay cache-line aligned in the mapping.
+constexpr qint64 kHeaderBytes = 64;
+
+struct Header {
+    char magic[4];
+    quint32 version;
+    quint32 sampleRate;
+    quint32 channels;
+    quint32 format;
+    qint64 frames;
+    qint64 sourceSize;
+    qint64 sourceMtime;
+    float peak;
+};
+static_assert(sizeof(Header) <= kHeaderBytes, "cache header outgrew its slot");
+
+struct Key {
+    QString file;
+    qint64 sourceSize = 0;
+    qint64 sourceMtime = 0;
+};
+
+QString cacheDir() {
+    const QString env = qEnvironmentVariable("GROOVEBOX_SAMPLE_CACHE");
+    if (!env.isEmpty()) {
+        return env;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           "/groovebox/samples";
+}
+
+qint64 budgetBytes() {
+    bool ok = false;
+    const int env = qEnvironmentVariableIntValue("GROOVEBOX_SAMPLE_CACHE_MB", &ok);
+    const qint64 mb = ok ? qMax(0, env) : kDefaultBudgetMb;
+    return mb * 1024 * 1024;
+}
+
+bool makeKey(const QString &path, int sampleRate, Key *key) {
+    if (sampleRate <= 0 || budgetBytes() <= 0) {
+        return false;
+    }
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return false;
+    }
+    QString source = info.canonicalFilePath();
+    if (source.isEmpty()) {
+        source = info.absoluteFilePath();
+    }
+    key->sourceSize = info.size();
+    key->sourceMtime = info.lastModified().toMSecsSinceEpoch();
+    const QByteArray id = source.toUtf8() + '\n' + QByteArray::number(key->sourceSize) + '\n' +
+                          QByteArray::number(key->sourceMtime) + '\n' +
+                          QByteArray::number(sampleRate);
+    const QByteArray hash = QCryptographicHash::hash(id, QCryptographicHash::Sha1).toHex();
+    key->file = cacheDir() + '/' + QString::fromLatin1(hash) + ".pcm";
+    return true;
+}
+
+// Drops the least recently used entries until the directory fits the budget. load() bumps an
+// entry's mtime, so mtime order is use order.
+void trim() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    const qint64 budget = budgetBytes();
+    const QFileInfoList entries = QDir(cacheDir()).entryInfoList(
+        QStringList{QStringLiteral("*.pcm")}, QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+        if (total > budget) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
+
+}  // namespace
+
+std::shared_ptr<const AudioEngine::Buffer> load(const QString &path, int sampleRate,
+                                                float *peak) {
+    Key key;
+    if (!makeKey(path, sampleRate, &key)) {
+        return nullptr;
+    }
+    const int fd = ::open(QFile::encodeName(key.file).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= kHeaderBytes) {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::futimens(fd, nullptr);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, base, sizeof(header));
+    const bool int16 = header.format == static_cast<quint32>(SampleBuffer::Format::Int16);
+    const qint64 expected =
+        kHeaderBytes + header.frames * static_cast<qint64>(header.channels) *
+                           static_cast<qint64>(int16 ? sizeof(int16_t) : sizeof(float));
+    if (std::memcmp(header.magic, "GBSC", 4) != 0 || header.version != kVersion ||
+        header.sampleRate != static_cast<quint32>(sampleRate) ||
+        (!int16 && header.format != static_cast<quint32>(SampleBuffer::Format::Float32)) ||
+        header.channels < 1 ||
+        header.channels > 2 || header.frames <= 0 || header.frames > INT_MAX ||
+        header.sourceSize != key.sourceSize || header.sourceMtime != key.sourceMtime ||
+        expected != static_cast<qint64>(size)) {
+        ::munmap(base, size);
+        QFile::remove(key.file);
+        return nullptr;
+    }
+    // Start reading ahead now so the first trigger does not fault pages in on the audio thread.
+    ::madvise(base, size, MADV_WILLNEED);
+
+    std::shared_ptr<const void> mapping(
+        base, [size](const void *p) { ::munmap(const_cast<void *>(p), size); });
+    if (peak) {
+        *peak = header.peak;
+    }
+    return SampleBuffer::wrap(static_cast<const char *>(base) + kHeaderBytes,
+                              static_cast<int>(header.frames), static_cast<int>(header.channels),
+                              sampleRate,
+                              int16 ? SampleBuffer::Format::Int16 : SampleBuffer::Format::Float32,
+                              std::move(mapping));
+}
+
+void store(const QString &path, const AudioEngine::Buffer &buffer, float peak) {
+    if (!buffer.isValid() || buffer.channels() > 2) {
+        return;
+    }
+    Key key;
+    if (!makeKey(path, buffer.sampleRate(), &key)) {
+        return;
+    }
+    const qint64 dataBytes = static_cast<qint64>(buffer.bytes());
+    if (kHeaderBytes + dataBytes > budgetBytes() || !QDir().mkpath(cacheDir())) {
+        return;
+    }
+
+    char head[kHeaderBytes] = {};
+    Header header{};
+    std::memcpy(header.magic, "GBSC", 4);
+    header.version = kVersion;
+    header.sampleRate = static_cast<quint32>(buffer.sampleRate());
+    header.channels = static_cast<quint32>(buffer.channels());
+    header.format = static_cast<quint32>(buffer.format());
+    header.frames = buffer.frames();
+    header.sourceSize = key.sourceSize;
+    header.sourceMtime = key.sourceMtime;
+    header.peak = peak;
+    std::memcpy(head, &header, sizeof(header));
+
+    // QSaveFile renames into place on commit, so a concurrent load never maps a partial entry.
+    QSaveFile file(key.file);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(head, kHeaderBytes);
+    file.write(reinterpret_cast<const char *>(buffer.data()), dataBytes);
+    if (!file.commit()) {
+        return;
+    }
+    trim();
+}
+
+}  // namespace SampleCache
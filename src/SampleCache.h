@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QString>
+#include <memory>
+
+#include "AudioEngine.h"
+
+// Decoded pad samples kept on disk at the engine rate, so reloading a kit skips the decode.
+// Entries are the buffer's frames (float or 16-bit) behind a small header, keyed by the
+// source's path, size, mtime and the target rate, and come back memory-mapped: pages load on
+// first touch. The directory is trimmed to a size budget, least recently used first. Calls
+// touch the disk and are thread-safe.
+//
+// Location: GROOVEBOX_SAMPLE_CACHE, else ~/.cache/groovebox/samples.
+// Budget: GROOVEBOX_SAMPLE_CACHE_MB (default 512); 0 disables the cache.
+namespace SampleCache {
+
+// Maps the cached decode of path at sampleRate. Returns null when there is no entry for the
+// file as it is now; *peak receives the absolute peak stored with it.
+std::shared_ptr<const AudioEngine::Buffer> load(const QString &path, int sampleRate,
+                                                float *peak);
+
+// Saves buffer as the decode of path at its sample rate, then trims the cache.
+void store(const QString &path, const AudioEngine::Buffer &buffer, float peak);
+
+}  // namespace SampleCache
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+
+#include "AudioEngine.h"
+
+// Sample file loading for pads and previews. WAV, FLAC and Layer III MP3 are parsed and
+// decoded in-process (MP3 through Mp3Decoder); Layer I/II, free-format MP3 and anything else go
+// through ffmpeg. All calls block and are thread-safe, so decode() belongs on a worker thread.
+namespace SampleDecoder {
+
+struct Info {
+    int sampleRate = 0;
+    int channels = 0;
+    qint64 frames = 0;
+    qint64 durationMs = 0;
+    // True when decode() handles the file without ffmpeg.
+    bool native = false;
+    // Native WAV only: where the interleaved PCM starts in the file and how it is coded, so it
+    // can be read in place (see SampleStream). pcmOffset stays 0 for anything else.
+    qint64 pcmOffset = 0;
+    int pcmBytesPerSample = 0;
+    bool pcmFloat = false;
+};
+
+// Reads only the stream headers, so it is cheap enough for the GUI thread. Returns false for
+// unreadable or unrecognised files.
+bool probe(const QString &path, Info *info);
+
+// Decodes to frames at sampleRate: 16-bit sources come back as Int16 buffers, the rest as
+// float. Mono stays mono; wider files keep their first two channels. maxFrames > 0 stops after
+// that many output frames. Returns null on failure.
+std::shared_ptr<const AudioEngine::Buffer> decode(const QString &path, int sampleRate,
+                                                  qint64 maxFrames = 0);
+
+// Converts `frames` frames of in-place PCM described by info to interleaved floats, keeping
+// the first `channels` channels of each frame.
+void convertPcm(const Info &info, const uchar *src, int frames, int channels, float *out);
+
+}  // namespace SampleDecoder
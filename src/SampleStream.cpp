@@ -0,0 +1,127 @@
+#include "SampleStream.h"
+
+#include <QFile>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Resampler.h"
+
+namespace {
+
+constexpr int kMaxChannels = 2;
+constexpr int kScanFrames = 65536;
+
+}  // namespace
+
+std::shared_ptr<const SampleStream> SampleStream::open(const QString &path, int sampleRate) {
+    SampleDecoder::Info info;
+    if (sampleRate <= 0 || !SampleDecoder::probe(path, &info) || info.pcmOffset <= 0 ||
+        info.frames <= 0) {
+        return nullptr;
+    }
+    const double step = static_cast<double>(info.sampleRate) / sampleRate;
+    const double outFrames = std::floor(info.frames / step);
+    if (outFrames < 2.0 || outFrames > INT_MAX) {
+        return nullptr;
+    }
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::shared_ptr<SampleStream> stream(new SampleStream());
+    stream->m_fd = fd;
+    stream->m_info = info;
+    stream->m_frames = static_cast<int>(outFrames);
+    stream->m_channels = std::min(info.channels, kMaxChannels);
+    stream->m_sampleRate = sampleRate;
+    stream->m_step = step;
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    const int headFrames = std::min(
+        stream->m_frames, static_cast<int>(static_cast<qint64>(kHeadMs) * sampleRate / 1000));
+    std::shared_ptr<SampleBuffer> head =
+        SampleBuffer::create(headFrames, stream->m_channels, sampleRate);
+    if (!head || !stream->read(0, headFrames, head->writableFloat())) {
+        return nullptr;
+    }
+    stream->m_head = std::move(head);
+    return stream;
+}
+
+SampleStream::~SampleStream() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool SampleStream::readSource(qint64 first, int count, float *out) const {
+    const size_t frameBytes = static_cast<size_t>(m_info.pcmBytesPerSample * m_info.channels);
+    std::vector<uchar> bytes(static_cast<size_t>(count) * frameBytes);
+    const off_t offset =
+        static_cast<off_t>(m_info.pcmOffset + first * static_cast<qint64>(frameBytes));
+    size_t done = 0;
+    while (done < bytes.size()) {
+        const ssize_t got = ::pread(m_fd, bytes.data() + done, bytes.size() - done,
+                                    offset + static_cast<off_t>(done));
+        if (got <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(got);
+    }
+    SampleDecoder::convertPcm(m_info, bytes.data(), count, m_channels, out);
+    return true;
+}
+
+bool SampleStream::read(qint64 first, int count, float *out) const {
+    if (count <= 0) {
+        return true;
+    }
+    std::fill(out, out + static_cast<size_t>(count) * m_channels, 0.0f);
+    if (first >= m_frames) {
+        return true;
+    }
+    if (m_info.sampleRate == m_sampleRate) {
+        const int available = static_cast<int>(std::min<qint64>(count, m_info.frames - first));
+        return readSource(first, available, out);
+    }
+    // Read the source window under the output frames plus the resampler's reach either side,
+    // so window edges sound the same as the middle of a whole-file decode.
+    const int reach = Resampler::reach(m_step);
+    const double pos = first * m_step;
+    const qint64 from = std::max<qint64>(0, static_cast<qint64>(std::floor(pos)) - reach);
+    const qint64 to = std::min<qint64>(
+        m_info.frames, static_cast<qint64>(std::floor((first + count - 1) * m_step)) + reach + 1);
+    if (to <= from) {
+        return true;
+    }
+    const int windowFrames = static_cast<int>(to - from);
+    std::vector<float> window(static_cast<size_t>(windowFrames) * m_channels);
+    if (!readSource(from, windowFrames, window.data())) {
+        return false;
+    }
+    Resampler::resample(window.data(), m_channels, 0, windowFrames, pos - from, m_step, out,
+                        count);
+    return true;
+}
+
+float SampleStream::scanPeak() const {
+    std::vector<float> chunk(static_cast<size_t>(kScanFrames) * m_channels);
+    float peak = 0.0f;
+    for (qint64 at = 0; at < m_info.frames; at += kScanFrames) {
+        const int count = static_cast<int>(std::min<qint64>(kScanFrames, m_info.frames - at));
+        if (!readSource(at, count, chunk.data())) {
+            break;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(count) * m_channels; ++i) {
+            peak = std::max(peak, std::fabs(chunk[i]));
+        }
+    }
+    return peak;
+}
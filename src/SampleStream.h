@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+
+#include "SampleBuffer.h"
+#include "SampleDecoder.h"
+
+// A long sample played straight from disk instead of being decoded into memory. Opening one
+// decodes only the first kHeadMs into head(), so a voice can start on it at once; the engine's
+// stream reader fetches the rest with read() while the voice plays. Frames count at the rate
+// the stream was opened for; files at another rate are converted window by window with the
+// same resampler decode() uses. Only native WAV files stream. Immutable once opened, so any
+// thread may read it.
+class SampleStream {
+public:
+    static constexpr int kHeadMs = 500;
+
+    // Null for files that cannot be read in place.
+    static std::shared_ptr<const SampleStream> open(const QString &path, int sampleRate);
+
+    ~SampleStream();
+    SampleStream(const SampleStream &) = delete;
+    SampleStream &operator=(const SampleStream &) = delete;
+
+    int frames() const { return m_frames; }
+    int channels() const { return m_channels; }
+    int sampleRate() const { return m_sampleRate; }
+    const std::shared_ptr<const SampleBuffer> &head() const { return m_head; }
+
+    // Writes frames [first, first + count) to out as interleaved floats; frames past the end
+    // read as silence. Blocks on the disk. False once the file cannot be read any more.
+    bool read(qint64 first, int count, float *out) const;
+    // Largest absolute sample value in the file. Reads all of it, so keep it off the GUI thread.
+    float scanPeak() const;
+
+private:
+    SampleStream() = default;
+
+    // Source frames [first, first + count) as floats; false on a short or failed read.
+    bool readSource(qint64 first, int count, float *out) const;
+
+    int m_fd = -1;
+    SampleDecoder::Info m_info;
+    int m_frames = 0;
+    int m_channels = 0;
+    int m_sampleRate = 0;
+    // Source frames per output frame.
+    double m_step = 1.0;
+    std::shared_ptr<const SampleBuffer> m_head;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+// Four-lane float vectors over NEON or SSE2 for the voice and effect kernels, with a
+// plain-array stand-in elsewhere. Loads and stores are unaligned; integer loads convert to
+// float without scaling.
+
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GROOVEBOX_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GROOVEBOX_SIMD_SSE 1
+#endif
+
+namespace SimdVec {
+
+#if defined(GROOVEBOX_SIMD_NEON)
+using Vec = float32x4_t;
+inline Vec load(const float *p) { return vld1q_f32(p); }
+inline void store(float *p, Vec v) { vst1q_f32(p, v); }
+inline Vec splat(float v) { return vdupq_n_f32(v); }
+inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+inline Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+inline Vec vmin(Vec a, Vec b) { return vminq_f32(a, b); }
+inline Vec vmax(Vec a, Vec b) { return vmaxq_f32(a, b); }
+inline float hsum(Vec v) {
+    const float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+// ARMv7 has no vector divide: reciprocal estimate plus two Newton steps.
+inline Vec div(Vec a, Vec b) {
+    Vec r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+inline void loadStereo(const float *p, Vec &l, Vec &r) {
+    const float32x4x2_t lr = vld2q_f32(p);
+    l = lr.val[0];
+    r = lr.val[1];
+}
+inline void storeStereo(float *p, Vec l, Vec r) {
+    float32x4x2_t lr;
+    lr.val[0] = l;
+    lr.val[1] = r;
+    vst2q_f32(p, lr);
+}
+// Rows become columns: afterwards a holds lane 0 of all four, b lane 1 and so on.
+inline void transpose(Vec &a, Vec &b, Vec &c, Vec &d) {
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+inline Vec load(const int16_t *p) { return vcvtq_f32_s32(vmovl_s16(vld1_s16(p))); }
+inline Vec load(const int32_t *p) { return vcvtq_f32_s32(vld1q_s32(p)); }
+inline void loadStereo(const int16_t *p, Vec &l, Vec &r) {
+    const int16x4x2_t lr = vld2_s16(p);
+    l = vcvtq_f32_s32(vmovl_s16(lr.val[0]));
+    r = vcvtq_f32_s32(vmovl_s16(lr.val[1]));
+}
+#elif defined(GROOVEBOX_SIMD_SSE)
+using Vec = __m128;
+inline Vec load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, Vec v) { _mm_storeu_ps(p, v); }
+inline Vec splat(float v) { return _mm_set1_ps(v); }
+inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+inline Vec vmin(Vec a, Vec b) { return _mm_min_ps(a, b); }
+inline Vec vmax(Vec a, Vec b) { return _mm_max_ps(a, b); }
+inline float hsum(Vec v) {
+    const __m128 pair = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+inline void loadStereo(const float *p, Vec &l, Vec &r) {
+    const __m128 a = _mm_loadu_ps(p);
+    const __m128 b = _mm_loadu_ps(p + 4);
+    l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+inline void storeStereo(float *p, Vec l, Vec r) {
+    _mm_storeu_ps(p, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(l, r));
+}
+inline void transpose(Vec &a, Vec &b, Vec &c, Vec &d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+// Sign-extends by unpacking each int16 into the high half of a 32-bit lane.
+inline Vec widen(__m128i halves) { return _mm_cvtepi32_ps(_mm_srai_epi32(halves, 16)); }
+inline Vec load(const int16_t *p) {
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return widen(_mm_unpacklo_epi16(v, v));
+}
+inline Vec load(const int32_t *p) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+inline void loadStereo(const int16_t *p, Vec &l, Vec &r) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128 a = widen(_mm_unpacklo_epi16(v, v));
+    const __m128 b = widen(_mm_unpackhi_epi16(v, v));
+    l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+#endif
+
+#if defined(GROOVEBOX_SIMD_NEON) || defined(GROOVEBOX_SIMD_SSE)
+#define GROOVEBOX_SIMD 1
+#else
+// Four plain floats, for kernels written only in lanes. Code that has a scalar path checks
+// GROOVEBOX_SIMD and skips its vector loop instead.
+struct Vec {
+    float v[4];
+};
+inline Vec load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float *p, Vec a) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = a.v[i];
+    }
+}
+inline Vec splat(float x) { return {{x, x, x, x}}; }
+inline float hsum(Vec a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+inline Vec add(Vec a, Vec b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+inline Vec sub(Vec a, Vec b) {
+    return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+}
+inline Vec mul(Vec a, Vec b) {
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+inline void transpose(Vec &a, Vec &b, Vec &c, Vec &d) {
+    Vec *rows[4] = {&a, &b, &c, &d};
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j) {
+            const float t = rows[i]->v[j];
+            rows[i]->v[j] = rows[j]->v[i];
+            rows[j]->v[i] = t;
+        }
+    }
+}
+#endif
+
+}  // namespace SimdVec
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Single-producer / single-consumer ring of plain values for streaming blocks between
+// threads. write() and read() copy as much as fits and return how much they moved; neither
+// blocks or allocates. reset() sizes the storage and must not race either side.
+template <typename T>
+class SpscRingBuffer {
+public:
+    void reset(size_t minCapacity) {
+        size_t capacity = 2;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        m_data.assign(capacity, T());
+        m_mask = capacity - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return m_data.size(); }
+
+    size_t readAvailable() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+    }
+
+    size_t writeAvailable() const {
+        return m_data.size() -
+               (m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+
+    size_t write(const T *src, size_t count) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        count = std::min(count, writeAvailable());
+        const size_t start = head & m_mask;
+        const size_t first = std::min(count, m_data.size() - start);
+        std::copy(src, src + first, m_data.begin() + static_cast<std::ptrdiff_t>(start));
+        std::copy(src + first, src + count, m_data.begin());
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t read(T *dst, size_t count) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        count = std::min(count, readAvailable());
+        const size_t start = tail & m_mask;
+        const size_t first = std::min(count, m_data.size() - start);
+        const auto begin = m_data.begin() + static_cast<std::ptrdiff_t>(start);
+        std::copy(begin, begin + static_cast<std::ptrdiff_t>(first), dst);
+        std::copy(m_data.begin(), m_data.begin() + static_cast<std::ptrdiff_t>(count - first),
+                  dst + first);
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> m_data;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
@@ -0,0 +1,279 @@
+#include "TimeStretch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Resampler.h"
+#include "kiss_fftr.h"
+
+namespace TimeStretch {
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kTwoPi = 2.0 * kPi;
+
+// Vocoder framing. kSynthHop is the output hop; the analysis hop follows the stretch ratio.
+constexpr int kFftSize = 2048;
+constexpr int kBins = kFftSize / 2 + 1;
+constexpr int kSynthHop = kFftSize / 4;
+constexpr int kMaxAnalysisHop = kFftSize / 2;
+constexpr int kMinSynthHop = 32;
+
+// Spectral flux (rise in summed magnitude, relative to the previous frame) that counts as an
+// onset and resets phases to the analysis frame.
+constexpr float kTransientFlux = 0.6f;
+constexpr float kTransientFloor = 1e-3f;
+
+bool cancelled(const std::atomic<bool> *cancel) {
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+double wrapPhase(double phase) {
+    return phase - kTwoPi * std::floor((phase + kPi) / kTwoPi);
+}
+
+struct Channel {
+    std::vector<float> input;
+    std::vector<float> magnitude;
+    std::vector<float> phase;
+    std::vector<float> prevPhase;
+    std::vector<float> synthPhase;
+    std::vector<kiss_fft_cpx> spectrum;
+};
+
+// Phase vocoder with identity phase locking: peak bins advance by their measured frequency,
+// bins around a peak keep their phase offset to it. Returns outFrames samples per channel, or
+// nothing when cancelled.
+std::vector<std::vector<float>> stretch(std::vector<std::vector<float>> inputs, double ratio,
+                                        int outFrames, const std::atomic<bool> *cancel) {
+    int synthHop = kSynthHop;
+    double analysisHop = synthHop / ratio;
+    if (analysisHop > kMaxAnalysisHop) {
+        analysisHop = kMaxAnalysisHop;
+        synthHop = std::max(kMinSynthHop, static_cast<int>(std::lround(analysisHop * ratio)));
+        analysisHop = synthHop / ratio;
+    }
+
+    const int pad = kFftSize / 2;
+    std::vector<Channel> channels(inputs.size());
+    for (size_t c = 0; c < inputs.size(); ++c) {
+        Channel &ch = channels[c];
+        const std::vector<float> &src = inputs[c];
+        ch.input.assign(src.size() + static_cast<size_t>(pad) * 2 + kFftSize, 0.0f);
+        std::copy(src.begin(), src.end(), ch.input.begin() + pad);
+        ch.magnitude.assign(kBins, 0.0f);
+        ch.phase.assign(kBins, 0.0f);
+        ch.prevPhase.assign(kBins, 0.0f);
+        ch.synthPhase.assign(kBins, 0.0f);
+        ch.spectrum.resize(kBins);
+    }
+    inputs.clear();
+
+    std::vector<float> window(kFftSize);
+    for (int i = 0; i < kFftSize; ++i) {
+        window[static_cast<size_t>(i)] =
+            static_cast<float>(0.5 - 0.5 * std::cos(kTwoPi * i / kFftSize));
+    }
+
+    const int totalOut = outFrames + kFftSize * 2;
+    std::vector<std::vector<float>> outputs(channels.size(),
+                                            std::vector<float>(static_cast<size_t>(totalOut)));
+    std::vector<float> norm(static_cast<size_t>(totalOut), 0.0f);
+    const int frameCount = (outFrames + pad) / synthHop + 2;
+
+    kiss_fftr_cfg forward = kiss_fftr_alloc(kFftSize, 0, nullptr, nullptr);
+    kiss_fftr_cfg inverse = kiss_fftr_alloc(kFftSize, 1, nullptr, nullptr);
+    std::vector<float> frame(kFftSize);
+    std::vector<float> prevTotal(kBins, 0.0f);
+    std::vector<float> total(kBins, 0.0f);
+    std::vector<int> peaks;
+    peaks.reserve(kBins);
+    bool ok = true;
+
+    for (int f = 0; f < frameCount; ++f) {
+        if (cancelled(cancel)) {
+            ok = false;
+            break;
+        }
+        const double readPos = f * analysisHop;
+        const int readStart = static_cast<int>(readPos);
+        const double readFrac = readPos - readStart;
+        const int writeStart = f * synthHop;
+
+        std::fill(total.begin(), total.end(), 0.0f);
+        for (Channel &ch : channels) {
+            const size_t available = ch.input.size();
+            for (int i = 0; i < kFftSize; ++i) {
+                const size_t at = static_cast<size_t>(readStart + i);
+                const float a = at < available ? ch.input[at] : 0.0f;
+                const float b = at + 1 < available ? ch.input[at + 1] : 0.0f;
+                frame[static_cast<size_t>(i)] =
+                    (a + (b - a) * static_cast<float>(readFrac)) * window[static_cast<size_t>(i)];
+            }
+            kiss_fftr(forward, frame.data(), ch.spectrum.data());
+            for (int k = 0; k < kBins; ++k) {
+                const kiss_fft_cpx &bin = ch.spectrum[static_cast<size_t>(k)];
+                const float mag = std::sqrt(bin.r * bin.r + bin.i * bin.i);
+                ch.magnitude[static_cast<size_t>(k)] = mag;
+                ch.phase[static_cast<size_t>(k)] = std::atan2(bin.i, bin.r);
+                total[static_cast<size_t>(k)] += mag;
+            }
+        }
+
+        float rise = 0.0f;
+        float before = 0.0f;
+        for (int k = 0; k < kBins; ++k) {
+            rise += std::max(0.0f, total[static_cast<size_t>(k)] - prevTotal[static_cast<size_t>(k)]);
+            before += prevTotal[static_cast<size_t>(k)];
+        }
+        const bool reset = f == 0 || (rise > kTransientFloor && rise > before * kTransientFlux);
+        prevTotal.swap(total);
+
+        for (size_t c = 0; c < channels.size(); ++c) {
+            Channel &ch = channels[c];
+            if (reset) {
+                ch.synthPhase = ch.phase;
+            } else {
+                peaks.clear();
+                for (int k = 1; k + 1 < kBins; ++k) {
+                    const float m = ch.magnitude[static_cast<size_t>(k)];
+                    if (m > ch.magnitude[static_cast<size_t>(k) - 1] &&
+                        m >= ch.magnitude[static_cast<size_t>(k) + 1]) {
+                        peaks.push_back(k);
+                    }
+                }
+                if (peaks.empty()) {
+                    peaks.push_back(0);
+                }
+                int region = 0;
+                for (size_t p = 0; p < peaks.size(); ++p) {
+                    const int peak = peaks[p];
+                    const double omega = kTwoPi * peak / kFftSize;
+                    const double delta = wrapPhase(ch.phase[static_cast<size_t>(peak)] -
+                                                   ch.prevPhase[static_cast<size_t>(peak)] -
+                                                   omega * analysisHop);
+                    const double freq = omega + delta / analysisHop;
+                    const double peakPhase =
+                        ch.synthPhase[static_cast<size_t>(peak)] + freq * synthHop;
+                    // The region ends halfway to the next peak.
+                    const int regionEnd =
+                        p + 1 < peaks.size() ? (peak + peaks[p + 1]) / 2 : kBins - 1;
+                    const double offset = peakPhase - ch.phase[static_cast<size_t>(peak)];
+                    for (; region <= regionEnd; ++region) {
+                        ch.synthPhase[static_cast<size_t>(region)] = static_cast<float>(
+                            wrapPhase(ch.phase[static_cast<size_t>(region)] + offset));
+                    }
+                }
+            }
+            ch.prevPhase.swap(ch.phase);
+
+            for (int k = 0; k < kBins; ++k) {
+                const float mag = ch.magnitude[static_cast<size_t>(k)];
+                const float ph = ch.synthPhase[static_cast<size_t>(k)];
+                ch.spectrum[static_cast<size_t>(k)].r = mag * std::cos(ph);
+                ch.spectrum[static_cast<size_t>(k)].i = mag * std::sin(ph);
+            }
+            kiss_fftri(inverse, ch.spectrum.data(), frame.data());
+            std::vector<float> &out = outputs[c];
+            for (int i = 0; i < kFftSize && writeStart + i < totalOut; ++i) {
+                out[static_cast<size_t>(writeStart + i)] +=
+                    frame[static_cast<size_t>(i)] * window[static_cast<size_t>(i)];
+            }
+        }
+        for (int i = 0; i < kFftSize && writeStart + i < totalOut; ++i) {
+            const float w = window[static_cast<size_t>(i)];
+            norm[static_cast<size_t>(writeStart + i)] += w * w;
+        }
+    }
+    kiss_fftr_free(forward);
+    kiss_fftr_free(inverse);
+    if (!ok) {
+        return {};
+    }
+
+    // Output time t corresponds to padded frame position t - pad; kissfft's inverse is unscaled.
+    const float peakNorm = *std::max_element(norm.begin(), norm.end());
+    const float floor = peakNorm * 0.1f;
+    std::vector<std::vector<float>> result(outputs.size(),
+                                           std::vector<float>(static_cast<size_t>(outFrames)));
+    for (size_t c = 0; c < outputs.size(); ++c) {
+        for (int i = 0; i < outFrames; ++i) {
+            const size_t at = static_cast<size_t>(i + pad);
+            const float n = std::max(norm[at], floor) * kFftSize;
+            result[c][static_cast<size_t>(i)] = outputs[c][at] / n;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+std::shared_ptr<const AudioEngine::Buffer> render(const AudioEngine::Buffer &source,
+                                                  int startFrame, int endFrame, double tempo,
+                                                  double pitchRate,
+                                                  const std::atomic<bool> *cancel) {
+    const int channels = source.channels();
+    startFrame = std::max(0, startFrame);
+    endFrame = std::min(endFrame, source.frames());
+    if (channels <= 0 || endFrame <= startFrame || tempo <= 0.0 || pitchRate <= 0.0) {
+        return nullptr;
+    }
+    const int frames = endFrame - startFrame;
+    const int outFrames = std::max(1, static_cast<int>(std::lround(frames / tempo)));
+    const double ratio = pitchRate / tempo;
+    const bool shift = std::abs(pitchRate - 1.0) > 1e-4;
+    const bool lengthen = std::abs(ratio - 1.0) > 1e-4;
+
+    // Pitch first: reading pitchRate times faster raises the pitch and shortens the slice by the
+    // same factor; the vocoder then stretches it to the target length.
+    const int shiftedFrames = shift ? std::max(1, static_cast<int>(std::lround(frames / pitchRate)))
+                                    : frames;
+    std::vector<float> slice(static_cast<size_t>(frames) * static_cast<size_t>(channels));
+    source.readFloat(startFrame, frames, slice.data());
+    std::vector<float> shifted;
+    if (shift) {
+        shifted.resize(static_cast<size_t>(shiftedFrames) * static_cast<size_t>(channels));
+        Resampler::resample(slice.data(), channels, 0, frames, pitchRate, shifted.data(),
+                            shiftedFrames);
+    }
+    if (cancelled(cancel)) {
+        return nullptr;
+    }
+    std::vector<std::vector<float>> planes(static_cast<size_t>(channels));
+    const float *src = shift ? shifted.data() : slice.data();
+    for (int ch = 0; ch < channels; ++ch) {
+        std::vector<float> &plane = planes[static_cast<size_t>(ch)];
+        plane.resize(static_cast<size_t>(shiftedFrames));
+        for (int i = 0; i < shiftedFrames; ++i) {
+            plane[static_cast<size_t>(i)] = src[i * channels + ch];
+        }
+    }
+    shifted.clear();
+    slice.clear();
+    if (lengthen) {
+        const double exact = static_cast<double>(outFrames) / shiftedFrames;
+        planes = stretch(std::move(planes), exact, outFrames, cancel);
+        if (planes.empty()) {
+            return nullptr;
+        }
+    }
+
+    auto buffer = SampleBuffer::create(outFrames, channels, source.sampleRate());
+    float *out = buffer->writableFloat();
+    for (int ch = 0; ch < channels; ++ch) {
+        const std::vector<float> &plane = planes[static_cast<size_t>(ch)];
+        const int available = std::min(outFrames, static_cast<int>(plane.size()));
+        for (int i = 0; i < outFrames; ++i) {
+            out[i * channels + ch] = i < available ? plane[static_cast<size_t>(i)] : 0.0f;
+        }
+    }
+    if (source.format() == SampleBuffer::Format::Int16) {
+        if (std::shared_ptr<const SampleBuffer> compact = SampleBuffer::quantized(*buffer)) {
+            return compact;
+        }
+    }
+    return buffer;
+}
+
+}  // namespace TimeStretch
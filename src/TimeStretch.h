@@ -0,0 +1,23 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "AudioEngine.h"
+
+// In-process replacement for the ffmpeg asetrate + atempo chain used for processed pads. The
+// pitch shift is a windowed-sinc resample; the stretch that restores the length is a
+// phase-locked phase vocoder (kissfft) that resets phases on transients so hits stay sharp.
+// Pure function of its inputs, safe to run on any worker thread.
+namespace TimeStretch {
+
+// Renders frames [startFrame, endFrame) of source so the result plays `tempo` times faster and
+// `pitchRate` times higher: it is round((endFrame - startFrame) / tempo) frames long, with the
+// source's channel count and rate, and Int16 like the source when nothing clips. Returns null
+// on empty input or once *cancel turns true.
+std::shared_ptr<const AudioEngine::Buffer> render(const AudioEngine::Buffer &source,
+                                                  int startFrame, int endFrame, double tempo,
+                                                  double pitchRate,
+                                                  const std::atomic<bool> *cancel = nullptr);
+
+}  // namespace TimeStretch
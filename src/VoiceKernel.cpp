@@ -0,0 +1,345 @@
+#include "VoiceKernel.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "SampleBuffer.h"
+#include "SimdVec.h"
+
+namespace VoiceKernel {
+namespace {
+
+using namespace SimdVec;
+
+// Read positions run as 32.32 fixed point inside a block: exact steps, no double math per frame.
+constexpr double kFixedOne = 4294967296.0;
+constexpr float kInvFixedOne = 1.0f / 4294967296.0f;
+constexpr float kInvFixedHalf = 1.0f / 2147483648.0f;
+
+#if defined(GROOVEBOX_SIMD_NEON)
+// Four consecutive 32.32 read positions: whole frames go to idx[], fractions come back.
+struct Phase4 {
+    Phase4(uint64_t phase, uint64_t step) {
+        const uint64_t lanes[4] = {phase, phase + step, phase + 2 * step, phase + 3 * step};
+        p01 = vld1q_u64(lanes);
+        p23 = vld1q_u64(lanes + 2);
+        step4 = vdupq_n_u64(4 * step);
+    }
+    Vec next(int32_t *idx) {
+        const uint32x4_t whole = vcombine_u32(vshrn_n_u64(p01, 32), vshrn_n_u64(p23, 32));
+        const uint32x4_t frac = vcombine_u32(vmovn_u64(p01), vmovn_u64(p23));
+        vst1q_s32(idx, vreinterpretq_s32_u32(whole));
+        p01 = vaddq_u64(p01, step4);
+        p23 = vaddq_u64(p23, step4);
+        return vmulq_n_f32(vcvtq_f32_u32(frac), kInvFixedOne);
+    }
+    uint64x2_t p01;
+    uint64x2_t p23;
+    uint64x2_t step4;
+};
+#elif defined(GROOVEBOX_SIMD_SSE)
+struct Phase4 {
+    Phase4(uint64_t phase, uint64_t step) {
+        p01 = _mm_set_epi64x(static_cast<long long>(phase + step), static_cast<long long>(phase));
+        p23 = _mm_set_epi64x(static_cast<long long>(phase + 3 * step),
+                             static_cast<long long>(phase + 2 * step));
+        step4 = _mm_set1_epi64x(static_cast<long long>(4 * step));
+    }
+    Vec next(int32_t *idx) {
+        const __m128 a = _mm_castsi128_ps(p01);
+        const __m128 b = _mm_castsi128_ps(p23);
+        const __m128i frac = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i whole = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(idx), whole);
+        p01 = _mm_add_epi64(p01, step4);
+        p23 = _mm_add_epi64(p23, step4);
+        // SSE2 only converts signed ints, so drop the lowest fraction bit first.
+        return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(frac, 1)), _mm_set1_ps(kInvFixedHalf));
+    }
+    __m128i p01;
+    __m128i p23;
+    __m128i step4;
+};
+#endif
+
+#if defined(GROOVEBOX_SIMD)
+inline void accumulate(float *left, float *right, Vec l, Vec r, Vec gainL, Vec gainR,
+                       const float *env) {
+    l = mul(l, gainL);
+    r = mul(r, gainR);
+    if (env) {
+        const Vec e = load(env);
+        l = mul(l, e);
+        r = mul(r, e);
+    }
+    store(left, add(load(left), l));
+    store(right, add(load(right), r));
+}
+
+// Unity rate on a whole frame: every output frame is a source frame, so plain loads replace
+// the gather and the interpolation drops out.
+template <typename Sample, int Channels>
+int mixAligned(const Sample *src, const float *env, float gainL, float gainR, float *left,
+               float *right, int frames) {
+    const Vec gl = splat(gainL);
+    const Vec gr = splat(gainR);
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        Vec l;
+        Vec r;
+        if (Channels == 2) {
+            loadStereo(src + i * 2, l, r);
+        } else {
+            l = load(src + i);
+            r = l;
+        }
+        accumulate(left + i, right + i, l, r, gl, gr, env ? env + i : nullptr);
+    }
+    return i;
+}
+
+inline int32_t loadPair(const int16_t *p) {
+    int32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Each lane reads the frame under its read position (a) and the one after (b) with a single
+// vector load, and a transpose lines the lanes up, so gathered samples never round-trip
+// through memory on their way into the interpolation. The loads go in one row per lane.
+// Every lane's b must be in the buffer.
+#if defined(GROOVEBOX_SIMD_NEON)
+inline void gatherStereo(const float *data, const int32_t *idx, Vec &la, Vec &ra, Vec &lb,
+                         Vec &rb) {
+    la = vld1q_f32(data + idx[0] * 2);
+    ra = vld1q_f32(data + idx[1] * 2);
+    lb = vld1q_f32(data + idx[2] * 2);
+    rb = vld1q_f32(data + idx[3] * 2);
+    transpose(la, ra, lb, rb);
+}
+inline void gatherStereo(const int16_t *data, const int32_t *idx, Vec &la, Vec &ra, Vec &lb,
+                         Vec &rb) {
+    la = load(data + idx[0] * 2);
+    ra = load(data + idx[1] * 2);
+    lb = load(data + idx[2] * 2);
+    rb = load(data + idx[3] * 2);
+    transpose(la, ra, lb, rb);
+}
+inline void gatherMono(const float *data, const int32_t *idx, Vec &a, Vec &b) {
+    const float32x2x2_t p01 = vtrn_f32(vld1_f32(data + idx[0]), vld1_f32(data + idx[1]));
+    const float32x2x2_t p23 = vtrn_f32(vld1_f32(data + idx[2]), vld1_f32(data + idx[3]));
+    a = vcombine_f32(p01.val[0], p23.val[0]);
+    b = vcombine_f32(p01.val[1], p23.val[1]);
+}
+inline void gatherMono(const int16_t *data, const int32_t *idx, Vec &a, Vec &b) {
+    // Both frames of a lane as one 32-bit word, a in the low half.
+    int32x4_t w = vdupq_n_s32(loadPair(data + idx[0]));
+    w = vsetq_lane_s32(loadPair(data + idx[1]), w, 1);
+    w = vsetq_lane_s32(loadPair(data + idx[2]), w, 2);
+    w = vsetq_lane_s32(loadPair(data + idx[3]), w, 3);
+    a = vcvtq_f32_s32(vshrq_n_s32(vshlq_n_s32(w, 16), 16));
+    b = vcvtq_f32_s32(vshrq_n_s32(w, 16));
+}
+#elif defined(GROOVEBOX_SIMD_SSE)
+inline __m128i load64(const void *p) {
+    return _mm_loadl_epi64(static_cast<const __m128i *>(p));
+}
+inline void gatherStereo(const float *data, const int32_t *idx, Vec &la, Vec &ra, Vec &lb,
+                         Vec &rb) {
+    la = _mm_loadu_ps(data + idx[0] * 2);
+    ra = _mm_loadu_ps(data + idx[1] * 2);
+    lb = _mm_loadu_ps(data + idx[2] * 2);
+    rb = _mm_loadu_ps(data + idx[3] * 2);
+    transpose(la, ra, lb, rb);
+}
+inline void gatherStereo(const int16_t *data, const int32_t *idx, Vec &la, Vec &ra, Vec &lb,
+                         Vec &rb) {
+    // Interleave the lanes as int16, then as pairs, before widening: a = La0-3 Ra0-3.
+    const __m128i t01 =
+        _mm_unpacklo_epi16(load64(data + idx[0] * 2), load64(data + idx[1] * 2));
+    const __m128i t23 =
+        _mm_unpacklo_epi16(load64(data + idx[2] * 2), load64(data + idx[3] * 2));
+    const __m128i a = _mm_unpacklo_epi32(t01, t23);
+    const __m128i b = _mm_unpackhi_epi32(t01, t23);
+    la = widen(_mm_unpacklo_epi16(a, a));
+    ra = widen(_mm_unpackhi_epi16(a, a));
+    lb = widen(_mm_unpacklo_epi16(b, b));
+    rb = widen(_mm_unpackhi_epi16(b, b));
+}
+inline void gatherMono(const float *data, const int32_t *idx, Vec &a, Vec &b) {
+    const __m128 t01 = _mm_unpacklo_ps(_mm_castsi128_ps(load64(data + idx[0])),
+                                       _mm_castsi128_ps(load64(data + idx[1])));
+    const __m128 t23 = _mm_unpacklo_ps(_mm_castsi128_ps(load64(data + idx[2])),
+                                       _mm_castsi128_ps(load64(data + idx[3])));
+    a = _mm_movelh_ps(t01, t23);
+    b = _mm_movehl_ps(t23, t01);
+}
+inline void gatherMono(const int16_t *data, const int32_t *idx, Vec &a, Vec &b) {
+    const __m128i t01 = _mm_unpacklo_epi16(_mm_cvtsi32_si128(loadPair(data + idx[0])),
+                                           _mm_cvtsi32_si128(loadPair(data + idx[1])));
+    const __m128i t23 = _mm_unpacklo_epi16(_mm_cvtsi32_si128(loadPair(data + idx[2])),
+                                           _mm_cvtsi32_si128(loadPair(data + idx[3])));
+    const __m128i ab = _mm_unpacklo_epi32(t01, t23);
+    a = widen(_mm_unpacklo_epi16(ab, ab));
+    b = widen(_mm_unpackhi_epi16(ab, ab));
+}
+#endif
+
+// Mono or interleaved stereo at any rate. Stops at the first group whose last lane would
+// clamp to lastFrame; mixScalar() finishes from there.
+template <typename Sample, int Channels>
+int mixGather(const Sample *data, int lastFrame, uint64_t phase, uint64_t step,
+              const float *env, float gainL, float gainR, float *left, float *right,
+              int frames) {
+    const Vec gl = splat(gainL);
+    const Vec gr = splat(gainR);
+    Phase4 positions(phase, step);
+    alignas(16) int32_t idx[4];
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const Vec f = positions.next(idx);
+        if (idx[3] >= lastFrame) {
+            break;
+        }
+        Vec l;
+        Vec r;
+        if (Channels == 2) {
+            Vec la;
+            Vec ra;
+            Vec lb;
+            Vec rb;
+            gatherStereo(data, idx, la, ra, lb, rb);
+            l = add(la, mul(sub(lb, la), f));
+            r = add(ra, mul(sub(rb, ra), f));
+        } else {
+            Vec a;
+            Vec b;
+            gatherMono(data, idx, a, b);
+            l = add(a, mul(sub(b, a), f));
+            r = l;
+        }
+        accumulate(left + i, right + i, l, r, gl, gr, env ? env + i : nullptr);
+    }
+    return i;
+}
+#endif
+
+template <typename Sample>
+void mixScalar(const Sample *data, int channels, int lastFrame, double pos, double rate,
+               const float *env, float gainL, float gainR, float *left, float *right,
+               int frames) {
+    const bool stereo = channels > 1;
+    for (int i = 0; i < frames; ++i) {
+        const int idx = static_cast<int>(pos);
+        const double frac = pos - static_cast<double>(idx);
+        const int next = idx < lastFrame ? idx + 1 : lastFrame;
+        const Sample *a = data + idx * channels;
+        const Sample *b = data + next * channels;
+        const float leftA = a[0];
+        const float rightA = stereo ? a[1] : leftA;
+        const float leftB = b[0];
+        const float rightB = stereo ? b[1] : leftB;
+        const float l = leftA + static_cast<float>((leftB - leftA) * frac);
+        const float r = rightA + static_cast<float>((rightB - rightA) * frac);
+        const float e = env ? env[i] : 1.0f;
+        left[i] += l * gainL * e;
+        right[i] += r * gainR * e;
+        pos += rate;
+    }
+}
+
+template <typename Sample>
+void mix(const Sample *data, int channels, int lastFrame, double pos, double rate,
+         const float *env, float gainL, float gainR, float *left, float *right, int frames) {
+#if defined(GROOVEBOX_SIMD)
+    if (frames <= 0) {
+        return;
+    }
+    const int start = static_cast<int>(pos);
+    int done = 0;
+    if (rate == 1.0 && pos == static_cast<double>(start) && (channels == 1 || channels == 2)) {
+        const Sample *src = data + start * channels;
+        done = channels == 2
+                   ? mixAligned<Sample, 2>(src, env, gainL, gainR, left, right, frames)
+                   : mixAligned<Sample, 1>(src, env, gainL, gainR, left, right, frames);
+    } else {
+        const uint64_t phase = static_cast<uint64_t>(pos * kFixedOne);
+        const uint64_t step = static_cast<uint64_t>(rate * kFixedOne);
+        // Decoded samples are at most stereo; anything wider takes the scalar path.
+        if (channels == 1) {
+            done = mixGather<Sample, 1>(data, lastFrame, phase, step, env, gainL, gainR, left,
+                                        right, frames);
+        } else if (channels == 2) {
+            done = mixGather<Sample, 2>(data, lastFrame, phase, step, env, gainL, gainR, left,
+                                        right, frames);
+        }
+    }
+    if (done < frames) {
+        mixScalar(data, channels, lastFrame, pos + done * rate, rate, env ? env + done : nullptr,
+                  gainL, gainR, left + done, right + done, frames - done);
+    }
+#else
+    mixScalar(data, channels, lastFrame, pos, rate, env, gainL, gainR, left, right, frames);
+#endif
+}
+
+}  // namespace
+
+void mixLinearScalar(const float *data, int channels, int lastFrame, double pos, double rate,
+                     const float *env, float gainL, float gainR, float *left, float *right,
+                     int frames) {
+    mixScalar(data, channels, lastFrame, pos, rate, env, gainL, gainR, left, right, frames);
+}
+
+void mixLinearScalar(const int16_t *data, int channels, int lastFrame, double pos, double rate,
+                     const float *env, float gainL, float gainR, float *left, float *right,
+                     int frames) {
+    mixScalar(data, channels, lastFrame, pos, rate, env, gainL * SampleBuffer::kInt16Scale,
+              gainR * SampleBuffer::kInt16Scale, left, right, frames);
+}
+
+void mixLinear(const float *data, int channels, int lastFrame, double pos, double rate,
+               const float *env, float gainL, float gainR, float *left, float *right,
+               int frames) {
+    mix(data, channels, lastFrame, pos, rate, env, gainL, gainR, left, right, frames);
+}
+
+void mixLinear(const int16_t *data, int channels, int lastFrame, double pos, double rate,
+               const float *env, float gainL, float gainR, float *left, float *right,
+               int frames) {
+    // Samples stay integers through the interpolation; the scale rides on the gains.
+    mix(data, channels, lastFrame, pos, rate, env, gainL * SampleBuffer::kInt16Scale,
+        gainR * SampleBuffer::kInt16Scale, left, right, frames);
+}
+
+void interleaveAdd(const float *left, const float *right, float *out, int channels, int frames) {
+    int i = 0;
+#if defined(GROOVEBOX_SIMD)
+    if (channels == 2) {
+        for (; i + 4 <= frames; i += 4) {
+            Vec l;
+            Vec r;
+            loadStereo(out + i * 2, l, r);
+            storeStereo(out + i * 2, add(l, load(left + i)), add(r, load(right + i)));
+        }
+    }
+#endif
+    for (; i < frames; ++i) {
+        out[i * channels] += left[i];
+        if (channels > 1) {
+            out[i * channels + 1] += right[i];
+        }
+    }
+}
+
+const char *simdName() {
+#if defined(GROOVEBOX_SIMD_NEON)
+    return "neon";
+#elif defined(GROOVEBOX_SIMD_SSE)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace VoiceKernel
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Block kernels for sample voices. Sources are interleaved sample buffers, float or 16-bit;
+// destinations are planar left/right blocks that the engine interleaves into its bus buffers
+// once per bus.
+namespace VoiceKernel {
+
+// Accumulates `frames` frames of `data` read from `pos` onwards, stepping by `rate` with
+// linear interpolation, into left/right scaled by gain and env[i] (env may be null for unity).
+// Mono sources feed both sides; only the first two channels of wider sources are used. The
+// caller guarantees every read position stays below lastFrame + 1; the interpolation partner
+// of a frame is clamped to lastFrame.
+void mixLinear(const float *data, int channels, int lastFrame, double pos, double rate,
+               const float *env, float gainL, float gainR, float *left, float *right,
+               int frames);
+// 16-bit source, full scale at 32768; converted on the fly.
+void mixLinear(const int16_t *data, int channels, int lastFrame, double pos, double rate,
+               const float *env, float gainL, float gainR, float *left, float *right,
+               int frames);
+
+// Same contract, one frame at a time in double precision like the original mixer. Used on
+// targets without SIMD support and as the reference for the benchmark.
+void mixLinearScalar(const float *data, int channels, int lastFrame, double pos, double rate,
+                     const float *env, float gainL, float gainR, float *left, float *right,
+                     int frames);
+void mixLinearScalar(const int16_t *data, int channels, int lastFrame, double pos, double rate,
+                     const float *env, float gainL, float gainR, float *left, float *right,
+                     int frames);
+
+// out[i * channels + {0,1}] += left[i], right[i].
+void interleaveAdd(const float *left, const float *right, float *out, int channels, int frames);
+
+// Name of the instruction set mixLinear() was built for.
+const char *simdName();
+
+}  // namespace VoiceKernel
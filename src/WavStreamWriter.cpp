@@ -0,0 +1,142 @@
+#include "WavStreamWriter.h"
+
+#include <QDataStream>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+constexpr int kFlushBytes = 64 * 1024;
+}  // namespace
+
+WavStreamWriter::~WavStreamWriter() {
+    close();
+}
+
+bool WavStreamWriter::open(const QString &path, int srcRate, int targetRate, int channels) {
+    close();
+    if (path.isEmpty() || channels <= 0 || srcRate <= 0) {
+        return false;
+    }
+    m_channels = channels;
+    m_srcRate = srcRate;
+    m_targetRate = targetRate > 0 ? targetRate : srcRate;
+    m_step = static_cast<double>(m_srcRate) / static_cast<double>(m_targetRate);
+    m_nextPos = 0.0;
+    m_consumed = 0;
+    m_prevFrame.assign(static_cast<size_t>(channels), 0.0f);
+    m_lerpFrame.assign(static_cast<size_t>(channels), 0.0f);
+    m_pcm.clear();
+    m_pcm.reserve(kFlushBytes + channels * 2);
+    m_dataBytes = 0;
+    m_ok = true;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    if (!writeHeader(0)) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+void WavStreamWriter::appendFrame(const float *frame) {
+    const int offset = m_pcm.size();
+    m_pcm.resize(offset + m_channels * 2);
+    int16_t *out = reinterpret_cast<int16_t *>(m_pcm.data() + offset);
+    for (int ch = 0; ch < m_channels; ++ch) {
+        const float v = std::max(-1.0f, std::min(1.0f, frame[ch]));
+        out[ch] = static_cast<int16_t>(v * 32767.0f);
+    }
+}
+
+bool WavStreamWriter::write(const float *samples, int frames) {
+    if (!m_file.isOpen() || !samples || frames <= 0) {
+        return m_file.isOpen();
+    }
+    if (m_srcRate == m_targetRate) {
+        for (int i = 0; i < frames; ++i) {
+            appendFrame(samples + i * m_channels);
+            if (m_pcm.size() >= kFlushBytes) {
+                flush();
+            }
+        }
+    } else {
+        // Linear interpolation; the last frame of the previous block bridges the seam.
+        const qint64 end = m_consumed + frames;
+        while (true) {
+            const qint64 i0 = static_cast<qint64>(std::floor(m_nextPos));
+            if (i0 + 1 >= end) {
+                break;
+            }
+            const float frac = static_cast<float>(m_nextPos - static_cast<double>(i0));
+            const float *s0 = (i0 < m_consumed)
+                                  ? m_prevFrame.data()
+                                  : samples + (i0 - m_consumed) * m_channels;
+            const float *s1 = samples + (i0 + 1 - m_consumed) * m_channels;
+            for (int ch = 0; ch < m_channels; ++ch) {
+                m_lerpFrame[static_cast<size_t>(ch)] = s0[ch] + (s1[ch] - s0[ch]) * frac;
+            }
+            appendFrame(m_lerpFrame.data());
+            if (m_pcm.size() >= kFlushBytes) {
+                flush();
+            }
+            m_nextPos += m_step;
+        }
+        std::copy(samples + (frames - 1) * m_channels, samples + frames * m_channels,
+                  m_prevFrame.begin());
+        m_consumed = end;
+    }
+    return m_ok;
+}
+
+bool WavStreamWriter::flush() {
+    if (m_pcm.isEmpty()) {
+        return m_ok;
+    }
+    if (m_file.write(m_pcm) != m_pcm.size()) {
+        m_ok = false;
+    }
+    m_dataBytes += m_pcm.size();
+    m_pcm.resize(0);
+    return m_ok;
+}
+
+bool WavStreamWriter::writeHeader(quint32 dataBytes) {
+    const int byteRate = m_targetRate * m_channels * 2;
+    const int blockAlign = m_channels * 2;
+    const quint32 riffSize = 36 + dataBytes;
+
+    QDataStream ds(&m_file);
+    ds.setByteOrder(QDataStream::LittleEndian);
+    ds.writeRawData("RIFF", 4);
+    ds << riffSize;
+    ds.writeRawData("WAVE", 4);
+    ds.writeRawData("fmt ", 4);
+    ds << 16;
+    ds << static_cast<quint16>(1);
+    ds << static_cast<quint16>(m_channels);
+    ds << static_cast<quint32>(m_targetRate);
+    ds << static_cast<quint32>(byteRate);
+    ds << static_cast<quint16>(blockAlign);
+    ds << static_cast<quint16>(16);
+    ds.writeRawData("data", 4);
+    ds << dataBytes;
+    return ds.status() == QDataStream::Ok;
+}
+
+bool WavStreamWriter::close() {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    flush();
+    const quint32 dataBytes = static_cast<quint32>(qMin<qint64>(m_dataBytes, 0xFFFFFFFFLL - 36));
+    if (!m_file.seek(0) || !writeHeader(dataBytes)) {
+        m_ok = false;
+    }
+    m_file.close();
+    return m_ok && m_dataBytes > 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+// Writes interleaved float audio to a 16-bit PCM WAV file block by block, resampling on the fly
+// when the file rate differs from the source rate. The header goes out with zero sizes on
+// open() and is patched by close(), so memory use does not grow with the length of the take.
+class WavStreamWriter {
+public:
+    WavStreamWriter() = default;
+    ~WavStreamWriter();
+    WavStreamWriter(const WavStreamWriter &) = delete;
+    WavStreamWriter &operator=(const WavStreamWriter &) = delete;
+
+    bool open(const QString &path, int srcRate, int targetRate, int channels);
+    bool write(const float *samples, int frames);
+    bool close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+private:
+    void appendFrame(const float *frame);
+    bool flush();
+    bool writeHeader(quint32 dataBytes);
+
+    QFile m_file;
+    int m_channels = 2;
+    int m_srcRate = 48000;
+    int m_targetRate = 48000;
+    double m_step = 1.0;
+    // Absolute source position of the next output frame, and frames consumed so far.
+    double m_nextPos = 0.0;
+    qint64 m_consumed = 0;
+    std::vector<float> m_prevFrame;
+    std::vector<float> m_lerpFrame;
+    QByteArray m_pcm;
+    qint64 m_dataBytes = 0;
+    bool m_ok = true;
+};
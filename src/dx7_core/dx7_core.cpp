@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdio>
 #include <cstdarg>
 #include <cstring>
@@ -427,14 +428,20 @@ void Dx7Core::init(int sampleRate, int voices) {
     impl_->sampleRate = sampleRate;
     impl_->maxVoices = voices;
 
-    Exp2::init();
-    Tanh::init();
-    Sin::init();
-    Freqlut::init(sampleRate);
-    Lfo::init(sampleRate);
-    PitchEnv::init(sampleRate);
-    Env::init_sr(sampleRate);
-    Porta::init_sr(sampleRate);
+    // The lookup tables are shared by every core. Rebuild them only when the rate changes so a
+    // core can be prepared on one thread while another renders.
+    static std::atomic<int> tableRate{0};
+    if (tableRate.load() != sampleRate) {
+        Exp2::init();
+        Tanh::init();
+        Sin::init();
+        Freqlut::init(sampleRate);
+        Lfo::init(sampleRate);
+        PitchEnv::init(sampleRate);
+        Env::init_sr(sampleRate);
+        Porta::init_sr(sampleRate);
+        tableRate.store(sampleRate);
+    }
 
     impl_->tuning = createStandardTuning();
 
@@ -12,6 +12,7 @@
 #include "ConsoleModeGuard.h"
 #include "FramebufferCleaner.h"
 #include "MainWindow.h"
+#include "RtScheduling.h"
 
 namespace {
 class ExitShortcutFilter : public QObject {
@@ -47,6 +48,9 @@ void handleSigint(int) {
 }  // namespace
 
 int main(int argc, char *argv[]) {
+    // Before Qt starts any threads, so they all inherit the non-real-time cores.
+    RtScheduling::setupProcess();
+
 #ifdef Q_OS_LINUX
     if (qEnvironmentVariableIsEmpty("DISPLAY") &&
         qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY") &&
@@ -403,6 +403,16 @@ protected:
 };
 
 class StringEngine final : public Op1EngineBase {
+public:
+    void init(int sampleRate, int voices) override {
+        Op1EngineBase::init(sampleRate, voices);
+        // onNoteOn() runs on the audio thread; size for the lowest pitch (40 Hz) up front.
+        const size_t maxLen = static_cast<size_t>(sampleRate_ / 40.0f) + 1;
+        for (auto &voice : voices_) {
+            voice.delay.reserve(maxLen);
+        }
+    }
+
 protected:
     void onNoteOn(Op1Voice &voice) override {
         const float freq = std::max(40.0f, voice.baseFreq * (0.5f + params_.ratio * 0.5f));
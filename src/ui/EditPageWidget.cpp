@@ -59,13 +59,13 @@ QString keyNameFromIndex(int idx, bool minor) {
     return QString("%1 %2").arg(names[idx]).arg(minor ? "MIN" : "MAJ");
 }
 
-QString detectKeyFromBuffer(const std::shared_ptr<AudioEngine::Buffer> &buffer) {
+QString detectKeyFromBuffer(const std::shared_ptr<const AudioEngine::Buffer> &buffer) {
     if (!buffer || !buffer->isValid()) {
         return QString();
     }
 
-    const int channels = std::max(1, buffer->channels);
-    const int sampleRate = std::max(1, buffer->sampleRate);
+    const int channels = std::max(1, buffer->channels());
+    const int sampleRate = std::max(1, buffer->sampleRate());
     const int totalFrames = buffer->frames();
     const int maxFrames = std::min(totalFrames, sampleRate * 2);
     if (maxFrames <= 0) {
@@ -82,15 +82,10 @@ QString detectKeyFromBuffer(const std::shared_ptr<AudioEngine::Buffer> &buffer)
 
     std::vector<float> mono;
     mono.reserve(static_cast<size_t>(maxFrames / step + 1));
-    const QVector<float> &samples = buffer->samples;
     for (int i = 0; i < maxFrames; i += step) {
-        const int base = i * channels;
         float v = 0.0f;
         for (int ch = 0; ch < channels; ++ch) {
-            const int idx = base + ch;
-            if (idx < samples.size()) {
-                v += samples[idx];
-            }
+            v += buffer->sample(i, ch);
         }
         mono.push_back(v / static_cast<float>(channels));
     }
@@ -562,6 +557,23 @@ void EditPageWidget::mousePressEvent(QMouseEvent *event) {
         return;
     }
 
+    if (m_voicesRect.contains(pos) && m_pads) {
+        const int pad = m_pads->activePad();
+        // 1 -> 2 -> 4 -> 8 -> 1.
+        const int voices = m_pads->params(pad).polyphony;
+        m_pads->setPolyphony(pad, voices >= 8 ? 1 : voices * 2);
+        update();
+        return;
+    }
+
+    if (m_chokeRect.contains(pos) && m_pads) {
+        const int pad = m_pads->activePad();
+        const int group = m_pads->params(pad).chokeGroup;
+        m_pads->setChokeGroup(pad, (group + 1) % (AudioEngine::kChokeGroups + 1));
+        update();
+        return;
+    }
+
     if (m_copyRect.contains(pos) && m_pads) {
         const int from = m_pads->activePad();
         const int to = (from + 1) % m_pads->padCount();
@@ -870,6 +882,24 @@ void EditPageWidget::paintEvent(QPaintEvent *event) {
     p.setPen(normOn ? Theme::bg0() : Theme::accent());
     p.drawText(normRect, Qt::AlignCenter, "NORMALIZE");
 
+    // Voicing: polyphony and choke group, on the same row.
+    const PadBank::PadParams voicing =
+        m_pads ? m_pads->params(m_pads->activePad()) : PadBank::PadParams();
+    const QRectF voicesRect(fxRect.left(), normRect.top(), fxRect.width(), normRect.height());
+    const QRectF chokeRect(buttonsRect.right() - Theme::px(180), normRect.top(), Theme::px(180),
+                           normRect.height());
+    m_voicesRect = voicesRect;
+    m_chokeRect = chokeRect;
+    p.setBrush(Theme::bg1());
+    p.setPen(QPen(Theme::accent(), 1.2));
+    p.drawRoundedRect(voicesRect, Theme::px(8), Theme::px(8));
+    p.drawRoundedRect(chokeRect, Theme::px(8), Theme::px(8));
+    p.setPen(Theme::accent());
+    p.drawText(voicesRect, Qt::AlignCenter, QString("VOICES: %1").arg(voicing.polyphony));
+    const QString chokeText = voicing.chokeGroup > 0 ? QString::number(voicing.chokeGroup)
+                                                     : QString("OFF");
+    p.drawText(chokeRect, Qt::AlignCenter, QString("CHOKE: %1").arg(chokeText));
+
     p.setBrush(Theme::bg1());
     p.setPen(QPen(Theme::accentAlt(), 1.2));
     p.drawRoundedRect(deleteRect, Theme::px(10), Theme::px(10));
@@ -47,6 +47,8 @@ private:
     QHash<int, QPixmap> m_iconCache;
     QRectF m_fxBusRect;
     QRectF m_normalizeRect;
+    QRectF m_voicesRect;
+    QRectF m_chokeRect;
     QRectF m_deleteRect;
     QRectF m_copyRect;
     QRectF m_keyButtonRect;
@@ -1,5 +1,7 @@
 #include "FxPageWidget.h"
 
+#include <QDir>
+#include <QFileInfo>
 #include <QHideEvent>
 #include <QKeyEvent>
 #include <QMouseEvent>
@@ -27,6 +29,35 @@ float hash2(int x, int y, int t) {
     return (nn & 0x7fffffff) / static_cast<float>(0x7fffffff);
 }
 
+// Impulse responses for the conv effect: the WAVs in GROOVEBOX_IR_DIR, or ~/samples/ir.
+// Listed once; the IR knob picks one by position.
+const QStringList &impulseFiles() {
+    static const QStringList files = [] {
+        QString dir = qEnvironmentVariable("GROOVEBOX_IR_DIR");
+        if (dir.isEmpty()) {
+            dir = QDir::homePath() + "/samples/ir";
+        }
+        QStringList out;
+        const QDir irDir(dir);
+        const QStringList names =
+            irDir.entryList({"*.wav", "*.WAV"}, QDir::Files, QDir::Name | QDir::IgnoreCase);
+        for (const QString &name : names) {
+            out.push_back(irDir.filePath(name));
+        }
+        return out;
+    }();
+    return files;
+}
+
+QString impulseFor(float knob) {
+    const QStringList &files = impulseFiles();
+    if (files.isEmpty()) {
+        return QString();
+    }
+    const int last = static_cast<int>(files.size()) - 1;
+    return files[qBound(0, static_cast<int>(knob * (last + 0.99f)), last)];
+}
+
 QStringList effectGroups() {
     return {"ALL", "DYNAMICS", "DIST", "MOD", "SPACE", "EQ/FILTER", "VISUAL"};
 }
@@ -47,7 +78,7 @@ QString effectGroupFor(const QString &effect) {
         return "MOD";
     }
     if (fx == "delay" || fx == "reverb" || fx == "delay pitch" || fx == "pad" ||
-        fx == "vocoder") {
+        fx == "vocoder" || fx == "conv") {
         return "SPACE";
     }
     if (fx == "eq" || fx == "filter") {
@@ -76,7 +107,8 @@ FxPageWidget::FxPageWidget(PadBank *pads, QWidget *parent) : QWidget(parent), m_
     m_effects = {"reverb", "comp", "dist", "lofi",
                  "cassette", "chorus", "eq", "sidechan",
                  "delay", "tremolo", "ringmod", "robot",
-                 "punch", "subharm", "keyharm", "freeze"};
+                 "punch", "subharm", "keyharm", "freeze",
+                 "conv"};
 
     m_animTimer.setInterval(33);
     m_animTimer.setTimerType(Qt::PreciseTimer);
@@ -152,6 +184,9 @@ void FxPageWidget::assignEffect(int effectIndex) {
         track.inserts[m_selectedSlot].p1 = 0.45f;
         track.inserts[m_selectedSlot].p2 = 0.8f;  // wet
         track.inserts[m_selectedSlot].p3 = 0.0f;  // hold
+    } else if (name == "conv") {
+        track.inserts[m_selectedSlot].p1 = 0.35f; // mix
+        track.inserts[m_selectedSlot].p2 = 0.0f;  // first IR
     }
     syncBusEffects(m_selectedTrack);
     update();
@@ -530,6 +565,9 @@ void FxPageWidget::syncBusEffects(int trackIndex) {
             fx.p3 = slot.p3;
             fx.p4 = slot.p4;
             fx.p5 = slot.p5;
+            if (slot.effect == "conv") {
+                fx.impulse = impulseFor(slot.p2);
+            }
             ids.push_back(fx);
         }
     }
@@ -1111,13 +1149,32 @@ void FxPageWidget::drawEffectPreview(QPainter &p, const QRectF &rect, const FxIn
         p.drawLine(QPointF(r.left() + 12, c.y()), QPointF(r.right() - 12, c.y()));
         p.drawLine(QPointF(c.x() - 14, c.y() - 14), QPointF(c.x() + 14, c.y() + 14));
         p.drawLine(QPointF(c.x() - 14, c.y() + 14), QPointF(c.x() + 14, c.y() - 14));
+    } else if (fx == "conv") {
+        // Impulse response: a spike and its decaying tail.
+        const float base = r.bottom() - 14;
+        const float height = r.height() - 32;
+        const int bars = 28;
+        const float step = (r.width() - 24) / bars;
+        for (int i = 0; i < bars; ++i) {
+            const float decay = std::exp(-static_cast<float>(i) / (bars * (0.15f + p2 * 0.35f)));
+            const float jitter = 0.55f + 0.45f * hash2(i, static_cast<int>(p2 * 97.0f), 0);
+            const float h = height * (i == 0 ? 1.0f : decay * jitter * 0.7f);
+            const int alpha = static_cast<int>((0.35f + p1 * 0.6f) * 255);
+            p.setPen(QPen(QColor(200, 180, 255, alpha), 1.6));
+            const float x = r.left() + 12 + step * i;
+            p.drawLine(QPointF(x, base), QPointF(x, base - h));
+        }
     }
 
     if (fx != "comp") {
         QVector<ParamInfo> params;
         if (fx == "reverb") {
+            const float decaySec = 0.2f * std::pow(2.0f, p2 * 5.5f);
+            const float cutoff = 2000.0f * std::pow(2.0f, p4 * 3.0f);
             params.push_back({"WET", percent(p1), p1, 0});
-            params.push_back({"FEED", percent(p2), p2, 1});
+            params.push_back({"DECAY", QString("%1 s").arg(decaySec, 0, 'f', 1), p2, 1});
+            params.push_back({"SIZE", percent(p3), p3, 2});
+            params.push_back({"TONE", hzLabel(cutoff), p4, 3});
         } else if (fx == "dist") {
             const float drive = 1.0f + p1 * 6.0f;
             params.push_back({"DRIVE", QString("x%1").arg(drive, 0, 'f', 1), p1, 0});
@@ -1192,6 +1249,12 @@ void FxPageWidget::drawEffectPreview(QPainter &p, const QRectF &rect, const FxIn
             params.push_back({"LENGTH", msLabel(lenSec), p1, 0});
             params.push_back({"MIX", percent(p2), p2, 1});
             params.push_back({"REFRESH", (p3 >= 0.5f) ? "ON" : "OFF", p3, 2});
+        } else if (fx == "conv") {
+            const QString impulse = impulseFor(p2);
+            const QString irLabel =
+                impulse.isEmpty() ? QString("NONE") : QFileInfo(impulse).completeBaseName();
+            params.push_back({"MIX", percent(p1), p1, 0});
+            params.push_back({"IR", irLabel.left(10).toUpper(), p2, 1});
         }
 
         if (!params.isEmpty()) {
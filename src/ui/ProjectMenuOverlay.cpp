@@ -42,6 +42,8 @@ QJsonObject padParamsToJson(const PadBank::PadParams &p) {
     obj["loop"] = p.loop;
     obj["fxBus"] = p.fxBus;
     obj["normalize"] = p.normalize;
+    obj["polyphony"] = p.polyphony;
+    obj["choke"] = p.chokeGroup;
     return obj;
 }
 
@@ -59,6 +61,8 @@ PadBank::PadParams padParamsFromJson(const QJsonObject &obj) {
     p.loop = obj.value("loop").toBool(p.loop);
     p.fxBus = obj.value("fxBus").toInt(p.fxBus);
     p.normalize = obj.value("normalize").toBool(p.normalize);
+    p.polyphony = obj.value("polyphony").toInt(p.polyphony);
+    p.chokeGroup = obj.value("choke").toInt(p.chokeGroup);
     return p;
 }
 
@@ -329,6 +333,20 @@ ProjectMenuOverlay::ProjectMenuOverlay(PadBank *pads, SeqPageWidget *seq, FxPage
     setAttribute(Qt::WA_StyledBackground, true);
     setVisible(false);
     setFocusPolicy(Qt::StrongFocus);
+
+    if (m_seq) {
+        connect(m_seq, &SeqPageWidget::renderProgress, this, [this](int percent) {
+            m_renderPercent = percent;
+            update();
+        });
+        connect(m_seq, &SeqPageWidget::renderFinished, this,
+                [this](bool ok, const QString &path) {
+                    m_renderPercent = -1;
+                    m_renderStatus = ok ? QString("LAST: %1").arg(QFileInfo(path).fileName())
+                                        : QString("RENDER FAILED");
+                    update();
+                });
+    }
 }
 
 void ProjectMenuOverlay::showMenu() {
@@ -582,6 +600,8 @@ void ProjectMenuOverlay::newProject() {
         m_pads->setLoop(pad, false);
         m_pads->setNormalize(pad, false);
         m_pads->setFxBus(pad, 0);
+        m_pads->setPolyphony(pad, 1);
+        m_pads->setChokeGroup(pad, 0);
         if (m_seq) {
             m_seq->applyPianoSteps(pad, QVector<int>());
             m_seq->applyPianoNotes(pad, QVector<int>());
@@ -762,6 +782,8 @@ bool ProjectMenuOverlay::loadProject(const QString &name) {
         m_pads->setLoop(pad, pp.loop);
         m_pads->setNormalize(pad, pp.normalize);
         m_pads->setFxBus(pad, pp.fxBus);
+        m_pads->setPolyphony(pad, pp.polyphony);
+        m_pads->setChokeGroup(pad, pp.chokeGroup);
 
         if (isSynth) {
             const PadBank::SynthParams sp =
@@ -842,7 +864,11 @@ void ProjectMenuOverlay::renderProject() {
     ensureMediaDirs();
     QString filename = makeTimestampName("render") + ".wav";
     const QString path = QDir(renderDir()).filePath(filename);
-    m_seq->renderToFile(path, m_renderBars, m_renderRate);
+    if (m_seq->renderToFile(path, m_renderBars, m_renderRate)) {
+        m_renderStatus.clear();
+    } else {
+        m_renderStatus = QString("RENDER FAILED");
+    }
 }
 
 void ProjectMenuOverlay::paintEvent(QPaintEvent *event) {
@@ -1165,15 +1191,19 @@ void ProjectMenuOverlay::paintEvent(QPaintEvent *event) {
     p.drawRoundedRect(m_renderBtnRect, Theme::px(8), Theme::px(8));
     p.setPen(Theme::bg0());
     p.setFont(Theme::condensedFont(10, QFont::Bold));
-    p.drawText(m_renderBtnRect, Qt::AlignCenter, "RENDER WAV");
+    const bool rendering = m_seq && m_seq->isRendering();
+    p.drawText(m_renderBtnRect, Qt::AlignCenter,
+               rendering ? QString("CANCEL %1%").arg(qMax(0, m_renderPercent))
+                         : QString("RENDER WAV"));
 
     p.setPen(Theme::textMuted());
     p.setFont(Theme::baseFont(9));
     p.drawText(renderBox.adjusted(Theme::px(12), Theme::px(52), -Theme::px(12), 0),
                Qt::AlignLeft | Qt::AlignTop,
-               QString("OUTPUT: %1 Hz\nDEST: %2")
+               QString("OUTPUT: %1 Hz\nDEST: %2\n%3")
                    .arg(m_renderRate)
-                   .arg(QDir(renderDir()).absolutePath()));
+                   .arg(QDir(renderDir()).absolutePath())
+                   .arg(m_renderStatus));
 }
 
 void ProjectMenuOverlay::mousePressEvent(QMouseEvent *event) {
@@ -1301,7 +1331,11 @@ void ProjectMenuOverlay::mousePressEvent(QMouseEvent *event) {
         return;
     }
     if (m_renderBtnRect.contains(pos)) {
-        renderProject();
+        if (m_seq && m_seq->isRendering()) {
+            m_seq->cancelRender();
+        } else {
+            renderProject();
+        }
         update();
         return;
     }
@@ -58,6 +58,8 @@ private:
 
     int m_renderBars = 4;
     int m_renderRate = 44100;
+    int m_renderPercent = -1;
+    QString m_renderStatus;
     bool m_metronome = false;
 
     QVector<BtDevice> m_btDevices;
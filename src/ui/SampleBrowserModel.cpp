@@ -305,5 +305,5 @@ void SampleBrowserModel::scanNode(Node *node) {
 
 bool SampleBrowserModel::isAudioFile(const QFileInfo &info) {
     const QString ext = info.suffix().toLower();
-    return ext == "wav" || ext == "mp3";
+    return ext == "wav" || ext == "mp3" || ext == "flac";
 }
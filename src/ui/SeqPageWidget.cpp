@@ -5,6 +5,8 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QtGlobal>
+#include <cmath>
+#include "OfflineRenderer.h"
 #include "PadBank.h"
 #include "Theme.h"
 
@@ -29,11 +31,18 @@ SeqPageWidget::SeqPageWidget(PadBank *pads, QWidget *parent) : QWidget(parent),
     m_animTimer.setTimerType(Qt::PreciseTimer);
     m_animTimer.setInterval(33);
     connect(&m_animTimer, &QTimer::timeout, this, [this]() {
+        if (m_playing && engineTransport()) {
+            m_playStep = m_pads->sequencerPosition(&m_playPhase);
+        }
         if (m_playing || m_waiting) {
             update();
         }
     });
 
+    m_syncTimer.setSingleShot(true);
+    m_syncTimer.setInterval(0);
+    connect(&m_syncTimer, &QTimer::timeout, this, &SeqPageWidget::syncPattern);
+
     m_readyTimer.setInterval(60);
     connect(&m_readyTimer, &QTimer::timeout, this, [this]() {
         if (!m_waiting) {
@@ -48,6 +57,9 @@ SeqPageWidget::SeqPageWidget(PadBank *pads, QWidget *parent) : QWidget(parent),
         update();
     });
 
+    m_renderTimer.setInterval(50);
+    connect(&m_renderTimer, &QTimer::timeout, this, &SeqPageWidget::pollRender);
+
     m_longPressTimer.setSingleShot(true);
     m_longPressTimer.setInterval(450);
     connect(&m_longPressTimer, &QTimer::timeout, this, [this]() {
@@ -68,8 +80,29 @@ SeqPageWidget::SeqPageWidget(PadBank *pads, QWidget *parent) : QWidget(parent),
                 m_playTimer.setInterval(stepIntervalMs());
                 m_animTimer.setInterval(33);
             }
+            m_syncAtBar = false;
+            m_syncTimer.start();
             update();
         });
+        auto resync = [this](int) {
+            m_syncAtBar = false;
+            m_syncTimer.start();
+        };
+        connect(m_pads, &PadBank::padChanged, this, resync);
+        connect(m_pads, &PadBank::padParamsChanged, this, resync);
+        connect(m_pads, &PadBank::engineBufferChanged, this, [this](int) {
+            m_syncAtBar = m_syncAtBar || !m_syncTimer.isActive();
+            m_syncTimer.start();
+        });
+    }
+}
+
+SeqPageWidget::~SeqPageWidget() {
+    if (m_renderer) {
+        m_renderer->cancel();
+    }
+    if (m_renderThread.joinable()) {
+        m_renderThread.join();
     }
 }
 
@@ -110,12 +143,94 @@ bool SeqPageWidget::padsReady() const {
     return true;
 }
 
+bool SeqPageWidget::engineTransport() const {
+    return m_pads && m_pads->sequencerAvailable();
+}
+
+void SeqPageWidget::syncPattern() {
+    if (!engineTransport()) {
+        return;
+    }
+    AudioEngine::SeqPattern pattern;
+    pattern.steps = 64;
+    pattern.metronome = m_metronomeEnabled;
+    pattern.atBar = m_syncAtBar;
+    m_syncAtBar = false;
+    if (m_metronomeEnabled) {
+        pattern.click = m_pads->metronomeBuffer(false);
+        pattern.accent = m_pads->metronomeBuffer(true);
+    }
+
+    const int rate = m_pads->engineSampleRate();
+    const double stepFrames = rate * 60.0 / qMax(1, m_pads->bpm()) / 4.0;
+    auto msToFrames = [rate](int ms) { return static_cast<int>(static_cast<qint64>(ms) * rate / 1000); };
+    for (int pad = 0; pad < 8; ++pad) {
+        const bool pianoPad = m_pads->isSynth(pad) && !m_pianoNotes[pad].isEmpty();
+        bool used = pianoPad;
+        for (int step = 0; step < 64 && !used; ++step) {
+            used = m_steps[pad][step];
+        }
+        PadBank::EngineTrigger trig;
+        if (!used || !m_pads->sequencerTrigger(pad, trig)) {
+            continue;
+        }
+        AudioEngine::SeqEvent event;
+        event.padId = pad;
+        event.synth = trig.synth;
+        event.buffer = trig.buffer;
+        event.stream = trig.stream;
+        event.startFrame = trig.startFrame;
+        event.endFrame = trig.endFrame;
+        event.loop = trig.loop;
+        event.volume = trig.volume;
+        event.pan = trig.pan;
+        event.rate = trig.rate;
+        event.bus = trig.bus;
+        if (pianoPad) {
+            const int baseMidi = 48;
+            const int rows = 49;
+            for (const auto &note : m_pianoNotes[pad]) {
+                if (note.start < 0 || note.start >= 64) {
+                    continue;
+                }
+                event.step = note.start;
+                event.midiNote = qBound(0, baseMidi + (rows - 1 - note.row) - 12, 127);
+                const int gate = static_cast<int>(std::llround(qMax(1, note.length) * stepFrames));
+                event.lengthFrames = qBound(msToFrames(60), gate, msToFrames(4000));
+                pattern.events.push_back(event);
+            }
+            continue;
+        }
+        event.midiNote = trig.midiNote;
+        event.lengthFrames = trig.lengthFrames;
+        for (int step = 0; step < 64; ++step) {
+            if (m_steps[pad][step]) {
+                event.step = step;
+                pattern.events.push_back(event);
+            }
+        }
+    }
+    m_pads->setSequencerPattern(pattern);
+}
+
 void SeqPageWidget::startPlayback() {
     m_playing = true;
     m_playStep = 0;
-    triggerStep(m_playStep);
-    m_playTimer.setInterval(stepIntervalMs());
-    m_playTimer.start();
+    m_playPhase = 0.0f;
+    if (engineTransport()) {
+        m_syncTimer.stop();
+        syncPattern();
+        if (!m_pads->startSequencer(m_playStep)) {
+            // The engine did not take it; show the transport as it really is.
+            m_playing = false;
+            update();
+            return;
+        }
+    } else {
+        triggerStep(m_playStep);
+        m_playTimer.setInterval(stepIntervalMs());
+        m_playTimer.start();
+    }
     if (!m_playClock.isValid()) {
         m_playClock.start();
     } else {
@@ -129,6 +244,10 @@ void SeqPageWidget::startPlayback() {
 
 void SeqPageWidget::togglePlayback() {
     if (m_playing || m_waiting) {
+        if (m_playing && engineTransport() && !m_pads->stopSequencer()) {
+            // Still running in the engine, so still playing here; the next tap tries again.
+            return;
+        }
         m_playing = false;
         m_waiting = false;
         m_readyTimer.stop();
@@ -151,19 +270,6 @@ void SeqPageWidget::togglePlayback() {
 void SeqPageWidget::advancePlayhead() {
     m_playStep = (m_playStep + 1) % 64;
     triggerStep(m_playStep);
-    if (m_rendering) {
-        m_renderStepCount++;
-        if (m_renderStepCount >= m_renderStepsTotal) {
-            m_rendering = false;
-            m_playing = false;
-            m_waiting = false;
-            m_playTimer.stop();
-            m_animTimer.stop();
-            if (m_pads) {
-                m_pads->stopAll();
-            }
-        }
-    }
     if (m_playClock.isValid()) {
         m_lastStepMs = m_playClock.elapsed();
     }
@@ -211,6 +317,8 @@ void SeqPageWidget::applyPianoSteps(int pad, const QVector<int> &steps) {
             m_steps[pad][step] = true;
         }
     }
+    m_syncAtBar = false;
+    m_syncTimer.start();
     update();
 }
 
@@ -244,28 +352,58 @@ QVector<int> SeqPageWidget::pianoNotesData(int pad) const {
 
 void SeqPageWidget::setMetronomeEnabled(bool enabled) {
     m_metronomeEnabled = enabled;
+    m_syncAtBar = false;
+    m_syncTimer.start();
 }
 
-void SeqPageWidget::renderToFile(const QString &path, int bars, int targetRate) {
-    if (!m_pads || bars <= 0 || path.isEmpty()) {
+bool SeqPageWidget::renderToFile(const QString &path, int bars, int targetRate) {
+    if (!m_pads || bars <= 0 || path.isEmpty() || m_renderer) {
+        return false;
+    }
+    // The offline engine takes the pattern along with the rest of the engine state.
+    m_syncTimer.stop();
+    syncPattern();
+    std::unique_ptr<AudioEngine> engine = m_pads->createOfflineEngine(512);
+    if (!engine) {
+        return false;
+    }
+    const double stepFrames = engine->sampleRate() * 60.0 / qMax(1, m_pads->bpm()) / 4.0;
+    const qint64 totalFrames = static_cast<qint64>(std::llround(bars * 16 * stepFrames));
+    engine->startSequencer(0);
+
+    m_renderer = std::make_unique<OfflineRenderer>(std::move(engine), totalFrames);
+    m_renderPath = path;
+    OfflineRenderer *renderer = m_renderer.get();
+    m_renderThread = std::thread([renderer, path, targetRate]() {
+        renderer->render(path, targetRate);
+    });
+    m_renderTimer.start();
+    emit renderProgress(0);
+    return true;
+}
+
+void SeqPageWidget::cancelRender() {
+    if (m_renderer) {
+        m_renderer->cancel();
+    }
+}
+
+void SeqPageWidget::pollRender() {
+    if (!m_renderer) {
+        m_renderTimer.stop();
         return;
     }
-    const int steps = bars * 16;
-    const int totalMs = steps * stepIntervalMs();
-    if (!m_pads->startRecording(path, totalMs, targetRate)) {
+    if (!m_renderer->finished()) {
+        emit renderProgress(static_cast<int>(m_renderer->progress() * 100.0f));
         return;
     }
-    if (m_playing || m_waiting) {
-        m_playing = false;
-        m_waiting = false;
-        m_playTimer.stop();
-        m_animTimer.stop();
-        m_readyTimer.stop();
+    m_renderTimer.stop();
+    if (m_renderThread.joinable()) {
+        m_renderThread.join();
     }
-    m_rendering = true;
-    m_renderStepsTotal = steps;
-    m_renderStepCount = 0;
-    startPlayback();
+    const bool ok = m_renderer->succeeded();
+    m_renderer.reset();
+    emit renderFinished(ok, m_renderPath);
 }
 
 void SeqPageWidget::applyPianoNotes(int pad, const QVector<int> &notesData) {
@@ -281,6 +419,8 @@ void SeqPageWidget::applyPianoNotes(int pad, const QVector<int> &notesData) {
         note.row = qBound(0, notesData[i + 2], 48);
         notes.push_back(note);
     }
+    m_syncAtBar = false;
+    m_syncTimer.start();
     update();
 }
 
@@ -300,6 +440,9 @@ void SeqPageWidget::keyPressEvent(QKeyEvent *event) {
     }
     if (key == Qt::Key_R) {
         m_playStep = 0;
+        if (m_playing && engineTransport()) {
+            m_pads->startSequencer(m_playStep);
+        }
         update();
         return;
     }
@@ -331,7 +474,11 @@ void SeqPageWidget::mousePressEvent(QMouseEvent *event) {
             m_lastStepMs = m_playClock.elapsed();
         }
         if (m_playing) {
-            triggerStep(m_playStep);
+            if (engineTransport()) {
+                m_pads->startSequencer(m_playStep);
+            } else {
+                triggerStep(m_playStep);
+            }
         }
         m_scrubActive = true;
         update();
@@ -388,6 +535,8 @@ void SeqPageWidget::mousePressEvent(QMouseEvent *event) {
     } else {
         m_steps[row][step] = !m_steps[row][step];
     }
+    m_syncAtBar = false;
+    m_syncTimer.start();
 
     update();
 }
@@ -403,6 +552,9 @@ void SeqPageWidget::mouseMoveEvent(QMouseEvent *event) {
         const float cellW = gridArea.width() / cols;
         const int step = qBound(0, static_cast<int>((event->position().x() - gridArea.left()) / cellW),
                                 cols - 1);
+        if (m_playing && engineTransport() && step != m_playStep) {
+            m_pads->startSequencer(step);
+        }
         m_playStep = step;
         if (m_playClock.isValid()) {
             m_lastStepMs = m_playClock.elapsed();
@@ -544,7 +696,9 @@ void SeqPageWidget::paintEvent(QPaintEvent *event) {
     if (m_playing || m_waiting) {
         float frac = 0.0f;
         const int stepMs = stepIntervalMs();
-        if (m_playClock.isValid() && stepMs > 0) {
+        if (m_playing && engineTransport()) {
+            frac = m_playPhase;
+        } else if (m_playClock.isValid() && stepMs > 0) {
             const qint64 elapsed = m_playClock.elapsed() - m_lastStepMs;
             frac = qBound(0.0f, static_cast<float>(elapsed) / static_cast<float>(stepMs), 1.0f);
         }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <thread>
 #include <QColor>
 #include <QVector>
 #include <QTimer>
@@ -13,23 +15,30 @@ class QKeyEvent;
 class QEvent;
 class QWheelEvent;
 class PadBank;
+class OfflineRenderer;
 
 class SeqPageWidget : public QWidget {
     Q_OBJECT
 public:
     explicit SeqPageWidget(PadBank *pads, QWidget *parent = nullptr);
+    ~SeqPageWidget() override;
     void applyPianoSteps(int pad, const QVector<int> &steps);
     void applyPianoNotes(int pad, const QVector<int> &notesData);
     QVector<int> pianoSteps(int pad) const;
     QVector<int> pianoNotesData(int pad) const;
     void setMetronomeEnabled(bool enabled);
     bool metronomeEnabled() const { return m_metronomeEnabled; }
-    void renderToFile(const QString &path, int bars, int targetRate);
+    // Renders the pattern on a separate offline engine; live playback keeps running.
+    bool renderToFile(const QString &path, int bars, int targetRate);
+    void cancelRender();
+    bool isRendering() const { return m_renderer != nullptr; }
 
 signals:
     void padOpenRequested(int pad);
     void padAssignRequested(int pad);
     void padMenuRequested(int pad);
+    void renderProgress(int percent);
+    void renderFinished(bool ok, const QString &path);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -46,6 +55,9 @@ private:
     void togglePlayback();
     void advancePlayhead();
     void triggerStep(int step);
+    bool engineTransport() const;
+    void syncPattern();
+    void pollRender();
 
     struct PianoNote {
         int start = 0;
@@ -61,6 +73,10 @@ private:
     QTimer m_readyTimer;
     QTimer m_animTimer;
     QTimer m_longPressTimer;
+    // Coalesces pattern rebuilds; the engine's transport plays whatever was last synced.
+    QTimer m_syncTimer;
+    // The pending rebuild only swaps in re-rendered pad buffers, so it may wait for a bar line.
+    bool m_syncAtBar = false;
     QElapsedTimer m_playClock;
     qint64 m_lastStepMs = 0;
     bool m_playing = false;
@@ -69,11 +85,13 @@ private:
     bool m_pressOnLabel = false;
     bool m_scrubActive = false;
     int m_playStep = 0;
+    float m_playPhase = 0.0f;
     int m_bpm = 120;
     bool m_metronomeEnabled = false;
-    bool m_rendering = false;
-    int m_renderStepsTotal = 0;
-    int m_renderStepCount = 0;
+    std::unique_ptr<OfflineRenderer> m_renderer;
+    std::thread m_renderThread;
+    QTimer m_renderTimer;
+    QString m_renderPath;
     PadBank *m_pads = nullptr;
     QPointF m_pressPos;
     int m_pressedPad = -1;
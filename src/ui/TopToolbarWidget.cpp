@@ -1,17 +1,173 @@
 #include "TopToolbarWidget.h"
 
 #include <QFontMetrics>
+#include <QHideEvent>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QWheelEvent>
 #include <cmath>
 
+#include "EffectKernels.h"
 #include "PadBank.h"
 #include "Theme.h"
 
+namespace {
+
+// Callback load against the period, its worst case and xruns, then each mix worker when there
+// are several.
+QString dspSummary(PadBank *pads, const DspStats &dsp) {
+    QString text = QString("DSP %1%  PK %2%  XR %3")
+                       .arg(static_cast<int>(dsp.load() * 100))
+                       .arg(static_cast<int>(dsp.worstLoad() * 100))
+                       .arg(dsp.xruns());
+    const int workers = pads->engineWorkerCount();
+    if (workers > 1) {
+        text += "  W";
+        for (int i = 0; i < workers; ++i) {
+            text += QString(" %1").arg(static_cast<int>(pads->engineWorkerLoad(i) * 100));
+        }
+        text += "%";
+    }
+    if (!pads->realtimeProblems().isEmpty()) {
+        text += "  NO RT";
+    }
+    return text;
+}
+
+// Buses always, synth pads and effect types only while they cost something, then whatever
+// keeps the audio thread from running real-time.
+QStringList dspBreakdown(PadBank *pads, const DspStats &dsp) {
+    auto percent = [](float load) { return QString("%1%").arg(load * 100.0f, 0, 'f', 1); };
+    static const char *const kBusNames[] = {"MASTER", "A", "B", "C", "D", "E"};
+    QStringList buses;
+    for (int bus = 0; bus < DspStats::kBuses; ++bus) {
+        buses << QString("%1 %2").arg(kBusNames[bus], percent(dsp.busLoad(bus)));
+    }
+    QStringList synths;
+    for (int pad = 0; pad < DspStats::kSynthPads; ++pad) {
+        const float load = dsp.synthLoad(pad);
+        if (load >= 0.001f) {
+            synths << QString("%1 %2").arg(pad + 1).arg(percent(load));
+        }
+    }
+    QStringList effects;
+    for (int type = 1; type < DspStats::kEffectTypes; ++type) {
+        const float load = dsp.effectLoad(type);
+        if (load >= 0.001f) {
+            effects << QString("%1 %2").arg(EffectKernels::typeName(type), percent(load));
+        }
+    }
+    QStringList lines;
+    lines << QString("BUS  %1").arg(buses.join("  "));
+    lines << QString("SYNTH  %1").arg(synths.isEmpty() ? QString("-") : synths.join("  "));
+    lines << QString("FX  %1").arg(effects.isEmpty() ? QString("-") : effects.join("  "));
+    const QStringList problems = pads->realtimeProblems();
+    if (!problems.isEmpty()) {
+        lines << "NO RT: " + problems.join("; ");
+    }
+    return lines;
+}
+
+}  // namespace
+
+// Drops down under the toolbar when the stats are tapped; there is no hover on the
+// touchscreen. Tapping it again closes it, RESET PK clears the worst case and histogram.
+class DspBreakdownPanel : public QWidget {
+public:
+    DspBreakdownPanel(PadBank *pads, QWidget *parent) : QWidget(parent), m_pads(pads) {
+        hide();
+        connect(&m_refresh, &QTimer::timeout, this, [this]() { update(); });
+    }
+
+    void toggle(const QPoint &anchor) {
+        if (isVisible()) {
+            hide();
+            return;
+        }
+        const int margin = Theme::px(14);
+        const int maxWidth = parentWidget() ? parentWidget()->width() - 2 * margin : width();
+        const int w = qMax(Theme::px(200), qMin(Theme::px(560), maxWidth));
+        const int h = Theme::px(20) * 5 + Theme::px(20);
+        int x = anchor.x();
+        if (parentWidget()) {
+            x = qBound(margin, x, qMax(margin, parentWidget()->width() - margin - w));
+        }
+        setGeometry(x, anchor.y(), w, h);
+        show();
+        raise();
+        m_refresh.start(500);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *) override {
+        QPainter p(this);
+        Theme::applyRenderHints(p);
+        const QRectF panel = rect().adjusted(1, 1, -1, -1);
+        p.setBrush(Theme::bg1());
+        p.setPen(QPen(Theme::accent(), 1.2));
+        p.drawRoundedRect(panel, Theme::px(8), Theme::px(8));
+
+        const DspStats *dsp = m_pads ? m_pads->engineDspStats() : nullptr;
+        const qreal pad = Theme::pxF(10.0f);
+        const qreal lineH = Theme::pxF(20.0f);
+        p.setFont(Theme::baseFont(9, QFont::DemiBold));
+        QFontMetrics fm(p.font());
+
+        const qreal resetW = fm.horizontalAdvance("RESET PK") + Theme::pxF(16.0f);
+        m_resetRect = QRectF(panel.right() - pad - resetW, panel.top() + pad, resetW, lineH);
+        p.setPen(QPen(Theme::stroke(), 1.0));
+        p.setBrush(Theme::bg2());
+        p.drawRoundedRect(m_resetRect, Theme::px(4), Theme::px(4));
+        p.setPen(Theme::text());
+        p.drawText(m_resetRect, Qt::AlignCenter, "RESET PK");
+
+        if (!dsp) {
+            p.setPen(Theme::textMuted());
+            p.drawText(panel.adjusted(pad, pad, -pad, -pad), Qt::AlignLeft | Qt::AlignTop,
+                       "NO ENGINE");
+            return;
+        }
+        QStringList lines = dspBreakdown(m_pads, *dsp);
+        lines.prepend(dspSummary(m_pads, *dsp));
+        qreal y = panel.top() + pad;
+        for (int i = 0; i < lines.size(); ++i) {
+            const qreal right = i == 0 ? m_resetRect.left() - pad : panel.right() - pad;
+            const QRectF row(panel.left() + pad, y, right - panel.left() - pad, lineH);
+            const bool problem = lines[i].startsWith("NO RT");
+            p.setPen(problem ? Theme::warn() : i == 0 ? Theme::accent() : Theme::text());
+            p.drawText(row, Qt::AlignLeft | Qt::AlignVCenter,
+                       fm.elidedText(lines[i], Qt::ElideRight, static_cast<int>(row.width())));
+            y += lineH;
+        }
+    }
+
+    void mousePressEvent(QMouseEvent *event) override {
+        if (m_resetRect.contains(event->position())) {
+            if (m_pads) {
+                m_pads->resetEngineDspStats();
+            }
+            update();
+            return;
+        }
+        hide();
+    }
+
+    void hideEvent(QHideEvent *event) override {
+        m_refresh.stop();
+        QWidget::hideEvent(event);
+    }
+
+private:
+    PadBank *m_pads = nullptr;
+    QTimer m_refresh;
+    QRectF m_resetRect;
+};
+
 TopToolbarWidget::TopToolbarWidget(PadBank *pads, QWidget *parent)
     : QWidget(parent), m_stats(this), m_pads(pads) {
     setFixedHeight(Theme::px(72));
+    // A sibling rather than a child, so it can hang below the toolbar over the page.
+    m_dspPanel = new DspBreakdownPanel(m_pads, parent ? parent : this);
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
 
     m_tabs << "SEQ" << "FX" << "ARRANGE";
@@ -94,6 +250,15 @@ void TopToolbarWidget::updateStats() {
 void TopToolbarWidget::mousePressEvent(QMouseEvent *event) {
     const QPointF pos = event->position();
 
+    if (m_statsRect.contains(pos)) {
+        QPoint anchor(static_cast<int>(m_statsRect.left()), height());
+        if (m_dspPanel->parentWidget() != this) {
+            anchor = mapTo(m_dspPanel->parentWidget(), anchor);
+        }
+        m_dspPanel->toggle(anchor);
+        return;
+    }
+
     if (m_bpmRect.contains(pos)) {
         const bool shift = event->modifiers().testFlag(Qt::ShiftModifier);
         const int delta = shift ? 5 : 1;
@@ -208,6 +373,7 @@ void TopToolbarWidget::paintEvent(QPaintEvent *event) {
                            qMin(statsWidth, fallbackWidth), Theme::px(18));
     }
 
+    m_statsRect = QRectF();
     if (statsRect.width() > 60.0f) {
         const float cpu = m_stats.cpuUsage();
         const float ram = m_stats.ramUsage();
@@ -222,7 +388,62 @@ void TopToolbarWidget::paintEvent(QPaintEvent *event) {
                 .arg(static_cast<int>(load * 100));
         QFontMetrics fm(p.font());
         statsText = fm.elidedText(statsText, Qt::ElideRight, static_cast<int>(statsRect.width()));
-        p.drawText(statsRect, Qt::AlignLeft | Qt::AlignVCenter, statsText);
+        m_statsRect = statsRect;
+        const DspStats *dsp = m_pads ? m_pads->engineDspStats() : nullptr;
+        const bool degraded = dsp && !m_pads->realtimeProblems().isEmpty();
+        if (dsp && statsRect.height() > fm.height() * 2) {
+            // Second line: the callback summary and the load histogram.
+            const QString dspText = dspSummary(m_pads, *dsp);
+            const QRectF top(statsRect.left(), statsRect.top(), statsRect.width(),
+                             statsRect.height() * 0.5);
+            const QRectF bottom(statsRect.left(), top.bottom(), statsRect.width(),
+                                statsRect.height() * 0.5);
+            p.drawText(top, Qt::AlignLeft | Qt::AlignBottom, statsText);
+
+            // Histogram bins from 0-10% up to overrun, log-scaled so rare spikes still show.
+            const DspStats::Histogram bins = dsp->histogram();
+            const qreal barWidth = Theme::pxF(3.0f);
+            const qreal barGap = Theme::pxF(1.0f);
+            const qreal histWidth = bins.size() * (barWidth + barGap);
+            const qreal histHeight = qMin<qreal>(bottom.height() - Theme::px(2), fm.height());
+            const QRectF hist(bottom.right() - histWidth, bottom.top() + Theme::px(1), histWidth,
+                              histHeight);
+            quint32 peak = 0;
+            for (quint32 count : bins) {
+                peak = qMax(peak, count);
+            }
+            if (peak > 0) {
+                const qreal scale = std::log(static_cast<qreal>(peak) + 1.0);
+                p.setPen(Qt::NoPen);
+                for (size_t i = 0; i < bins.size(); ++i) {
+                    if (bins[i] == 0) {
+                        continue;
+                    }
+                    const qreal h = qMax<qreal>(
+                        1.0, hist.height() * std::log(static_cast<qreal>(bins[i]) + 1.0) / scale);
+                    const bool overrun = i + 1 == bins.size();
+                    p.setBrush(overrun  ? Theme::danger()
+                               : i >= 8 ? Theme::warn()
+                                        : Theme::accent());
+                    p.drawRect(QRectF(hist.left() + i * (barWidth + barGap), hist.bottom() - h,
+                                      barWidth, h));
+                }
+            }
+
+            p.setPen(dsp->xruns() > 0 || degraded ? Theme::warn() : Theme::textMuted());
+            const QRectF textRect = bottom.adjusted(0, 0, -histWidth - Theme::px(6), 0);
+            p.drawText(textRect, Qt::AlignLeft | Qt::AlignTop,
+                       fm.elidedText(dspText, Qt::ElideRight, static_cast<int>(textRect.width())));
+        } else if (dsp) {
+            // No room for two lines: the callback matters more than the system figures.
+            p.setPen(dsp->xruns() > 0 || degraded ? Theme::warn() : Theme::text());
+            const QString line = dspSummary(m_pads, *dsp) + "  " +
+                                 QString("CPU %1%").arg(static_cast<int>(cpu * 100));
+            p.drawText(statsRect, Qt::AlignLeft | Qt::AlignVCenter,
+                       fm.elidedText(line, Qt::ElideRight, static_cast<int>(statsRect.width())));
+        } else {
+            p.drawText(statsRect, Qt::AlignLeft | Qt::AlignVCenter, statsText);
+        }
     }
 
     // Master VU meter (arc)
@@ -9,6 +9,7 @@
 
 #include "SystemStats.h"
 
+class DspBreakdownPanel;
 class QMouseEvent;
 class QPaintEvent;
 class QResizeEvent;
@@ -52,5 +53,9 @@ private:
     PadBank *m_pads = nullptr;
     QVector<QRectF> m_padRects;
     QRectF m_bpmRect;
+    // Tapping the stats opens m_dspPanel: where the time goes, and a reset for the worst case
+    // and histogram.
+    QRectF m_statsRect;
+    DspBreakdownPanel *m_dspPanel = nullptr;
     int m_bpm = 120;
 };